@@ -126,6 +126,27 @@ egg_counter_get (EggCounter *counter)
   return value;
 }
 
+/**
+ * egg_counter_add:
+ * @counter: An #EggCounter.
+ * @count: the amount to add to the counter.
+ *
+ * Like EGG_COUNTER_ADD(), but for counters that are registered at runtime
+ * instead of with EGG_DEFINE_COUNTER().
+ */
+void
+egg_counter_add (EggCounter *counter,
+                 gint64      count)
+{
+  g_return_if_fail (counter);
+
+#ifdef EGG_COUNTER_REQUIRES_ATOMIC
+  __sync_add_and_fetch ((gint64 *)&counter->values [0], count);
+#else
+  counter->values [egg_get_current_cpu ()].value += count;
+#endif
+}
+
 void
 egg_counter_reset (EggCounter *counter)
 {
@@ -283,6 +283,8 @@ void             egg_counter_arena_foreach      (EggCounterArena       *arena,
                                                  gpointer               user_data);
 void             egg_counter_reset              (EggCounter            *counter);
 gint64           egg_counter_get                (EggCounter            *counter);
+void             egg_counter_add                (EggCounter            *counter,
+                                                 gint64                 count);
 
 G_END_DECLS
 
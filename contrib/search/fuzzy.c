@@ -460,23 +460,22 @@ fuzzy_match (Fuzzy       *fuzzy,
     }
   else
     {
+      /*
+       * A single character has no gaps to score, so every item containing
+       * it is a match with a gap of zero. Score and limit them below just
+       * like longer needles.
+       */
       guint last_id = G_MAXUINT;
 
       for (i = 0; i < root->len; i++)
         {
           item = &g_array_index (root, FuzzyItem, i);
-          match.id = GPOINTER_TO_INT (item->id);
-          if (match.id != last_id)
+          if (item->id != last_id)
             {
-              match.key = fuzzy_get_string (fuzzy, item->id);
-              match.value = g_ptr_array_index (fuzzy->id_to_value, item->id);
-              match.score = 0;
-              g_array_append_val (matches, match);
-              last_id = match.id;
+              g_hash_table_insert (lookup.matches, GINT_TO_POINTER (item->id), GINT_TO_POINTER (0));
+              last_id = item->id;
             }
         }
-
-      goto cleanup;
     }
 
   g_hash_table_iter_init (&iter, lookup.matches);
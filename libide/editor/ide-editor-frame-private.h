@@ -44,12 +44,13 @@ struct _IdeEditorFrame
   GdTaggedEntryTag    *search_entry_tag;
   IdeSourceView       *source_view;
   IdeEditorMapBin      *source_map_container;
-  IdeSourceMap        *source_map;
+  GtkWidget           *source_map;
   GtkOverlay          *source_overlay;
 
   gulong               cursor_moved_handler;
 
   guint                auto_hide_map : 1;
+  guint                rasterize_map : 1;
   guint                show_ruler : 1;
 };
 
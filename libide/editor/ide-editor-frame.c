@@ -40,6 +40,7 @@ enum {
   PROP_AUTO_HIDE_MAP,
   PROP_BACK_FORWARD_LIST,
   PROP_DOCUMENT,
+  PROP_RASTERIZE_MAP,
   PROP_SHOW_MAP,
   PROP_SHOW_RULER,
   LAST_PROP
@@ -155,20 +156,20 @@ ide_editor_frame_animate_map (IdeEditorFrame *self,
 
 static void
 ide_editor_frame_show_map (IdeEditorFrame *self,
-                          IdeSourceMap  *source_map)
+                          GtkWidget      *source_map)
 {
   g_assert (IDE_IS_EDITOR_FRAME (self));
-  g_assert (IDE_IS_SOURCE_MAP (source_map));
+  g_assert (IDE_IS_SOURCE_MAP (source_map) || IDE_IS_SOURCE_RASTER_MAP (source_map));
 
   ide_editor_frame_animate_map (self, TRUE);
 }
 
 static void
 ide_editor_frame_hide_map (IdeEditorFrame *self,
-                          IdeSourceMap  *source_map)
+                          GtkWidget      *source_map)
 {
   g_assert (IDE_IS_EDITOR_FRAME (self));
-  g_assert (IDE_IS_SOURCE_MAP (source_map));
+  g_assert (IDE_IS_SOURCE_MAP (source_map) || IDE_IS_SOURCE_RASTER_MAP (source_map));
 
   /* ignore hide request if auto-hide is disabled */
   if ((self->source_map != NULL) && !self->auto_hide_map)
@@ -614,12 +615,15 @@ ide_editor_frame_set_show_map (IdeEditorFrame *self,
       if (self->source_map != NULL)
         {
           gtk_container_remove (GTK_CONTAINER (self->source_map_container),
-                                GTK_WIDGET (self->source_map));
+                                self->source_map);
           self->source_map = NULL;
         }
       else
         {
-          self->source_map = g_object_new (IDE_TYPE_SOURCE_MAP,
+          GType map_type;
+
+          map_type = self->rasterize_map ? IDE_TYPE_SOURCE_RASTER_MAP : IDE_TYPE_SOURCE_MAP;
+          self->source_map = g_object_new (map_type,
                                            "view", self->source_view,
                                            "visible", TRUE,
                                            NULL);
@@ -634,7 +638,7 @@ ide_editor_frame_set_show_map (IdeEditorFrame *self,
                                    self,
                                    G_CONNECT_SWAPPED);
           gtk_container_add (GTK_CONTAINER (self->source_map_container),
-                             GTK_WIDGET (self->source_map));
+                             self->source_map);
           g_signal_emit_by_name (self->source_map, "show-map");
         }
 
@@ -657,6 +661,29 @@ ide_editor_frame_set_auto_hide_map (IdeEditorFrame *self,
     }
 }
 
+static void
+ide_editor_frame_set_rasterize_map (IdeEditorFrame *self,
+                                   gboolean       rasterize_map)
+{
+  g_assert (IDE_IS_EDITOR_FRAME (self));
+
+  rasterize_map = !!rasterize_map;
+
+  if (rasterize_map != self->rasterize_map)
+    {
+      self->rasterize_map = rasterize_map;
+
+      /* Recreate the map using the requested renderer. */
+      if (ide_editor_frame_get_show_map (self))
+        {
+          ide_editor_frame_set_show_map (self, FALSE);
+          ide_editor_frame_set_show_map (self, TRUE);
+        }
+
+      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_RASTERIZE_MAP]);
+    }
+}
+
 static void
 ide_editor_frame__source_view_populate_popup (IdeEditorFrame *self,
                                              GtkWidget     *popup,
@@ -867,6 +894,10 @@ ide_editor_frame_get_property (GObject    *object,
       g_value_set_object (value, ide_editor_frame_get_document (self));
       break;
 
+    case PROP_RASTERIZE_MAP:
+      g_value_set_boolean (value, self->rasterize_map);
+      break;
+
     case PROP_SHOW_MAP:
       g_value_set_boolean (value, ide_editor_frame_get_show_map (self));
       break;
@@ -902,6 +933,10 @@ ide_editor_frame_set_property (GObject      *object,
       ide_source_view_set_back_forward_list (self->source_view, g_value_get_object (value));
       break;
 
+    case PROP_RASTERIZE_MAP:
+      ide_editor_frame_set_rasterize_map (self, g_value_get_boolean (value));
+      break;
+
     case PROP_SHOW_MAP:
       ide_editor_frame_set_show_map (self, g_value_get_boolean (value));
       break;
@@ -950,6 +985,13 @@ ide_editor_frame_class_init (IdeEditorFrameClass *klass)
                          IDE_TYPE_BUFFER,
                          (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  properties [PROP_RASTERIZE_MAP] =
+    g_param_spec_boolean ("rasterize-map",
+                          "Rasterize Map",
+                          "If the overview map should be drawn from cached color runs.",
+                          FALSE,
+                          (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   properties [PROP_SHOW_MAP] =
     g_param_spec_boolean ("show-map",
                           "Show Map",
@@ -1005,6 +1047,7 @@ ide_editor_frame_init (IdeEditorFrame *self)
   g_settings_bind (settings, "show-line-numbers", self->source_view, "show-line-numbers", G_SETTINGS_BIND_GET);
   g_settings_bind (settings, "smart-backspace", self->source_view, "smart-backspace", G_SETTINGS_BIND_GET);
   g_settings_bind_with_mapping (settings, "smart-home-end", self->source_view, "smart-home-end", G_SETTINGS_BIND_GET, get_smart_home_end, NULL, NULL, NULL);
+  g_settings_bind (settings, "rasterize-map", self, "rasterize-map", G_SETTINGS_BIND_GET);
   g_settings_bind (settings, "show-map", self, "show-map", G_SETTINGS_BIND_GET);
   g_settings_bind (settings, "auto-hide-map", self, "auto-hide-map", G_SETTINGS_BIND_GET);
   g_signal_connect_object (settings, "changed::keybindings", G_CALLBACK (keybindings_changed), self, 0);
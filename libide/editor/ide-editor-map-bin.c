@@ -124,6 +124,10 @@ ide_editor_map_bin_add (GtkContainer *container,
 
       gtk_widget_show (GTK_WIDGET (self->separator));
     }
+  else if (IDE_IS_SOURCE_RASTER_MAP (child) && (self->separator != NULL))
+    {
+      gtk_widget_show (GTK_WIDGET (self->separator));
+    }
 
   GTK_CONTAINER_CLASS (ide_editor_map_bin_parent_class)->add (container, child);
 }
@@ -134,7 +138,8 @@ ide_editor_map_bin_remove (GtkContainer *container,
 {
   IdeEditorMapBin *self = (IdeEditorMapBin *)container;
 
-  if (IDE_IS_SOURCE_MAP (child) && (self->separator != NULL))
+  if ((IDE_IS_SOURCE_MAP (child) || IDE_IS_SOURCE_RASTER_MAP (child)) &&
+      (self->separator != NULL))
     gtk_widget_hide (GTK_WIDGET (self->separator));
 
   GTK_CONTAINER_CLASS (ide_editor_map_bin_parent_class)->remove (container, child);
@@ -0,0 +1,899 @@
+/* ide-bracket-index.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-bracket-index"
+
+#include <gtksourceview/gtksource.h>
+#include <string.h>
+
+#include "ide-bracket-index.h"
+
+/*
+ * The bracket index keeps the positions of brackets, block comments and
+ * preprocessor conditionals of a #GtkTextBuffer, sorted by offset. The
+ * buffer is lexed with C rules so that brackets within comments and
+ * string literals are skipped. Those rules would hide brackets in other
+ * languages (such as after a Rust lifetime or an apostrophe in a shell
+ * comment), so only C-family buffers get an index.
+ *
+ * Edits only shift offsets and drop the items they touch. The next query
+ * relexes forward from the last untouched item before the edit until the
+ * lexer state matches what the previous pass had at an untouched item, so
+ * typing relexes a handful of characters rather than the whole buffer.
+ * Items are then paired in a single pass, after which matching and
+ * enclosing lookups are binary searches.
+ */
+
+#define INDEX_KEY "IDE_BRACKET_INDEX"
+
+typedef enum
+{
+  ITEM_BRACKET,
+  ITEM_DIRECTIVE,
+  ITEM_COMMENT,
+} ItemKind;
+
+typedef enum
+{
+  DIRECTIVE_IF,
+  DIRECTIVE_ELIF,
+  DIRECTIVE_ELSE,
+  DIRECTIVE_ENDIF,
+} Directive;
+
+enum {
+  BRACKET_PAREN,
+  BRACKET_SQUARE,
+  BRACKET_CURLY,
+  N_BRACKETS
+};
+
+static const gchar brackets[N_BRACKETS][2] = {
+  { '(', ')' },
+  { '[', ']' },
+  { '{', '}' },
+};
+
+typedef struct
+{
+  gint   begin;
+  /* Offset of the last character of the item */
+  gint   end;
+  guint8 kind;
+  /* The bracket type or Directive */
+  guint8 type;
+  guint8 is_open;
+  /*
+   * For brackets, the matching bracket. For directives, the next directive
+   * of the same #if chain, or the #if for an #endif.
+   */
+  gint   partner;
+  /* For brackets, the enclosing open bracket of the same type */
+  gint   parent;
+  /* The innermost open bracket of each type once past this item */
+  gint   scope[N_BRACKETS];
+} Item;
+
+typedef enum
+{
+  LEX_NORMAL,
+  LEX_DIRECTIVE,
+  LEX_LINE_COMMENT,
+  LEX_BLOCK_COMMENT,
+  LEX_STRING,
+} LexMode;
+
+typedef struct
+{
+  LexMode  mode;
+  gint     offset;
+  gint     item_begin;
+  gunichar prev;
+  gunichar quote;
+  guint    line_blank : 1;
+  guint    word_len;
+  gchar    word[8];
+} Lexer;
+
+struct _IdeBracketIndex
+{
+  /* Unowned, the index is attached to the buffer */
+  GtkTextBuffer *buffer;
+  GArray        *items;
+  gint           dirty_begin;
+  gint           dirty_end;
+  guint          needs_scan : 1;
+  guint          needs_pairing : 1;
+};
+
+static inline Item *
+get_item (IdeBracketIndex *self,
+          guint            index)
+{
+  return &g_array_index (self->items, Item, index);
+}
+
+/* Returns the index of the first item ending at or after @offset */
+static guint
+item_index_for_end (IdeBracketIndex *self,
+                    gint             offset)
+{
+  guint lo = 0;
+  guint hi = self->items->len;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (get_item (self, mid)->end < offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+/* Returns the index of the first item beginning at or after @offset */
+static guint
+item_index_for_begin (IdeBracketIndex *self,
+                      gint             offset)
+{
+  guint lo = 0;
+  guint hi = self->items->len;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (get_item (self, mid)->begin < offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static void
+shift_items (IdeBracketIndex *self,
+             guint            index,
+             gint             delta)
+{
+  for (; index < self->items->len; index++)
+    {
+      Item *item = get_item (self, index);
+
+      item->begin += delta;
+      item->end += delta;
+    }
+}
+
+static void
+lexer_emit (Lexer    *lexer,
+            GArray   *found,
+            ItemKind  kind,
+            guint     type,
+            gboolean  is_open,
+            gint      begin,
+            gint      end)
+{
+  Item item = { 0 };
+
+  item.begin = begin;
+  item.end = end;
+  item.kind = kind;
+  item.type = type;
+  item.is_open = !!is_open;
+  item.partner = -1;
+  item.parent = -1;
+
+  g_array_append_val (found, item);
+}
+
+static void
+lexer_finish_directive (Lexer  *lexer,
+                        GArray *found)
+{
+  static const struct {
+    const gchar *word;
+    Directive    directive;
+  } directives[] = {
+    { "if", DIRECTIVE_IF },
+    { "ifdef", DIRECTIVE_IF },
+    { "ifndef", DIRECTIVE_IF },
+    { "elif", DIRECTIVE_ELIF },
+    { "else", DIRECTIVE_ELSE },
+    { "endif", DIRECTIVE_ENDIF },
+  };
+  guint i;
+
+  if (lexer->word_len < sizeof lexer->word)
+    {
+      lexer->word[lexer->word_len] = '\0';
+
+      for (i = 0; i < G_N_ELEMENTS (directives); i++)
+        {
+          if (strcmp (lexer->word, directives[i].word) == 0)
+            {
+              lexer_emit (lexer, found, ITEM_DIRECTIVE, directives[i].directive, FALSE,
+                          lexer->item_begin, lexer->offset - 1);
+              break;
+            }
+        }
+    }
+
+  lexer->mode = LEX_NORMAL;
+  lexer->prev = 0;
+}
+
+static void
+lexer_feed (Lexer    *lexer,
+            gunichar  ch,
+            GArray   *found)
+{
+  guint i;
+
+  switch (lexer->mode)
+    {
+    case LEX_DIRECTIVE:
+      if (g_ascii_isalpha (ch))
+        {
+          if (lexer->word_len < sizeof lexer->word - 1)
+            lexer->word[lexer->word_len++] = ch;
+          else
+            lexer->word_len = sizeof lexer->word;
+          break;
+        }
+
+      lexer_finish_directive (lexer, found);
+
+      /* @ch is not part of the directive, lex it normally */
+
+    case LEX_NORMAL:
+      if (ch == '\n')
+        {
+          lexer->line_blank = TRUE;
+          lexer->prev = 0;
+          break;
+        }
+
+      if (lexer->prev == '/' && ch == '*')
+        {
+          lexer->mode = LEX_BLOCK_COMMENT;
+          lexer->item_begin = lexer->offset - 1;
+          lexer->prev = 0;
+          break;
+        }
+
+      if (lexer->prev == '/' && ch == '/')
+        {
+          lexer->mode = LEX_LINE_COMMENT;
+          break;
+        }
+
+      if (ch == '"' || ch == '\'')
+        {
+          lexer->mode = LEX_STRING;
+          lexer->quote = ch;
+          lexer->prev = 0;
+          lexer->line_blank = FALSE;
+          break;
+        }
+
+      /* Like the movements, only match "#if" and friends without a space */
+      if (ch == '#' && lexer->line_blank)
+        {
+          lexer->mode = LEX_DIRECTIVE;
+          lexer->item_begin = lexer->offset;
+          lexer->word_len = 0;
+          lexer->line_blank = FALSE;
+          break;
+        }
+
+      for (i = 0; i < N_BRACKETS; i++)
+        {
+          if (ch == brackets[i][0] || ch == brackets[i][1])
+            {
+              lexer_emit (lexer, found, ITEM_BRACKET, i, ch == brackets[i][0],
+                          lexer->offset, lexer->offset);
+              break;
+            }
+        }
+
+      if (!g_unichar_isspace (ch))
+        lexer->line_blank = FALSE;
+
+      lexer->prev = ch;
+      break;
+
+    case LEX_LINE_COMMENT:
+      if (ch == '\n')
+        {
+          lexer->mode = LEX_NORMAL;
+          lexer->line_blank = TRUE;
+          lexer->prev = 0;
+        }
+      break;
+
+    case LEX_BLOCK_COMMENT:
+      if (lexer->prev == '*' && ch == '/')
+        {
+          lexer_emit (lexer, found, ITEM_COMMENT, 0, FALSE, lexer->item_begin, lexer->offset);
+          lexer->mode = LEX_NORMAL;
+          lexer->prev = 0;
+        }
+      else
+        {
+          lexer->prev = ch;
+        }
+      break;
+
+    case LEX_STRING:
+      if (lexer->prev == '\\')
+        {
+          lexer->prev = 0;
+        }
+      else if (ch == lexer->quote)
+        {
+          lexer->mode = LEX_NORMAL;
+          lexer->prev = 0;
+        }
+      else if (ch == '\n')
+        {
+          /* Unterminated, don't let a stray quote run through the buffer */
+          lexer->mode = LEX_NORMAL;
+          lexer->line_blank = TRUE;
+          lexer->prev = 0;
+        }
+      else
+        {
+          lexer->prev = ch;
+        }
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static void
+lexer_feed_range (Lexer         *lexer,
+                  GtkTextBuffer *buffer,
+                  gint           end_offset,
+                  GArray        *found)
+{
+  GtkTextIter begin;
+  GtkTextIter end;
+  const gchar *p;
+  gchar *text;
+
+  if (lexer->offset >= end_offset)
+    return;
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &begin, lexer->offset);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, end_offset);
+  text = gtk_text_iter_get_slice (&begin, &end);
+
+  for (p = text; *p; p = g_utf8_next_char (p))
+    {
+      lexer_feed (lexer, g_utf8_get_char (p), found);
+      lexer->offset++;
+    }
+
+  g_free (text);
+}
+
+static void
+ide_bracket_index_scan (IdeBracketIndex *self)
+{
+  Lexer lexer = { 0 };
+  GArray *found;
+  guint lo_index;
+  guint hi_index;
+  guint step = 1;
+  gint lo;
+
+  g_assert (self != NULL);
+
+  if (!self->needs_scan)
+    return;
+
+  lo_index = item_index_for_end (self, self->dirty_begin - 1);
+  hi_index = MAX (lo_index, item_index_for_begin (self, self->dirty_end));
+  lo = (lo_index > 0) ? get_item (self, lo_index - 1)->end + 1 : 0;
+
+  /* Nothing but the end of an item precedes @lo on its line, if anything */
+  lexer.mode = LEX_NORMAL;
+  lexer.offset = lo;
+  lexer.line_blank = (lo == 0);
+
+  found = g_array_new (FALSE, FALSE, sizeof (Item));
+
+  for (;;)
+    {
+      const Item *next;
+
+      if (hi_index >= self->items->len)
+        {
+          lexer_feed_range (&lexer, self->buffer, gtk_text_buffer_get_char_count (self->buffer), found);
+          if (lexer.mode == LEX_DIRECTIVE)
+            lexer_finish_directive (&lexer, found);
+          break;
+        }
+
+      next = get_item (self, hi_index);
+      lexer_feed_range (&lexer, self->buffer, next->begin, found);
+
+      /*
+       * The previous pass was in its normal state at @next. If we are too,
+       * and nothing about our state would lex @next differently, everything
+       * from here on is unchanged. Otherwise keep going, in growing steps
+       * since an opened comment can swallow much of the buffer.
+       */
+      if (lexer.mode == LEX_NORMAL &&
+          lexer.prev != '/' &&
+          (next->kind != ITEM_DIRECTIVE || lexer.line_blank))
+        break;
+
+      hi_index = MIN (self->items->len, hi_index + step);
+      step *= 2;
+    }
+
+  if (hi_index > lo_index)
+    g_array_remove_range (self->items, lo_index, hi_index - lo_index);
+  g_array_insert_vals (self->items, lo_index, found->data, found->len);
+  g_array_free (found, TRUE);
+
+  self->needs_scan = FALSE;
+  self->needs_pairing = TRUE;
+}
+
+static void
+ide_bracket_index_pair (IdeBracketIndex *self)
+{
+  GArray *stacks[N_BRACKETS];
+  GArray *chains;
+  guint i;
+  guint t;
+
+  g_assert (self != NULL);
+
+  if (!self->needs_pairing)
+    return;
+
+  for (t = 0; t < N_BRACKETS; t++)
+    stacks[t] = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  /* Pairs of the #if starting a chain and the last directive in it */
+  chains = g_array_new (FALSE, FALSE, sizeof (gint) * 2);
+
+  for (i = 0; i < self->items->len; i++)
+    {
+      Item *item = get_item (self, i);
+      gint index = i;
+
+      item->partner = -1;
+      item->parent = -1;
+
+      if (item->kind == ITEM_BRACKET)
+        {
+          GArray *stack = stacks[item->type];
+          gint top = -1;
+
+          if (stack->len > 0)
+            top = g_array_index (stack, gint, stack->len - 1);
+
+          if (item->is_open)
+            {
+              item->parent = top;
+              g_array_append_val (stack, index);
+            }
+          else if (top != -1)
+            {
+              Item *open = get_item (self, top);
+
+              open->partner = index;
+              item->partner = top;
+              item->parent = open->parent;
+              g_array_set_size (stack, stack->len - 1);
+            }
+        }
+      else if (item->kind == ITEM_DIRECTIVE)
+        {
+          gint *chain = NULL;
+
+          if (chains->len > 0)
+            chain = &g_array_index (chains, gint, (chains->len - 1) * 2);
+
+          switch ((Directive)item->type)
+            {
+            case DIRECTIVE_IF:
+              {
+                gint pair[2] = { index, index };
+                g_array_append_val (chains, pair);
+              }
+              break;
+
+            case DIRECTIVE_ELIF:
+            case DIRECTIVE_ELSE:
+              if (chain != NULL)
+                {
+                  get_item (self, chain[1])->partner = index;
+                  chain[1] = index;
+                }
+              break;
+
+            case DIRECTIVE_ENDIF:
+              if (chain != NULL)
+                {
+                  get_item (self, chain[1])->partner = index;
+                  item->partner = chain[0];
+                  g_array_set_size (chains, chains->len - 1);
+                }
+              break;
+
+            default:
+              g_assert_not_reached ();
+            }
+        }
+
+      for (t = 0; t < N_BRACKETS; t++)
+        {
+          GArray *stack = stacks[t];
+
+          item->scope[t] = stack->len ? g_array_index (stack, gint, stack->len - 1) : -1;
+        }
+    }
+
+  for (t = 0; t < N_BRACKETS; t++)
+    g_array_free (stacks[t], TRUE);
+  g_array_free (chains, TRUE);
+
+  self->needs_pairing = FALSE;
+}
+
+static void
+ide_bracket_index_ensure (IdeBracketIndex *self)
+{
+  ide_bracket_index_scan (self);
+  ide_bracket_index_pair (self);
+}
+
+static void
+ide_bracket_index_mark_dirty (IdeBracketIndex *self,
+                              gint             begin,
+                              gint             end)
+{
+  if (self->needs_scan)
+    {
+      self->dirty_begin = MIN (self->dirty_begin, begin);
+      self->dirty_end = MAX (self->dirty_end, end);
+    }
+  else
+    {
+      self->dirty_begin = begin;
+      self->dirty_end = end;
+      self->needs_scan = TRUE;
+    }
+}
+
+/*
+ * Drops the items from @index that begin before @end_offset. Items ending
+ * right before an edit are included too, since text appended to "#if" or
+ * after a "/" can change how they lex.
+ */
+static void
+remove_touched_items (IdeBracketIndex *self,
+                      guint            index,
+                      gint             end_offset)
+{
+  guint n_touched = 0;
+
+  while (index + n_touched < self->items->len &&
+         get_item (self, index + n_touched)->begin < end_offset)
+    n_touched++;
+
+  if (n_touched > 0)
+    g_array_remove_range (self->items, index, n_touched);
+}
+
+static void
+ide_bracket_index_insert_text_cb (GtkTextBuffer   *buffer,
+                                  GtkTextIter     *location,
+                                  const gchar     *text,
+                                  gint             len,
+                                  IdeBracketIndex *self)
+{
+  gint offset;
+  gint n_chars;
+  guint i;
+
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+  g_assert (location != NULL);
+  g_assert (self != NULL);
+
+  offset = gtk_text_iter_get_offset (location);
+  n_chars = g_utf8_strlen (text, len);
+
+  i = item_index_for_end (self, offset - 1);
+  remove_touched_items (self, i, offset);
+  shift_items (self, i, n_chars);
+
+  if (self->needs_scan && self->dirty_end >= offset)
+    self->dirty_end += n_chars;
+
+  ide_bracket_index_mark_dirty (self, offset, offset + n_chars);
+}
+
+static void
+ide_bracket_index_delete_range_cb (GtkTextBuffer   *buffer,
+                                   GtkTextIter     *begin,
+                                   GtkTextIter     *end,
+                                   IdeBracketIndex *self)
+{
+  gint begin_offset;
+  gint end_offset;
+  gint n_chars;
+  guint i;
+
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+  g_assert (begin != NULL);
+  g_assert (end != NULL);
+  g_assert (self != NULL);
+
+  begin_offset = gtk_text_iter_get_offset (begin);
+  end_offset = gtk_text_iter_get_offset (end);
+  n_chars = end_offset - begin_offset;
+
+  if (n_chars <= 0)
+    return;
+
+  i = item_index_for_end (self, begin_offset - 1);
+  remove_touched_items (self, i, end_offset);
+  shift_items (self, i, -n_chars);
+
+  if (self->needs_scan)
+    {
+      if (self->dirty_begin > begin_offset)
+        self->dirty_begin = MAX (begin_offset, self->dirty_begin - n_chars);
+      if (self->dirty_end > begin_offset)
+        self->dirty_end = MAX (begin_offset, self->dirty_end - n_chars);
+    }
+
+  ide_bracket_index_mark_dirty (self, begin_offset, begin_offset);
+}
+
+static void
+ide_bracket_index_free (IdeBracketIndex *self)
+{
+  g_clear_pointer (&self->items, g_array_unref);
+  g_slice_free (IdeBracketIndex, self);
+}
+
+static gboolean
+is_c_family (GtkTextBuffer *buffer)
+{
+  static const gchar *language_ids[] = { "c", "chdr", "cpp", "cpphdr", "objc", NULL };
+  GtkSourceLanguage *language;
+
+  if (!GTK_SOURCE_IS_BUFFER (buffer) ||
+      !(language = gtk_source_buffer_get_language (GTK_SOURCE_BUFFER (buffer))))
+    return FALSE;
+
+  return g_strv_contains (language_ids, gtk_source_language_get_id (language));
+}
+
+/**
+ * ide_bracket_index_get_for_buffer: (skip)
+ * @buffer: A #GtkTextBuffer.
+ *
+ * Gets the bracket index attached to @buffer, creating it the first time.
+ * The index follows edits to @buffer for the lifetime of @buffer.
+ *
+ * Returns: (transfer none) (nullable): An #IdeBracketIndex, or %NULL if
+ *   @buffer is not in a C-family language and should be scanned instead.
+ */
+IdeBracketIndex *
+ide_bracket_index_get_for_buffer (GtkTextBuffer *buffer)
+{
+  IdeBracketIndex *self;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+
+  if (!is_c_family (buffer))
+    return NULL;
+
+  self = g_object_get_data (G_OBJECT (buffer), INDEX_KEY);
+
+  if (self == NULL)
+    {
+      self = g_slice_new0 (IdeBracketIndex);
+      self->buffer = buffer;
+      self->items = g_array_new (FALSE, FALSE, sizeof (Item));
+      self->dirty_begin = 0;
+      self->dirty_end = gtk_text_buffer_get_char_count (buffer);
+      self->needs_scan = TRUE;
+
+      /*
+       * Connect before the default handlers so the iters still describe
+       * the buffer as it was before the edit. The index is freed with the
+       * buffer, so there is nothing to disconnect.
+       */
+      g_signal_connect (buffer,
+                        "insert-text",
+                        G_CALLBACK (ide_bracket_index_insert_text_cb),
+                        self);
+      g_signal_connect (buffer,
+                        "delete-range",
+                        G_CALLBACK (ide_bracket_index_delete_range_cb),
+                        self);
+
+      g_object_set_data_full (G_OBJECT (buffer),
+                              INDEX_KEY,
+                              self,
+                              (GDestroyNotify)ide_bracket_index_free);
+    }
+
+  return self;
+}
+
+static const Item *
+find_item_at (IdeBracketIndex   *self,
+              const GtkTextIter *iter)
+{
+  gint offset;
+  guint i;
+
+  ide_bracket_index_ensure (self);
+
+  offset = gtk_text_iter_get_offset (iter);
+  i = item_index_for_end (self, offset);
+
+  if (i < self->items->len && get_item (self, i)->begin <= offset)
+    return get_item (self, i);
+
+  return NULL;
+}
+
+/**
+ * ide_bracket_index_get_match: (skip)
+ * @self: An #IdeBracketIndex.
+ * @iter: A #GtkTextIter on a bracket or preprocessor conditional.
+ * @match: (out): A location for the match.
+ *
+ * Locates the bracket matching the one at @iter. If @iter is within a
+ * preprocessor conditional, @match is set to the "#" of the next
+ * conditional in the same block, or to the "#if" for an "#endif".
+ *
+ * Brackets within comments and strings are not indexed.
+ *
+ * Returns: %TRUE if @match was set.
+ */
+gboolean
+ide_bracket_index_get_match (IdeBracketIndex   *self,
+                             const GtkTextIter *iter,
+                             GtkTextIter       *match)
+{
+  const Item *item;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+  g_return_val_if_fail (match != NULL, FALSE);
+
+  item = find_item_at (self, iter);
+
+  if (item == NULL || item->kind == ITEM_COMMENT || item->partner == -1)
+    return FALSE;
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, match, get_item (self, item->partner)->begin);
+
+  return TRUE;
+}
+
+/**
+ * ide_bracket_index_get_enclosing: (skip)
+ * @self: An #IdeBracketIndex.
+ * @iter: A #GtkTextIter.
+ * @open_char: One of "(", "[" or "{".
+ * @depth: Which enclosing bracket to locate, starting from 1.
+ * @open: (out): A location for the open bracket.
+ *
+ * Locates the @depth-th bracket of type @open_char that is still open at
+ * @iter. A bracket at @iter does not count as being before @iter. The
+ * bracket does not need to be closed.
+ *
+ * Returns: %TRUE if @open was set.
+ */
+gboolean
+ide_bracket_index_get_enclosing (IdeBracketIndex   *self,
+                                 const GtkTextIter *iter,
+                                 gunichar           open_char,
+                                 guint              depth,
+                                 GtkTextIter       *open)
+{
+  gint index;
+  guint type;
+  guint i;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+  g_return_val_if_fail (open != NULL, FALSE);
+  g_return_val_if_fail (depth > 0, FALSE);
+
+  for (type = 0; type < N_BRACKETS; type++)
+    {
+      if (open_char == (gunichar)brackets[type][0])
+        break;
+    }
+
+  g_return_val_if_fail (type < N_BRACKETS, FALSE);
+
+  ide_bracket_index_ensure (self);
+
+  i = item_index_for_begin (self, gtk_text_iter_get_offset (iter));
+  if (i == 0)
+    return FALSE;
+
+  index = get_item (self, i - 1)->scope[type];
+
+  while (index != -1 && --depth > 0)
+    index = get_item (self, index)->parent;
+
+  if (index == -1)
+    return FALSE;
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, open, get_item (self, index)->begin);
+
+  return TRUE;
+}
+
+/**
+ * ide_bracket_index_get_comment: (skip)
+ * @self: An #IdeBracketIndex.
+ * @iter: A #GtkTextIter.
+ * @begin: (out) (optional): A location for the "/" opening the comment.
+ * @end: (out) (optional): A location for the "/" closing the comment.
+ *
+ * Locates the block comment containing @iter, if any.
+ *
+ * Returns: %TRUE if @iter is within a block comment.
+ */
+gboolean
+ide_bracket_index_get_comment (IdeBracketIndex   *self,
+                               const GtkTextIter *iter,
+                               GtkTextIter       *begin,
+                               GtkTextIter       *end)
+{
+  const Item *item;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  item = find_item_at (self, iter);
+
+  if (item == NULL || item->kind != ITEM_COMMENT)
+    return FALSE;
+
+  if (begin != NULL)
+    gtk_text_buffer_get_iter_at_offset (self->buffer, begin, item->begin);
+  if (end != NULL)
+    gtk_text_buffer_get_iter_at_offset (self->buffer, end, item->end);
+
+  return TRUE;
+}
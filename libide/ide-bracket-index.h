@@ -0,0 +1,44 @@
+/* ide-bracket-index.h
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_BRACKET_INDEX_H
+#define IDE_BRACKET_INDEX_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _IdeBracketIndex IdeBracketIndex;
+
+IdeBracketIndex *ide_bracket_index_get_for_buffer (GtkTextBuffer     *buffer);
+gboolean         ide_bracket_index_get_match      (IdeBracketIndex   *self,
+                                                   const GtkTextIter *iter,
+                                                   GtkTextIter       *match);
+gboolean         ide_bracket_index_get_enclosing  (IdeBracketIndex   *self,
+                                                   const GtkTextIter *iter,
+                                                   gunichar           open_char,
+                                                   guint              depth,
+                                                   GtkTextIter       *open);
+gboolean         ide_bracket_index_get_comment    (IdeBracketIndex   *self,
+                                                   const GtkTextIter *iter,
+                                                   GtkTextIter       *begin,
+                                                   GtkTextIter       *end);
+
+G_END_DECLS
+
+#endif /* IDE_BRACKET_INDEX_H */
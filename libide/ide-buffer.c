@@ -101,6 +101,7 @@ typedef struct
 G_DEFINE_TYPE_WITH_PRIVATE (IdeBuffer, ide_buffer, GTK_SOURCE_TYPE_BUFFER)
 
 EGG_DEFINE_COUNTER (instances, "IdeBuffer", "Instances", "Number of IdeBuffer instances.")
+EGG_DEFINE_COUNTER (diagnoses, "IdeBuffer", "Diagnoses", "Number of diagnose requests dispatched.")
 
 enum {
   PROP_0,
@@ -601,6 +602,8 @@ ide_buffer__diagnose_timeout_cb (gpointer user_data)
       priv->in_diagnose = TRUE;
       g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_BUSY]);
 
+      EGG_COUNTER_INC (diagnoses);
+
       ide_buffer_sync_to_unsaved_files (self);
       ide_diagnostician_diagnose_async (priv->diagnostician,
                                         priv->file,
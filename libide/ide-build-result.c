@@ -711,3 +711,61 @@ ide_build_result_emit_diagnostic (IdeBuildResult *self,
 
   g_timeout_add (0, ide_build_result_emit_diagnostic_cb, pair);
 }
+
+static gboolean
+ide_build_result_emit_diagnostics_cb (gpointer data)
+{
+  struct {
+    IdeBuildResult *result;
+    GPtrArray      *diagnostics;
+  } *pair = data;
+
+  g_assert (pair != NULL);
+  g_assert (IDE_IS_BUILD_RESULT (pair->result));
+  g_assert (pair->diagnostics != NULL);
+
+  for (guint i = 0; i < pair->diagnostics->len; i++)
+    {
+      IdeDiagnostic *diagnostic = g_ptr_array_index (pair->diagnostics, i);
+
+      g_signal_emit (pair->result, signals [DIAGNOSTIC], 0, diagnostic);
+    }
+
+  g_object_unref (pair->result);
+  g_ptr_array_unref (pair->diagnostics);
+  g_slice_free1 (sizeof *pair, pair);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * ide_build_result_emit_diagnostics:
+ * @self: An #IdeBuildResult
+ * @diagnostics: (element-type Ide.Diagnostic): An array of #IdeDiagnostic
+ *
+ * Like ide_build_result_emit_diagnostic() but emits a whole batch of
+ * diagnostics from a single main loop dispatch. This may be called from
+ * any thread. @diagnostics should free its elements with
+ * ide_diagnostic_unref() and must not be modified after calling this.
+ */
+void
+ide_build_result_emit_diagnostics (IdeBuildResult *self,
+                                   GPtrArray      *diagnostics)
+{
+  struct {
+    IdeBuildResult *result;
+    GPtrArray      *diagnostics;
+  } *pair;
+
+  g_return_if_fail (IDE_IS_BUILD_RESULT (self));
+  g_return_if_fail (diagnostics != NULL);
+
+  if (diagnostics->len == 0)
+    return;
+
+  pair = g_slice_alloc0 (sizeof *pair);
+  pair->result = g_object_ref (self);
+  pair->diagnostics = g_ptr_array_ref (diagnostics);
+
+  g_timeout_add (0, ide_build_result_emit_diagnostics_cb, pair);
+}
@@ -57,6 +57,8 @@ void           ide_build_result_set_running       (IdeBuildResult *self,
                                                    gboolean        running);
 void           ide_build_result_emit_diagnostic   (IdeBuildResult *self,
                                                    IdeDiagnostic  *diagnostic);
+void           ide_build_result_emit_diagnostics  (IdeBuildResult *self,
+                                                   GPtrArray      *diagnostics);
 gchar         *ide_build_result_get_mode          (IdeBuildResult *self);
 void           ide_build_result_set_mode          (IdeBuildResult *self,
                                                    const gchar    *mode);
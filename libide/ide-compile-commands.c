@@ -0,0 +1,655 @@
+/* ide-compile-commands.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-compile-commands"
+
+#include <json-glib/json-glib.h>
+#include <string.h>
+
+#include "ide-compile-commands.h"
+#include "ide-debug.h"
+#include "ide-macros.h"
+#include "ide-thread-pool.h"
+
+/**
+ * SECTION:ide-compile-commands
+ * @title: IdeCompileCommands
+ * @short_description: Compilation database for build flags
+ *
+ * #IdeCompileCommands parses a "compile_commands.json" compilation database
+ * as produced by CMake, Meson, Bear and others. The database is read once
+ * into an index keyed by file, so that build flags can be resolved without
+ * spawning the build system for every file that is opened.
+ *
+ * Once loaded, the index is immutable and may be queried from any thread.
+ */
+
+typedef struct
+{
+  volatile gint  ref_count;
+  GFile         *directory;
+  gchar         *command;
+  gchar        **arguments;
+} CompileInfo;
+
+typedef struct
+{
+  GHashTable *info_by_file;
+  GHashTable *info_by_dir;
+} CompileIndex;
+
+struct _IdeCompileCommands
+{
+  GObject     parent_instance;
+
+  GFile      *file;
+
+  /*
+   * Maps GFile of a source file to the CompileInfo used to build it.
+   * The second table maps the parent directory of C-family sources to the
+   * first CompileInfo found there, which we use as a fallback for headers
+   * since they never have an entry of their own.
+   */
+  GHashTable *info_by_file;
+  GHashTable *info_by_dir;
+};
+
+G_DEFINE_TYPE (IdeCompileCommands, ide_compile_commands, G_TYPE_OBJECT)
+
+static const gchar *header_suffixes[] = { ".h", ".hh", ".hpp", ".hxx", ".h++", NULL };
+static const gchar *cxx_suffixes[] = { ".cc", ".cpp", ".cxx", ".c++", ".C", ".hh", ".hpp", ".hxx", ".h++", NULL };
+
+static CompileInfo *
+compile_info_ref (CompileInfo *info)
+{
+  g_assert (info != NULL);
+  g_assert (info->ref_count > 0);
+
+  g_atomic_int_inc (&info->ref_count);
+
+  return info;
+}
+
+static void
+compile_info_unref (CompileInfo *info)
+{
+  g_assert (info != NULL);
+  g_assert (info->ref_count > 0);
+
+  if (g_atomic_int_dec_and_test (&info->ref_count))
+    {
+      g_clear_object (&info->directory);
+      g_clear_pointer (&info->command, g_free);
+      g_clear_pointer (&info->arguments, g_strfreev);
+      g_slice_free (CompileInfo, info);
+    }
+}
+
+static void
+compile_index_free (gpointer data)
+{
+  CompileIndex *index = data;
+
+  g_clear_pointer (&index->info_by_file, g_hash_table_unref);
+  g_clear_pointer (&index->info_by_dir, g_hash_table_unref);
+  g_slice_free (CompileIndex, index);
+}
+
+static gboolean
+has_suffix (const gchar  *path,
+            const gchar **suffixes)
+{
+  guint i;
+
+  for (i = 0; suffixes [i]; i++)
+    {
+      if (g_str_has_suffix (path, suffixes [i]))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static CompileIndex *
+ide_compile_commands_build_index (GFile         *file,
+                                  GCancellable  *cancellable,
+                                  GError       **error)
+{
+  g_autoptr(JsonParser) parser = NULL;
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autofree gchar *path = NULL;
+  CompileIndex *index;
+  JsonArray *ar;
+  JsonNode *root;
+  guint n_items;
+  guint i;
+
+  IDE_ENTRY;
+
+  g_assert (G_IS_FILE (file));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  if (!(path = g_file_get_path (file)))
+    {
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_NOT_SUPPORTED,
+                   "Compilation databases must be on a local filesystem");
+      IDE_RETURN (NULL);
+    }
+
+  /*
+   * Compilation databases for large projects can be tens of megabytes, so
+   * map the file rather than reading it into a heap allocation. The parser
+   * only needs the contents for the duration of the parse.
+   */
+  if (!(mapped = g_mapped_file_new (path, FALSE, error)))
+    IDE_RETURN (NULL);
+
+  parser = json_parser_new ();
+
+  if (!json_parser_load_from_data (parser,
+                                   g_mapped_file_get_contents (mapped),
+                                   g_mapped_file_get_length (mapped),
+                                   error))
+    IDE_RETURN (NULL);
+
+  if (NULL == (root = json_parser_get_root (parser)) || !JSON_NODE_HOLDS_ARRAY (root))
+    {
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_INVALID_DATA,
+                   "Compilation database must contain an array");
+      IDE_RETURN (NULL);
+    }
+
+  index = g_slice_new0 (CompileIndex);
+  index->info_by_file = g_hash_table_new_full (g_file_hash,
+                                               (GEqualFunc)g_file_equal,
+                                               g_object_unref,
+                                               (GDestroyNotify)compile_info_unref);
+  index->info_by_dir = g_hash_table_new_full (g_file_hash,
+                                              (GEqualFunc)g_file_equal,
+                                              g_object_unref,
+                                              (GDestroyNotify)compile_info_unref);
+
+  ar = json_node_get_array (root);
+  n_items = json_array_get_length (ar);
+
+  for (i = 0; i < n_items; i++)
+    {
+      g_autoptr(GFile) source = NULL;
+      CompileInfo *info;
+      const gchar *directory;
+      const gchar *filename;
+      JsonObject *obj;
+      JsonNode *node;
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+        {
+          compile_index_free (index);
+          IDE_RETURN (NULL);
+        }
+
+      node = json_array_get_element (ar, i);
+
+      if (!JSON_NODE_HOLDS_OBJECT (node))
+        continue;
+
+      obj = json_node_get_object (node);
+
+      if (!json_object_has_member (obj, "directory") || !json_object_has_member (obj, "file"))
+        continue;
+
+      directory = json_object_get_string_member (obj, "directory");
+      filename = json_object_get_string_member (obj, "file");
+
+      if (directory == NULL || filename == NULL)
+        continue;
+
+      info = g_slice_new0 (CompileInfo);
+      info->ref_count = 1;
+      info->directory = g_file_new_for_path (directory);
+
+      if (json_object_has_member (obj, "arguments"))
+        {
+          JsonArray *args = json_object_get_array_member (obj, "arguments");
+          guint n_args = args ? json_array_get_length (args) : 0;
+          guint j;
+
+          info->arguments = g_new0 (gchar *, n_args + 1);
+
+          for (j = 0; j < n_args; j++)
+            info->arguments [j] = g_strdup (json_array_get_string_element (args, j));
+        }
+      else if (json_object_has_member (obj, "command"))
+        {
+          info->command = g_strdup (json_object_get_string_member (obj, "command"));
+        }
+
+      if (info->arguments == NULL && info->command == NULL)
+        {
+          compile_info_unref (info);
+          continue;
+        }
+
+      if (g_path_is_absolute (filename))
+        source = g_file_new_for_path (filename);
+      else
+        source = g_file_resolve_relative_path (info->directory, filename);
+
+      if (!has_suffix (filename, header_suffixes))
+        {
+          g_autoptr(GFile) parent = g_file_get_parent (source);
+
+          if (parent != NULL && !g_hash_table_contains (index->info_by_dir, parent))
+            g_hash_table_insert (index->info_by_dir,
+                                 g_steal_pointer (&parent),
+                                 compile_info_ref (info));
+        }
+
+      g_hash_table_insert (index->info_by_file, g_steal_pointer (&source), info);
+    }
+
+  IDE_TRACE_MSG ("Indexed %u compile commands from %s",
+                 g_hash_table_size (index->info_by_file), path);
+
+  IDE_RETURN (index);
+}
+
+static void
+ide_compile_commands_set_index (IdeCompileCommands *self,
+                                GFile              *file,
+                                CompileIndex       *index)
+{
+  g_assert (IDE_IS_COMPILE_COMMANDS (self));
+  g_assert (G_IS_FILE (file));
+  g_assert (index != NULL);
+
+  g_set_object (&self->file, file);
+
+  g_clear_pointer (&self->info_by_file, g_hash_table_unref);
+  g_clear_pointer (&self->info_by_dir, g_hash_table_unref);
+
+  self->info_by_file = g_steal_pointer (&index->info_by_file);
+  self->info_by_dir = g_steal_pointer (&index->info_by_dir);
+}
+
+static void
+ide_compile_commands_finalize (GObject *object)
+{
+  IdeCompileCommands *self = (IdeCompileCommands *)object;
+
+  g_clear_object (&self->file);
+  g_clear_pointer (&self->info_by_file, g_hash_table_unref);
+  g_clear_pointer (&self->info_by_dir, g_hash_table_unref);
+
+  G_OBJECT_CLASS (ide_compile_commands_parent_class)->finalize (object);
+}
+
+static void
+ide_compile_commands_class_init (IdeCompileCommandsClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = ide_compile_commands_finalize;
+}
+
+static void
+ide_compile_commands_init (IdeCompileCommands *self)
+{
+}
+
+IdeCompileCommands *
+ide_compile_commands_new (void)
+{
+  return g_object_new (IDE_TYPE_COMPILE_COMMANDS, NULL);
+}
+
+/**
+ * ide_compile_commands_get_file:
+ *
+ * Gets the file that was loaded with ide_compile_commands_load().
+ *
+ * Returns: (transfer none) (nullable): A #GFile or %NULL.
+ */
+GFile *
+ide_compile_commands_get_file (IdeCompileCommands *self)
+{
+  g_return_val_if_fail (IDE_IS_COMPILE_COMMANDS (self), NULL);
+
+  return self->file;
+}
+
+/**
+ * ide_compile_commands_load:
+ * @self: An #IdeCompileCommands
+ * @file: A #GFile containing a "compile_commands.json"
+ * @cancellable: (nullable): A #GCancellable or %NULL
+ * @error: A location for a #GError or %NULL
+ *
+ * Synchronously loads the compilation database found in @file.
+ *
+ * This may block, so you probably want ide_compile_commands_load_async().
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ */
+gboolean
+ide_compile_commands_load (IdeCompileCommands  *self,
+                           GFile               *file,
+                           GCancellable        *cancellable,
+                           GError             **error)
+{
+  CompileIndex *index;
+
+  g_return_val_if_fail (IDE_IS_COMPILE_COMMANDS (self), FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable), FALSE);
+
+  if (!(index = ide_compile_commands_build_index (file, cancellable, error)))
+    return FALSE;
+
+  ide_compile_commands_set_index (self, file, index);
+  compile_index_free (index);
+
+  return TRUE;
+}
+
+static void
+ide_compile_commands_load_worker (GTask        *task,
+                                  gpointer      source_object,
+                                  gpointer      task_data,
+                                  GCancellable *cancellable)
+{
+  GFile *file = task_data;
+  CompileIndex *index;
+  GError *error = NULL;
+
+  IDE_ENTRY;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (IDE_IS_COMPILE_COMMANDS (source_object));
+  g_assert (G_IS_FILE (file));
+
+  /*
+   * We build the index into a separate structure and only swap it into
+   * the instance from the main thread in load_finish(). That way lookups
+   * racing with a reload always see a consistent index.
+   */
+  if (!(index = ide_compile_commands_build_index (file, cancellable, &error)))
+    g_task_return_error (task, error);
+  else
+    g_task_return_pointer (task, index, compile_index_free);
+
+  IDE_EXIT;
+}
+
+void
+ide_compile_commands_load_async (IdeCompileCommands  *self,
+                                 GFile               *file,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  IDE_ENTRY;
+
+  g_return_if_fail (IDE_IS_COMPILE_COMMANDS (self));
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, ide_compile_commands_load_async);
+  g_task_set_task_data (task, g_object_ref (file), g_object_unref);
+
+  ide_thread_pool_push_task (IDE_THREAD_POOL_COMPILER,
+                             task,
+                             ide_compile_commands_load_worker);
+
+  IDE_EXIT;
+}
+
+gboolean
+ide_compile_commands_load_finish (IdeCompileCommands  *self,
+                                  GAsyncResult        *result,
+                                  GError             **error)
+{
+  GTask *task = (GTask *)result;
+  CompileIndex *index;
+
+  IDE_ENTRY;
+
+  g_return_val_if_fail (IDE_IS_COMPILE_COMMANDS (self), FALSE);
+  g_return_val_if_fail (G_IS_TASK (task), FALSE);
+
+  if (!(index = g_task_propagate_pointer (task, error)))
+    IDE_RETURN (FALSE);
+
+  ide_compile_commands_set_index (self, g_task_get_task_data (task), index);
+  compile_index_free (index);
+
+  IDE_RETURN (TRUE);
+}
+
+static void
+ide_compile_commands_filter_include (GPtrArray   *ret,
+                                     GFile       *directory,
+                                     const gchar *part1,
+                                     const gchar *part2)
+{
+  g_autoptr(GFile) child = NULL;
+  g_autofree gchar *path = NULL;
+
+  g_assert (ret != NULL);
+  g_assert (G_IS_FILE (directory));
+  g_assert (part1 != NULL);
+  g_assert (part2 != NULL);
+
+  /*
+   * Include paths in the database are relative to the "directory" of the
+   * entry (where the compiler was run), but clang will be run from our own
+   * working directory, so make everything absolute.
+   */
+  if (g_path_is_absolute (part2))
+    {
+      g_ptr_array_add (ret, g_strdup_printf ("%s%s", part1, part2));
+      return;
+    }
+
+  child = g_file_resolve_relative_path (directory, part2);
+  path = g_file_get_path (child);
+
+  g_ptr_array_add (ret, g_strdup_printf ("%s%s", part1, path));
+}
+
+static gchar **
+ide_compile_commands_filter (CompileInfo  *info,
+                             GFile        *file,
+                             GError      **error)
+{
+  g_auto(GStrv) parsed = NULL;
+  g_autoptr(GPtrArray) ret = NULL;
+  g_autofree gchar *path = NULL;
+  const gchar * const *argv;
+  gboolean has_language = FALSE;
+  guint argc;
+  guint i;
+
+  g_assert (info != NULL);
+  g_assert (G_IS_FILE (file));
+
+  if (info->arguments != NULL)
+    {
+      argv = (const gchar * const *)info->arguments;
+    }
+  else
+    {
+      if (!g_shell_parse_argv (info->command, NULL, &parsed, error))
+        return NULL;
+      argv = (const gchar * const *)parsed;
+    }
+
+  argc = g_strv_length ((gchar **)argv);
+  ret = g_ptr_array_new_with_free_func (g_free);
+  path = g_file_get_path (file);
+
+  for (i = 1; i < argc; i++)
+    {
+      const gchar *flag = argv [i];
+      const gchar *next = (i + 1 < argc) ? argv [i + 1] : NULL;
+
+      if (strlen (flag) < 2 || flag [0] != '-')
+        continue;
+
+      if (g_str_has_prefix (flag, "-isystem") ||
+          g_str_has_prefix (flag, "-iquote") ||
+          g_str_has_prefix (flag, "-include"))
+        {
+          const gchar *prefix = g_str_has_prefix (flag, "-isystem") ? "-isystem" :
+                                g_str_has_prefix (flag, "-iquote") ? "-iquote" : "-include";
+
+          if (flag [strlen (prefix)] != '\0')
+            ide_compile_commands_filter_include (ret, info->directory, prefix, flag + strlen (prefix));
+          else if (next != NULL)
+            {
+              g_ptr_array_add (ret, g_strdup (prefix));
+              ide_compile_commands_filter_include (ret, info->directory, "", next);
+              i++;
+            }
+
+          continue;
+        }
+
+      switch (flag [1])
+        {
+        case 'I': /* -I./includes/ -I ./includes/ */
+          if (flag [2] != '\0')
+            ide_compile_commands_filter_include (ret, info->directory, "-I", flag + 2);
+          else if (next != NULL)
+            {
+              ide_compile_commands_filter_include (ret, info->directory, "-I", next);
+              i++;
+            }
+          break;
+
+        case 'W': /* -Werror... but not -Wl,... -Wp,... -Wa,... */
+          if (g_ascii_isalpha (flag [2]) && flag [3] == ',')
+            break;
+          /* fall through */
+
+        case 'f': /* -fPIC... */
+        case 'm': /* -m64 -mtune=native */
+          g_ptr_array_add (ret, g_strdup (flag));
+          break;
+
+        case 'x': /* -xc++ -x c++ */
+          has_language = TRUE;
+          /* fall through */
+
+        case 'D': /* -Dfoo -D foo */
+        case 'U': /* -Ufoo -U foo */
+          g_ptr_array_add (ret, g_strdup (flag));
+          if (flag [2] == '\0' && next != NULL)
+            {
+              g_ptr_array_add (ret, g_strdup (next));
+              i++;
+            }
+          break;
+
+        default:
+          if (g_str_has_prefix (flag, "-std="))
+            g_ptr_array_add (ret, g_strdup (flag));
+          break;
+        }
+    }
+
+  /*
+   * The compiler driver decides the language for us, but we only keep the
+   * flags clang needs to parse the file, so make the language explicit
+   * unless the command already did.
+   */
+  if (!has_language &&
+      ((argc > 0 && g_str_has_suffix (argv [0], "++")) ||
+       (path != NULL && has_suffix (path, cxx_suffixes))))
+    g_ptr_array_insert (ret, 0, g_strdup ("-xc++"));
+
+  g_ptr_array_add (ret, NULL);
+
+  return (gchar **)g_ptr_array_free (g_steal_pointer (&ret), FALSE);
+}
+
+/**
+ * ide_compile_commands_lookup:
+ * @self: An #IdeCompileCommands
+ * @file: A #GFile to lookup
+ * @error: A location for a #GError or %NULL
+ *
+ * Locates the build flags needed to parse @file from the loaded compilation
+ * database. Only flags that affect parsing (include paths, defines, language
+ * standard, etc) are returned, with relative paths made absolute.
+ *
+ * Headers do not have entries in compilation databases, so for those the
+ * flags of a source file in the same directory are used.
+ *
+ * This function does no I/O and may be called from any thread once the
+ * database has been loaded.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): A #GStrv of flags
+ *   or %NULL and @error is set.
+ */
+gchar **
+ide_compile_commands_lookup (IdeCompileCommands  *self,
+                             GFile               *file,
+                             GError             **error)
+{
+  CompileInfo *info = NULL;
+
+  g_return_val_if_fail (IDE_IS_COMPILE_COMMANDS (self), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  if (self->info_by_file != NULL)
+    info = g_hash_table_lookup (self->info_by_file, file);
+
+  if (info == NULL && self->info_by_dir != NULL)
+    {
+      g_autofree gchar *name = g_file_get_basename (file);
+
+      if (name != NULL && has_suffix (name, header_suffixes))
+        {
+          g_autoptr(GFile) parent = g_file_get_parent (file);
+
+          if (parent != NULL)
+            info = g_hash_table_lookup (self->info_by_dir, parent);
+        }
+    }
+
+  if (info == NULL)
+    {
+      g_autofree gchar *uri = g_file_get_uri (file);
+
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_NOT_FOUND,
+                   "Failed to locate build flags for %s",
+                   uri);
+      return NULL;
+    }
+
+  return ide_compile_commands_filter (info, file, error);
+}
@@ -30,6 +30,15 @@ G_BEGIN_DECLS
 #define IDE_IS_COMPLETION_PROVIDER(o)            (G_TYPE_CHECK_INSTANCE_TYPE((o),    IDE_TYPE_COMPLETION_PROVIDER))
 #define IDE_COMPLETION_PROVIDER_GET_INTERFACE(o) (G_TYPE_INSTANCE_GET_INTERFACE((o), IDE_TYPE_COMPLETION_PROVIDER, IdeCompletionProviderIface))
 
+/**
+ * IDE_COMPLETION_PROVIDER_MAX_VISIBLE_PROPOSALS:
+ *
+ * The number of proposals a provider should give to GtkSourceCompletion at
+ * most. It creates a row for every proposal it is given, and anything past
+ * the best few hundred matches is not going to be scrolled to anyway.
+ */
+#define IDE_COMPLETION_PROVIDER_MAX_VISIBLE_PROPOSALS 500
+
 typedef struct _IdeCompletionProvider          IdeCompletionProvider;
 typedef struct _IdeCompletionProviderInterface IdeCompletionProviderInterface;
 
@@ -21,6 +21,7 @@
 #include <glib/gi18n.h>
 #include <string.h>
 
+#include "egg-counter.h"
 #include "egg-signal-group.h"
 
 #include "ide-debug.h"
@@ -58,6 +59,9 @@ struct _IdeHighlightEngine
 
 G_DEFINE_TYPE (IdeHighlightEngine, ide_highlight_engine, IDE_TYPE_OBJECT)
 
+EGG_DEFINE_COUNTER (ticks, "IdeHighlightEngine", "Ticks", "Number of highlight quanta processed.")
+EGG_DEFINE_COUNTER (queued, "IdeHighlightEngine", "Queued", "Number of engines with pending highlight work.")
+
 enum {
   PROP_0,
   PROP_BUFFER,
@@ -311,6 +315,8 @@ ide_highlight_engine_tick (IdeHighlightEngine *self)
   g_assert (self->invalid_begin != NULL);
   g_assert (self->invalid_end != NULL);
 
+  EGG_COUNTER_INC (ticks);
+
   self->quanta_expiration = g_get_monotonic_time () + HIGHLIGHT_QUANTA_USEC;
 
   buffer = GTK_TEXT_BUFFER (self->buffer);
@@ -374,6 +380,8 @@ ide_highlight_engine_work_timeout_handler (gpointer data)
 
   self->work_timeout = 0;
 
+  EGG_COUNTER_DEC (queued);
+
   return G_SOURCE_REMOVE;
 }
 
@@ -389,6 +397,8 @@ ide_highlight_engine_queue_work (IdeHighlightEngine *self)
                                                    ide_highlight_engine_work_timeout_handler,
                                                    self,
                                                    NULL);
+
+  EGG_COUNTER_INC (queued);
 }
 
 static gboolean
@@ -450,6 +460,7 @@ ide_highlight_engine_reload (IdeHighlightEngine *self)
     {
       g_source_remove (self->work_timeout);
       self->work_timeout = 0;
+      EGG_COUNTER_DEC (queued);
     }
 
   if (self->buffer == NULL)
@@ -665,6 +676,7 @@ ide_highlight_engine__unbind_buffer_cb (IdeHighlightEngine  *self,
     {
       g_source_remove (self->work_timeout);
       self->work_timeout = 0;
+      EGG_COUNTER_DEC (queued);
     }
 
   g_object_set_qdata (G_OBJECT (text_buffer), engineQuark, NULL);
@@ -61,6 +61,8 @@ void                _ide_runtime_manager_unload             (IdeRuntimeManager
 void                _ide_search_context_add_provider        (IdeSearchContext      *context,
                                                              IdeSearchProvider     *provider,
                                                              gsize                  max_results);
+void                _ide_search_context_set_previous        (IdeSearchContext      *context,
+                                                             IdeSearchContext      *previous);
 void                _ide_service_emit_context_loaded        (IdeService            *service);
 IdeSettings        *_ide_settings_new                       (IdeContext            *context,
                                                              const gchar           *schema_id,
@@ -18,9 +18,6 @@
 
 #define G_LOG_DOMAIN "ide-pattern-spec"
 
-#ifndef _GNU_SOURCE
-# define _GNU_SOURCE
-#endif
 #include <string.h>
 
 #include "egg-counter.h"
@@ -41,26 +38,54 @@ EGG_DEFINE_COUNTER (instances, "IdePatternSpec", "Instances", "Number of IdePatt
  * case sensitivity is used.
  */
 
+typedef struct
+{
+  /* Lowercased unless the spec is case-sensitive */
+  gchar *text;
+  gsize  len;
+  guint  is_ascii : 1;
+} IdePatternPart;
+
 struct _IdePatternSpec
 {
   volatile gint   ref_count;
   gchar          *needle;
-  gchar         **parts;
+  IdePatternPart *parts;
+  guint           n_parts;
   guint           case_sensitive : 1;
 };
 
+static inline gboolean
+is_word_break (gchar ch)
+{
+  return (ch == ' ' || ch == '_' || ch == '-');
+}
+
+static gboolean
+str_is_ascii (const gchar *str)
+{
+  for (; *str; str++)
+    {
+      if ((guchar)*str >= 0x80)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 IdePatternSpec *
 ide_pattern_spec_new (const gchar *needle)
 {
   IdePatternSpec *self;
+  g_auto(GStrv) parts = NULL;
   const gchar *tmp;
+  guint i;
 
   g_return_val_if_fail (needle, NULL);
 
   self = g_new0 (IdePatternSpec, 1);
   self->ref_count = 1;
   self->needle = g_strdup (needle);
-  self->parts = g_strsplit (needle, " ", 0);
   self->case_sensitive = FALSE;
 
   for (tmp = needle; *tmp; tmp = g_utf8_next_char (tmp))
@@ -72,6 +97,34 @@ ide_pattern_spec_new (const gchar *needle)
         }
     }
 
+  /*
+   * Compile the needle up front so that matching (which happens for every
+   * row on every keystroke) does not need to allocate or casefold it again.
+   * Empty parts (from repeated spaces) never affect the result.
+   */
+  parts = g_strsplit (needle, " ", 0);
+  self->parts = g_new0 (IdePatternPart, g_strv_length (parts));
+
+  for (i = 0; parts [i]; i++)
+    {
+      IdePatternPart *part;
+
+      if (parts [i][0] == '\0')
+        continue;
+
+      part = &self->parts [self->n_parts++];
+      part->is_ascii = str_is_ascii (parts [i]);
+
+      if (self->case_sensitive)
+        part->text = g_strdup (parts [i]);
+      else if (part->is_ascii)
+        part->text = g_ascii_strdown (parts [i], -1);
+      else
+        part->text = g_utf8_strdown (parts [i], -1);
+
+      part->len = strlen (part->text);
+    }
+
   EGG_COUNTER_INC (instances);
 
   return self;
@@ -88,69 +141,155 @@ ide_pattern_spec_get_text (IdePatternSpec *self)
 static void
 ide_pattern_spec_free (IdePatternSpec *self)
 {
-  g_strfreev (self->parts);
+  guint i;
+
+  for (i = 0; i < self->n_parts; i++)
+    g_free (self->parts [i].text);
+
+  g_free (self->parts);
   g_free (self->needle);
   g_free (self);
 
   EGG_COUNTER_DEC (instances);
 }
 
-static inline gboolean
-is_word_break (gunichar ch)
+static const gchar *
+next_word_start (const gchar *haystack,
+                 const gchar *end)
 {
-  return (ch == ' ' || ch == '_' || ch == '-');
+  /* Word breaks are ASCII, so we can walk bytes rather than characters. */
+  while (haystack < end && !is_word_break (*haystack))
+    haystack++;
+
+  while (haystack < end && is_word_break (*haystack))
+    haystack++;
+
+  return haystack;
 }
 
 static const gchar *
-next_word_start (const gchar *haystack)
+find_exact (const gchar          *haystack,
+            const gchar          *end,
+            const IdePatternPart *part)
 {
-  for (; *haystack; haystack = g_utf8_next_char (haystack))
+  const gchar *p = haystack;
+
+  while ((gsize)(end - p) >= part->len &&
+         NULL != (p = memchr (p, part->text [0], end - p - part->len + 1)))
     {
-      gunichar ch = g_utf8_get_char (haystack);
+      if (memcmp (p, part->text, part->len) == 0)
+        return p;
+      p++;
+    }
+
+  return NULL;
+}
+
+static const gchar *
+find_ascii_casefold (const gchar          *haystack,
+                     const gchar          *end,
+                     const IdePatternPart *part)
+{
+  const gchar *last;
+  gchar lower;
+  gchar upper;
 
-      if (is_word_break (ch))
-        break;
+  if ((gsize)(end - haystack) < part->len)
+    return NULL;
+
+  last = end - part->len;
+  lower = part->text [0];
+  upper = g_ascii_toupper (lower);
+
+  /*
+   * The needle is ASCII, so comparing bytes is correct even when the
+   * haystack contains UTF-8, as multi-byte sequences never match ASCII.
+   */
+
+  if (lower == upper)
+    {
+      /* Without a case to fold for the first byte, let memchr() skip. */
+      for (const gchar *p = haystack;
+           p <= last && NULL != (p = memchr (p, lower, last - p + 1));
+           p++)
+        {
+          if (g_ascii_strncasecmp (p + 1, part->text + 1, part->len - 1) == 0)
+            return p;
+        }
+    }
+  else
+    {
+      for (const gchar *p = haystack; p <= last; p++)
+        {
+          if ((*p == lower || *p == upper) &&
+              g_ascii_strncasecmp (p + 1, part->text + 1, part->len - 1) == 0)
+            return p;
+        }
     }
 
-  for (; *haystack; haystack = g_utf8_next_char (haystack))
+  return NULL;
+}
+
+static const gchar *
+find_unicode_casefold (const gchar           *haystack,
+                       const gchar           *end,
+                       const IdePatternPart  *part,
+                       const gchar          **match_end)
+{
+  for (const gchar *p = haystack; p < end; p = g_utf8_next_char (p))
     {
-      gunichar ch = g_utf8_get_char (haystack);
+      const gchar *h = p;
+      const gchar *n = part->text;
 
-      if (is_word_break (ch))
-        continue;
+      while (*n != '\0' && h < end &&
+             g_unichar_tolower (g_utf8_get_char (h)) == g_utf8_get_char (n))
+        {
+          h = g_utf8_next_char (h);
+          n = g_utf8_next_char (n);
+        }
 
-      break;
+      if (*n == '\0')
+        {
+          *match_end = h;
+          return p;
+        }
     }
 
-  g_return_val_if_fail (*haystack == '\0' || !is_word_break (*haystack), NULL);
-
-  return haystack;
+  return NULL;
 }
 
 gboolean
 ide_pattern_spec_match (IdePatternSpec *self,
                         const gchar    *haystack)
 {
-  gsize i;
+  const gchar *end;
+  guint i;
 
   g_return_val_if_fail (self, FALSE);
   g_return_val_if_fail (haystack, FALSE);
 
-  for (i = 0; (haystack != NULL) && self->parts [i]; i++)
+  end = haystack + strlen (haystack);
+
+  for (i = 0; i < self->n_parts; i++)
     {
-      if (self->parts [i][0] == '\0')
-        continue;
+      const IdePatternPart *part = &self->parts [i];
+      const gchar *match_end = NULL;
 
       if (self->case_sensitive)
-        haystack = strstr (haystack, self->parts [i]);
+        haystack = find_exact (haystack, end, part);
+      else if (part->is_ascii)
+        haystack = find_ascii_casefold (haystack, end, part);
       else
-        haystack = strcasestr (haystack, self->parts [i]);
+        haystack = find_unicode_casefold (haystack, end, part, &match_end);
 
       if (haystack == NULL)
         return FALSE;
 
-      if (self->parts [i + 1] != NULL)
-        haystack = next_word_start (haystack + strlen (self->parts [i]));
+      if (match_end == NULL)
+        match_end = haystack + part->len;
+
+      if (i + 1 < self->n_parts)
+        haystack = next_word_start (match_end, end);
     }
 
   return TRUE;
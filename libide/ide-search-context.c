@@ -18,24 +18,90 @@
 
 #define G_LOG_DOMAIN "ide-search-context"
 
+#include <string.h>
+
+#include "egg-counter.h"
+
+#include "ide-completion-item.h"
 #include "ide-debug.h"
+#include "ide-internal.h"
 #include "ide-search-context.h"
 #include "ide-search-provider.h"
 #include "ide-search-result.h"
 
+/*
+ * Providers that have not completed within this budget no longer hold back
+ * the "completed" signal, so a single slow provider cannot delay the whole
+ * search. Results they deliver afterwards are still added until the query
+ * is cancelled.
+ */
+#define DEFAULT_PROVIDER_BUDGET_MSEC 250
+
+typedef struct
+{
+  IdeSearchContext  *context;
+  IdeSearchProvider *provider;
+
+  /* Results provided for this query, in the order they were added. */
+  GPtrArray         *results;
+
+  /*
+   * Results carried over from the previous query (when this query extends
+   * it) that still match. They are shown immediately and replaced as soon
+   * as the provider delivers its own results.
+   */
+  GPtrArray         *carried;
+
+  gint64             begin_time;
+  guint              timeout_id;
+
+  /* The provider notified completion. */
+  guint              completed : 1;
+
+  /* The budget expired first, the provider no longer counts as in progress. */
+  guint              timed_out : 1;
+} ProviderInfo;
+
 struct _IdeSearchContext
 {
-  IdeObject     parent_instance;
+  IdeObject         parent_instance;
+
+  GCancellable     *cancellable;
+  GList            *providers;
+  GPtrArray        *infos;
+  IdeSearchContext *previous;
+  gchar            *search_terms;
+  gsize             max_results;
+  guint             in_progress;
+  guint             executed : 1;
+};
 
-  GCancellable *cancellable;
-  GList        *providers;
-  gsize         max_results;
-  guint         in_progress;
-  guint         executed : 1;
+/*
+ * Latency histogram buckets, in milliseconds. The last bucket catches
+ * providers that exceeded their budget but completed later on.
+ */
+static const struct {
+  gint64       msec;
+  const gchar *name;
+} latency_buckets[] = {
+  { 16,         "<16ms" },
+  { 50,         "<50ms" },
+  { 100,        "<100ms" },
+  { 250,        "<250ms" },
+  { G_MAXINT64, ">250ms" },
 };
 
+typedef struct
+{
+  EggCounter buckets [G_N_ELEMENTS (latency_buckets)];
+  EggCounter timeouts;
+} LatencyCounters;
+
 G_DEFINE_TYPE (IdeSearchContext, ide_search_context, IDE_TYPE_OBJECT)
 
+EGG_DEFINE_COUNTER (searches, "Search", "Searches", "Number of searches executed")
+EGG_DEFINE_COUNTER (carried_results, "Search", "Carried Results", "Results reused from the previous query")
+
 enum {
   COMPLETED,
   COUNT_SET,
@@ -46,6 +112,194 @@ enum {
 
 static guint signals [LAST_SIGNAL];
 
+static LatencyCounters *
+get_latency_counters (IdeSearchProvider *provider)
+{
+  static GHashTable *counters;
+  LatencyCounters *ret;
+  const gchar *type_name;
+  GType type;
+  guint i;
+
+  g_assert (IDE_IS_SEARCH_PROVIDER (provider));
+
+  /*
+   * Counters cannot be unregistered, so we create a set per provider type
+   * the first time we see it and keep it for the life of the process.
+   * This is only ever called from the main thread.
+   */
+
+  if (counters == NULL)
+    counters = g_hash_table_new (NULL, NULL);
+
+  type = G_OBJECT_TYPE (provider);
+
+  if (NULL != (ret = g_hash_table_lookup (counters, GSIZE_TO_POINTER (type))))
+    return ret;
+
+  type_name = g_type_name (type);
+  ret = g_new0 (LatencyCounters, 1);
+
+  for (i = 0; i < G_N_ELEMENTS (latency_buckets); i++)
+    {
+      ret->buckets [i].category = "Search Latency";
+      ret->buckets [i].name = g_strdup_printf ("%s %s", type_name, latency_buckets [i].name);
+      ret->buckets [i].description = "Number of queries completed within the latency bucket";
+      egg_counter_arena_register (egg_counter_arena_get_default (), &ret->buckets [i]);
+    }
+
+  ret->timeouts.category = "Search Latency";
+  ret->timeouts.name = g_strdup_printf ("%s Timeout", type_name);
+  ret->timeouts.description = "Number of queries that exceeded the latency budget";
+  egg_counter_arena_register (egg_counter_arena_get_default (), &ret->timeouts);
+
+  g_hash_table_insert (counters, GSIZE_TO_POINTER (type), ret);
+
+  return ret;
+}
+
+static void
+provider_info_free (gpointer data)
+{
+  ProviderInfo *info = data;
+
+  if (info->timeout_id != 0)
+    {
+      g_source_remove (info->timeout_id);
+      info->timeout_id = 0;
+    }
+
+  g_clear_pointer (&info->results, g_ptr_array_unref);
+  g_clear_pointer (&info->carried, g_ptr_array_unref);
+  g_clear_object (&info->provider);
+  g_slice_free (ProviderInfo, info);
+}
+
+static ProviderInfo *
+ide_search_context_find_info (IdeSearchContext  *self,
+                              IdeSearchProvider *provider)
+{
+  guint i;
+
+  g_assert (IDE_IS_SEARCH_CONTEXT (self));
+  g_assert (IDE_IS_SEARCH_PROVIDER (provider));
+
+  for (i = 0; i < self->infos->len; i++)
+    {
+      ProviderInfo *info = g_ptr_array_index (self->infos, i);
+
+      if (info->provider == provider)
+        return info;
+    }
+
+  return NULL;
+}
+
+static void
+ide_search_context_flush_carried (IdeSearchContext *self,
+                                  ProviderInfo     *info)
+{
+  g_autoptr(GPtrArray) carried = NULL;
+  guint i;
+
+  g_assert (IDE_IS_SEARCH_CONTEXT (self));
+  g_assert (info != NULL);
+
+  if (info->carried == NULL)
+    return;
+
+  carried = g_steal_pointer (&info->carried);
+
+  for (i = 0; i < carried->len; i++)
+    g_signal_emit (self, signals [RESULT_REMOVED], 0, info->provider, g_ptr_array_index (carried, i));
+}
+
+static void
+ide_search_context_release_info (IdeSearchContext *self,
+                                 ProviderInfo     *info)
+{
+  g_assert (IDE_IS_SEARCH_CONTEXT (self));
+  g_assert (info != NULL);
+  g_assert (self->in_progress > 0);
+
+  if (info->timeout_id != 0)
+    {
+      g_source_remove (info->timeout_id);
+      info->timeout_id = 0;
+    }
+
+  if (--self->in_progress == 0)
+    g_signal_emit (self, signals [COMPLETED], 0);
+}
+
+static void
+ide_search_context_complete_info (IdeSearchContext *self,
+                                  ProviderInfo     *info)
+{
+  g_assert (IDE_IS_SEARCH_CONTEXT (self));
+  g_assert (info != NULL);
+  g_assert (!info->completed);
+
+  info->completed = TRUE;
+
+  /*
+   * The provider delivered everything it had, so whatever we carried over
+   * from the previous query and it did not replace is stale.
+   */
+  ide_search_context_flush_carried (self, info);
+
+  if (!g_cancellable_is_cancelled (self->cancellable))
+    {
+      LatencyCounters *counters = get_latency_counters (info->provider);
+      gint64 msec = (g_get_monotonic_time () - info->begin_time) / 1000;
+      guint i;
+
+      /* Late providers always land in the last bucket. */
+      if (info->timed_out)
+        msec = MAX (msec, DEFAULT_PROVIDER_BUDGET_MSEC);
+
+      for (i = 0; i < G_N_ELEMENTS (latency_buckets); i++)
+        {
+          if (msec < latency_buckets [i].msec)
+            {
+              egg_counter_add (&counters->buckets [i], 1);
+              break;
+            }
+        }
+    }
+
+  /* Late providers were released when their budget expired. */
+  if (!info->timed_out)
+    ide_search_context_release_info (self, info);
+}
+
+static gboolean
+ide_search_context_provider_timeout (gpointer data)
+{
+  ProviderInfo *info = data;
+  IdeSearchContext *self = info->context;
+
+  g_assert (IDE_IS_SEARCH_CONTEXT (self));
+  g_assert (!info->completed);
+  g_assert (!info->timed_out);
+
+  IDE_TRACE_MSG ("%s exceeded search budget", G_OBJECT_TYPE_NAME (info->provider));
+
+  info->timeout_id = 0;
+  info->timed_out = TRUE;
+
+  if (!g_cancellable_is_cancelled (self->cancellable))
+    egg_counter_add (&get_latency_counters (info->provider)->timeouts, 1);
+
+  /*
+   * Stop holding back the "completed" signal but keep the provider around,
+   * its results are still added as they arrive.
+   */
+  ide_search_context_release_info (self, info);
+
+  return G_SOURCE_REMOVE;
+}
+
 gboolean
 ide_search_context_get_completed (IdeSearchContext *self)
 {
@@ -58,12 +312,19 @@ void
 ide_search_context_provider_completed (IdeSearchContext  *self,
                                        IdeSearchProvider *provider)
 {
+  ProviderInfo *info;
+
   g_return_if_fail (IDE_IS_SEARCH_CONTEXT (self));
   g_return_if_fail (IDE_IS_SEARCH_PROVIDER (provider));
   g_return_if_fail (g_list_find (self->providers, provider));
 
-  if (--self->in_progress == 0)
-    g_signal_emit (self, signals [COMPLETED], 0);
+  info = ide_search_context_find_info (self, provider);
+  g_assert (info != NULL);
+
+  if (info->completed)
+    return;
+
+  ide_search_context_complete_info (self, info);
 }
 
 /**
@@ -87,10 +348,27 @@ ide_search_context_add_result (IdeSearchContext  *self,
                                IdeSearchProvider *provider,
                                IdeSearchResult   *result)
 {
+  ProviderInfo *info;
+
   g_return_if_fail (IDE_IS_SEARCH_CONTEXT (self));
   g_return_if_fail (IDE_IS_SEARCH_PROVIDER (provider));
   g_return_if_fail (IDE_IS_SEARCH_RESULT (result));
 
+  /*
+   * Drop results for superseded queries so they cannot cause work for the
+   * display. Providers that exceeded their budget keep delivering theirs.
+   */
+  if (g_cancellable_is_cancelled (self->cancellable))
+    return;
+
+  info = ide_search_context_find_info (self, provider);
+
+  if (info != NULL)
+    {
+      ide_search_context_flush_carried (self, info);
+      g_ptr_array_add (info->results, g_object_ref (result));
+    }
+
   g_signal_emit (self, signals [RESULT_ADDED], 0, provider, result);
 }
 
@@ -99,10 +377,15 @@ ide_search_context_remove_result (IdeSearchContext  *self,
                                   IdeSearchProvider *provider,
                                   IdeSearchResult   *result)
 {
+  ProviderInfo *info;
+
   g_return_if_fail (IDE_IS_SEARCH_CONTEXT (self));
   g_return_if_fail (IDE_IS_SEARCH_PROVIDER (provider));
   g_return_if_fail (IDE_IS_SEARCH_RESULT (result));
 
+  if (NULL != (info = ide_search_context_find_info (self, provider)))
+    g_ptr_array_remove (info->results, result);
+
   g_signal_emit (self, signals [RESULT_REMOVED], 0, provider, result);
 }
 
@@ -117,12 +400,57 @@ ide_search_context_set_provider_count (IdeSearchContext  *self,
   g_signal_emit (self, signals [COUNT_SET], 0, provider, count);
 }
 
+static void
+ide_search_context_carry_results (IdeSearchContext *self,
+                                  ProviderInfo     *info,
+                                  const gchar      *casefold_terms)
+{
+  ProviderInfo *previous_info;
+  guint i;
+
+  g_assert (IDE_IS_SEARCH_CONTEXT (self));
+  g_assert (info != NULL);
+  g_assert (casefold_terms != NULL);
+
+  if (self->previous == NULL)
+    return;
+
+  previous_info = ide_search_context_find_info (self->previous, info->provider);
+
+  if (previous_info == NULL || previous_info->results->len == 0)
+    return;
+
+  /*
+   * Results for the new query are a subset of the results for the query it
+   * extends, so refine what we already have while the provider works.
+   */
+  for (i = 0; i < previous_info->results->len; i++)
+    {
+      IdeSearchResult *result = g_ptr_array_index (previous_info->results, i);
+      const gchar *title = ide_search_result_get_title (result);
+      guint priority;
+
+      if (title == NULL || !ide_completion_item_fuzzy_match (title, casefold_terms, &priority))
+        continue;
+
+      if (info->carried == NULL)
+        info->carried = g_ptr_array_new_with_free_func (g_object_unref);
+
+      g_ptr_array_add (info->carried, g_object_ref (result));
+      g_signal_emit (self, signals [RESULT_ADDED], 0, info->provider, result);
+
+      EGG_COUNTER_INC (carried_results);
+    }
+}
+
 void
 ide_search_context_execute (IdeSearchContext *self,
                             const gchar      *search_terms,
                             gsize             max_results)
 {
-  GList *iter;
+  g_autofree gchar *casefold_terms = NULL;
+  gboolean extends_previous = FALSE;
+  guint i;
 
   IDE_ENTRY;
 
@@ -130,35 +458,100 @@ ide_search_context_execute (IdeSearchContext *self,
   g_return_if_fail (!self->executed);
   g_return_if_fail (search_terms);
 
+  EGG_COUNTER_INC (searches);
+
   self->executed = TRUE;
-  self->in_progress = g_list_length (self->providers);
+  self->in_progress = self->infos->len;
   self->max_results = max_results;
+  self->search_terms = g_strdup (search_terms);
+
+  if (self->previous != NULL &&
+      self->previous->search_terms != NULL &&
+      self->previous->search_terms [0] != '\0' &&
+      strlen (search_terms) > strlen (self->previous->search_terms) &&
+      g_str_has_prefix (search_terms, self->previous->search_terms))
+    {
+      extends_previous = TRUE;
+      casefold_terms = g_utf8_casefold (search_terms, -1);
+    }
 
   if (!self->in_progress)
     {
+      g_clear_object (&self->previous);
       g_signal_emit (self, signals [COMPLETED], 0);
       IDE_EXIT;
     }
 
-  for (iter = self->providers; iter; iter = iter->next)
+  /*
+   * Start every provider's budget before populating any of them, since
+   * synchronous providers would otherwise eat into the budget of the
+   * providers after them.
+   */
+  for (i = 0; i < self->infos->len; i++)
+    {
+      ProviderInfo *info = g_ptr_array_index (self->infos, i);
+
+      info->begin_time = g_get_monotonic_time ();
+      info->timeout_id = g_timeout_add (DEFAULT_PROVIDER_BUDGET_MSEC,
+                                        ide_search_context_provider_timeout,
+                                        info);
+
+      if (extends_previous)
+        ide_search_context_carry_results (self, info, casefold_terms);
+    }
+
+  /* We only need the previous query while starting this one. */
+  g_clear_object (&self->previous);
+
+  /*
+   * Providers may complete synchronously from populate(), which could cause
+   * the last reference to the context to be dropped by a "completed" handler.
+   */
+  g_object_ref (self);
+
+  for (i = 0; i < self->infos->len; i++)
     {
-      ide_search_provider_populate (iter->data,
+      ProviderInfo *info = g_ptr_array_index (self->infos, i);
+
+      if (info->completed)
+        continue;
+
+      ide_search_provider_populate (info->provider,
                                     self,
                                     search_terms,
                                     max_results,
                                     self->cancellable);
     }
 
+  g_object_unref (self);
+
   IDE_EXIT;
 }
 
 void
 ide_search_context_cancel (IdeSearchContext *self)
 {
+  guint i;
+
   g_return_if_fail (IDE_IS_SEARCH_CONTEXT (self));
 
   if (!g_cancellable_is_cancelled (self->cancellable))
     g_cancellable_cancel (self->cancellable);
+
+  /*
+   * Nobody is waiting on a cancelled query, so there is no reason to keep
+   * the budget timers around. Providers still notify completion as usual.
+   */
+  for (i = 0; i < self->infos->len; i++)
+    {
+      ProviderInfo *info = g_ptr_array_index (self->infos, i);
+
+      if (info->timeout_id != 0)
+        {
+          g_source_remove (info->timeout_id);
+          info->timeout_id = 0;
+        }
+    }
 }
 
 void
@@ -166,11 +559,41 @@ _ide_search_context_add_provider (IdeSearchContext  *self,
                                   IdeSearchProvider *provider,
                                   gsize              max_results)
 {
+  ProviderInfo *info;
+
   g_return_if_fail (IDE_IS_SEARCH_CONTEXT (self));
   g_return_if_fail (IDE_IS_SEARCH_PROVIDER (provider));
   g_return_if_fail (!self->executed);
 
   self->providers = g_list_append (self->providers, g_object_ref (provider));
+
+  info = g_slice_new0 (ProviderInfo);
+  info->context = self;
+  info->provider = g_object_ref (provider);
+  info->results = g_ptr_array_new_with_free_func (g_object_unref);
+
+  g_ptr_array_add (self->infos, info);
+}
+
+/**
+ * _ide_search_context_set_previous:
+ * @self: An #IdeSearchContext
+ * @previous: (nullable): The #IdeSearchContext of the previous query
+ *
+ * Sets the context of the query that preceded this one. If the search
+ * terms of this context extend those of @previous, the matching results
+ * of @previous are shown immediately when executing the search.
+ */
+void
+_ide_search_context_set_previous (IdeSearchContext *self,
+                                  IdeSearchContext *previous)
+{
+  g_return_if_fail (IDE_IS_SEARCH_CONTEXT (self));
+  g_return_if_fail (!previous || IDE_IS_SEARCH_CONTEXT (previous));
+  g_return_if_fail (!self->executed);
+  g_return_if_fail (self != previous);
+
+  g_set_object (&self->previous, previous);
 }
 
 static void
@@ -183,6 +606,9 @@ ide_search_context_finalize (GObject *object)
   g_list_foreach (copy, (GFunc)g_object_unref, NULL);
   g_list_free (copy);
 
+  g_clear_pointer (&self->infos, g_ptr_array_unref);
+  g_clear_pointer (&self->search_terms, g_free);
+  g_clear_object (&self->previous);
   g_clear_object (&self->cancellable);
 
   G_OBJECT_CLASS (ide_search_context_parent_class)->finalize (object);
@@ -242,6 +668,7 @@ static void
 ide_search_context_init (IdeSearchContext *self)
 {
   self->cancellable = g_cancellable_new ();
+  self->infos = g_ptr_array_new_with_free_func (provider_info_free);
 }
 
 gsize
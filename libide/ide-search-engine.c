@@ -30,6 +30,12 @@ struct _IdeSearchEngine
   IdeObject         parent_instance;
 
   PeasExtensionSet *extensions;
+
+  /*
+   * Weak pointer to the most recent search, so that a search extending its
+   * terms can refine the existing results while providers run.
+   */
+  IdeSearchContext *last_context;
 };
 
 G_DEFINE_TYPE (IdeSearchEngine, ide_search_engine, IDE_TYPE_OBJECT)
@@ -78,6 +84,15 @@ ide_search_engine_search (IdeSearchEngine *self,
                               (PeasExtensionSetForeachFunc)add_provider_to_context,
                               search_context);
 
+  if (self->last_context != NULL)
+    {
+      _ide_search_context_set_previous (search_context, self->last_context);
+      g_object_remove_weak_pointer (G_OBJECT (self->last_context), (gpointer *)&self->last_context);
+    }
+
+  self->last_context = search_context;
+  g_object_add_weak_pointer (G_OBJECT (self->last_context), (gpointer *)&self->last_context);
+
   return search_context;
 }
 
@@ -102,6 +117,12 @@ ide_search_engine_dispose (GObject *object)
 {
   IdeSearchEngine *self = (IdeSearchEngine *)object;
 
+  if (self->last_context != NULL)
+    {
+      g_object_remove_weak_pointer (G_OBJECT (self->last_context), (gpointer *)&self->last_context);
+      self->last_context = NULL;
+    }
+
   g_clear_object (&self->extensions);
 
   G_OBJECT_CLASS (ide_search_engine_parent_class)->dispose (object);
@@ -0,0 +1,455 @@
+/* ide-search-match-index.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-search-match-index"
+
+#include "ide-search-match-index.h"
+
+/*
+ * The search match index keeps the occurrences of a GtkSourceSearchContext
+ * as a sorted array of character offsets, so that drawing search bubbles
+ * only needs to look up the visible range instead of searching forward from
+ * the top of the viewport on every frame.
+ *
+ * Matches are collected with a chain of gtk_source_search_context_forward_async()
+ * calls over a pending range, which is the whole buffer after the search
+ * settings change. Edits shift the offsets of the matches after them and
+ * only the lines they touch are added to the pending range and rescanned.
+ *
+ * A search context only keeps a single pending forward search, and starting
+ * another drops the previous one. The view uses its own search context for
+ * movements, so we scan with a private one sharing the same buffer and
+ * settings, with highlighting disabled.
+ */
+
+struct _IdeSearchMatchIndex
+{
+  GtkSourceSearchContext *context;
+  GtkSourceSearchSettings *settings;
+  GtkTextBuffer          *buffer;
+  GtkTextView            *view;
+  GCancellable           *cancellable;
+
+  /* IdeSearchMatch, sorted and non-overlapping */
+  GArray                 *matches;
+
+  /* The range that still needs to be scanned, if has_pending */
+  gint                    pending_begin;
+  gint                    pending_end;
+
+  gulong                  insert_text_handler;
+  gulong                  delete_range_handler;
+  gulong                  settings_handler;
+  guint                   scan_source;
+
+  guint                   has_pending : 1;
+};
+
+static void ide_search_match_index_scan (IdeSearchMatchIndex *self);
+
+/* Returns the index of the first match ending after @offset */
+static guint
+ide_search_match_index_bsearch (IdeSearchMatchIndex *self,
+                                gint                 offset)
+{
+  guint lo = 0;
+  guint hi = self->matches->len;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (g_array_index (self->matches, IdeSearchMatch, mid).end <= offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static void
+ide_search_match_index_remove_range (IdeSearchMatchIndex *self,
+                                     gint                 begin,
+                                     gint                 end)
+{
+  guint first;
+  guint last;
+
+  first = ide_search_match_index_bsearch (self, begin);
+
+  /* Zero-length matches at @begin also need to go */
+  while (first > 0 && g_array_index (self->matches, IdeSearchMatch, first - 1).end == begin)
+    first--;
+
+  for (last = first; last < self->matches->len; last++)
+    {
+      if (g_array_index (self->matches, IdeSearchMatch, last).begin > end)
+        break;
+    }
+
+  if (last > first)
+    g_array_remove_range (self->matches, first, last - first);
+}
+
+static gboolean
+ide_search_match_index_scan_cb (gpointer user_data)
+{
+  IdeSearchMatchIndex *self = user_data;
+
+  self->scan_source = 0;
+  ide_search_match_index_scan (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+ide_search_match_index_invalidate (IdeSearchMatchIndex *self,
+                                   gint                 begin,
+                                   gint                 end)
+{
+  g_assert (self != NULL);
+  g_assert (begin <= end);
+
+  if (self->has_pending)
+    {
+      begin = MIN (begin, self->pending_begin);
+      end = MAX (end, self->pending_end);
+    }
+
+  self->pending_begin = begin;
+  self->pending_end = end;
+  self->has_pending = TRUE;
+
+  ide_search_match_index_remove_range (self, begin, end);
+
+  /* Restart any in-flight scan from the new pending range. */
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+
+  if (self->scan_source == 0)
+    self->scan_source = g_idle_add_full (G_PRIORITY_LOW,
+                                         ide_search_match_index_scan_cb,
+                                         self,
+                                         NULL);
+}
+
+static void
+ide_search_match_index_finish (IdeSearchMatchIndex *self)
+{
+  self->has_pending = FALSE;
+  g_clear_object (&self->cancellable);
+  gtk_widget_queue_draw (GTK_WIDGET (self->view));
+}
+
+static gboolean
+ide_search_match_index_is_visible (IdeSearchMatchIndex *self,
+                                   gint                 begin,
+                                   gint                 end)
+{
+  GdkRectangle rect;
+  GtkTextIter iter;
+
+  gtk_text_view_get_visible_rect (self->view, &rect);
+
+  gtk_text_view_get_iter_at_location (self->view, &iter, rect.x, rect.y + rect.height);
+  if (begin > gtk_text_iter_get_offset (&iter))
+    return FALSE;
+
+  gtk_text_view_get_iter_at_location (self->view, &iter, rect.x, rect.y);
+  gtk_text_iter_set_line_offset (&iter, 0);
+
+  return end >= gtk_text_iter_get_offset (&iter);
+}
+
+static void
+ide_search_match_index_forward_cb (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  GtkSourceSearchContext *context = (GtkSourceSearchContext *)object;
+  IdeSearchMatchIndex *self = user_data;
+  g_autoptr(GError) error = NULL;
+  IdeSearchMatch match;
+  GtkTextIter begin;
+  GtkTextIter end;
+  guint pos;
+
+  g_assert (GTK_SOURCE_IS_SEARCH_CONTEXT (context));
+  g_assert (G_IS_ASYNC_RESULT (result));
+
+  if (!gtk_source_search_context_forward_finish (context, result, &begin, &end, &error))
+    {
+      /* @self may already be freed if we were cancelled */
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        ide_search_match_index_finish (self);
+      return;
+    }
+
+  match.begin = gtk_text_iter_get_offset (&begin);
+  match.end = gtk_text_iter_get_offset (&end);
+
+  /* We wrapped around or went past the pending range, so we are done. */
+  if (match.begin < self->pending_begin || match.begin > self->pending_end)
+    {
+      ide_search_match_index_finish (self);
+      return;
+    }
+
+  pos = ide_search_match_index_bsearch (self, match.begin);
+  g_array_insert_val (self->matches, pos, match);
+
+  if (ide_search_match_index_is_visible (self, match.begin, match.end))
+    gtk_widget_queue_draw (GTK_WIDGET (self->view));
+
+  self->pending_begin = MAX (match.end, match.begin + 1);
+
+  if (self->pending_begin > self->pending_end)
+    ide_search_match_index_finish (self);
+  else
+    ide_search_match_index_scan (self);
+}
+
+static void
+ide_search_match_index_scan (IdeSearchMatchIndex *self)
+{
+  GtkTextIter iter;
+
+  g_assert (self != NULL);
+
+  if (!self->has_pending)
+    return;
+
+  if (self->cancellable == NULL)
+    self->cancellable = g_cancellable_new ();
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &iter, self->pending_begin);
+  gtk_source_search_context_forward_async (self->context,
+                                           &iter,
+                                           self->cancellable,
+                                           ide_search_match_index_forward_cb,
+                                           self);
+}
+
+static void
+ide_search_match_index_reset (IdeSearchMatchIndex *self)
+{
+  g_assert (self != NULL);
+
+  g_array_set_size (self->matches, 0);
+  self->has_pending = FALSE;
+
+  ide_search_match_index_invalidate (self, 0, gtk_text_buffer_get_char_count (self->buffer));
+}
+
+static inline void
+shift_offset (gint *offset,
+              gint  position,
+              gint  delta)
+{
+  if (*offset >= position)
+    *offset = MAX (position, *offset + delta);
+}
+
+static void
+ide_search_match_index_shift (IdeSearchMatchIndex *self,
+                              gint                 position,
+                              gint                 delta)
+{
+  guint i;
+
+  for (i = ide_search_match_index_bsearch (self, position); i < self->matches->len; i++)
+    {
+      IdeSearchMatch *match = &g_array_index (self->matches, IdeSearchMatch, i);
+
+      if (match->begin > position)
+        shift_offset (&match->begin, position, delta);
+      shift_offset (&match->end, position, delta);
+    }
+
+  if (self->has_pending)
+    {
+      if (self->pending_begin > position)
+        shift_offset (&self->pending_begin, position, delta);
+      shift_offset (&self->pending_end, position, delta);
+    }
+}
+
+static void
+ide_search_match_index_insert_text (IdeSearchMatchIndex *self,
+                                    const GtkTextIter   *location,
+                                    const gchar         *text,
+                                    gint                 len,
+                                    GtkTextBuffer       *buffer)
+{
+  GtkTextIter line_begin = *location;
+  GtkTextIter line_end = *location;
+  gint position;
+  gint n_chars;
+
+  g_assert (self != NULL);
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  position = gtk_text_iter_get_offset (location);
+  n_chars = g_utf8_strlen (text, len);
+
+  gtk_text_iter_set_line_offset (&line_begin, 0);
+  if (!gtk_text_iter_ends_line (&line_end))
+    gtk_text_iter_forward_to_line_end (&line_end);
+
+  ide_search_match_index_shift (self, position, n_chars);
+  ide_search_match_index_invalidate (self,
+                                     gtk_text_iter_get_offset (&line_begin),
+                                     gtk_text_iter_get_offset (&line_end) + n_chars);
+}
+
+static void
+ide_search_match_index_delete_range (IdeSearchMatchIndex *self,
+                                     const GtkTextIter   *begin,
+                                     const GtkTextIter   *end,
+                                     GtkTextBuffer       *buffer)
+{
+  GtkTextIter line_begin = *begin;
+  GtkTextIter line_end = *end;
+  gint position;
+  gint n_chars;
+
+  g_assert (self != NULL);
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  position = gtk_text_iter_get_offset (begin);
+  n_chars = gtk_text_iter_get_offset (end) - position;
+
+  gtk_text_iter_set_line_offset (&line_begin, 0);
+  if (!gtk_text_iter_ends_line (&line_end))
+    gtk_text_iter_forward_to_line_end (&line_end);
+
+  ide_search_match_index_shift (self, position, -n_chars);
+  ide_search_match_index_invalidate (self,
+                                     gtk_text_iter_get_offset (&line_begin),
+                                     gtk_text_iter_get_offset (&line_end) - n_chars);
+}
+
+IdeSearchMatchIndex *
+ide_search_match_index_new (GtkSourceSearchContext *context,
+                            GtkTextView            *view)
+{
+  IdeSearchMatchIndex *self;
+
+  g_return_val_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (context), NULL);
+  g_return_val_if_fail (GTK_IS_TEXT_VIEW (view), NULL);
+
+  self = g_slice_new0 (IdeSearchMatchIndex);
+  self->settings = g_object_ref (gtk_source_search_context_get_settings (context));
+  self->buffer = g_object_ref (gtk_source_search_context_get_buffer (context));
+  self->context = gtk_source_search_context_new (GTK_SOURCE_BUFFER (self->buffer), self->settings);
+  gtk_source_search_context_set_highlight (self->context, FALSE);
+  self->view = view;
+  self->matches = g_array_new (FALSE, FALSE, sizeof (IdeSearchMatch));
+
+  /* Connect before the default handler so iters are still valid. */
+  self->insert_text_handler =
+    g_signal_connect_swapped (self->buffer,
+                              "insert-text",
+                              G_CALLBACK (ide_search_match_index_insert_text),
+                              self);
+  self->delete_range_handler =
+    g_signal_connect_swapped (self->buffer,
+                              "delete-range",
+                              G_CALLBACK (ide_search_match_index_delete_range),
+                              self);
+  self->settings_handler =
+    g_signal_connect_swapped (self->settings,
+                              "notify",
+                              G_CALLBACK (ide_search_match_index_reset),
+                              self);
+
+  ide_search_match_index_reset (self);
+
+  return self;
+}
+
+void
+ide_search_match_index_free (IdeSearchMatchIndex *self)
+{
+  if (self == NULL)
+    return;
+
+  if (self->cancellable != NULL)
+    {
+      g_cancellable_cancel (self->cancellable);
+      g_clear_object (&self->cancellable);
+    }
+
+  if (self->scan_source != 0)
+    {
+      g_source_remove (self->scan_source);
+      self->scan_source = 0;
+    }
+
+  g_signal_handler_disconnect (self->buffer, self->insert_text_handler);
+  g_signal_handler_disconnect (self->buffer, self->delete_range_handler);
+  g_signal_handler_disconnect (self->settings, self->settings_handler);
+
+  g_clear_pointer (&self->matches, g_array_unref);
+  g_clear_object (&self->buffer);
+  g_clear_object (&self->settings);
+  g_clear_object (&self->context);
+
+  g_slice_free (IdeSearchMatchIndex, self);
+}
+
+/**
+ * ide_search_match_index_get_matches:
+ * @begin: the first character offset of the range
+ * @end: the last character offset of the range
+ * @n_matches: (out): the number of matches within the range
+ *
+ * Gets the known matches that overlap the range from @begin to @end. This
+ * never searches the buffer, so matches within a range that is still being
+ * scanned show up once the scan reaches them.
+ *
+ * Returns: (transfer none): The first of @n_matches matches.
+ */
+const IdeSearchMatch *
+ide_search_match_index_get_matches (IdeSearchMatchIndex *self,
+                                    gint                 begin,
+                                    gint                 end,
+                                    guint               *n_matches)
+{
+  guint first;
+  guint last;
+
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (n_matches != NULL, NULL);
+
+  first = ide_search_match_index_bsearch (self, begin);
+
+  for (last = first; last < self->matches->len; last++)
+    {
+      if (g_array_index (self->matches, IdeSearchMatch, last).begin >= end)
+        break;
+    }
+
+  *n_matches = last - first;
+
+  if (first >= self->matches->len)
+    return NULL;
+
+  return &g_array_index (self->matches, IdeSearchMatch, first);
+}
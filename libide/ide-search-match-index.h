@@ -0,0 +1,44 @@
+/* ide-search-match-index.h
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_SEARCH_MATCH_INDEX_H
+#define IDE_SEARCH_MATCH_INDEX_H
+
+#include <gtksourceview/gtksource.h>
+
+G_BEGIN_DECLS
+
+typedef struct _IdeSearchMatchIndex IdeSearchMatchIndex;
+
+typedef struct
+{
+  gint begin;
+  gint end;
+} IdeSearchMatch;
+
+IdeSearchMatchIndex  *ide_search_match_index_new         (GtkSourceSearchContext *context,
+                                                          GtkTextView            *view);
+void                  ide_search_match_index_free        (IdeSearchMatchIndex    *self);
+const IdeSearchMatch *ide_search_match_index_get_matches (IdeSearchMatchIndex    *self,
+                                                          gint                    begin,
+                                                          gint                    end,
+                                                          guint                  *n_matches);
+
+G_END_DECLS
+
+#endif /* IDE_SEARCH_MATCH_INDEX_H */
@@ -0,0 +1,1233 @@
+/* ide-source-raster-map.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-source-raster-map"
+
+#include <math.h>
+#include <string.h>
+
+#include "egg-counter.h"
+#include "egg-signal-group.h"
+
+#include "ide-macros.h"
+#include "ide-source-raster-map.h"
+#include "ide-source-raster-map-private.h"
+
+/*
+ * IdeSourceRasterMap is an alternative to IdeSourceMap that does not
+ * layout the buffer a second time. Each line is reduced to a series of
+ * colored runs (one pixel per column) taken from the foreground of the
+ * tags applied by the highlight engine. The runs are rasterized into
+ * tiles of TILE_LINES lines which are cached until an edit or a change
+ * in highlighting touches one of the lines they cover.
+ */
+
+#define CONCEAL_TIMEOUT 2000
+#define LINE_HEIGHT     3
+#define RUN_HEIGHT      2
+#define MAP_WIDTH       100
+#define TILE_LINES      256
+#define TILE_MARGIN     1
+#define SLIDER_ALPHA    0.15
+
+struct _IdeSourceRasterMap
+{
+  GtkDrawingArea  parent_instance;
+
+  GtkSourceView  *view;
+  EggSignalGroup *view_signals;
+  EggSignalGroup *buffer_signals;
+  EggSignalGroup *vadj_signals;
+
+  /* tile index => cairo_surface_t */
+  GHashTable     *tiles;
+
+  /* GtkTextTag => GdkRGBA or NULL if the tag has no foreground */
+  GHashTable     *tag_colors;
+
+  GdkRGBA         foreground;
+  GdkRGBA         background;
+
+  guint           delayed_conceal_timeout;
+  guint           has_background : 1;
+  guint           show_map : 1;
+  guint           in_drag : 1;
+};
+
+G_DEFINE_TYPE (IdeSourceRasterMap, ide_source_raster_map, GTK_TYPE_DRAWING_AREA)
+
+EGG_DEFINE_COUNTER (tiles, "IdeSourceRasterMap", "Tiles", "Number of map tiles rasterized.")
+
+enum {
+  PROP_0,
+  PROP_VIEW,
+  LAST_PROP
+};
+
+enum {
+  SHOW_MAP,
+  HIDE_MAP,
+  LAST_SIGNAL
+};
+
+static GParamSpec *properties [LAST_PROP];
+static guint signals [LAST_SIGNAL];
+
+static void
+rgba_free (gpointer data)
+{
+  if (data != NULL)
+    gdk_rgba_free (data);
+}
+
+static GtkTextBuffer *
+ide_source_raster_map_get_buffer (IdeSourceRasterMap *self)
+{
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  if (self->view == NULL)
+    return NULL;
+
+  return gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->view));
+}
+
+static void
+ide_source_raster_map_update_colors (IdeSourceRasterMap *self)
+{
+  GtkSourceStyleScheme *scheme = NULL;
+  GtkSourceStyle *style;
+  GtkStyleContext *context;
+  GtkTextBuffer *buffer;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  context = gtk_widget_get_style_context (GTK_WIDGET (self));
+  gtk_style_context_get_color (context,
+                               gtk_style_context_get_state (context),
+                               &self->foreground);
+  self->has_background = FALSE;
+
+  buffer = ide_source_raster_map_get_buffer (self);
+  if (GTK_SOURCE_IS_BUFFER (buffer))
+    scheme = gtk_source_buffer_get_style_scheme (GTK_SOURCE_BUFFER (buffer));
+
+  if (scheme != NULL && (style = gtk_source_style_scheme_get_style (scheme, "text")))
+    {
+      g_autofree gchar *foreground = NULL;
+      g_autofree gchar *background = NULL;
+      gboolean foreground_set = FALSE;
+      gboolean background_set = FALSE;
+
+      g_object_get (style,
+                    "foreground", &foreground,
+                    "foreground-set", &foreground_set,
+                    "background", &background,
+                    "background-set", &background_set,
+                    NULL);
+
+      if (foreground_set && foreground != NULL)
+        gdk_rgba_parse (&self->foreground, foreground);
+
+      if (background_set && background != NULL)
+        self->has_background = gdk_rgba_parse (&self->background, background);
+    }
+}
+
+static void
+ide_source_raster_map_reset (IdeSourceRasterMap *self)
+{
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  g_hash_table_remove_all (self->tiles);
+  g_hash_table_remove_all (self->tag_colors);
+  ide_source_raster_map_update_colors (self);
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+/*
+ * Drops every cached tile covering a line within [begin_line, end_line].
+ * Pass G_MAXUINT for @end_line when the edit shifted the lines following
+ * it, since those tiles are stale as well.
+ */
+static void
+ide_source_raster_map_invalidate (IdeSourceRasterMap *self,
+                                  guint               begin_line,
+                                  guint               end_line)
+{
+  GHashTableIter iter;
+  gpointer key;
+  gboolean removed = FALSE;
+  guint first;
+  guint last;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (begin_line <= end_line);
+
+  first = begin_line / TILE_LINES;
+  last = end_line / TILE_LINES;
+
+  g_hash_table_iter_init (&iter, self->tiles);
+
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      guint tile = GPOINTER_TO_UINT (key);
+
+      if (tile >= first && tile <= last)
+        {
+          g_hash_table_iter_remove (&iter);
+          removed = TRUE;
+        }
+    }
+
+  /*
+   * Every visible tile is cached after a draw, so there is nothing to
+   * redraw unless we dropped one. This also keeps the tags applied while
+   * rendering a tile (which is not cached yet) from queuing another frame.
+   */
+  if (removed)
+    gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+static const GdkRGBA *
+ide_source_raster_map_get_tag_color (IdeSourceRasterMap *self,
+                                     GtkTextTag         *tag)
+{
+  GdkRGBA *rgba = NULL;
+  gboolean foreground_set = FALSE;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (GTK_IS_TEXT_TAG (tag));
+
+  if (g_hash_table_lookup_extended (self->tag_colors, tag, NULL, (gpointer *)&rgba))
+    return rgba;
+
+  g_object_get (tag,
+                "foreground-set", &foreground_set,
+                "foreground-rgba", &rgba,
+                NULL);
+
+  if (!foreground_set)
+    g_clear_pointer (&rgba, gdk_rgba_free);
+
+  g_hash_table_insert (self->tag_colors, g_object_ref (tag), rgba);
+
+  return rgba;
+}
+
+static const GdkRGBA *
+ide_source_raster_map_get_color (IdeSourceRasterMap *self,
+                                 const GtkTextIter  *iter)
+{
+  const GdkRGBA *color = &self->foreground;
+  GSList *tags;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (iter != NULL);
+
+  /* Tags are sorted by ascending priority, so the last one wins. */
+  tags = gtk_text_iter_get_tags (iter);
+
+  for (const GSList *l = tags; l != NULL; l = l->next)
+    {
+      const GdkRGBA *rgba = ide_source_raster_map_get_tag_color (self, l->data);
+
+      if (rgba != NULL)
+        color = rgba;
+    }
+
+  g_slist_free (tags);
+
+  return color;
+}
+
+static void
+ide_source_raster_map_render_line (IdeSourceRasterMap *self,
+                                   cairo_t            *cr,
+                                   GtkTextBuffer      *buffer,
+                                   guint               line,
+                                   gint                y,
+                                   guint               tab_width)
+{
+  GtkTextIter iter;
+  GtkTextIter line_end;
+  guint column = 0;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (cr != NULL);
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+  g_assert (tab_width > 0);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, line);
+
+  line_end = iter;
+  if (!gtk_text_iter_ends_line (&line_end))
+    gtk_text_iter_forward_to_line_end (&line_end);
+
+  /*
+   * Walk the line one tag segment at a time. Every segment has a single
+   * color, so its runs of non-space characters can be filled together.
+   */
+  while (column < MAP_WIDTH && gtk_text_iter_compare (&iter, &line_end) < 0)
+    {
+      g_autofree gchar *text = NULL;
+      const GdkRGBA *color;
+      GtkTextIter next = iter;
+      guint run_begin = 0;
+      gboolean in_run = FALSE;
+      gboolean has_runs = FALSE;
+
+      gtk_text_iter_forward_to_tag_toggle (&next, NULL);
+      if (gtk_text_iter_compare (&next, &line_end) > 0)
+        next = line_end;
+
+      color = ide_source_raster_map_get_color (self, &iter);
+      text = gtk_text_iter_get_slice (&iter, &next);
+
+      for (const gchar *p = text; *p != '\0' && column < MAP_WIDTH; p = g_utf8_next_char (p))
+        {
+          gunichar ch = g_utf8_get_char (p);
+
+          if (ch == '\t' || g_unichar_isspace (ch))
+            {
+              if (in_run)
+                {
+                  cairo_rectangle (cr, run_begin, y, column - run_begin, RUN_HEIGHT);
+                  has_runs = TRUE;
+                  in_run = FALSE;
+                }
+
+              if (ch == '\t')
+                column = (column / tab_width + 1) * tab_width;
+              else
+                column++;
+            }
+          else
+            {
+              if (!in_run)
+                {
+                  run_begin = column;
+                  in_run = TRUE;
+                }
+
+              column++;
+            }
+        }
+
+      if (in_run)
+        {
+          cairo_rectangle (cr, run_begin, y, MIN (column, MAP_WIDTH) - run_begin, RUN_HEIGHT);
+          has_runs = TRUE;
+        }
+
+      if (has_runs)
+        {
+          gdk_cairo_set_source_rgba (cr, color);
+          cairo_fill (cr);
+        }
+
+      iter = next;
+    }
+}
+
+static cairo_surface_t *
+ide_source_raster_map_render_tile (IdeSourceRasterMap *self,
+                                   GtkTextBuffer      *buffer,
+                                   guint               tile)
+{
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  guint first_line;
+  guint last_line;
+  guint tab_width;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  surface = gdk_window_create_similar_image_surface (gtk_widget_get_window (GTK_WIDGET (self)),
+                                                     CAIRO_FORMAT_ARGB32,
+                                                     MAP_WIDTH,
+                                                     TILE_LINES * LINE_HEIGHT,
+                                                     gtk_widget_get_scale_factor (GTK_WIDGET (self)));
+
+  cr = cairo_create (surface);
+
+  tab_width = MAX (1, gtk_source_view_get_tab_width (self->view));
+  first_line = tile * TILE_LINES;
+  last_line = MIN (first_line + TILE_LINES, (guint)gtk_text_buffer_get_line_count (buffer));
+
+  /*
+   * The highlight engine only works on the region visible in the view,
+   * so the lines of this tile may not have been highlighted yet. Make
+   * sure they are before reading the tags. Should that change anything,
+   * our apply-tag handler drops the tile once it is cached.
+   */
+  if (GTK_SOURCE_IS_BUFFER (buffer) && first_line < last_line)
+    {
+      GtkTextIter begin;
+      GtkTextIter end;
+
+      gtk_text_buffer_get_iter_at_line (buffer, &begin, first_line);
+      gtk_text_buffer_get_iter_at_line (buffer, &end, last_line - 1);
+      if (!gtk_text_iter_ends_line (&end))
+        gtk_text_iter_forward_to_line_end (&end);
+
+      gtk_source_buffer_ensure_highlight (GTK_SOURCE_BUFFER (buffer), &begin, &end);
+    }
+
+  for (guint line = first_line; line < last_line; line++)
+    ide_source_raster_map_render_line (self, cr, buffer, line,
+                                       (line - first_line) * LINE_HEIGHT,
+                                       tab_width);
+
+  cairo_destroy (cr);
+
+  EGG_COUNTER_INC (tiles);
+
+  return surface;
+}
+
+/*
+ * When the buffer is taller than the widget, the map scrolls so that its
+ * position tracks the fraction of the document scrolled in the view.
+ */
+static gint
+ide_source_raster_map_get_offset (IdeSourceRasterMap *self,
+                                  gint                height,
+                                  guint               n_lines)
+{
+  GtkAdjustment *vadj;
+  gdouble range;
+  gdouble fraction;
+  gint total;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (self->view != NULL);
+
+  total = n_lines * LINE_HEIGHT;
+  if (total <= height)
+    return 0;
+
+  vadj = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (self->view));
+  if (vadj == NULL)
+    return 0;
+
+  range = gtk_adjustment_get_upper (vadj)
+        - gtk_adjustment_get_page_size (vadj)
+        - gtk_adjustment_get_lower (vadj);
+  if (range <= 0)
+    return 0;
+
+  fraction = (gtk_adjustment_get_value (vadj) - gtk_adjustment_get_lower (vadj)) / range;
+  fraction = CLAMP (fraction, 0.0, 1.0);
+
+  return fraction * (total - height);
+}
+
+static void
+ide_source_raster_map_draw_slider (IdeSourceRasterMap *self,
+                                   cairo_t            *cr,
+                                   gint                width,
+                                   gint                offset)
+{
+  GtkAdjustment *vadj;
+  GtkTextIter begin;
+  GtkTextIter end;
+  gdouble value;
+  gint first_line;
+  gint last_line;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (cr != NULL);
+
+  vadj = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (self->view));
+  if (vadj == NULL)
+    return;
+
+  value = gtk_adjustment_get_value (vadj);
+
+  gtk_text_view_get_line_at_y (GTK_TEXT_VIEW (self->view), &begin, value, NULL);
+  gtk_text_view_get_line_at_y (GTK_TEXT_VIEW (self->view), &end,
+                               value + gtk_adjustment_get_page_size (vadj), NULL);
+
+  first_line = gtk_text_iter_get_line (&begin);
+  last_line = gtk_text_iter_get_line (&end);
+
+  cairo_rectangle (cr,
+                   0,
+                   first_line * LINE_HEIGHT - offset,
+                   width,
+                   (last_line - first_line + 1) * LINE_HEIGHT);
+  cairo_set_source_rgba (cr,
+                         self->foreground.red,
+                         self->foreground.green,
+                         self->foreground.blue,
+                         SLIDER_ALPHA);
+  cairo_fill (cr);
+}
+
+static gboolean
+ide_source_raster_map_draw (GtkWidget *widget,
+                            cairo_t   *cr)
+{
+  IdeSourceRasterMap *self = (IdeSourceRasterMap *)widget;
+  GtkStyleContext *context;
+  GtkTextBuffer *buffer;
+  GtkAllocation alloc;
+  GHashTableIter iter;
+  gpointer key;
+  guint n_lines;
+  guint first_tile;
+  guint last_tile;
+  gint offset;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (cr != NULL);
+
+  gtk_widget_get_allocation (widget, &alloc);
+
+  context = gtk_widget_get_style_context (widget);
+  gtk_render_background (context, cr, 0, 0, alloc.width, alloc.height);
+
+  if (self->has_background)
+    {
+      gdk_cairo_set_source_rgba (cr, &self->background);
+      cairo_paint (cr);
+    }
+
+  if (NULL == (buffer = ide_source_raster_map_get_buffer (self)))
+    return GDK_EVENT_PROPAGATE;
+
+  n_lines = gtk_text_buffer_get_line_count (buffer);
+  offset = ide_source_raster_map_get_offset (self, alloc.height, n_lines);
+
+  first_tile = offset / LINE_HEIGHT / TILE_LINES;
+  last_tile = MIN (n_lines - 1, (guint)(offset + alloc.height) / LINE_HEIGHT) / TILE_LINES;
+
+  /* Only keep the tiles that are (nearly) visible around. */
+  g_hash_table_iter_init (&iter, self->tiles);
+
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      guint tile = GPOINTER_TO_UINT (key);
+
+      if (tile + TILE_MARGIN < first_tile || tile > last_tile + TILE_MARGIN)
+        g_hash_table_iter_remove (&iter);
+    }
+
+  for (guint tile = first_tile; tile <= last_tile; tile++)
+    {
+      cairo_surface_t *surface;
+
+      surface = g_hash_table_lookup (self->tiles, GUINT_TO_POINTER (tile));
+
+      if (surface == NULL)
+        {
+          surface = ide_source_raster_map_render_tile (self, buffer, tile);
+          g_hash_table_insert (self->tiles, GUINT_TO_POINTER (tile), surface);
+        }
+
+      cairo_set_source_surface (cr, surface, 0, (gint)(tile * TILE_LINES * LINE_HEIGHT) - offset);
+      cairo_paint (cr);
+    }
+
+  ide_source_raster_map_draw_slider (self, cr, alloc.width, offset);
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static void
+ide_source_raster_map_get_preferred_width (GtkWidget *widget,
+                                           gint      *min_width,
+                                           gint      *nat_width)
+{
+  *min_width = *nat_width = MAP_WIDTH;
+}
+
+static void
+ide_source_raster_map_scroll_to_y (IdeSourceRasterMap *self,
+                                   gdouble             y)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  guint n_lines;
+  gint offset;
+  gint line;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  if (NULL == (buffer = ide_source_raster_map_get_buffer (self)))
+    return;
+
+  n_lines = gtk_text_buffer_get_line_count (buffer);
+  offset = ide_source_raster_map_get_offset (self,
+                                             gtk_widget_get_allocated_height (GTK_WIDGET (self)),
+                                             n_lines);
+  line = (y + offset) / LINE_HEIGHT;
+  line = CLAMP (line, 0, (gint)n_lines - 1);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, line);
+  gtk_text_view_scroll_to_iter (GTK_TEXT_VIEW (self->view), &iter, 0.0, TRUE, 1.0, 0.5);
+}
+
+static gboolean
+ide_source_raster_map_do_conceal (gpointer data)
+{
+  IdeSourceRasterMap *self = data;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  self->delayed_conceal_timeout = 0;
+
+  if (self->show_map == TRUE)
+    {
+      self->show_map = FALSE;
+      g_signal_emit (self, signals [HIDE_MAP], 0);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+ide_source_raster_map_show_map (IdeSourceRasterMap *self)
+{
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  if (self->show_map == FALSE)
+    {
+      self->show_map = TRUE;
+      g_signal_emit (self, signals [SHOW_MAP], 0);
+    }
+}
+
+static void
+ide_source_raster_map_show_map_and_queue_fade (IdeSourceRasterMap *self)
+{
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  if (self->delayed_conceal_timeout != 0)
+    g_source_remove (self->delayed_conceal_timeout);
+
+  self->delayed_conceal_timeout = g_timeout_add (CONCEAL_TIMEOUT,
+                                                 ide_source_raster_map_do_conceal,
+                                                 self);
+
+  ide_source_raster_map_show_map (self);
+}
+
+static gboolean
+ide_source_raster_map_enter_notify_event (GtkWidget        *widget,
+                                          GdkEventCrossing *event)
+{
+  IdeSourceRasterMap *self = (IdeSourceRasterMap *)widget;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  ide_source_raster_map_show_map (self);
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static gboolean
+ide_source_raster_map_leave_notify_event (GtkWidget        *widget,
+                                          GdkEventCrossing *event)
+{
+  IdeSourceRasterMap *self = (IdeSourceRasterMap *)widget;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  ide_source_raster_map_show_map_and_queue_fade (self);
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static gboolean
+ide_source_raster_map_button_press_event (GtkWidget      *widget,
+                                          GdkEventButton *event)
+{
+  IdeSourceRasterMap *self = (IdeSourceRasterMap *)widget;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  if (event->button != GDK_BUTTON_PRIMARY)
+    return GDK_EVENT_PROPAGATE;
+
+  self->in_drag = TRUE;
+  ide_source_raster_map_scroll_to_y (self, event->y);
+
+  return GDK_EVENT_STOP;
+}
+
+static gboolean
+ide_source_raster_map_button_release_event (GtkWidget      *widget,
+                                            GdkEventButton *event)
+{
+  IdeSourceRasterMap *self = (IdeSourceRasterMap *)widget;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  if (event->button != GDK_BUTTON_PRIMARY || !self->in_drag)
+    return GDK_EVENT_PROPAGATE;
+
+  self->in_drag = FALSE;
+
+  return GDK_EVENT_STOP;
+}
+
+static gboolean
+ide_source_raster_map_motion_notify_event (GtkWidget      *widget,
+                                           GdkEventMotion *event)
+{
+  IdeSourceRasterMap *self = (IdeSourceRasterMap *)widget;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  ide_source_raster_map_show_map_and_queue_fade (self);
+
+  if (self->in_drag)
+    {
+      ide_source_raster_map_scroll_to_y (self, event->y);
+      return GDK_EVENT_STOP;
+    }
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static gboolean
+ide_source_raster_map_scroll_event (GtkWidget      *widget,
+                                    GdkEventScroll *event)
+{
+  IdeSourceRasterMap *self = (IdeSourceRasterMap *)widget;
+  GtkAdjustment *vadj;
+  gdouble delta_x = 0.0;
+  gdouble delta_y = 0.0;
+  gdouble step;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  ide_source_raster_map_show_map_and_queue_fade (self);
+
+  if (self->view == NULL ||
+      NULL == (vadj = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (self->view))))
+    return GDK_EVENT_PROPAGATE;
+
+  if (!gdk_event_get_scroll_deltas ((GdkEvent *)event, &delta_x, &delta_y))
+    {
+      if (event->direction == GDK_SCROLL_UP)
+        delta_y = -1.0;
+      else if (event->direction == GDK_SCROLL_DOWN)
+        delta_y = 1.0;
+      else
+        return GDK_EVENT_PROPAGATE;
+    }
+
+  step = pow (gtk_adjustment_get_page_size (vadj), 2.0 / 3.0);
+  gtk_adjustment_set_value (vadj, gtk_adjustment_get_value (vadj) + delta_y * step);
+
+  return GDK_EVENT_STOP;
+}
+
+static void
+ide_source_raster_map_style_updated (GtkWidget *widget)
+{
+  IdeSourceRasterMap *self = (IdeSourceRasterMap *)widget;
+  GdkRGBA old_foreground;
+  GdkRGBA old_background;
+  gboolean old_has_background;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  GTK_WIDGET_CLASS (ide_source_raster_map_parent_class)->style_updated (widget);
+
+  old_foreground = self->foreground;
+  old_background = self->background;
+  old_has_background = self->has_background;
+
+  ide_source_raster_map_update_colors (self);
+
+  /*
+   * This is emitted for state changes too, so only drop the tiles when the
+   * default colors they were drawn with have changed, such as on a theme
+   * switch.
+   */
+  if (!gdk_rgba_equal (&old_foreground, &self->foreground) ||
+      old_has_background != self->has_background ||
+      (self->has_background && !gdk_rgba_equal (&old_background, &self->background)))
+    {
+      g_hash_table_remove_all (self->tiles);
+      gtk_widget_queue_draw (widget);
+    }
+}
+
+static void
+ide_source_raster_map_notify_scale_factor (IdeSourceRasterMap *self,
+                                           GParamSpec         *pspec,
+                                           gpointer            user_data)
+{
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+
+  ide_source_raster_map_reset (self);
+}
+
+static void
+ide_source_raster_map__buffer_insert_text (IdeSourceRasterMap *self,
+                                           GtkTextIter        *location,
+                                           const gchar        *text,
+                                           gint                len,
+                                           GtkTextBuffer      *buffer)
+{
+  guint line;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (location != NULL);
+  g_assert (text != NULL);
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  line = gtk_text_iter_get_line (location);
+
+  if (memchr (text, '\n', len) || memchr (text, '\r', len))
+    ide_source_raster_map_invalidate (self, line, G_MAXUINT);
+  else
+    ide_source_raster_map_invalidate (self, line, line);
+}
+
+static void
+ide_source_raster_map__buffer_delete_range (IdeSourceRasterMap *self,
+                                            GtkTextIter        *begin,
+                                            GtkTextIter        *end,
+                                            GtkTextBuffer      *buffer)
+{
+  guint begin_line;
+  guint end_line;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (begin != NULL);
+  g_assert (end != NULL);
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  begin_line = gtk_text_iter_get_line (begin);
+  end_line = gtk_text_iter_get_line (end);
+
+  if (begin_line != end_line)
+    ide_source_raster_map_invalidate (self, MIN (begin_line, end_line), G_MAXUINT);
+  else
+    ide_source_raster_map_invalidate (self, begin_line, begin_line);
+}
+
+static void
+ide_source_raster_map__buffer_tag_changed (IdeSourceRasterMap *self,
+                                           GtkTextTag         *tag,
+                                           GtkTextIter        *begin,
+                                           GtkTextIter        *end,
+                                           GtkTextBuffer      *buffer)
+{
+  guint begin_line;
+  guint end_line;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (GTK_IS_TEXT_TAG (tag));
+  g_assert (begin != NULL);
+  g_assert (end != NULL);
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  /* Tags without a foreground (search, spelling, etc) do not affect us. */
+  if (ide_source_raster_map_get_tag_color (self, tag) == NULL)
+    return;
+
+  begin_line = gtk_text_iter_get_line (begin);
+  end_line = gtk_text_iter_get_line (end);
+
+  ide_source_raster_map_invalidate (self,
+                                    MIN (begin_line, end_line),
+                                    MAX (begin_line, end_line));
+}
+
+static void
+ide_source_raster_map__buffer_notify_style_scheme (IdeSourceRasterMap *self,
+                                                   GParamSpec         *pspec,
+                                                   GtkSourceBuffer    *buffer)
+{
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (GTK_SOURCE_IS_BUFFER (buffer));
+
+  ide_source_raster_map_reset (self);
+}
+
+static void
+ide_source_raster_map__view_notify_buffer (IdeSourceRasterMap *self,
+                                           GParamSpec         *pspec,
+                                           GtkSourceView      *view)
+{
+  GtkTextBuffer *buffer;
+
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (GTK_SOURCE_IS_VIEW (view));
+
+  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+  egg_signal_group_set_target (self->buffer_signals,
+                               GTK_SOURCE_IS_BUFFER (buffer) ? buffer : NULL);
+
+  ide_source_raster_map_reset (self);
+}
+
+static void
+ide_source_raster_map__view_notify_tab_width (IdeSourceRasterMap *self,
+                                              GParamSpec         *pspec,
+                                              GtkSourceView      *view)
+{
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (GTK_SOURCE_IS_VIEW (view));
+
+  g_hash_table_remove_all (self->tiles);
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+static void
+ide_source_raster_map__view_notify_vadjustment (IdeSourceRasterMap *self,
+                                                GParamSpec         *pspec,
+                                                GtkSourceView      *view)
+{
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (GTK_SOURCE_IS_VIEW (view));
+
+  egg_signal_group_set_target (self->vadj_signals,
+                               gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (view)));
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+static gboolean
+ide_source_raster_map__view_enter_notify_event (IdeSourceRasterMap *self,
+                                                GdkEventCrossing   *event,
+                                                GtkWidget          *widget)
+{
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (event != NULL);
+  g_assert (GTK_IS_WIDGET (widget));
+
+  ide_source_raster_map_show_map (self);
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static gboolean
+ide_source_raster_map__view_event (IdeSourceRasterMap *self,
+                                   GdkEvent           *event,
+                                   GtkWidget          *widget)
+{
+  g_assert (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_assert (event != NULL);
+  g_assert (GTK_IS_WIDGET (widget));
+
+  ide_source_raster_map_show_map_and_queue_fade (self);
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+gboolean
+_ide_source_raster_map_has_tile (IdeSourceRasterMap *self,
+                                 guint               tile)
+{
+  g_return_val_if_fail (IDE_IS_SOURCE_RASTER_MAP (self), FALSE);
+
+  return g_hash_table_contains (self->tiles, GUINT_TO_POINTER (tile));
+}
+
+GtkSourceView *
+ide_source_raster_map_get_view (IdeSourceRasterMap *self)
+{
+  g_return_val_if_fail (IDE_IS_SOURCE_RASTER_MAP (self), NULL);
+
+  return self->view;
+}
+
+void
+ide_source_raster_map_set_view (IdeSourceRasterMap *self,
+                                GtkSourceView      *view)
+{
+  g_return_if_fail (IDE_IS_SOURCE_RASTER_MAP (self));
+  g_return_if_fail (!view || GTK_SOURCE_IS_VIEW (view));
+
+  if (ide_set_weak_pointer (&self->view, view))
+    {
+      egg_signal_group_set_target (self->view_signals, view);
+
+      if (view != NULL)
+        {
+          ide_source_raster_map__view_notify_buffer (self, NULL, view);
+          ide_source_raster_map__view_notify_vadjustment (self, NULL, view);
+        }
+      else
+        {
+          egg_signal_group_set_target (self->buffer_signals, NULL);
+          egg_signal_group_set_target (self->vadj_signals, NULL);
+          ide_source_raster_map_reset (self);
+        }
+
+      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_VIEW]);
+    }
+}
+
+GtkWidget *
+ide_source_raster_map_new (GtkSourceView *view)
+{
+  return g_object_new (IDE_TYPE_SOURCE_RASTER_MAP,
+                       "view", view,
+                       NULL);
+}
+
+static void
+ide_source_raster_map_destroy (GtkWidget *widget)
+{
+  IdeSourceRasterMap *self = (IdeSourceRasterMap *)widget;
+
+  ide_clear_source (&self->delayed_conceal_timeout);
+
+  if (self->view_signals != NULL)
+    {
+      egg_signal_group_set_target (self->view_signals, NULL);
+      egg_signal_group_set_target (self->buffer_signals, NULL);
+      egg_signal_group_set_target (self->vadj_signals, NULL);
+    }
+
+  g_clear_object (&self->view_signals);
+  g_clear_object (&self->buffer_signals);
+  g_clear_object (&self->vadj_signals);
+
+  ide_clear_weak_pointer (&self->view);
+
+  g_hash_table_remove_all (self->tiles);
+  g_hash_table_remove_all (self->tag_colors);
+
+  GTK_WIDGET_CLASS (ide_source_raster_map_parent_class)->destroy (widget);
+}
+
+static void
+ide_source_raster_map_finalize (GObject *object)
+{
+  IdeSourceRasterMap *self = (IdeSourceRasterMap *)object;
+
+  g_clear_pointer (&self->tiles, g_hash_table_unref);
+  g_clear_pointer (&self->tag_colors, g_hash_table_unref);
+
+  G_OBJECT_CLASS (ide_source_raster_map_parent_class)->finalize (object);
+}
+
+static void
+ide_source_raster_map_get_property (GObject    *object,
+                                    guint       prop_id,
+                                    GValue     *value,
+                                    GParamSpec *pspec)
+{
+  IdeSourceRasterMap *self = IDE_SOURCE_RASTER_MAP (object);
+
+  switch (prop_id)
+    {
+    case PROP_VIEW:
+      g_value_set_object (value, ide_source_raster_map_get_view (self));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+ide_source_raster_map_set_property (GObject      *object,
+                                    guint         prop_id,
+                                    const GValue *value,
+                                    GParamSpec   *pspec)
+{
+  IdeSourceRasterMap *self = IDE_SOURCE_RASTER_MAP (object);
+
+  switch (prop_id)
+    {
+    case PROP_VIEW:
+      ide_source_raster_map_set_view (self, g_value_get_object (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+ide_source_raster_map_class_init (IdeSourceRasterMapClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  object_class->finalize = ide_source_raster_map_finalize;
+  object_class->get_property = ide_source_raster_map_get_property;
+  object_class->set_property = ide_source_raster_map_set_property;
+
+  widget_class->destroy = ide_source_raster_map_destroy;
+  widget_class->draw = ide_source_raster_map_draw;
+  widget_class->get_preferred_width = ide_source_raster_map_get_preferred_width;
+  widget_class->enter_notify_event = ide_source_raster_map_enter_notify_event;
+  widget_class->leave_notify_event = ide_source_raster_map_leave_notify_event;
+  widget_class->button_press_event = ide_source_raster_map_button_press_event;
+  widget_class->button_release_event = ide_source_raster_map_button_release_event;
+  widget_class->motion_notify_event = ide_source_raster_map_motion_notify_event;
+  widget_class->scroll_event = ide_source_raster_map_scroll_event;
+  widget_class->style_updated = ide_source_raster_map_style_updated;
+
+  properties [PROP_VIEW] =
+    g_param_spec_object ("view",
+                         "View",
+                         "The source view to display an overview for.",
+                         GTK_SOURCE_TYPE_VIEW,
+                         (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, LAST_PROP, properties);
+
+  signals [HIDE_MAP] =
+    g_signal_new ("hide-map",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE,
+                  0);
+
+  signals [SHOW_MAP] =
+    g_signal_new ("show-map",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE,
+                  0);
+
+  gtk_widget_class_set_css_name (widget_class, "idesourcerastermap");
+}
+
+static void
+ide_source_raster_map_init (IdeSourceRasterMap *self)
+{
+  self->tiles = g_hash_table_new_full (NULL, NULL, NULL,
+                                       (GDestroyNotify)cairo_surface_destroy);
+  self->tag_colors = g_hash_table_new_full (NULL, NULL, g_object_unref, rgba_free);
+
+  gtk_widget_add_events (GTK_WIDGET (self),
+                         (GDK_BUTTON_PRESS_MASK |
+                          GDK_BUTTON_RELEASE_MASK |
+                          GDK_POINTER_MOTION_MASK |
+                          GDK_ENTER_NOTIFY_MASK |
+                          GDK_LEAVE_NOTIFY_MASK |
+                          GDK_SCROLL_MASK |
+                          GDK_SMOOTH_SCROLL_MASK));
+
+  /* Buffer */
+  self->buffer_signals = egg_signal_group_new (GTK_SOURCE_TYPE_BUFFER);
+
+  egg_signal_group_connect_object (self->buffer_signals,
+                                   "insert-text",
+                                   G_CALLBACK (ide_source_raster_map__buffer_insert_text),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  egg_signal_group_connect_object (self->buffer_signals,
+                                   "delete-range",
+                                   G_CALLBACK (ide_source_raster_map__buffer_delete_range),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  egg_signal_group_connect_object (self->buffer_signals,
+                                   "apply-tag",
+                                   G_CALLBACK (ide_source_raster_map__buffer_tag_changed),
+                                   self,
+                                   G_CONNECT_SWAPPED | G_CONNECT_AFTER);
+
+  egg_signal_group_connect_object (self->buffer_signals,
+                                   "remove-tag",
+                                   G_CALLBACK (ide_source_raster_map__buffer_tag_changed),
+                                   self,
+                                   G_CONNECT_SWAPPED | G_CONNECT_AFTER);
+
+  egg_signal_group_connect_object (self->buffer_signals,
+                                   "notify::style-scheme",
+                                   G_CALLBACK (ide_source_raster_map__buffer_notify_style_scheme),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  /* Vertical Adjustment */
+  self->vadj_signals = egg_signal_group_new (GTK_TYPE_ADJUSTMENT);
+
+  egg_signal_group_connect_object (self->vadj_signals,
+                                   "value-changed",
+                                   G_CALLBACK (gtk_widget_queue_draw),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  egg_signal_group_connect_object (self->vadj_signals,
+                                   "changed",
+                                   G_CALLBACK (gtk_widget_queue_draw),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  /* View */
+  self->view_signals = egg_signal_group_new (GTK_SOURCE_TYPE_VIEW);
+
+  egg_signal_group_connect_object (self->view_signals,
+                                   "notify::buffer",
+                                   G_CALLBACK (ide_source_raster_map__view_notify_buffer),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  egg_signal_group_connect_object (self->view_signals,
+                                   "notify::tab-width",
+                                   G_CALLBACK (ide_source_raster_map__view_notify_tab_width),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  egg_signal_group_connect_object (self->view_signals,
+                                   "notify::vadjustment",
+                                   G_CALLBACK (ide_source_raster_map__view_notify_vadjustment),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  egg_signal_group_connect_object (self->view_signals,
+                                   "enter-notify-event",
+                                   G_CALLBACK (ide_source_raster_map__view_enter_notify_event),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  egg_signal_group_connect_object (self->view_signals,
+                                   "leave-notify-event",
+                                   G_CALLBACK (ide_source_raster_map__view_event),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  egg_signal_group_connect_object (self->view_signals,
+                                   "motion-notify-event",
+                                   G_CALLBACK (ide_source_raster_map__view_event),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  egg_signal_group_connect_object (self->view_signals,
+                                   "scroll-event",
+                                   G_CALLBACK (ide_source_raster_map__view_event),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  g_signal_connect (self,
+                    "notify::scale-factor",
+                    G_CALLBACK (ide_source_raster_map_notify_scale_factor),
+                    NULL);
+}
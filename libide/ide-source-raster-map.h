@@ -0,0 +1,38 @@
+/* ide-source-raster-map.h
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_SOURCE_RASTER_MAP_H
+#define IDE_SOURCE_RASTER_MAP_H
+
+#include <gtksourceview/gtksource.h>
+
+G_BEGIN_DECLS
+
+#define IDE_TYPE_SOURCE_RASTER_MAP (ide_source_raster_map_get_type())
+
+G_DECLARE_FINAL_TYPE (IdeSourceRasterMap, ide_source_raster_map,
+                      IDE, SOURCE_RASTER_MAP, GtkDrawingArea)
+
+GtkWidget     *ide_source_raster_map_new      (GtkSourceView      *view);
+GtkSourceView *ide_source_raster_map_get_view (IdeSourceRasterMap *self);
+void           ide_source_raster_map_set_view (IdeSourceRasterMap *self,
+                                               GtkSourceView      *view);
+
+G_END_DECLS
+
+#endif /* IDE_SOURCE_RASTER_MAP_H */
@@ -20,6 +20,7 @@
 
 #include <string.h>
 
+#include "ide-bracket-index.h"
 #include "ide-debug.h"
 #include "ide-enums.h"
 #include "ide-internal.h"
@@ -231,22 +232,15 @@ ensure_anchor_selected (Movement *mv)
     }
 }
 
-static gboolean
-text_iter_forward_to_empty_line (GtkTextIter *iter,
-                                 GtkTextIter *bounds)
+static gint
+text_iter_chars_to_line_end (const GtkTextIter *iter)
 {
-  if (!gtk_text_iter_forward_char (iter))
-    return FALSE;
+  GtkTextIter end = *iter;
 
-  while (gtk_text_iter_compare (iter, bounds) < 0)
-    {
-      if (gtk_text_iter_starts_line (iter) && gtk_text_iter_ends_line (iter))
-        return TRUE;
-      if (!gtk_text_iter_forward_char (iter))
-        return FALSE;
-    }
+  if (!gtk_text_iter_ends_line (&end))
+    gtk_text_iter_forward_to_line_end (&end);
 
-  return FALSE;
+  return gtk_text_iter_get_line_offset (&end) - gtk_text_iter_get_line_offset (iter);
 }
 
 static void
@@ -290,14 +284,12 @@ ide_source_view_movements_select_range (Movement *mv)
 static void
 ide_source_view_movements_nth_char (Movement *mv)
 {
+  gint chars;
+
   gtk_text_iter_set_line_offset (&mv->insert, 0);
 
-  for (; mv->count > 0; mv->count--)
-    {
-      if (gtk_text_iter_ends_line (&mv->insert))
-        break;
-      gtk_text_iter_forward_char (&mv->insert);
-    }
+  chars = text_iter_chars_to_line_end (&mv->insert);
+  gtk_text_iter_set_line_offset (&mv->insert, CLAMP (mv->count, 0, chars));
 
   if (!mv->exclusive)
     gtk_text_iter_forward_char (&mv->insert);
@@ -306,14 +298,13 @@ ide_source_view_movements_nth_char (Movement *mv)
 static void
 ide_source_view_movements_previous_char (Movement *mv)
 {
+  gint line_offset;
+
   mv->count = MAX (1, mv->count);
 
-  for (; mv->count; mv->count--)
-    {
-      if (gtk_text_iter_starts_line (&mv->insert))
-        break;
-      gtk_text_iter_backward_char (&mv->insert);
-    }
+  /* stop at the start of the line */
+  line_offset = gtk_text_iter_get_line_offset (&mv->insert);
+  gtk_text_iter_set_line_offset (&mv->insert, MAX (0, line_offset - mv->count));
 
   if (!mv->exclusive)
     gtk_text_iter_forward_char (&mv->insert);
@@ -322,14 +313,15 @@ ide_source_view_movements_previous_char (Movement *mv)
 static void
 ide_source_view_movements_next_char (Movement *mv)
 {
+  gint line_offset;
+  gint chars;
+
   mv->count = MAX (1, mv->count);
 
-  for (; mv->count; mv->count--)
-    {
-      if (gtk_text_iter_ends_line (&mv->insert))
-        break;
-      gtk_text_iter_forward_char (&mv->insert);
-    }
+  /* stop at the end of the line */
+  line_offset = gtk_text_iter_get_line_offset (&mv->insert);
+  chars = text_iter_chars_to_line_end (&mv->insert);
+  gtk_text_iter_set_line_offset (&mv->insert, line_offset + MIN (mv->count, chars));
 
   if (!mv->exclusive && !gtk_text_iter_ends_line (&mv->insert))
     gtk_text_iter_forward_char (&mv->insert);
@@ -491,14 +483,15 @@ ide_source_view_movements_last_line (Movement *mv)
     }
 }
 
-static gboolean
-ide_source_view_movements_next_line (Movement *mv)
+static void
+ide_source_view_movements_next_line (Movement *mv,
+                                     guint     count)
 {
-  GtkTextIter prev_insert = mv->insert;
-  GtkTextIter prev_selection = mv->selection;
   GtkTextBuffer *buffer;
   gboolean has_selection;
   guint line;
+  guint last_line;
+  guint target_line;
   guint offset = 0;
 
   buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (mv->self));
@@ -507,6 +500,7 @@ ide_source_view_movements_next_line (Movement *mv)
   has_selection = !gtk_text_iter_equal (&mv->insert, &mv->selection) || !mv->exclusive;
 
   line = gtk_text_iter_get_line (&mv->insert);
+  last_line = gtk_text_buffer_get_line_count (buffer) - 1;
 
   if ((*mv->target_offset) > 0)
     offset = *mv->target_offset;
@@ -519,12 +513,10 @@ ide_source_view_movements_next_line (Movement *mv)
    */
   if (is_single_line_selection (&mv->insert, &mv->selection))
     {
-      guint target_line;
-
       if (gtk_text_iter_compare (&mv->insert, &mv->selection) < 0)
         gtk_text_iter_order (&mv->selection, &mv->insert);
 
-      target_line = gtk_text_iter_get_line (&mv->insert) + 1;
+      target_line = gtk_text_iter_get_line (&mv->insert) + count;
       gtk_text_iter_set_line (&mv->insert, target_line);
 
       if (target_line != gtk_text_iter_get_line (&mv->insert))
@@ -535,7 +527,7 @@ ide_source_view_movements_next_line (Movement *mv)
 
       select_range (mv, &mv->insert, &mv->selection);
       ensure_anchor_selected (mv);
-      return TRUE;
+      return;
     }
 
   if (is_single_char_selection (&mv->insert, &mv->selection))
@@ -544,7 +536,12 @@ ide_source_view_movements_next_line (Movement *mv)
         *mv->target_offset = ++offset;
     }
 
-  gtk_text_buffer_get_iter_at_line_offset (buffer, &mv->insert, line + 1, offset);
+  /* Jump straight to the target line rather than one line at a time. */
+  target_line = line + count;
+  if (target_line > last_line && line < last_line)
+    target_line = last_line;
+
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &mv->insert, target_line, offset);
 
 select_to_end:
 
@@ -559,19 +556,16 @@ select_to_end:
   /* make sure selection/insert are up to date */
   if (!gtk_text_buffer_get_has_selection (buffer))
     mv->selection = mv->insert;
-
-  return (!gtk_text_iter_equal (&prev_selection, &mv->selection) ||
-          !gtk_text_iter_equal (&prev_insert, &mv->insert));
 }
 
-static gboolean
-ide_source_view_movements_previous_line (Movement *mv)
+static void
+ide_source_view_movements_previous_line (Movement *mv,
+                                         guint     count)
 {
-  GtkTextIter prev_insert = mv->insert;
-  GtkTextIter prev_selection = mv->selection;
   GtkTextBuffer *buffer;
   gboolean has_selection;
   guint line;
+  guint target_line;
   guint offset = 0;
 
   buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (mv->self));
@@ -585,7 +579,7 @@ ide_source_view_movements_previous_line (Movement *mv)
     offset = *mv->target_offset;
 
   if (line == 0)
-    return FALSE;
+    return;
 
   /*
    * If we have a whole line selected (from say `V`), then we need to swap the cursor and
@@ -596,10 +590,11 @@ ide_source_view_movements_previous_line (Movement *mv)
     {
       if (gtk_text_iter_compare (&mv->insert, &mv->selection) > 0)
         gtk_text_iter_order (&mv->insert, &mv->selection);
-      gtk_text_iter_set_line (&mv->insert, gtk_text_iter_get_line (&mv->insert) - 1);
+      line = gtk_text_iter_get_line (&mv->insert);
+      gtk_text_iter_set_line (&mv->insert, line - MIN (line, count));
       select_range (mv, &mv->insert, &mv->selection);
       ensure_anchor_selected (mv);
-      return TRUE;
+      return;
     }
 
   if (is_single_char_selection (&mv->insert, &mv->selection))
@@ -612,10 +607,13 @@ ide_source_view_movements_previous_line (Movement *mv)
         }
     }
 
-  gtk_text_buffer_get_iter_at_line (buffer, &mv->insert, line - 1);
-  if ((line - 1) == gtk_text_iter_get_line (&mv->insert))
+  /* Jump straight to the target line rather than one line at a time. */
+  target_line = line - MIN (line, count);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &mv->insert, target_line);
+  if (target_line == gtk_text_iter_get_line (&mv->insert))
     {
-      gtk_text_buffer_get_iter_at_line_offset (buffer, &mv->insert, line - 1, offset);
+      gtk_text_buffer_get_iter_at_line_offset (buffer, &mv->insert, target_line, offset);
 
       if (has_selection)
         {
@@ -631,9 +629,6 @@ ide_source_view_movements_previous_line (Movement *mv)
   /* make sure selection/insert are up to date */
   if (!gtk_text_buffer_get_has_selection (buffer))
     mv->selection = mv->insert;
-
-  return (!gtk_text_iter_equal (&prev_selection, &mv->selection) ||
-          !gtk_text_iter_equal (&prev_insert, &mv->insert));
 }
 
 static void
@@ -951,6 +946,75 @@ bracket_predicate (GtkTextIter *iter,
 
 }
 
+static gboolean
+is_bracket_pair (gunichar left_char,
+                 gunichar right_char)
+{
+  return ((left_char == '(' && right_char == ')') ||
+          (left_char == '[' && right_char == ']') ||
+          (left_char == '{' && right_char == '}'));
+}
+
+/*
+ * Same as match_char_with_depth() but resolved from the buffer's bracket
+ * index, skipping brackets in comments and strings. Returns FALSE in
+ * @handled if the index can't answer, in which case the caller scans.
+ */
+static gboolean
+match_char_with_depth_indexed (GtkTextIter      *iter,
+                               gunichar          left_char,
+                               gunichar          right_char,
+                               GtkDirectionType  direction,
+                               gint              depth,
+                               gboolean          is_exclusive,
+                               gboolean         *handled)
+{
+  IdeBracketIndex *index;
+  GtkTextIter pos = *iter;
+  GtkTextIter open;
+  GtkTextIter match;
+  gunichar ch;
+
+  /* Only C-family buffers are indexed */
+  if (!(index = ide_bracket_index_get_for_buffer (gtk_text_iter_get_buffer (iter))))
+    {
+      *handled = FALSE;
+      return FALSE;
+    }
+
+  ch = gtk_text_iter_get_char (iter);
+
+  /* Brackets within comments and strings are not indexed */
+  *handled = ((ch != left_char && ch != right_char) ||
+              ide_bracket_index_get_match (index, iter, &match));
+  if (!*handled)
+    return FALSE;
+
+  if (direction == GTK_DIR_LEFT)
+    {
+      /* The bracket under the cursor counts, unless it is the right bound */
+      if (!gtk_text_iter_ends_line (&pos) && ch != right_char)
+        gtk_text_iter_forward_char (&pos);
+
+      if (!ide_bracket_index_get_enclosing (index, &pos, left_char, depth, &match))
+        return FALSE;
+    }
+  else
+    {
+      if (!gtk_text_iter_forward_char (&pos) ||
+          !ide_bracket_index_get_enclosing (index, &pos, left_char, depth, &open) ||
+          !ide_bracket_index_get_match (index, &open, &match))
+        return FALSE;
+    }
+
+  *iter = match;
+
+  if (!is_exclusive)
+    gtk_text_iter_forward_char (iter);
+
+  return TRUE;
+}
+
 /* find the matching char position in 'depth' outer levels */
 static gboolean
 match_char_with_depth (GtkTextIter      *iter,
@@ -969,6 +1033,16 @@ match_char_with_depth (GtkTextIter      *iter,
   g_return_val_if_fail ((left_char == right_char && string_mode) ||
                         (left_char != right_char && !string_mode), FALSE);
 
+  if (!string_mode && is_bracket_pair (left_char, right_char))
+    {
+      gboolean handled;
+
+      ret = match_char_with_depth_indexed (iter, left_char, right_char, direction,
+                                           depth, is_exclusive, &handled);
+      if (handled)
+        return ret;
+    }
+
   state.jump_from = left_char;
   state.jump_to = right_char;
   state.direction = direction;
@@ -1182,12 +1256,19 @@ macro_conditionals_skip_block_forward (GtkTextIter *insert)
   return MACRO_COND_NONE;
 }
 
+/*
+ * Moves from an #if, #elif or #else to the next conditional of the same
+ * block, and from an #endif back to its #if. Buffers without a bracket
+ * index are scanned.
+ */
 static gboolean
 match_macro_conditionals (GtkTextIter *insert)
 {
+  IdeBracketIndex *index;
   GtkTextIter cursor;
   GtkTextIter cond_start;
   GtkTextIter cond_end;
+  GtkTextIter match;
   MacroCond next_cond;
   MacroCond cond;
 
@@ -1195,6 +1276,17 @@ match_macro_conditionals (GtkTextIter *insert)
   if (cond == MACRO_COND_NONE)
     return FALSE;
 
+  if ((index = ide_bracket_index_get_for_buffer (gtk_text_iter_get_buffer (insert))))
+    {
+      if (ide_bracket_index_get_match (index, &cond_start, &match))
+        {
+          *insert = match;
+          return TRUE;
+        }
+
+      return FALSE;
+    }
+
   if (cond == MACRO_COND_ENDIF)
     {
       cursor = cond_start;
@@ -1227,6 +1319,7 @@ static gboolean
 match_comments (GtkTextIter *insert,
                 gunichar     ch)
 {
+  IdeBracketIndex *index;
   GtkTextIter cursor;
   GtkTextIter cursor_before;
   GtkTextIter cursor_after;
@@ -1279,8 +1372,13 @@ match_comments (GtkTextIter *insert,
       return FALSE;
     }
 
+  index = ide_bracket_index_get_for_buffer (gtk_text_iter_get_buffer (insert));
+
   if (comment_start && !gtk_text_iter_is_end (&cursor))
     {
+      if (index != NULL && ide_bracket_index_get_comment (index, &cursor, NULL, insert))
+        return TRUE;
+
       if (_ide_text_iter_find_chars_forward (&cursor, NULL, NULL, "*/", FALSE))
         {
           gtk_text_iter_forward_char (&cursor);
@@ -1291,6 +1389,9 @@ match_comments (GtkTextIter *insert,
     }
   else if (!comment_start && !gtk_text_iter_is_start (&cursor))
     {
+      if (index != NULL && ide_bracket_index_get_comment (index, &cursor, insert, NULL))
+        return TRUE;
+
       if (_ide_text_iter_find_chars_backward (&cursor, NULL, NULL, "/*", FALSE))
         {
           *insert = cursor;
@@ -1489,73 +1590,29 @@ ide_source_view_movements_scroll_center (Movement *mv)
 static void
 ide_source_view_movements_next_word_end (Movement *mv)
 {
-  GtkTextIter copy;
-
-  copy = mv->insert;
-
-  _ide_text_iter_forward_word_end (&mv->insert);
-
-  /* prefer an empty line before word */
-  text_iter_forward_to_empty_line (&copy, &mv->insert);
-  if (gtk_text_iter_compare (&copy, &mv->insert) < 0)
-    mv->insert = copy;
-
-  if (!mv->exclusive && !gtk_text_iter_ends_line (&mv->insert))
-    gtk_text_iter_forward_char (&mv->insert);
+  /* prefers an empty line before word, like vim */
+  _ide_text_iter_forward_word_ends (&mv->insert, MAX (1, mv->count), !mv->exclusive);
 }
 
 static void
 ide_source_view_movements_next_full_word_end (Movement *mv)
 {
-  GtkTextIter copy;
-
-  copy = mv->insert;
-
-  _ide_text_iter_forward_WORD_end (&mv->insert);
-
-  /* prefer an empty line before word */
-  text_iter_forward_to_empty_line (&copy, &mv->insert);
-  if (gtk_text_iter_compare (&copy, &mv->insert) < 0)
-    mv->insert = copy;
-
-  if (!mv->exclusive && !gtk_text_iter_ends_line (&mv->insert))
-    gtk_text_iter_forward_char (&mv->insert);
+  /* prefers an empty line before word, like vim */
+  _ide_text_iter_forward_WORD_ends (&mv->insert, MAX (1, mv->count), !mv->exclusive);
 }
 
 static void
 ide_source_view_movements_next_word_start (Movement *mv)
 {
-  GtkTextIter copy;
-
-  copy = mv->insert;
-
-  _ide_text_iter_forward_word_start (&mv->insert);
-
-  /* prefer an empty line before word */
-  text_iter_forward_to_empty_line (&copy, &mv->insert);
-  if (gtk_text_iter_compare (&copy, &mv->insert) < 0)
-    mv->insert = copy;
-
-  if (!mv->exclusive && !gtk_text_iter_ends_line (&mv->insert))
-    gtk_text_iter_forward_char (&mv->insert);
+  /* prefers an empty line before word, like vim */
+  _ide_text_iter_forward_word_starts (&mv->insert, MAX (1, mv->count), !mv->exclusive);
 }
 
 static void
 ide_source_view_movements_next_full_word_start (Movement *mv)
 {
-  GtkTextIter copy;
-
-  copy = mv->insert;
-
-  _ide_text_iter_forward_WORD_start (&mv->insert);
-
-  /* prefer an empty line before word */
-  text_iter_forward_to_empty_line (&copy, &mv->insert);
-  if (gtk_text_iter_compare (&copy, &mv->insert) < 0)
-    mv->insert = copy;
-
-  if (!mv->exclusive && !gtk_text_iter_ends_line (&mv->insert))
-    gtk_text_iter_forward_char (&mv->insert);
+  /* prefers an empty line before word, like vim */
+  _ide_text_iter_forward_WORD_starts (&mv->insert, MAX (1, mv->count), !mv->exclusive);
 }
 
 static void
@@ -1649,7 +1706,12 @@ ide_source_view_movements_previous_full_word_end (Movement *mv)
 static void
 ide_source_view_movements_paragraph_start (Movement *mv)
 {
-  _ide_text_iter_backward_paragraph_start (&mv->insert);
+  guint i;
+
+  /* Once we hit the buffer bounds, further paragraphs are no-ops. */
+  for (i = MAX (1, mv->count); i > 0; i--)
+    if (!_ide_text_iter_backward_paragraph_start (&mv->insert))
+      break;
 
   if (mv->exclusive)
     {
@@ -1664,7 +1726,12 @@ ide_source_view_movements_paragraph_start (Movement *mv)
 static void
 ide_source_view_movements_paragraph_end (Movement *mv)
 {
-  _ide_text_iter_forward_paragraph_end (&mv->insert);
+  guint i;
+
+  /* Once we hit the buffer bounds, further paragraphs are no-ops. */
+  for (i = MAX (1, mv->count); i > 0; i--)
+    if (!_ide_text_iter_forward_paragraph_end (&mv->insert))
+      break;
 
   if (mv->exclusive)
     {
@@ -2044,8 +2111,7 @@ _ide_source_view_apply_movement (IdeSourceView         *self,
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_NEXT_FULL_WORD_START:
-      for (i = MAX (1, mv.count); i > 0; i--)
-        ide_source_view_movements_next_full_word_start (&mv);
+      ide_source_view_movements_next_full_word_start (&mv);
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_PREVIOUS_FULL_WORD_END:
@@ -2054,8 +2120,7 @@ _ide_source_view_apply_movement (IdeSourceView         *self,
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_NEXT_FULL_WORD_END:
-      for (i = MAX (1, mv.count); i > 0; i--)
-        ide_source_view_movements_next_full_word_end (&mv);
+      ide_source_view_movements_next_full_word_end (&mv);
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_PREVIOUS_SUB_WORD_START:
@@ -2073,8 +2138,7 @@ _ide_source_view_apply_movement (IdeSourceView         *self,
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_NEXT_WORD_START:
-      for (i = MAX (1, mv.count); i > 0; i--)
-        ide_source_view_movements_next_word_start (&mv);
+      ide_source_view_movements_next_word_start (&mv);
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_PREVIOUS_WORD_END:
@@ -2083,8 +2147,7 @@ _ide_source_view_apply_movement (IdeSourceView         *self,
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_NEXT_WORD_END:
-      for (i = MAX (1, mv.count); i > 0; i--)
-        ide_source_view_movements_next_word_end (&mv);
+      ide_source_view_movements_next_word_end (&mv);
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_SENTENCE_START:
@@ -2098,47 +2161,26 @@ _ide_source_view_apply_movement (IdeSourceView         *self,
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_PARAGRAPH_START:
-      for (i = MAX (1, mv.count); i > 0; i--)
-        {
-          mv.exclusive = exclusive && i == 1;
-          ide_source_view_movements_paragraph_start (&mv);
-        }
+      ide_source_view_movements_paragraph_start (&mv);
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_PARAGRAPH_END:
-      for (i = MAX (1, mv.count); i > 0; i--)
-        {
-          mv.exclusive = exclusive && i == 1;
-          ide_source_view_movements_paragraph_end (&mv);
-        }
+      ide_source_view_movements_paragraph_end (&mv);
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_PREVIOUS_LINE:
       mv.ignore_target_offset = TRUE;
       mv.ignore_select = TRUE;
       mv.count = MIN (mv.count, end_line);
-      /*
-       * It would be nice to do this as one large movement, but
-       * ide_source_view_movements_previous_line() needs to be
-       * split up into movements for different line-wise options.
-       */
-      for (i = MAX (1, mv.count); i > 0; i--)
-        if (!ide_source_view_movements_previous_line (&mv))
-          break;
+      ide_source_view_movements_previous_line (&mv, MAX (1, mv.count));
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_NEXT_LINE:
       mv.ignore_target_offset = TRUE;
       mv.ignore_select = TRUE;
       mv.count = MIN (mv.count, end_line);
-      /*
-       * It would be nice to do this as one large movement, but
-       * ide_source_view_movements_next_line() needs to be
-       * split up into movements for different line-wise options.
-       */
-      for (i = MAX (min_count, mv.count); i > 0; i--)
-        if (!ide_source_view_movements_next_line (&mv))
-          break;
+      if (MAX (min_count, mv.count) > 0)
+        ide_source_view_movements_next_line (&mv, MAX (min_count, mv.count));
       break;
 
     case IDE_SOURCE_VIEW_MOVEMENT_FIRST_LINE:
@@ -53,6 +53,7 @@
 #include "ide-line-diagnostics-gutter-renderer.h"
 #include "ide-pango.h"
 #include "ide-rgba.h"
+#include "ide-search-match-index.h"
 #include "ide-source-range.h"
 #include "ide-source-snippet.h"
 #include "ide-source-snippet-chunk.h"
@@ -115,6 +116,7 @@ typedef struct
   GQueue                      *snippets;
   GtkSourceCompletionProvider *snippets_provider;
   GtkSourceSearchContext      *search_context;
+  IdeSearchMatchIndex         *search_matches;
   EggAnimation                *hadj_animation;
   EggAnimation                *vadj_animation;
 
@@ -1513,6 +1515,8 @@ ide_source_view_bind_buffer (IdeSourceView  *self,
 
   g_clear_object (&search_settings);
 
+  priv->search_matches = ide_search_match_index_new (priv->search_context, GTK_TEXT_VIEW (self));
+
   /* Create scroll mark used by movements and our scrolling helper */
   gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (buffer), &iter);
   priv->scroll_mark = gtk_text_buffer_create_mark (GTK_TEXT_BUFFER (buffer), NULL, &iter, TRUE);
@@ -1586,6 +1590,7 @@ ide_source_view_unbind_buffer (IdeSourceView  *self,
 
   egg_signal_group_set_target (priv->completion_providers_signals, NULL);
 
+  g_clear_pointer (&priv->search_matches, ide_search_match_index_free);
   g_clear_object (&priv->search_context);
   g_clear_object (&priv->indenter_adapter);
   g_clear_object (&priv->completion_providers);
@@ -4442,52 +4447,46 @@ add_match (GtkTextView       *text_view,
 }
 
 static guint
-add_matches (GtkTextView            *text_view,
-             cairo_region_t         *region,
-             GtkSourceSearchContext *search_context,
-             const GtkTextIter      *begin,
-             const GtkTextIter      *end)
-{
-  GtkTextIter first_begin;
-  GtkTextIter new_begin;
-  GtkTextIter match_begin;
-  GtkTextIter match_end;
-  guint count = 0;
+add_matches (GtkTextView         *text_view,
+             cairo_region_t      *region,
+             IdeSearchMatchIndex *search_matches,
+             const GtkTextIter   *begin,
+             const GtkTextIter   *end)
+{
+  GtkTextBuffer *buffer;
+  const IdeSearchMatch *matches;
+  guint n_matches = 0;
+  guint i;
 
   g_assert (GTK_IS_TEXT_VIEW (text_view));
   g_assert (region);
-  g_assert (GTK_SOURCE_IS_SEARCH_CONTEXT (search_context));
+  g_assert (search_matches != NULL);
   g_assert (begin);
   g_assert (end);
 
-  if (!gtk_source_search_context_forward (search_context,
-                                          begin,
-                                          &first_begin,
-                                          &match_end))
-    return 0;
+  /*
+   * Only look at the matches we already know about. The index collects them
+   * asynchronously, so we never search the buffer from the draw path.
+   */
+  matches = ide_search_match_index_get_matches (search_matches,
+                                                gtk_text_iter_get_offset (begin),
+                                                gtk_text_iter_get_offset (end),
+                                                &n_matches);
 
-  add_match (text_view, region, &first_begin, &match_end);
+  buffer = gtk_text_view_get_buffer (text_view);
 
-  for (;; )
+  for (i = 0; i < n_matches; i++)
     {
-      gtk_text_iter_assign (&new_begin, &match_end);
+      GtkTextIter match_begin;
+      GtkTextIter match_end;
 
-      if (gtk_source_search_context_forward (search_context,
-                                             &new_begin,
-                                             &match_begin,
-                                             &match_end) &&
-          (gtk_text_iter_compare (&match_begin, end) < 0) &&
-          (gtk_text_iter_compare (&first_begin, &match_begin) != 0))
-        {
-          add_match (text_view, region, &match_begin, &match_end);
-          count++;
-          continue;
-        }
+      gtk_text_buffer_get_iter_at_offset (buffer, &match_begin, matches [i].begin);
+      gtk_text_buffer_get_iter_at_offset (buffer, &match_end, matches [i].end);
 
-      break;
+      add_match (text_view, region, &match_begin, &match_end);
     }
 
-  return count;
+  return n_matches;
 }
 
 static void
@@ -4524,7 +4523,9 @@ ide_source_view_draw_search_bubbles (IdeSourceView *self,
   g_return_if_fail (GTK_IS_TEXT_VIEW (text_view));
   g_return_if_fail (cr);
 
-  if (!priv->search_context || !gtk_source_search_context_get_highlight (priv->search_context))
+  if (!priv->search_context ||
+      !priv->search_matches ||
+      !gtk_source_search_context_get_highlight (priv->search_context))
     return;
 
   if (!gdk_cairo_get_clip_rectangle (cr, &area))
@@ -4539,7 +4540,7 @@ ide_source_view_draw_search_bubbles (IdeSourceView *self,
 
   clip_region = cairo_region_create_rectangle (&area);
   match_region = cairo_region_create ();
-  count = add_matches (text_view, match_region, priv->search_context, &begin, &end);
+  count = add_matches (text_view, match_region, priv->search_matches, &begin, &end);
 
   cairo_region_subtract (clip_region, match_region);
 
@@ -18,15 +18,43 @@
 
 #define G_LOG_DOMAIN "ide-symbol-resolver"
 
+#include <glib/gi18n.h>
+
 #include "ide-context.h"
 #include "ide-file.h"
 #include "ide-symbol-resolver.h"
 
 G_DEFINE_INTERFACE (IdeSymbolResolver, ide_symbol_resolver, IDE_TYPE_OBJECT)
 
+static void
+ide_symbol_resolver_real_find_references_async (IdeSymbolResolver   *self,
+                                                IdeSourceLocation   *location,
+                                                GCancellable        *cancellable,
+                                                GAsyncReadyCallback  callback,
+                                                gpointer             user_data)
+{
+  g_task_report_new_error (self, callback, user_data,
+                           ide_symbol_resolver_real_find_references_async,
+                           G_IO_ERROR,
+                           G_IO_ERROR_NOT_SUPPORTED,
+                           _("%s does not support finding references"),
+                           G_OBJECT_TYPE_NAME (self));
+}
+
+static GPtrArray *
+ide_symbol_resolver_real_find_references_finish (IdeSymbolResolver  *self,
+                                                 GAsyncResult       *result,
+                                                 GError            **error)
+{
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 static void
 ide_symbol_resolver_default_init (IdeSymbolResolverInterface *iface)
 {
+  iface->find_references_async = ide_symbol_resolver_real_find_references_async;
+  iface->find_references_finish = ide_symbol_resolver_real_find_references_finish;
+
   g_object_interface_install_property (iface,
                                        g_param_spec_object ("context",
                                                             "Context",
@@ -123,3 +151,51 @@ ide_symbol_resolver_get_symbol_tree_finish (IdeSymbolResolver  *self,
 
   return IDE_SYMBOL_RESOLVER_GET_IFACE (self)->get_symbol_tree_finish (self, result, error);
 }
+
+/**
+ * ide_symbol_resolver_find_references_async:
+ * @self: An #IdeSymbolResolver.
+ * @location: An #IdeSourceLocation.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A callback to execute upon completion.
+ * @user_data: user data for @callback.
+ *
+ * Asynchronously requests the locations of every reference to the symbol
+ * found at @location, across the whole project. @callback should call
+ * ide_symbol_resolver_find_references_finish() to retrieve the result.
+ */
+void
+ide_symbol_resolver_find_references_async (IdeSymbolResolver   *self,
+                                           IdeSourceLocation   *location,
+                                           GCancellable        *cancellable,
+                                           GAsyncReadyCallback  callback,
+                                           gpointer             user_data)
+{
+  g_return_if_fail (IDE_IS_SYMBOL_RESOLVER (self));
+  g_return_if_fail (location != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  IDE_SYMBOL_RESOLVER_GET_IFACE (self)->find_references_async (self, location, cancellable, callback, user_data);
+}
+
+/**
+ * ide_symbol_resolver_find_references_finish:
+ * @self: An #IdeSymbolResolver.
+ * @result: A #GAsyncResult provided to the callback.
+ * @error: (out): A location for an @error or %NULL.
+ *
+ * Completes an asynchronous call to ide_symbol_resolver_find_references_async().
+ *
+ * Returns: (transfer container) (element-type Ide.SourceRange): An array of
+ *   #IdeSourceRange if successful; otherwise %NULL and @error is set.
+ */
+GPtrArray *
+ide_symbol_resolver_find_references_finish (IdeSymbolResolver  *self,
+                                            GAsyncResult       *result,
+                                            GError            **error)
+{
+  g_return_val_if_fail (IDE_IS_SYMBOL_RESOLVER (self), NULL);
+  g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+
+  return IDE_SYMBOL_RESOLVER_GET_IFACE (self)->find_references_finish (self, result, error);
+}
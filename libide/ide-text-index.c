@@ -0,0 +1,1632 @@
+/* ide-text-index.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-text-index"
+
+#include <glib/gi18n.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ide-debug.h"
+#include "ide-global.h"
+#include "ide-text-index.h"
+#include "ide-thread-pool.h"
+
+/**
+ * SECTION:ide-text-index
+ * @title: IdeTextIndex
+ * @short_description: Trigram index for searching the contents of a project
+ *
+ * #IdeTextIndex records the set of trigrams found in every file below
+ * a directory, skipping anything the #IdeVcs ignores. A query is reduced
+ * to the trigrams any match must contain, so only the files containing
+ * all of them need to be read and checked.
+ *
+ * Trigrams are case-folded for ASCII so that the same index serves case
+ * sensitive and insensitive queries. The trigram set of each file is kept
+ * delta-encoded and persisted to the cache directory along with the
+ * modification time of the file, so that loading the index again only
+ * reads the files that have changed.
+ *
+ * The index is mutated from the main thread only. Reindexing or removing
+ * a file drops its postings right away and leaves an empty slot behind so
+ * that the ids of other files stay valid. Once empty slots make up half of
+ * the table, the table is compacted and the postings are rebuilt.
+ */
+
+#define TEXT_INDEX_VERSION      1
+#define TEXT_INDEX_TYPE         "(ua(sxay))"
+#define MAX_FILE_SIZE           (1024 * 1024)
+#define BINARY_CHECK_LENGTH     8000
+#define MIN_COMPACT_SLOTS       1024
+/* Stay well below the default inotify watch limit. */
+#define MAX_DIRECTORY_MONITORS  4096
+#define SAVE_DELAY_SECONDS      10
+
+#define FOLD(c)            ((guint8)g_ascii_tolower ((guchar)(c)))
+#define MAKE_TRIGRAM(a,b,c) (((guint32)(a) << 16) | ((guint32)(b) << 8) | (guint32)(c))
+
+typedef struct
+{
+  gchar  *path;
+  gint64  mtime;
+  /* Sorted trigrams, delta-encoded as varints */
+  GBytes *trigrams;
+  /* Position within TextIndexData.files */
+  guint32 id;
+} TextFile;
+
+typedef struct
+{
+  /* TextFile, the position is the file id. Dropped files leave a NULL. */
+  GPtrArray  *files;
+  guint       n_empty;
+  /* relative path => live TextFile */
+  GHashTable *paths;
+  /* trigram => GArray of guint32 file ids, ascending */
+  GHashTable *postings;
+  /* GFile of every directory that was crawled */
+  GPtrArray  *directories;
+} TextIndexData;
+
+typedef struct
+{
+  GFile  *root_directory;
+  IdeVcs *vcs;
+  gchar  *cache_path;
+} LoadRequest;
+
+typedef struct
+{
+  GFile  *root_directory;
+  gchar  *path;
+} UpdateRequest;
+
+typedef struct
+{
+  GFile     *root_directory;
+  GPtrArray *candidates;
+  GRegex    *regex;
+  guint      max_matches;
+} SearchRequest;
+
+struct _IdeTextIndex
+{
+  GObject        parent_instance;
+
+  GFile         *root_directory;
+  IdeVcs        *vcs;
+  gchar         *cache_path;
+  TextIndexData *data;
+
+  /* Relative paths waiting to be reindexed */
+  GHashTable    *updating;
+  GPtrArray     *monitors;
+
+  guint          save_source;
+};
+
+G_DEFINE_TYPE (IdeTextIndex, ide_text_index, G_TYPE_OBJECT)
+G_DEFINE_BOXED_TYPE (IdeTextIndexMatch, ide_text_index_match,
+                     ide_text_index_match_copy, ide_text_index_match_free)
+
+enum {
+  PROP_0,
+  PROP_ROOT_DIRECTORY,
+  PROP_VCS,
+  LAST_PROP
+};
+
+static GParamSpec *properties [LAST_PROP];
+
+static void
+text_file_free (gpointer data)
+{
+  TextFile *file = data;
+
+  g_free (file->path);
+  g_clear_pointer (&file->trigrams, g_bytes_unref);
+  g_slice_free (TextFile, file);
+}
+
+static TextIndexData *
+text_index_data_new (void)
+{
+  TextIndexData *data;
+
+  data = g_slice_new0 (TextIndexData);
+  data->files = g_ptr_array_new_with_free_func (text_file_free);
+  data->paths = g_hash_table_new (g_str_hash, g_str_equal);
+  data->postings = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify)g_array_unref);
+  data->directories = g_ptr_array_new_with_free_func (g_object_unref);
+
+  return data;
+}
+
+static void
+text_index_data_free (gpointer ptr)
+{
+  TextIndexData *data = ptr;
+
+  g_clear_pointer (&data->postings, g_hash_table_unref);
+  g_clear_pointer (&data->paths, g_hash_table_unref);
+  g_clear_pointer (&data->files, g_ptr_array_unref);
+  g_clear_pointer (&data->directories, g_ptr_array_unref);
+  g_slice_free (TextIndexData, data);
+}
+
+static void
+load_request_free (gpointer data)
+{
+  LoadRequest *request = data;
+
+  g_clear_object (&request->root_directory);
+  g_clear_object (&request->vcs);
+  g_free (request->cache_path);
+  g_slice_free (LoadRequest, request);
+}
+
+static void
+update_request_free (gpointer data)
+{
+  UpdateRequest *request = data;
+
+  g_clear_object (&request->root_directory);
+  g_free (request->path);
+  g_slice_free (UpdateRequest, request);
+}
+
+static void
+search_request_free (gpointer data)
+{
+  SearchRequest *request = data;
+
+  g_clear_object (&request->root_directory);
+  g_clear_pointer (&request->candidates, g_ptr_array_unref);
+  g_clear_pointer (&request->regex, g_regex_unref);
+  g_slice_free (SearchRequest, request);
+}
+
+IdeTextIndexMatch *
+ide_text_index_match_copy (const IdeTextIndexMatch *match)
+{
+  IdeTextIndexMatch *copy;
+
+  copy = g_slice_dup (IdeTextIndexMatch, match);
+  copy->path = g_strdup (match->path);
+  copy->text = g_strdup (match->text);
+
+  return copy;
+}
+
+void
+ide_text_index_match_free (IdeTextIndexMatch *match)
+{
+  if (match != NULL)
+    {
+      g_free (match->path);
+      g_free (match->text);
+      g_slice_free (IdeTextIndexMatch, match);
+    }
+}
+
+static gint
+compare_guint32 (gconstpointer a,
+                 gconstpointer b)
+{
+  guint32 ua = *(const guint32 *)a;
+  guint32 ub = *(const guint32 *)b;
+
+  return (ua < ub) ? -1 : (ua > ub) ? 1 : 0;
+}
+
+static GBytes *
+text_index_encode (const gchar *contents,
+                   gsize        len)
+{
+  g_autoptr(GArray) trigrams = NULL;
+  GByteArray *encoded;
+  guint32 last = 0;
+  gsize i;
+
+  trigrams = g_array_sized_new (FALSE, FALSE, sizeof (guint32), len);
+
+  for (i = 0; i + 2 < len; i++)
+    {
+      guint32 trigram;
+
+      /* Matches never span lines, so neither do trigrams. */
+      if (contents [i] == '\n' || contents [i + 1] == '\n' || contents [i + 2] == '\n')
+        continue;
+
+      trigram = MAKE_TRIGRAM (FOLD (contents [i]), FOLD (contents [i + 1]), FOLD (contents [i + 2]));
+      g_array_append_val (trigrams, trigram);
+    }
+
+  g_array_sort (trigrams, compare_guint32);
+
+  encoded = g_byte_array_sized_new (trigrams->len);
+
+  for (i = 0; i < trigrams->len; i++)
+    {
+      guint32 trigram = g_array_index (trigrams, guint32, i);
+      guint32 delta;
+      guint8 byte;
+
+      if (trigram == last)
+        continue;
+
+      delta = trigram - last;
+      last = trigram;
+
+      while (delta >= 0x80)
+        {
+          byte = (delta & 0x7F) | 0x80;
+          g_byte_array_append (encoded, &byte, 1);
+          delta >>= 7;
+        }
+
+      byte = delta;
+      g_byte_array_append (encoded, &byte, 1);
+    }
+
+  return g_byte_array_free_to_bytes (encoded);
+}
+
+static gsize
+text_file_next_trigram (const guint8 *encoded,
+                        gsize         len,
+                        gsize         i,
+                        guint32      *trigram)
+{
+  guint32 delta = 0;
+  guint shift = 0;
+
+  while (i < len)
+    {
+      guint8 byte = encoded [i++];
+
+      delta |= (guint32)(byte & 0x7F) << shift;
+      shift += 7;
+
+      if (!(byte & 0x80))
+        break;
+    }
+
+  *trigram += delta;
+
+  return i;
+}
+
+static void
+text_index_data_insert_postings (TextIndexData *data,
+                                 TextFile      *file)
+{
+  const guint8 *encoded;
+  guint32 trigram = 0;
+  gsize len = 0;
+  gsize i = 0;
+
+  encoded = g_bytes_get_data (file->trigrams, &len);
+
+  while (i < len)
+    {
+      GArray *posting;
+
+      i = text_file_next_trigram (encoded, len, i, &trigram);
+
+      if (!(posting = g_hash_table_lookup (data->postings, GUINT_TO_POINTER (trigram))))
+        {
+          posting = g_array_new (FALSE, FALSE, sizeof (guint32));
+          g_hash_table_insert (data->postings, GUINT_TO_POINTER (trigram), posting);
+        }
+
+      g_array_append_val (posting, file->id);
+    }
+}
+
+static void
+text_index_data_remove_postings (TextIndexData *data,
+                                 TextFile      *file)
+{
+  const guint8 *encoded;
+  guint32 trigram = 0;
+  gsize len = 0;
+  gsize i = 0;
+
+  encoded = g_bytes_get_data (file->trigrams, &len);
+
+  while (i < len)
+    {
+      GArray *posting;
+      guint lo = 0;
+      guint hi;
+
+      i = text_file_next_trigram (encoded, len, i, &trigram);
+
+      if (!(posting = g_hash_table_lookup (data->postings, GUINT_TO_POINTER (trigram))))
+        continue;
+
+      /* Postings are ascending, the id is found by bisection. */
+      hi = posting->len;
+
+      while (lo < hi)
+        {
+          guint mid = (lo + hi) / 2;
+
+          if (g_array_index (posting, guint32, mid) < file->id)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+
+      if (lo < posting->len && g_array_index (posting, guint32, lo) == file->id)
+        g_array_remove_index (posting, lo);
+
+      if (posting->len == 0)
+        g_hash_table_remove (data->postings, GUINT_TO_POINTER (trigram));
+    }
+}
+
+static void
+text_index_data_compact (TextIndexData *data)
+{
+  GPtrArray *files;
+  guint i;
+
+  g_assert (data != NULL);
+
+  files = g_ptr_array_new_full (data->files->len - data->n_empty, text_file_free);
+
+  for (i = 0; i < data->files->len; i++)
+    {
+      TextFile *file = g_ptr_array_index (data->files, i);
+
+      if (file != NULL)
+        {
+          file->id = files->len;
+          g_ptr_array_add (files, file);
+        }
+    }
+
+  /* The files moved to the new array, don't free them with the old one. */
+  g_ptr_array_set_free_func (data->files, NULL);
+  g_ptr_array_unref (data->files);
+  data->files = files;
+  data->n_empty = 0;
+
+  g_hash_table_remove_all (data->postings);
+
+  for (i = 0; i < data->files->len; i++)
+    text_index_data_insert_postings (data, g_ptr_array_index (data->files, i));
+}
+
+static void
+text_index_data_drop (TextIndexData *data,
+                      TextFile      *file)
+{
+  g_assert (data != NULL);
+  g_assert (file != NULL);
+  g_assert (g_ptr_array_index (data->files, file->id) == file);
+
+  text_index_data_remove_postings (data, file);
+  g_hash_table_remove (data->paths, file->path);
+
+  g_ptr_array_index (data->files, file->id) = NULL;
+  data->n_empty++;
+
+  text_file_free (file);
+}
+
+static void
+text_index_data_maybe_compact (TextIndexData *data)
+{
+  if (data->n_empty >= MIN_COMPACT_SLOTS && data->n_empty >= data->files->len / 2)
+    text_index_data_compact (data);
+}
+
+static void
+text_index_data_add (TextIndexData *data,
+                     TextFile      *file)
+{
+  TextFile *previous;
+
+  g_assert (data != NULL);
+  g_assert (file != NULL);
+
+  if ((previous = g_hash_table_lookup (data->paths, file->path)))
+    text_index_data_drop (data, previous);
+
+  file->id = data->files->len;
+  g_ptr_array_add (data->files, file);
+  g_hash_table_insert (data->paths, file->path, file);
+
+  text_index_data_insert_postings (data, file);
+  text_index_data_maybe_compact (data);
+}
+
+static void
+text_index_data_remove (TextIndexData *data,
+                        const gchar   *path)
+{
+  TextFile *file;
+
+  if ((file = g_hash_table_lookup (data->paths, path)))
+    {
+      text_index_data_drop (data, file);
+      text_index_data_maybe_compact (data);
+    }
+}
+
+static GVariant *
+text_index_data_serialize (TextIndexData *data)
+{
+  GVariantBuilder builder;
+  guint i;
+
+  g_assert (data != NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (TEXT_INDEX_TYPE));
+  g_variant_builder_add (&builder, "u", TEXT_INDEX_VERSION);
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(sxay)"));
+
+  for (i = 0; i < data->files->len; i++)
+    {
+      const TextFile *file = g_ptr_array_index (data->files, i);
+
+      if (file == NULL)
+        continue;
+
+      g_variant_builder_add (&builder, "(sx@ay)",
+                             file->path,
+                             file->mtime,
+                             g_variant_new_from_bytes (G_VARIANT_TYPE_BYTESTRING, file->trigrams, TRUE));
+    }
+
+  g_variant_builder_close (&builder);
+
+  return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static gboolean
+text_index_write (const gchar  *path,
+                  GVariant     *variant,
+                  GError      **error)
+{
+  g_autofree gchar *dir = NULL;
+
+  g_assert (path != NULL);
+  g_assert (variant != NULL);
+
+  dir = g_path_get_dirname (path);
+  g_mkdir_with_parents (dir, 0750);
+
+  return g_file_set_contents (path,
+                              g_variant_get_data (variant),
+                              g_variant_get_size (variant),
+                              error);
+}
+
+/*
+ * Reads @path and returns a TextFile for it, or %NULL if the file
+ * does not exist or should not be indexed.
+ */
+static TextFile *
+text_index_read_file (GFile       *file,
+                      const gchar *relative_path)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GFileInfo) info = NULL;
+  g_autofree gchar *path = NULL;
+  const gchar *contents;
+  TextFile *ret;
+  gsize len;
+
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_STANDARD_TYPE","
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                            NULL,
+                            NULL);
+
+  if (info == NULL ||
+      g_file_info_get_file_type (info) != G_FILE_TYPE_REGULAR ||
+      g_file_info_get_size (info) > MAX_FILE_SIZE)
+    return NULL;
+
+  if (!(path = g_file_get_path (file)) ||
+      !(mapped = g_mapped_file_new (path, FALSE, NULL)))
+    return NULL;
+
+  contents = g_mapped_file_get_contents (mapped);
+  len = g_mapped_file_get_length (mapped);
+
+  if (memchr (contents, '\0', MIN (len, BINARY_CHECK_LENGTH)) != NULL)
+    return NULL;
+
+  ret = g_slice_new0 (TextFile);
+  ret->path = g_strdup (relative_path);
+  ret->mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  ret->trigrams = text_index_encode (contents, len);
+
+  return ret;
+}
+
+static void
+text_index_crawl (TextIndexData *data,
+                  LoadRequest   *request,
+                  GHashTable    *cached,
+                  GFile         *directory,
+                  const gchar   *relpath,
+                  GCancellable  *cancellable)
+{
+  g_autoptr(GFileEnumerator) enumerator = NULL;
+  gpointer infoptr;
+
+  g_assert (data != NULL);
+  g_assert (G_IS_FILE (directory));
+
+  g_ptr_array_add (data->directories, g_object_ref (directory));
+
+  enumerator = g_file_enumerate_children (directory,
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME","
+                                          G_FILE_ATTRIBUTE_STANDARD_TYPE","
+                                          G_FILE_ATTRIBUTE_STANDARD_SIZE","
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          cancellable,
+                                          NULL);
+
+  if (enumerator == NULL)
+    return;
+
+  while ((infoptr = g_file_enumerator_next_file (enumerator, cancellable, NULL)))
+    {
+      g_autoptr(GFileInfo) info = infoptr;
+      g_autoptr(GFile) child = NULL;
+      g_autofree gchar *path = NULL;
+      const gchar *name = g_file_info_get_name (info);
+      GFileType file_type = g_file_info_get_file_type (info);
+      TextFile *file;
+      GVariant *entry;
+      gint64 mtime;
+
+      if (name [0] == '.')
+        continue;
+
+      child = g_file_get_child (directory, name);
+
+      if (request->vcs != NULL && ide_vcs_is_ignored (request->vcs, child, NULL))
+        continue;
+
+      path = relpath ? g_build_filename (relpath, name, NULL) : g_strdup (name);
+
+      if (file_type == G_FILE_TYPE_DIRECTORY)
+        {
+          text_index_crawl (data, request, cached, child, path, cancellable);
+          continue;
+        }
+
+      if (file_type != G_FILE_TYPE_REGULAR || g_file_info_get_size (info) > MAX_FILE_SIZE)
+        continue;
+
+      mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+
+      if ((entry = g_hash_table_lookup (cached, path)))
+        {
+          g_autoptr(GVariant) trigrams = NULL;
+          gint64 cached_mtime = 0;
+
+          g_variant_get_child (entry, 1, "x", &cached_mtime);
+
+          if (cached_mtime == mtime)
+            {
+              trigrams = g_variant_get_child_value (entry, 2);
+
+              file = g_slice_new0 (TextFile);
+              file->path = g_steal_pointer (&path);
+              file->mtime = mtime;
+              file->trigrams = g_variant_get_data_as_bytes (trigrams);
+
+              text_index_data_add (data, file);
+
+              continue;
+            }
+        }
+
+      if ((file = text_index_read_file (child, path)))
+        text_index_data_add (data, file);
+    }
+}
+
+static void
+ide_text_index_load_worker (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  LoadRequest *request = task_data;
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GHashTable) cached = NULL;
+  g_autoptr(GVariant) db = NULL;
+  g_autoptr(GVariant) serialized = NULL;
+  g_autoptr(GError) error = NULL;
+  TextIndexData *data;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (request != NULL);
+
+  cached = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_variant_unref);
+
+  if ((mapped = g_mapped_file_new (request->cache_path, FALSE, NULL)))
+    {
+      g_autoptr(GBytes) bytes = g_mapped_file_get_bytes (mapped);
+      guint32 version = 0;
+
+      db = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (TEXT_INDEX_TYPE), bytes, FALSE));
+      g_variant_get_child (db, 0, "u", &version);
+
+      if (version == TEXT_INDEX_VERSION)
+        {
+          g_autoptr(GVariant) files = g_variant_get_child_value (db, 1);
+          gsize n_files = g_variant_n_children (files);
+          gsize i;
+
+          for (i = 0; i < n_files; i++)
+            {
+              GVariant *entry = g_variant_get_child_value (files, i);
+              const gchar *path;
+
+              g_variant_get_child (entry, 0, "&s", &path);
+              g_hash_table_insert (cached, (gchar *)path, entry);
+            }
+        }
+    }
+
+  data = text_index_data_new ();
+  text_index_crawl (data, request, cached, request->root_directory, NULL, cancellable);
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      text_index_data_free (data);
+      return;
+    }
+
+  serialized = text_index_data_serialize (data);
+
+  if (!text_index_write (request->cache_path, serialized, &error))
+    g_warning ("Failed to write text index: %s", error->message);
+
+  g_task_return_pointer (task, data, text_index_data_free);
+}
+
+static void
+ide_text_index_save_worker (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  IdeTextIndex *self = source_object;
+  GVariant *serialized = task_data;
+  GError *error = NULL;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (IDE_IS_TEXT_INDEX (self));
+  g_assert (serialized != NULL);
+
+  if (!text_index_write (self->cache_path, serialized, &error))
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+ide_text_index_save_cb (GObject      *object,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+  g_autoptr(GError) error = NULL;
+
+  g_assert (IDE_IS_TEXT_INDEX (object));
+  g_assert (G_IS_TASK (result));
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    g_warning ("Failed to write text index: %s", error->message);
+}
+
+static gboolean
+ide_text_index_save (gpointer user_data)
+{
+  IdeTextIndex *self = user_data;
+  g_autoptr(GTask) task = NULL;
+
+  g_assert (IDE_IS_TEXT_INDEX (self));
+
+  self->save_source = 0;
+
+  if (self->data != NULL)
+    {
+      task = g_task_new (self, NULL, ide_text_index_save_cb, NULL);
+      g_task_set_source_tag (task, ide_text_index_save);
+      g_task_set_task_data (task,
+                            text_index_data_serialize (self->data),
+                            (GDestroyNotify)g_variant_unref);
+      ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, task, ide_text_index_save_worker);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+ide_text_index_queue_save (IdeTextIndex *self)
+{
+  g_assert (IDE_IS_TEXT_INDEX (self));
+
+  if (self->save_source == 0)
+    self->save_source = g_timeout_add_seconds (SAVE_DELAY_SECONDS, ide_text_index_save, self);
+}
+
+static void
+ide_text_index_update_worker (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+  UpdateRequest *request = task_data;
+  g_autoptr(GFile) file = NULL;
+  TextFile *result;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (request != NULL);
+
+  file = g_file_resolve_relative_path (request->root_directory, request->path);
+
+  /* A NULL result means the file was removed from the index. */
+  result = text_index_read_file (file, request->path);
+
+  g_task_return_pointer (task, result, result ? text_file_free : NULL);
+}
+
+static void
+ide_text_index_update_cb (GObject      *object,
+                          GAsyncResult *result,
+                          gpointer      user_data)
+{
+  IdeTextIndex *self = (IdeTextIndex *)object;
+  UpdateRequest *request;
+  TextFile *file;
+
+  g_assert (IDE_IS_TEXT_INDEX (self));
+  g_assert (G_IS_TASK (result));
+
+  request = g_task_get_task_data (G_TASK (result));
+  g_hash_table_remove (self->updating, request->path);
+
+  if (self->data == NULL)
+    return;
+
+  if ((file = g_task_propagate_pointer (G_TASK (result), NULL)))
+    text_index_data_add (self->data, file);
+  else
+    text_index_data_remove (self->data, request->path);
+
+  ide_text_index_queue_save (self);
+}
+
+/**
+ * ide_text_index_update_file:
+ * @self: An #IdeTextIndex
+ * @file: A #GFile below the root directory
+ *
+ * Reindexes @file, such as after it has been saved. If @file no longer
+ * exists, it is removed from the index.
+ */
+void
+ide_text_index_update_file (IdeTextIndex *self,
+                            GFile        *file)
+{
+  g_autoptr(GTask) task = NULL;
+  UpdateRequest *request;
+  gchar *path;
+
+  g_return_if_fail (IDE_IS_TEXT_INDEX (self));
+  g_return_if_fail (G_IS_FILE (file));
+
+  if (self->data == NULL)
+    return;
+
+  if (!(path = g_file_get_relative_path (self->root_directory, file)))
+    return;
+
+  if (g_hash_table_contains (self->updating, path) ||
+      (self->vcs != NULL && ide_vcs_is_ignored (self->vcs, file, NULL)))
+    {
+      g_free (path);
+      return;
+    }
+
+  g_hash_table_add (self->updating, path);
+
+  request = g_slice_new0 (UpdateRequest);
+  request->root_directory = g_object_ref (self->root_directory);
+  request->path = g_strdup (path);
+
+  task = g_task_new (self, NULL, ide_text_index_update_cb, NULL);
+  g_task_set_source_tag (task, ide_text_index_update_file);
+  g_task_set_task_data (task, request, update_request_free);
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, task, ide_text_index_update_worker);
+}
+
+static void
+ide_text_index_monitor_changed (IdeTextIndex      *self,
+                                GFile             *file,
+                                GFile             *other_file,
+                                GFileMonitorEvent  event,
+                                GFileMonitor      *monitor)
+{
+  g_assert (IDE_IS_TEXT_INDEX (self));
+  g_assert (G_IS_FILE (file));
+  g_assert (G_IS_FILE_MONITOR (monitor));
+
+  switch (event)
+    {
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_DELETED:
+      ide_text_index_update_file (self, file);
+      break;
+
+    default:
+      break;
+    }
+}
+
+static void
+ide_text_index_monitor_directories (IdeTextIndex *self)
+{
+  GPtrArray *directories;
+  guint i;
+
+  g_assert (IDE_IS_TEXT_INDEX (self));
+  g_assert (self->data != NULL);
+
+  directories = self->data->directories;
+
+  if (directories->len > MAX_DIRECTORY_MONITORS)
+    g_debug ("Only monitoring %u of %u directories for changes",
+             MAX_DIRECTORY_MONITORS, directories->len);
+
+  for (i = 0; i < directories->len && i < MAX_DIRECTORY_MONITORS; i++)
+    {
+      GFile *directory = g_ptr_array_index (directories, i);
+      GFileMonitor *monitor;
+
+      if (!(monitor = g_file_monitor_directory (directory, G_FILE_MONITOR_NONE, NULL, NULL)))
+        continue;
+
+      g_signal_connect_object (monitor,
+                               "changed",
+                               G_CALLBACK (ide_text_index_monitor_changed),
+                               self,
+                               G_CONNECT_SWAPPED);
+
+      g_ptr_array_add (self->monitors, monitor);
+    }
+
+  /* Only needed to set up the monitors. */
+  g_ptr_array_set_size (directories, 0);
+}
+
+static void
+ide_text_index_load_cb (GObject      *object,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+  IdeTextIndex *self = (IdeTextIndex *)object;
+  g_autoptr(GTask) task = user_data;
+  GError *error = NULL;
+  TextIndexData *data;
+
+  g_assert (IDE_IS_TEXT_INDEX (self));
+  g_assert (G_IS_TASK (result));
+  g_assert (G_IS_TASK (task));
+
+  if (!(data = g_task_propagate_pointer (G_TASK (result), &error)))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_clear_pointer (&self->data, text_index_data_free);
+  self->data = data;
+
+  g_ptr_array_set_size (self->monitors, 0);
+  ide_text_index_monitor_directories (self);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * ide_text_index_load_async:
+ * @self: An #IdeTextIndex
+ * @cancellable: (nullable): A #GCancellable or %NULL
+ * @callback: A callback to execute upon completion
+ * @user_data: User data for @callback
+ *
+ * Loads the index from the cache directory and reindexes the files that
+ * have changed since it was written. Once loaded, the index follows
+ * changes to the files using file monitors.
+ */
+void
+ide_text_index_load_async (IdeTextIndex        *self,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  g_autoptr(GTask) inner = NULL;
+  LoadRequest *request;
+
+  g_return_if_fail (IDE_IS_TEXT_INDEX (self));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, ide_text_index_load_async);
+
+  request = g_slice_new0 (LoadRequest);
+  request->root_directory = g_object_ref (self->root_directory);
+  request->vcs = self->vcs ? g_object_ref (self->vcs) : NULL;
+  request->cache_path = g_strdup (self->cache_path);
+
+  inner = g_task_new (self, cancellable, ide_text_index_load_cb, g_object_ref (task));
+  g_task_set_source_tag (inner, ide_text_index_load_async);
+  g_task_set_task_data (inner, request, load_request_free);
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, inner, ide_text_index_load_worker);
+}
+
+gboolean
+ide_text_index_load_finish (IdeTextIndex  *self,
+                            GAsyncResult  *result,
+                            GError       **error)
+{
+  g_return_val_if_fail (IDE_IS_TEXT_INDEX (self), FALSE);
+  g_return_val_if_fail (G_IS_TASK (result), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+add_run_trigrams (GArray      *trigrams,
+                  const gchar *run,
+                  gsize        len,
+                  gboolean     case_sensitive)
+{
+  gsize i;
+
+  for (i = 0; i + 2 < len; i++)
+    {
+      guint32 trigram;
+
+      /*
+       * The index only folds ASCII, so other case variants of a non-ASCII
+       * character would not be found by a case insensitive query.
+       */
+      if (!case_sensitive &&
+          (((guchar)run [i] | (guchar)run [i + 1] | (guchar)run [i + 2]) & 0x80))
+        continue;
+
+      trigram = MAKE_TRIGRAM (FOLD (run [i]), FOLD (run [i + 1]), FOLD (run [i + 2]));
+      g_array_append_val (trigrams, trigram);
+    }
+}
+
+static void
+flush_run (GString  *run,
+           GArray   *trigrams,
+           gboolean  case_sensitive)
+{
+  add_run_trigrams (trigrams, run->str, run->len, case_sensitive);
+  g_string_truncate (run, 0);
+}
+
+static void
+drop_last_char (GString *run)
+{
+  const gchar *prev;
+
+  if (run->len > 0 && (prev = g_utf8_find_prev_char (run->str, run->str + run->len)))
+    g_string_truncate (run, prev - run->str);
+  else
+    g_string_truncate (run, 0);
+}
+
+/*
+ * Collects the trigrams of the literal runs that every match of @pattern
+ * must contain. This is conservative: anything that is not understood
+ * ends the current run, and an alternation means there is no such run.
+ */
+static void
+plan_regex (const gchar *pattern,
+            GArray      *trigrams,
+            gboolean     case_sensitive)
+{
+  g_autoptr(GString) run = NULL;
+  const gchar *p;
+
+  if (strchr (pattern, '|') != NULL)
+    return;
+
+  run = g_string_new (NULL);
+
+  for (p = pattern; *p; p++)
+    {
+      switch (*p)
+        {
+        case '\\':
+          if (p [1] != '\0' && g_ascii_ispunct (p [1]))
+            {
+              g_string_append_c (run, *++p);
+              break;
+            }
+          flush_run (run, trigrams, case_sensitive);
+          if (p [1] != '\0')
+            p++;
+          break;
+
+        case '[':
+          flush_run (run, trigrams, case_sensitive);
+          p++;
+          if (*p == '^')
+            p++;
+          if (*p == ']')
+            p++;
+          for (; *p && *p != ']'; p++)
+            {
+              if (*p == '\\' && p [1] != '\0')
+                p++;
+            }
+          if (*p == '\0')
+            return;
+          break;
+
+        case '(':
+          {
+            guint depth = 1;
+
+            flush_run (run, trigrams, case_sensitive);
+            for (p++; *p && depth > 0; p++)
+              {
+                if (*p == '\\' && p [1] != '\0')
+                  p++;
+                else if (*p == '(')
+                  depth++;
+                else if (*p == ')')
+                  depth--;
+              }
+            if (*p == '\0')
+              return;
+            p--;
+          }
+          break;
+
+        case '{':
+          drop_last_char (run);
+          flush_run (run, trigrams, case_sensitive);
+          while (p [1] != '\0' && *p != '}')
+            p++;
+          break;
+
+        case '*':
+        case '?':
+          drop_last_char (run);
+          flush_run (run, trigrams, case_sensitive);
+          break;
+
+        case '+':
+        case '.':
+        case '^':
+        case '$':
+          flush_run (run, trigrams, case_sensitive);
+          break;
+
+        default:
+          g_string_append_c (run, *p);
+          break;
+        }
+    }
+
+  flush_run (run, trigrams, case_sensitive);
+}
+
+static GArray *
+intersect (GArray *a,
+           GArray *b)
+{
+  GArray *ret;
+  guint i = 0;
+  guint j = 0;
+
+  ret = g_array_sized_new (FALSE, FALSE, sizeof (guint32), MIN (a->len, b->len));
+
+  while (i < a->len && j < b->len)
+    {
+      guint32 ai = g_array_index (a, guint32, i);
+      guint32 bj = g_array_index (b, guint32, j);
+
+      if (ai < bj)
+        i++;
+      else if (ai > bj)
+        j++;
+      else
+        {
+          g_array_append_val (ret, ai);
+          i++;
+          j++;
+        }
+    }
+
+  return ret;
+}
+
+static gint
+compare_postings (gconstpointer a,
+                  gconstpointer b)
+{
+  const GArray *pa = *(GArray * const *)a;
+  const GArray *pb = *(GArray * const *)b;
+
+  return (gint)pa->len - (gint)pb->len;
+}
+
+/*
+ * Returns the relative paths of the files that contain every trigram in
+ * @trigrams, or every file in the index if @trigrams is empty.
+ */
+static GPtrArray *
+ide_text_index_get_candidates (IdeTextIndex *self,
+                               GArray       *trigrams)
+{
+  g_autoptr(GPtrArray) postings = NULL;
+  g_autoptr(GArray) ids = NULL;
+  GPtrArray *ret;
+  guint i;
+
+  g_assert (IDE_IS_TEXT_INDEX (self));
+  g_assert (self->data != NULL);
+
+  ret = g_ptr_array_new_with_free_func (g_free);
+
+  if (trigrams->len == 0)
+    {
+      for (i = 0; i < self->data->files->len; i++)
+        {
+          const TextFile *file = g_ptr_array_index (self->data->files, i);
+
+          if (file != NULL)
+            g_ptr_array_add (ret, g_strdup (file->path));
+        }
+
+      return ret;
+    }
+
+  g_array_sort (trigrams, compare_guint32);
+  postings = g_ptr_array_new ();
+
+  for (i = 0; i < trigrams->len; i++)
+    {
+      guint32 trigram = g_array_index (trigrams, guint32, i);
+      GArray *posting;
+
+      if (i > 0 && trigram == g_array_index (trigrams, guint32, i - 1))
+        continue;
+
+      if (!(posting = g_hash_table_lookup (self->data->postings, GUINT_TO_POINTER (trigram))))
+        return ret;
+
+      g_ptr_array_add (postings, posting);
+    }
+
+  /* Start with the rarest trigram to keep the intermediate sets small. */
+  g_ptr_array_sort (postings, compare_postings);
+
+  ids = g_array_ref (g_ptr_array_index (postings, 0));
+
+  for (i = 1; i < postings->len && ids->len > 0; i++)
+    {
+      GArray *next = intersect (ids, g_ptr_array_index (postings, i));
+
+      g_array_unref (ids);
+      ids = next;
+    }
+
+  for (i = 0; i < ids->len; i++)
+    {
+      const TextFile *file = g_ptr_array_index (self->data->files, g_array_index (ids, guint32, i));
+
+      if (file != NULL)
+        g_ptr_array_add (ret, g_strdup (file->path));
+    }
+
+  return ret;
+}
+
+static void
+ide_text_index_search_worker (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+  SearchRequest *request = task_data;
+  g_autoptr(GPtrArray) matches = NULL;
+  guint i;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (request != NULL);
+
+  matches = g_ptr_array_new_with_free_func ((GDestroyNotify)ide_text_index_match_free);
+
+  for (i = 0; i < request->candidates->len && matches->len < request->max_matches; i++)
+    {
+      const gchar *relative_path = g_ptr_array_index (request->candidates, i);
+      g_autoptr(GMatchInfo) match_info = NULL;
+      g_autoptr(GMappedFile) mapped = NULL;
+      g_autoptr(GFile) file = NULL;
+      g_autofree gchar *path = NULL;
+      const gchar *contents;
+      const gchar *line_start;
+      const gchar *counted;
+      guint line = 0;
+      gsize len;
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      file = g_file_resolve_relative_path (request->root_directory, relative_path);
+
+      if (!(path = g_file_get_path (file)) ||
+          !(mapped = g_mapped_file_new (path, FALSE, NULL)))
+        continue;
+
+      contents = g_mapped_file_get_contents (mapped);
+      len = g_mapped_file_get_length (mapped);
+
+      if (contents == NULL || !g_utf8_validate (contents, len, NULL))
+        continue;
+
+      if (!g_regex_match_full (request->regex, contents, len, 0, 0, &match_info, NULL))
+        continue;
+
+      line_start = counted = contents;
+
+      do
+        {
+          IdeTextIndexMatch *match;
+          const gchar *line_end;
+          gint begin = 0;
+          gint end = 0;
+
+          if (!g_match_info_fetch_pos (match_info, 0, &begin, &end))
+            break;
+
+          /* Count lines from where the previous match left off. */
+          for (; counted < contents + begin; counted++)
+            {
+              if (*counted == '\n')
+                {
+                  line++;
+                  line_start = counted + 1;
+                }
+            }
+
+          if (!(line_end = memchr (contents + begin, '\n', len - begin)))
+            line_end = contents + len;
+
+          match = g_slice_new0 (IdeTextIndexMatch);
+          match->path = g_strdup (relative_path);
+          match->text = g_strndup (line_start, line_end - line_start);
+          match->line = line;
+          match->line_offset = g_utf8_strlen (line_start, contents + begin - line_start);
+          match->length = g_utf8_strlen (contents + begin, MIN (end, line_end - contents) - begin);
+
+          g_ptr_array_add (matches, match);
+        }
+      while (matches->len < request->max_matches &&
+             g_match_info_next (match_info, NULL));
+    }
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  g_task_return_pointer (task, g_steal_pointer (&matches), (GDestroyNotify)g_ptr_array_unref);
+}
+
+/**
+ * ide_text_index_search_async:
+ * @self: An #IdeTextIndex
+ * @query: The text or regular expression to search for
+ * @flags: Flags for the search
+ * @max_matches: The maximum number of matches to return
+ * @cancellable: (nullable): A #GCancellable or %NULL
+ * @callback: A callback to execute upon completion
+ * @user_data: User data for @callback
+ *
+ * Searches the indexed files for @query. Only the files containing every
+ * trigram of the literal parts of @query are read.
+ */
+void
+ide_text_index_search_async (IdeTextIndex            *self,
+                             const gchar             *query,
+                             IdeTextIndexSearchFlags  flags,
+                             guint                    max_matches,
+                             GCancellable            *cancellable,
+                             GAsyncReadyCallback      callback,
+                             gpointer                 user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  g_autoptr(GArray) trigrams = NULL;
+  g_autoptr(GRegex) regex = NULL;
+  g_autofree gchar *escaped = NULL;
+  gboolean case_sensitive;
+  SearchRequest *request;
+  GRegexCompileFlags compile_flags;
+  GError *error = NULL;
+
+  IDE_ENTRY;
+
+  g_return_if_fail (IDE_IS_TEXT_INDEX (self));
+  g_return_if_fail (query != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, ide_text_index_search_async);
+
+  if (self->data == NULL)
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_NOT_INITIALIZED,
+                               _("The text index has not been loaded"));
+      IDE_EXIT;
+    }
+
+  case_sensitive = !!(flags & IDE_TEXT_INDEX_SEARCH_CASE_SENSITIVE);
+  compile_flags = G_REGEX_MULTILINE | G_REGEX_OPTIMIZE;
+  if (!case_sensitive)
+    compile_flags |= G_REGEX_CASELESS;
+
+  trigrams = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  if (flags & IDE_TEXT_INDEX_SEARCH_REGEX)
+    {
+      plan_regex (query, trigrams, case_sensitive);
+      regex = g_regex_new (query, compile_flags, 0, &error);
+    }
+  else
+    {
+      add_run_trigrams (trigrams, query, strlen (query), case_sensitive);
+      escaped = g_regex_escape_string (query, -1);
+      regex = g_regex_new (escaped, compile_flags, 0, &error);
+    }
+
+  if (regex == NULL)
+    {
+      g_task_return_error (task, error);
+      IDE_EXIT;
+    }
+
+  request = g_slice_new0 (SearchRequest);
+  request->root_directory = g_object_ref (self->root_directory);
+  request->candidates = ide_text_index_get_candidates (self, trigrams);
+  request->regex = g_steal_pointer (&regex);
+  request->max_matches = max_matches ? max_matches : G_MAXUINT;
+
+  IDE_TRACE_MSG ("%u candidates for %u trigrams", request->candidates->len, trigrams->len);
+
+  g_task_set_task_data (task, request, search_request_free);
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, task, ide_text_index_search_worker);
+
+  IDE_EXIT;
+}
+
+/**
+ * ide_text_index_search_finish:
+ * @self: An #IdeTextIndex
+ * @result: A #GAsyncResult
+ * @error: A location for a #GError or %NULL
+ *
+ * Completes a call to ide_text_index_search_async().
+ *
+ * Returns: (transfer container) (element-type Ide.TextIndexMatch): An array
+ *   of #IdeTextIndexMatch.
+ */
+GPtrArray *
+ide_text_index_search_finish (IdeTextIndex  *self,
+                              GAsyncResult  *result,
+                              GError       **error)
+{
+  g_return_val_if_fail (IDE_IS_TEXT_INDEX (self), NULL);
+  g_return_val_if_fail (G_IS_TASK (result), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * ide_text_index_get_root_directory:
+ * @self: An #IdeTextIndex
+ *
+ * Returns: (transfer none): The directory that is indexed.
+ */
+GFile *
+ide_text_index_get_root_directory (IdeTextIndex *self)
+{
+  g_return_val_if_fail (IDE_IS_TEXT_INDEX (self), NULL);
+
+  return self->root_directory;
+}
+
+/**
+ * ide_text_index_get_n_files:
+ * @self: An #IdeTextIndex
+ *
+ * Returns: The number of files in the index.
+ */
+guint
+ide_text_index_get_n_files (IdeTextIndex *self)
+{
+  g_return_val_if_fail (IDE_IS_TEXT_INDEX (self), 0);
+
+  return self->data ? g_hash_table_size (self->data->paths) : 0;
+}
+
+IdeTextIndex *
+ide_text_index_new (GFile  *root_directory,
+                    IdeVcs *vcs)
+{
+  g_return_val_if_fail (G_IS_FILE (root_directory), NULL);
+  g_return_val_if_fail (!vcs || IDE_IS_VCS (vcs), NULL);
+
+  return g_object_new (IDE_TYPE_TEXT_INDEX,
+                       "root-directory", root_directory,
+                       "vcs", vcs,
+                       NULL);
+}
+
+static void
+ide_text_index_constructed (GObject *object)
+{
+  IdeTextIndex *self = (IdeTextIndex *)object;
+  g_autofree gchar *uri = NULL;
+  g_autofree gchar *checksum = NULL;
+  g_autofree gchar *name = NULL;
+
+  G_OBJECT_CLASS (ide_text_index_parent_class)->constructed (object);
+
+  g_assert (G_IS_FILE (self->root_directory));
+
+  uri = g_file_get_uri (self->root_directory);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, uri, -1);
+  name = g_strdup_printf ("%s.gvariant", checksum);
+
+  self->cache_path = g_build_filename (g_get_user_cache_dir (),
+                                       ide_get_program_name (),
+                                       "text-index",
+                                       name,
+                                       NULL);
+}
+
+static void
+ide_text_index_finalize (GObject *object)
+{
+  IdeTextIndex *self = (IdeTextIndex *)object;
+
+  if (self->save_source != 0)
+    {
+      g_source_remove (self->save_source);
+      self->save_source = 0;
+    }
+
+  g_clear_pointer (&self->monitors, g_ptr_array_unref);
+  g_clear_pointer (&self->updating, g_hash_table_unref);
+  g_clear_pointer (&self->data, text_index_data_free);
+  g_clear_pointer (&self->cache_path, g_free);
+  g_clear_object (&self->root_directory);
+  g_clear_object (&self->vcs);
+
+  G_OBJECT_CLASS (ide_text_index_parent_class)->finalize (object);
+}
+
+static void
+ide_text_index_get_property (GObject    *object,
+                             guint       prop_id,
+                             GValue     *value,
+                             GParamSpec *pspec)
+{
+  IdeTextIndex *self = IDE_TEXT_INDEX (object);
+
+  switch (prop_id)
+    {
+    case PROP_ROOT_DIRECTORY:
+      g_value_set_object (value, self->root_directory);
+      break;
+
+    case PROP_VCS:
+      g_value_set_object (value, self->vcs);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+ide_text_index_set_property (GObject      *object,
+                             guint         prop_id,
+                             const GValue *value,
+                             GParamSpec   *pspec)
+{
+  IdeTextIndex *self = IDE_TEXT_INDEX (object);
+
+  switch (prop_id)
+    {
+    case PROP_ROOT_DIRECTORY:
+      self->root_directory = g_value_dup_object (value);
+      break;
+
+    case PROP_VCS:
+      self->vcs = g_value_dup_object (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+ide_text_index_class_init (IdeTextIndexClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->constructed = ide_text_index_constructed;
+  object_class->finalize = ide_text_index_finalize;
+  object_class->get_property = ide_text_index_get_property;
+  object_class->set_property = ide_text_index_set_property;
+
+  properties [PROP_ROOT_DIRECTORY] =
+    g_param_spec_object ("root-directory",
+                         "Root Directory",
+                         "The directory to index.",
+                         G_TYPE_FILE,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_VCS] =
+    g_param_spec_object ("vcs",
+                         "Vcs",
+                         "The version control system used to skip ignored files.",
+                         IDE_TYPE_VCS,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, LAST_PROP, properties);
+}
+
+static void
+ide_text_index_init (IdeTextIndex *self)
+{
+  self->updating = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->monitors = g_ptr_array_new_with_free_func (g_object_unref);
+}
@@ -0,0 +1,84 @@
+/* ide-text-index.h
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_TEXT_INDEX_H
+#define IDE_TEXT_INDEX_H
+
+#include <gio/gio.h>
+
+#include "ide-vcs.h"
+
+G_BEGIN_DECLS
+
+#define IDE_TYPE_TEXT_INDEX       (ide_text_index_get_type())
+#define IDE_TYPE_TEXT_INDEX_MATCH (ide_text_index_match_get_type())
+
+G_DECLARE_FINAL_TYPE (IdeTextIndex, ide_text_index, IDE, TEXT_INDEX, GObject)
+
+typedef enum
+{
+  IDE_TEXT_INDEX_SEARCH_NONE           = 0,
+  IDE_TEXT_INDEX_SEARCH_REGEX          = 1 << 0,
+  IDE_TEXT_INDEX_SEARCH_CASE_SENSITIVE = 1 << 1,
+} IdeTextIndexSearchFlags;
+
+typedef struct
+{
+  /* Relative to the root directory of the index */
+  gchar *path;
+  /* The line containing the match, without the newline */
+  gchar *text;
+  guint  line;
+  guint  line_offset;
+  guint  length;
+} IdeTextIndexMatch;
+
+GType              ide_text_index_match_get_type (void);
+IdeTextIndexMatch *ide_text_index_match_copy     (const IdeTextIndexMatch  *match);
+void               ide_text_index_match_free     (IdeTextIndexMatch        *match);
+
+IdeTextIndex      *ide_text_index_new            (GFile                    *root_directory,
+                                                  IdeVcs                   *vcs);
+GFile             *ide_text_index_get_root_directory
+                                                 (IdeTextIndex             *self);
+guint              ide_text_index_get_n_files    (IdeTextIndex             *self);
+void               ide_text_index_load_async     (IdeTextIndex             *self,
+                                                  GCancellable             *cancellable,
+                                                  GAsyncReadyCallback       callback,
+                                                  gpointer                  user_data);
+gboolean           ide_text_index_load_finish    (IdeTextIndex             *self,
+                                                  GAsyncResult             *result,
+                                                  GError                  **error);
+void               ide_text_index_update_file    (IdeTextIndex             *self,
+                                                  GFile                    *file);
+void               ide_text_index_search_async   (IdeTextIndex             *self,
+                                                  const gchar              *query,
+                                                  IdeTextIndexSearchFlags   flags,
+                                                  guint                     max_matches,
+                                                  GCancellable             *cancellable,
+                                                  GAsyncReadyCallback       callback,
+                                                  gpointer                  user_data);
+GPtrArray         *ide_text_index_search_finish  (IdeTextIndex             *self,
+                                                  GAsyncResult             *result,
+                                                  GError                  **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (IdeTextIndexMatch, ide_text_index_match_free)
+
+G_END_DECLS
+
+#endif /* IDE_TEXT_INDEX_H */
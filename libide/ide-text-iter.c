@@ -459,6 +459,295 @@ _ide_text_iter_backward_WORD_end (GtkTextIter *iter)
   return _ide_text_iter_backward_classified_end (iter, _ide_text_WORD_classify);
 }
 
+/*
+ * TextCursor walks the buffer by character offset over chunks of UCS-4
+ * text so that counted word motions do not have to pay for a GtkTextIter
+ * step (and its btree segment lookups) for every character they cross.
+ */
+
+#define TEXT_CURSOR_CHUNK 4096
+
+typedef struct
+{
+  GtkTextBuffer *buffer;
+  gunichar      *chars;
+  gint           begin;
+  gint           len;
+  gint           end;
+  gint           offset;
+} TextCursor;
+
+static void
+text_cursor_init (TextCursor        *c,
+                  const GtkTextIter *iter)
+{
+  c->buffer = gtk_text_iter_get_buffer (iter);
+  c->chars = NULL;
+  c->begin = 0;
+  c->len = 0;
+  c->end = gtk_text_buffer_get_char_count (c->buffer);
+  c->offset = gtk_text_iter_get_offset (iter);
+}
+
+static void
+text_cursor_clear (TextCursor *c)
+{
+  g_clear_pointer (&c->chars, g_free);
+}
+
+static gunichar
+text_cursor_get_char (TextCursor *c,
+                      gint        offset)
+{
+  if (offset < 0 || offset >= c->end)
+    return 0;
+
+  if (offset < c->begin || offset >= c->begin + c->len)
+    {
+      g_autofree gchar *slice = NULL;
+      GtkTextIter begin;
+      GtkTextIter end;
+      glong len = 0;
+
+      /* Keep one char of look-behind for line-start checks. */
+      c->begin = MAX (0, offset - 1);
+
+      gtk_text_buffer_get_iter_at_offset (c->buffer, &begin, c->begin);
+      gtk_text_buffer_get_iter_at_offset (c->buffer, &end, c->begin + TEXT_CURSOR_CHUNK);
+
+      slice = gtk_text_iter_get_slice (&begin, &end);
+
+      g_free (c->chars);
+      c->chars = g_utf8_to_ucs4_fast (slice, -1, &len);
+      c->len = len;
+
+      if (offset >= c->begin + c->len)
+        return 0;
+    }
+
+  return c->chars [offset - c->begin];
+}
+
+static gboolean
+text_cursor_forward_char (TextCursor *c)
+{
+  if (c->offset >= c->end)
+    return FALSE;
+
+  c->offset++;
+
+  return c->offset < c->end;
+}
+
+static gboolean
+text_cursor_backward_char (TextCursor *c)
+{
+  if (c->offset == 0)
+    return FALSE;
+
+  c->offset--;
+
+  return TRUE;
+}
+
+/* Mirrors gtk_text_iter_ends_line() */
+static gboolean
+text_cursor_ends_line (TextCursor *c,
+                       gint        offset)
+{
+  gunichar ch = text_cursor_get_char (c, offset);
+
+  if (ch == 0 || ch == '\r' || ch == 0x2029)
+    return TRUE;
+
+  if (ch == '\n')
+    return offset == 0 || text_cursor_get_char (c, offset - 1) != '\r';
+
+  return FALSE;
+}
+
+/* Mirrors gtk_text_iter_starts_line() */
+static gboolean
+text_cursor_starts_line (TextCursor *c,
+                         gint        offset)
+{
+  gunichar prev;
+
+  if (offset == 0)
+    return TRUE;
+
+  prev = text_cursor_get_char (c, offset - 1);
+
+  if (prev == '\n' || prev == 0x2029)
+    return TRUE;
+
+  if (prev == '\r')
+    return text_cursor_get_char (c, offset) != '\n';
+
+  return FALSE;
+}
+
+static gboolean
+text_cursor_forward_classified_start (TextCursor  *c,
+                                      gint       (*classify) (gunichar))
+{
+  gint begin_class;
+  gint cur_class;
+
+  begin_class = classify (text_cursor_get_char (c, c->offset));
+
+  if (begin_class == CLASS_SPACE)
+    {
+      for (;;)
+        {
+          if (!text_cursor_forward_char (c))
+            return FALSE;
+
+          cur_class = classify (text_cursor_get_char (c, c->offset));
+          if (cur_class != CLASS_SPACE)
+            return TRUE;
+        }
+    }
+
+  while (text_cursor_forward_char (c))
+    {
+      cur_class = classify (text_cursor_get_char (c, c->offset));
+
+      if (cur_class == CLASS_SPACE)
+        {
+          begin_class = CLASS_0;
+          continue;
+        }
+
+      if (cur_class != begin_class)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+text_cursor_forward_classified_end (TextCursor  *c,
+                                    gint       (*classify) (gunichar))
+{
+  gint begin_class;
+  gint cur_class;
+
+  if (!text_cursor_forward_char (c))
+    return FALSE;
+
+  if (classify (text_cursor_get_char (c, c->offset)) == CLASS_SPACE)
+    if (!text_cursor_forward_classified_start (c, classify))
+      return FALSE;
+
+  begin_class = classify (text_cursor_get_char (c, c->offset));
+
+  for (;;)
+    {
+      if (!text_cursor_forward_char (c))
+        return FALSE;
+
+      cur_class = classify (text_cursor_get_char (c, c->offset));
+
+      if (cur_class != begin_class)
+        {
+          text_cursor_backward_char (c);
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+static gboolean
+_ide_text_iter_forward_classified_n (GtkTextIter  *iter,
+                                     guint         count,
+                                     gboolean      to_end,
+                                     gboolean      inclusive,
+                                     gint        (*classify) (gunichar))
+{
+  TextCursor c;
+  gint begin;
+  gint pos;
+
+  g_assert (iter);
+
+  text_cursor_init (&c, iter);
+
+  for (; count > 0 && c.offset < c.end; count--)
+    {
+      begin = c.offset;
+
+      if (to_end)
+        text_cursor_forward_classified_end (&c, classify);
+      else
+        text_cursor_forward_classified_start (&c, classify);
+
+      /* An empty line counts as a word, prefer it to the one after. */
+      for (pos = begin + 1; pos < c.offset; pos++)
+        {
+          if (text_cursor_starts_line (&c, pos) && text_cursor_ends_line (&c, pos))
+            {
+              c.offset = pos;
+              break;
+            }
+        }
+
+      if (inclusive && !text_cursor_ends_line (&c, c.offset))
+        text_cursor_forward_char (&c);
+    }
+
+  gtk_text_iter_set_offset (iter, c.offset);
+
+  text_cursor_clear (&c);
+
+  return !gtk_text_iter_is_end (iter);
+}
+
+/**
+ * _ide_text_iter_forward_word_starts:
+ * @iter: A #GtkTextIter
+ * @count: the number of words to move
+ * @inclusive: if the motion is inclusive (see ":help inclusive" in vim)
+ *
+ * Moves @iter forward @count word starts, treating an empty line as a word.
+ * This is equivalent to calling _ide_text_iter_forward_word_start() @count
+ * times, but reads the buffer in chunks rather than a character at a time.
+ *
+ * Returns: %TRUE if @iter is not at the end of the buffer.
+ */
+gboolean
+_ide_text_iter_forward_word_starts (GtkTextIter *iter,
+                                    guint        count,
+                                    gboolean     inclusive)
+{
+  return _ide_text_iter_forward_classified_n (iter, count, FALSE, inclusive, _ide_text_word_classify);
+}
+
+gboolean
+_ide_text_iter_forward_WORD_starts (GtkTextIter *iter,
+                                    guint        count,
+                                    gboolean     inclusive)
+{
+  return _ide_text_iter_forward_classified_n (iter, count, FALSE, inclusive, _ide_text_WORD_classify);
+}
+
+gboolean
+_ide_text_iter_forward_word_ends (GtkTextIter *iter,
+                                  guint        count,
+                                  gboolean     inclusive)
+{
+  return _ide_text_iter_forward_classified_n (iter, count, TRUE, inclusive, _ide_text_word_classify);
+}
+
+gboolean
+_ide_text_iter_forward_WORD_ends (GtkTextIter *iter,
+                                  guint        count,
+                                  gboolean     inclusive)
+{
+  return _ide_text_iter_forward_classified_n (iter, count, TRUE, inclusive, _ide_text_WORD_classify);
+}
+
 static gboolean
 matches_pred (GtkTextIter              *iter,
               IdeTextIterCharPredicate  pred,
@@ -39,6 +39,18 @@ gboolean _ide_text_iter_forward_word_start       (GtkTextIter              *iter
 gboolean _ide_text_iter_forward_WORD_start       (GtkTextIter              *iter);
 gboolean _ide_text_iter_forward_word_end         (GtkTextIter              *iter);
 gboolean _ide_text_iter_forward_WORD_end         (GtkTextIter              *iter);
+gboolean _ide_text_iter_forward_word_starts      (GtkTextIter              *iter,
+                                                  guint                     count,
+                                                  gboolean                  inclusive);
+gboolean _ide_text_iter_forward_WORD_starts      (GtkTextIter              *iter,
+                                                  guint                     count,
+                                                  gboolean                  inclusive);
+gboolean _ide_text_iter_forward_word_ends        (GtkTextIter              *iter,
+                                                  guint                     count,
+                                                  gboolean                  inclusive);
+gboolean _ide_text_iter_forward_WORD_ends        (GtkTextIter              *iter,
+                                                  guint                     count,
+                                                  gboolean                  inclusive);
 gboolean _ide_text_iter_backward_paragraph_start (GtkTextIter              *iter);
 gboolean _ide_text_iter_forward_paragraph_end    (GtkTextIter              *iter);
 gboolean _ide_text_iter_backward_sentence_start  (GtkTextIter              *iter);
@@ -164,6 +164,26 @@ ide_tree_node_append (IdeTreeNode *node,
   _ide_tree_append (node->tree, node, child);
 }
 
+/**
+ * ide_tree_node_insert:
+ * @node: A #IdeTreeNode.
+ * @child: A #IdeTreeNode.
+ * @position: the index for @child among the children of @node.
+ *
+ * Inserts @child into the list of children owned by @node at @position.
+ * If @position is larger than the number of children, @child is appended.
+ */
+void
+ide_tree_node_insert (IdeTreeNode *node,
+                      IdeTreeNode *child,
+                      guint        position)
+{
+  g_return_if_fail (IDE_IS_TREE_NODE (node));
+  g_return_if_fail (IDE_IS_TREE_NODE (child));
+
+  _ide_tree_insert (node->tree, node, child, position);
+}
+
 /**
  * ide_tree_node_prepend:
  * @node: A #IdeTreeNode.
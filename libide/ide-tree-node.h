@@ -26,6 +26,9 @@ G_BEGIN_DECLS
 IdeTreeNode    *ide_tree_node_new                   (void);
 void            ide_tree_node_append                (IdeTreeNode            *node,
                                                      IdeTreeNode            *child);
+void            ide_tree_node_insert                (IdeTreeNode            *node,
+                                                     IdeTreeNode            *child,
+                                                     guint                   position);
 void            ide_tree_node_insert_sorted         (IdeTreeNode            *node,
                                                      IdeTreeNode            *child,
                                                      IdeTreeNodeCompareFunc  compare_func,
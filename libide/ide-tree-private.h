@@ -35,6 +35,10 @@ void         _ide_tree_append                  (IdeTree        *self,
 void         _ide_tree_prepend                 (IdeTree        *self,
                                                 IdeTreeNode    *node,
                                                 IdeTreeNode    *child);
+void         _ide_tree_insert                  (IdeTree        *self,
+                                                IdeTreeNode    *node,
+                                                IdeTreeNode    *child,
+                                                guint           position);
 void         _ide_tree_insert_sorted           (IdeTree        *self,
                                                 IdeTreeNode    *node,
                                                 IdeTreeNode    *child,
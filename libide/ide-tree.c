@@ -522,7 +522,7 @@ static void
 ide_tree_add (IdeTree     *self,
               IdeTreeNode *node,
               IdeTreeNode *child,
-              gboolean     prepend)
+              gint         position)
 {
   IdeTreePrivate *priv = ide_tree_get_instance_private (self);
   GtkTreePath *path;
@@ -548,7 +548,7 @@ ide_tree_add (IdeTree     *self,
     }
 
   gtk_tree_store_insert_with_values (priv->store, &iter, parentptr,
-                                     prepend ? 0 : -1,
+                                     position,
                                      0, child,
                                      -1);
 
@@ -1472,7 +1472,7 @@ _ide_tree_append (IdeTree     *self,
   g_return_if_fail (IDE_IS_TREE_NODE (node));
   g_return_if_fail (IDE_IS_TREE_NODE (child));
 
-  ide_tree_add (self, node, child, FALSE);
+  ide_tree_add (self, node, child, -1);
 }
 
 void
@@ -1484,7 +1484,20 @@ _ide_tree_prepend (IdeTree     *self,
   g_return_if_fail (IDE_IS_TREE_NODE (node));
   g_return_if_fail (IDE_IS_TREE_NODE (child));
 
-  ide_tree_add (self, node, child, TRUE);
+  ide_tree_add (self, node, child, 0);
+}
+
+void
+_ide_tree_insert (IdeTree     *self,
+                  IdeTreeNode *node,
+                  IdeTreeNode *child,
+                  guint        position)
+{
+  g_return_if_fail (IDE_IS_TREE (self));
+  g_return_if_fail (IDE_IS_TREE_NODE (node));
+  g_return_if_fail (IDE_IS_TREE_NODE (child));
+
+  ide_tree_add (self, node, child, MIN (position, G_MAXINT));
 }
 
 void
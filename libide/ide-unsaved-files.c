@@ -37,13 +37,14 @@ typedef struct
   GBytes          *content;
   gchar           *temp_path;
   gint             temp_fd;
-  IdeUnsavedFiles *backptr;
+  IdeUnsavedFile  *snapshot;
 } UnsavedFile;
 
 typedef struct
 {
-  GPtrArray *unsaved_files;
-  gint64     sequence;
+  /* GFile -> UnsavedFile */
+  GHashTable *unsaved_files;
+  gint64      sequence;
 } IdeUnsavedFilesPrivate;
 
 typedef struct
@@ -92,6 +93,7 @@ unsaved_file_free (gpointer data)
     {
       g_clear_object (&uf->file);
       g_clear_pointer (&uf->content, g_bytes_unref);
+      g_clear_pointer (&uf->snapshot, ide_unsaved_file_unref);
 
       if (uf->temp_path != NULL)
         {
@@ -121,6 +123,22 @@ unsaved_file_copy (const UnsavedFile *uf)
   return copy;
 }
 
+/*
+ * The snapshot is the immutable #IdeUnsavedFile handed out to consumers.
+ * It is created on demand and shared until the content changes, so asking
+ * for the unsaved files repeatedly does not allocate per file.
+ */
+static IdeUnsavedFile *
+unsaved_file_get_snapshot (UnsavedFile *uf)
+{
+  g_assert (uf != NULL);
+
+  if (uf->snapshot == NULL)
+    uf->snapshot = _ide_unsaved_file_new (uf->file, uf->content, uf->temp_path, uf->sequence);
+
+  return uf->snapshot;
+}
+
 static gboolean
 unsaved_file_save (UnsavedFile  *uf,
                    const gchar  *path,
@@ -247,7 +265,8 @@ ide_unsaved_files_save_async (IdeUnsavedFiles     *files,
   IdeUnsavedFilesPrivate *priv;
   g_autoptr(GTask) task = NULL;
   AsyncState *state;
-  gsize i;
+  GHashTableIter iter;
+  UnsavedFile *uf;
 
   g_return_if_fail (IDE_IS_UNSAVED_FILES (files));
   g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
@@ -256,15 +275,10 @@ ide_unsaved_files_save_async (IdeUnsavedFiles     *files,
 
   state = async_state_new (files);
 
-  for (i = 0; i < priv->unsaved_files->len; i++)
-    {
-      UnsavedFile *uf;
-      UnsavedFile *uf_copy;
+  g_hash_table_iter_init (&iter, priv->unsaved_files);
 
-      uf = g_ptr_array_index (priv->unsaved_files, i);
-      uf_copy = unsaved_file_copy (uf);
-      g_ptr_array_add (state->unsaved_files, uf_copy);
-    }
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&uf))
+    g_ptr_array_add (state->unsaved_files, unsaved_file_copy (uf));
 
   task = g_task_new (files, cancellable, callback, user_data);
   g_task_set_task_data (task, state, async_state_free);
@@ -406,28 +420,6 @@ ide_unsaved_files_restore_finish (IdeUnsavedFiles  *files,
   return g_task_propagate_boolean (G_TASK (result), error);
 }
 
-static void
-ide_unsaved_files_move_to_front (IdeUnsavedFiles *self,
-                                 guint            index)
-{
-  IdeUnsavedFilesPrivate *priv = ide_unsaved_files_get_instance_private (self);
-  UnsavedFile *new_front;
-  UnsavedFile *old_front;
-
-  g_return_if_fail (IDE_IS_UNSAVED_FILES (self));
-
-  new_front = g_ptr_array_index (priv->unsaved_files, index);
-  old_front = g_ptr_array_index (priv->unsaved_files, 0);
-
-  /*
-   * TODO: We could shift all these items down, but it probably isnt' worth
-   *       the effort. We will just move-to-front after a miss and ping
-   *       pong the old item back to the front.
-   */
-  priv->unsaved_files->pdata[0] = new_front;
-  priv->unsaved_files->pdata[index] = old_front;
-}
-
 static void
 ide_unsaved_files_remove_draft (IdeUnsavedFiles *self,
                                 GFile           *file)
@@ -461,23 +453,14 @@ ide_unsaved_files_remove (IdeUnsavedFiles *self,
                           GFile           *file)
 {
   IdeUnsavedFilesPrivate *priv = ide_unsaved_files_get_instance_private (self);
-  guint i;
 
   g_return_if_fail (IDE_IS_UNSAVED_FILES (self));
   g_return_if_fail (G_IS_FILE (file));
 
-  for (i = 0; i < priv->unsaved_files->len; i++)
+  if (g_hash_table_contains (priv->unsaved_files, file))
     {
-      UnsavedFile *unsaved;
-
-      unsaved = g_ptr_array_index (priv->unsaved_files, i);
-
-      if (g_file_equal (file, unsaved->file))
-        {
-          ide_unsaved_files_remove_draft (self, file);
-          g_ptr_array_remove_index_fast (priv->unsaved_files, i);
-          break;
-        }
+      ide_unsaved_files_remove_draft (self, file);
+      g_hash_table_remove (priv->unsaved_files, file);
     }
 }
 
@@ -510,7 +493,6 @@ ide_unsaved_files_update (IdeUnsavedFiles *self,
 {
   IdeUnsavedFilesPrivate *priv = ide_unsaved_files_get_instance_private (self);
   UnsavedFile *unsaved;
-  guint i;
 
   g_return_if_fail (IDE_IS_UNSAVED_FILES (self));
   g_return_if_fail (G_IS_FILE (file));
@@ -523,30 +505,17 @@ ide_unsaved_files_update (IdeUnsavedFiles *self,
       return;
     }
 
-  for (i = 0; i < priv->unsaved_files->len; i++)
+  if (NULL != (unsaved = g_hash_table_lookup (priv->unsaved_files, file)))
     {
-      unsaved = g_ptr_array_index (priv->unsaved_files, i);
-
-      if (g_file_equal (file, unsaved->file))
+      if (content != unsaved->content)
         {
-          if (content != unsaved->content)
-            {
-              g_clear_pointer (&unsaved->content, g_bytes_unref);
-              unsaved->content = g_bytes_ref (content);
-              unsaved->sequence = priv->sequence;
-            }
-
-          /*
-           * A file that get's updated is the most likely to get updated on
-           * the next attempt. Therefore, we will simply move this entry to
-           * the beginning of the array to increase it's chances of being the
-           * first entry we check.
-           */
-          if (i != 0)
-            ide_unsaved_files_move_to_front (self, i);
-
-          return;
+          g_clear_pointer (&unsaved->content, g_bytes_unref);
+          g_clear_pointer (&unsaved->snapshot, ide_unsaved_file_unref);
+          unsaved->content = g_bytes_ref (content);
+          unsaved->sequence = priv->sequence;
         }
+
+      return;
     }
 
   unsaved = g_slice_new0 (UnsavedFile);
@@ -555,7 +524,7 @@ ide_unsaved_files_update (IdeUnsavedFiles *self,
   unsaved->sequence = priv->sequence;
   setup_tempfile (file, &unsaved->temp_fd, &unsaved->temp_path);
 
-  g_ptr_array_insert (priv->unsaved_files, 0, unsaved);
+  g_hash_table_insert (priv->unsaved_files, unsaved->file, unsaved);
 }
 
 /**
@@ -570,32 +539,54 @@ ide_unsaved_files_update (IdeUnsavedFiles *self,
  * If you would like to hold onto an unsaved file instance, call
  * ide_unsaved_file_ref() to increment it's reference count.
  *
+ * The #IdeUnsavedFile elements are immutable snapshots shared with every
+ * other caller until the file changes again, so this does not copy any
+ * buffer contents.
+ *
  * Returns: (transfer container) (element-type IdeUnsavedFile*): A #GPtrArray
  *   containing #IdeUnsavedFile elements.
  */
 GPtrArray *
 ide_unsaved_files_to_array (IdeUnsavedFiles *self)
 {
-  IdeUnsavedFilesPrivate *priv;
+  g_return_val_if_fail (IDE_IS_UNSAVED_FILES (self), NULL);
+
+  return ide_unsaved_files_to_array_since (self, 0);
+}
+
+/**
+ * ide_unsaved_files_to_array_since:
+ * @self: An #IdeUnsavedFiles
+ * @sequence: a sequence previously returned from ide_unsaved_files_get_sequence()
+ *
+ * Like ide_unsaved_files_to_array(), but only contains the files that have
+ * changed after @sequence. This allows consumers that keep their own copy of
+ * the unsaved files to fetch just the changes. Files that have been removed
+ * are not reported, use ide_unsaved_files_contains() to check for those.
+ *
+ * Returns: (transfer container) (element-type IdeUnsavedFile*): A #GPtrArray
+ *   containing #IdeUnsavedFile elements.
+ */
+GPtrArray *
+ide_unsaved_files_to_array_since (IdeUnsavedFiles *self,
+                                  gint64           sequence)
+{
+  IdeUnsavedFilesPrivate *priv = ide_unsaved_files_get_instance_private (self);
+  GHashTableIter iter;
+  UnsavedFile *uf;
   GPtrArray *ar;
-  gsize i;
 
   g_return_val_if_fail (IDE_IS_UNSAVED_FILES (self), NULL);
 
-  priv = ide_unsaved_files_get_instance_private (self);
+  ar = g_ptr_array_new_full (g_hash_table_size (priv->unsaved_files),
+                             (GDestroyNotify)ide_unsaved_file_unref);
 
-  ar = g_ptr_array_new ();
-  g_ptr_array_set_free_func (ar, (GDestroyNotify)ide_unsaved_file_unref);
+  g_hash_table_iter_init (&iter, priv->unsaved_files);
 
-  for (i = 0; i < priv->unsaved_files->len; i++)
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&uf))
     {
-      IdeUnsavedFile *item;
-      UnsavedFile *uf;
-
-      uf = g_ptr_array_index (priv->unsaved_files, i);
-      item = _ide_unsaved_file_new (uf->file, uf->content, uf->temp_path, uf->sequence);
-
-      g_ptr_array_add (ar, item);
+      if (uf->sequence > sequence)
+        g_ptr_array_add (ar, ide_unsaved_file_ref (unsaved_file_get_snapshot (uf)));
     }
 
   return ar;
@@ -606,22 +597,11 @@ ide_unsaved_files_contains (IdeUnsavedFiles *self,
                             GFile           *file)
 {
   IdeUnsavedFilesPrivate *priv = ide_unsaved_files_get_instance_private (self);
-  guint i;
 
   g_return_val_if_fail (IDE_IS_UNSAVED_FILES (self), FALSE);
   g_return_val_if_fail (G_IS_FILE (file), FALSE);
 
-  for (i = 0; i < priv->unsaved_files->len; i++)
-    {
-      UnsavedFile *uf;
-
-      uf = g_ptr_array_index (priv->unsaved_files, i);
-
-      if (g_file_equal (uf->file, file))
-        return TRUE;
-    }
-
-  return FALSE;
+  return g_hash_table_contains (priv->unsaved_files, file);
 }
 
 /**
@@ -638,7 +618,7 @@ ide_unsaved_files_get_unsaved_file (IdeUnsavedFiles *self,
 {
   IdeUnsavedFilesPrivate *priv = ide_unsaved_files_get_instance_private (self);
   IdeUnsavedFile *ret = NULL;
-  gsize i;
+  UnsavedFile *uf;
 
   IDE_ENTRY;
 
@@ -654,23 +634,15 @@ ide_unsaved_files_get_unsaved_file (IdeUnsavedFiles *self,
   }
 #endif
 
-  for (i = 0; i < priv->unsaved_files->len; i++)
+  if (NULL != (uf = g_hash_table_lookup (priv->unsaved_files, file)))
     {
-      UnsavedFile *uf;
-
-      uf = g_ptr_array_index (priv->unsaved_files, i);
-
-      if (g_file_equal (uf->file, file))
-        {
-          IDE_TRACE_MSG ("Hit");
-          ret = _ide_unsaved_file_new (uf->file, uf->content, uf->temp_path, uf->sequence);
-          goto complete;
-        }
+      IDE_TRACE_MSG ("Hit");
+      ret = ide_unsaved_file_ref (unsaved_file_get_snapshot (uf));
+      IDE_RETURN (ret);
     }
 
   IDE_TRACE_MSG ("Miss");
 
-complete:
   IDE_RETURN (ret);
 }
 
@@ -690,7 +662,7 @@ ide_unsaved_files_finalize (GObject *object)
   IdeUnsavedFiles *self = (IdeUnsavedFiles *)object;
   IdeUnsavedFilesPrivate *priv = ide_unsaved_files_get_instance_private (self);
 
-  g_clear_pointer (&priv->unsaved_files, g_ptr_array_unref);
+  g_clear_pointer (&priv->unsaved_files, g_hash_table_unref);
 
   G_OBJECT_CLASS (ide_unsaved_files_parent_class)->finalize (object);
 }
@@ -708,26 +680,26 @@ ide_unsaved_files_init (IdeUnsavedFiles *self)
 {
   IdeUnsavedFilesPrivate *priv = ide_unsaved_files_get_instance_private (self);
 
-  priv->unsaved_files = g_ptr_array_new_with_free_func (unsaved_file_free);
+  priv->unsaved_files = g_hash_table_new_full ((GHashFunc)g_file_hash,
+                                               (GEqualFunc)g_file_equal,
+                                               NULL,
+                                               unsaved_file_free);
 }
 
 void
 ide_unsaved_files_clear (IdeUnsavedFiles *self)
 {
-  g_autoptr(GPtrArray) ar = NULL;
-  gsize i;
+  IdeUnsavedFilesPrivate *priv = ide_unsaved_files_get_instance_private (self);
+  GHashTableIter iter;
+  GFile *file;
 
   g_return_if_fail (IDE_IS_UNSAVED_FILES (self));
 
-  ar = ide_unsaved_files_to_array (self);
+  g_hash_table_iter_init (&iter, priv->unsaved_files);
 
-  for (i = 0; i < ar->len; i++)
+  while (g_hash_table_iter_next (&iter, (gpointer *)&file, NULL))
     {
-      IdeUnsavedFile *uf;
-      GFile *file;
-
-      uf = g_ptr_array_index (ar, i);
-      file = ide_unsaved_file_get_file (uf);
-      ide_unsaved_files_remove (self, file);
+      ide_unsaved_files_remove_draft (self, file);
+      g_hash_table_iter_remove (&iter);
     }
 }
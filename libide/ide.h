@@ -39,6 +39,7 @@ G_BEGIN_DECLS
 #include "ide-buffer.h"
 #include "ide-buffer-change-monitor.h"
 #include "ide-buffer-manager.h"
+#include "ide-compile-commands.h"
 #include "ide-completion-item.h"
 #include "ide-completion-provider.h"
 #include "ide-completion-results.h"
@@ -101,6 +102,7 @@ G_BEGIN_DECLS
 #include "ide-service.h"
 #include "ide-source-location.h"
 #include "ide-source-map.h"
+#include "ide-source-raster-map.h"
 #include "ide-source-range.h"
 #include "ide-source-snippet-chunk.h"
 #include "ide-source-snippet-context.h"
@@ -115,6 +117,7 @@ G_BEGIN_DECLS
 #include "ide-target.h"
 #include "ide-test-case.h"
 #include "ide-test-suite.h"
+#include "ide-text-index.h"
 #include "ide-thread-pool.h"
 #include "ide-tree-types.h"
 #include "ide-tree.h"
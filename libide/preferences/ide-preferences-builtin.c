@@ -149,6 +149,7 @@ ide_preferences_builtin_register_editor (IdePreferences *preferences)
   ide_preferences_add_list_group (preferences, "editor", "overview", _("Code Overview"), 100);
   ide_preferences_add_switch (preferences, "editor", "overview", "org.gnome.builder.editor", "show-map", NULL, NULL, _("Show overview map"), _("A zoomed out view to enhance navigating source code"), NULL, 0);
   ide_preferences_add_switch (preferences, "editor", "overview", "org.gnome.builder.editor", "auto-hide-map", NULL, NULL, _("Automatically hide overview map"), _("Automatically hide map when editor loses focus"), NULL, 1);
+  ide_preferences_add_switch (preferences, "editor", "overview", "org.gnome.builder.editor", "rasterize-map", NULL, NULL, _("Simplified overview map"), _("Draw the map from cached color runs, which is faster for large files"), NULL, 2);
 
   ide_preferences_add_list_group (preferences, "editor", "draw-spaces", _("Whitespace Characters"), 400);
   ide_preferences_add_radio (preferences, "editor", "draw-spaces", "org.gnome.builder.editor", "draw-spaces", NULL, "\"space\"", _("Spaces"), NULL, NULL, 0);
@@ -141,6 +141,28 @@ ide_omni_search_entry_clear_search (IdeOmniSearchEntry *self)
   ide_omni_search_entry_hide_popover (self, TRUE);
 }
 
+static void
+ide_omni_search_entry_result_added (IdeOmniSearchEntry *self,
+                                    IdeSearchProvider  *provider,
+                                    IdeSearchResult    *result,
+                                    IdeSearchContext   *context)
+{
+  g_assert (IDE_IS_OMNI_SEARCH_ENTRY (self));
+  g_assert (IDE_IS_SEARCH_CONTEXT (context));
+
+  /*
+   * Show results as soon as the first provider has some rather than waiting
+   * for every provider to complete. Hiding is left to the completed handler.
+   */
+  if (!self->has_results)
+    {
+      self->has_results = TRUE;
+
+      gtk_widget_set_visible (GTK_WIDGET (self->popover), TRUE);
+      gtk_entry_grab_focus_without_selecting (GTK_ENTRY (self));
+    }
+}
+
 static void
 ide_omni_search_entry_completed (IdeOmniSearchEntry *self,
                                  IdeSearchContext   *context)
@@ -192,6 +214,11 @@ ide_omni_search_entry_delay_cb (gpointer user_data)
                                G_CALLBACK (ide_omni_search_entry_completed),
                                self,
                                G_CONNECT_SWAPPED);
+      g_signal_connect_object (context,
+                               "result-added",
+                               G_CALLBACK (ide_omni_search_entry_result_added),
+                               self,
+                               G_CONNECT_SWAPPED);
       ide_omni_search_display_set_context (self->display, context);
       ide_search_context_execute (context, search_text, RESULTS_PER_PROVIDER);
       g_object_unref (context);
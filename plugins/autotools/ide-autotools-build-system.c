@@ -32,6 +32,7 @@
 #include "ide-autotools-build-system.h"
 #include "ide-autotools-builder.h"
 #include "ide-buffer-manager.h"
+#include "ide-compile-commands.h"
 #include "ide-configuration.h"
 #include "ide-configuration-manager.h"
 #include "ide-context.h"
@@ -44,8 +45,10 @@
 #include "ide-runtime.h"
 #include "ide-runtime-manager.h"
 #include "ide-tags-builder.h"
+#include "ide-thread-pool.h"
 
 #define MAKECACHE_KEY "makecache"
+#define COMPILE_COMMANDS_KEY "compile-commands"
 #define DEFAULT_MAKECACHE_TTL 0
 
 struct _IdeAutotoolsBuildSystem
@@ -55,6 +58,7 @@ struct _IdeAutotoolsBuildSystem
   GFile        *project_file;
   EggTaskCache *task_cache;
   gchar        *tarball_name;
+  GPtrArray    *compile_commands_monitors;
 };
 
 static void async_initable_iface_init (GAsyncInitableIface *iface);
@@ -314,6 +318,128 @@ populate_cache__get_local_makefile_cb (GObject      *object,
   IDE_EXIT;
 }
 
+static void
+populate_compile_commands_worker (GTask        *task,
+                                  gpointer      source_object,
+                                  gpointer      task_data,
+                                  GCancellable *cancellable)
+{
+  g_autoptr(IdeCompileCommands) compile_commands = NULL;
+  GPtrArray *candidates = task_data;
+  guint i;
+
+  IDE_ENTRY;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (candidates != NULL);
+
+  compile_commands = ide_compile_commands_new ();
+
+  for (i = 0; i < candidates->len; i++)
+    {
+      GFile *file = g_ptr_array_index (candidates, i);
+      GError *error = NULL;
+
+      if (!g_file_query_exists (file, cancellable))
+        continue;
+
+      if (ide_compile_commands_load (compile_commands, file, cancellable, &error))
+        break;
+
+      g_warning ("Failed to load compilation database: %s", error->message);
+      g_clear_error (&error);
+    }
+
+  /*
+   * We return an (possibly empty) database even if we failed to find one so
+   * that the result is cached. Otherwise we would probe the filesystem for
+   * every build flags request in projects without a compilation database.
+   */
+  g_task_return_pointer (task, g_steal_pointer (&compile_commands), g_object_unref);
+
+  IDE_EXIT;
+}
+
+static void
+compile_commands_changed_cb (IdeAutotoolsBuildSystem *self,
+                             GFile                   *file,
+                             GFile                   *other_file,
+                             GFileMonitorEvent        event,
+                             GFileMonitor            *monitor)
+{
+  g_assert (IDE_IS_AUTOTOOLS_BUILD_SYSTEM (self));
+  g_assert (G_IS_FILE_MONITOR (monitor));
+
+  if (event == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT ||
+      event == G_FILE_MONITOR_EVENT_CREATED ||
+      event == G_FILE_MONITOR_EVENT_DELETED)
+    egg_task_cache_evict (self->task_cache, COMPILE_COMMANDS_KEY);
+}
+
+static void
+populate_compile_commands__get_local_makefile_cb (GObject      *object,
+                                                  GAsyncResult *result,
+                                                  gpointer      user_data)
+{
+  IdeAutotoolsBuildSystem *self = (IdeAutotoolsBuildSystem *)object;
+  g_autoptr(GTask) task = user_data;
+  g_autoptr(GFile) makefile = NULL;
+  g_autoptr(GFile) srcdir = NULL;
+  g_autoptr(GPtrArray) candidates = NULL;
+  guint i;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_AUTOTOOLS_BUILD_SYSTEM (self));
+  g_assert (G_IS_TASK (task));
+
+  candidates = g_ptr_array_new_with_free_func (g_object_unref);
+
+  /*
+   * Prefer a database generated alongside the Makefile in the build
+   * directory, but also allow one placed (or symlinked) in the toplevel
+   * source directory as is common with tools like Bear.
+   */
+  if (NULL != (makefile = ide_autotools_build_system_get_local_makefile_finish (self, result, NULL)))
+    {
+      g_autoptr(GFile) builddir = g_file_get_parent (makefile);
+
+      g_ptr_array_add (candidates, g_file_get_child (builddir, "compile_commands.json"));
+    }
+
+  if (self->project_file != NULL && NULL != (srcdir = g_file_get_parent (self->project_file)))
+    g_ptr_array_add (candidates, g_file_get_child (srcdir, "compile_commands.json"));
+
+  /*
+   * Watch the candidates so that regenerating the database (or creating it
+   * for the first time) invalidates our cached copy.
+   */
+  g_ptr_array_set_size (self->compile_commands_monitors, 0);
+
+  for (i = 0; i < candidates->len; i++)
+    {
+      GFile *file = g_ptr_array_index (candidates, i);
+      GFileMonitor *monitor;
+
+      if (!(monitor = g_file_monitor_file (file, G_FILE_MONITOR_NONE, NULL, NULL)))
+        continue;
+
+      g_signal_connect_object (monitor,
+                               "changed",
+                               G_CALLBACK (compile_commands_changed_cb),
+                               self,
+                               G_CONNECT_SWAPPED);
+      g_ptr_array_add (self->compile_commands_monitors, monitor);
+    }
+
+  g_task_set_task_data (task, g_steal_pointer (&candidates), (GDestroyNotify)g_ptr_array_unref);
+  ide_thread_pool_push_task (IDE_THREAD_POOL_COMPILER,
+                             task,
+                             populate_compile_commands_worker);
+
+  IDE_EXIT;
+}
+
 static void
 populate_cache_cb (EggTaskCache  *cache,
                    gconstpointer  key,
@@ -325,13 +451,19 @@ populate_cache_cb (EggTaskCache  *cache,
   IDE_ENTRY;
 
   g_assert (IDE_IS_AUTOTOOLS_BUILD_SYSTEM (self));
-  g_assert (ide_str_equal0 (key, MAKECACHE_KEY));
+  g_assert (ide_str_equal0 (key, MAKECACHE_KEY) || ide_str_equal0 (key, COMPILE_COMMANDS_KEY));
   g_assert (G_IS_TASK (task));
 
-  ide_autotools_build_system_get_local_makefile_async (self,
-                                                       g_task_get_cancellable (task),
-                                                       populate_cache__get_local_makefile_cb,
-                                                       g_object_ref (task));
+  if (ide_str_equal0 (key, COMPILE_COMMANDS_KEY))
+    ide_autotools_build_system_get_local_makefile_async (self,
+                                                         g_task_get_cancellable (task),
+                                                         populate_compile_commands__get_local_makefile_cb,
+                                                         g_object_ref (task));
+  else
+    ide_autotools_build_system_get_local_makefile_async (self,
+                                                         g_task_get_cancellable (task),
+                                                         populate_cache__get_local_makefile_cb,
+                                                         g_object_ref (task));
 
   IDE_EXIT;
 }
@@ -442,6 +574,50 @@ ide_autotools_build_system__makecache_cb (GObject      *object,
                                       g_object_ref (task));
 }
 
+static void
+ide_autotools_build_system__compile_commands_cb (GObject      *object,
+                                                 GAsyncResult *result,
+                                                 gpointer      user_data)
+{
+  EggTaskCache *task_cache = (EggTaskCache *)object;
+  g_autoptr(IdeCompileCommands) compile_commands = NULL;
+  g_autoptr(GTask) task = user_data;
+  IdeAutotoolsBuildSystem *self;
+  gchar **flags;
+  GFile *file;
+
+  IDE_ENTRY;
+
+  g_assert (EGG_IS_TASK_CACHE (task_cache));
+  g_assert (G_IS_TASK (task));
+
+  self = g_task_get_source_object (task);
+  file = g_task_get_task_data (task);
+
+  g_assert (IDE_IS_AUTOTOOLS_BUILD_SYSTEM (self));
+  g_assert (G_IS_FILE (file));
+
+  /*
+   * The compilation database is an in-memory lookup, so if we have one and
+   * it knows about this file we can avoid spawning make entirely.
+   */
+  compile_commands = egg_task_cache_get_finish (task_cache, result, NULL);
+
+  if (compile_commands != NULL &&
+      NULL != (flags = ide_compile_commands_lookup (compile_commands, file, NULL)))
+    {
+      g_task_return_pointer (task, flags, (GDestroyNotify)g_strfreev);
+      IDE_EXIT;
+    }
+
+  ide_autotools_build_system_get_makecache_async (self,
+                                                  g_task_get_cancellable (task),
+                                                  ide_autotools_build_system__makecache_cb,
+                                                  g_object_ref (task));
+
+  IDE_EXIT;
+}
+
 static void
 ide_autotools_build_system_get_build_flags_async (IdeBuildSystem      *build_system,
                                                   IdeFile             *file,
@@ -463,10 +639,12 @@ ide_autotools_build_system_get_build_flags_async (IdeBuildSystem      *build_sys
   task = g_task_new (self, cancellable, callback, user_data);
   g_task_set_task_data (task, g_object_ref (gfile), g_object_unref);
 
-  ide_autotools_build_system_get_makecache_async (self,
-                                                  cancellable,
-                                                  ide_autotools_build_system__makecache_cb,
-                                                  g_object_ref (task));
+  egg_task_cache_get_async (self->task_cache,
+                            COMPILE_COMMANDS_KEY,
+                            FALSE,
+                            cancellable,
+                            ide_autotools_build_system__compile_commands_cb,
+                            g_object_ref (task));
 }
 
 static gchar **
@@ -525,7 +703,10 @@ ide_autotools_build_system__buffer_saved_cb (IdeAutotoolsBuildSystem *self,
   g_assert (IDE_IS_BUFFER_MANAGER (buffer_manager));
 
   if (looks_like_makefile (buffer))
-    egg_task_cache_evict (self->task_cache, MAKECACHE_KEY);
+    {
+      egg_task_cache_evict (self->task_cache, MAKECACHE_KEY);
+      egg_task_cache_evict (self->task_cache, COMPILE_COMMANDS_KEY);
+    }
 }
 
 static void
@@ -571,6 +752,7 @@ ide_autotools_build_system_finalize (GObject *object)
   IdeAutotoolsBuildSystem *self = (IdeAutotoolsBuildSystem *)object;
 
   g_clear_pointer (&self->tarball_name, g_free);
+  g_clear_pointer (&self->compile_commands_monitors, g_ptr_array_unref);
   g_clear_object (&self->task_cache);
 
   G_OBJECT_CLASS (ide_autotools_build_system_parent_class)->finalize (object);
@@ -680,6 +862,8 @@ ide_autotools_build_system_init (IdeAutotoolsBuildSystem *self)
                                          NULL);
 
   egg_task_cache_set_name (self->task_cache, "makecache");
+
+  self->compile_commands_monitors = g_ptr_array_new_with_free_func (g_object_unref);
 }
 
 static void
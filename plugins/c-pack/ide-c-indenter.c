@@ -22,6 +22,7 @@
 #include <libpeas/peas.h>
 
 #include "c-parse-helper.h"
+#include "ide-bracket-index.h"
 #include "ide-c-indenter.h"
 #include "ide-debug.h"
 #include "ide-source-view.h"
@@ -119,22 +120,6 @@ build_indent (IdeCIndenter *c,
     }
 }
 
-static gboolean
-iter_ends_c89_comment (const GtkTextIter *iter)
-{
-  if (gtk_text_iter_get_char (iter) == '/')
-    {
-      GtkTextIter tmp;
-
-      tmp = *iter;
-
-      if (gtk_text_iter_backward_char (&tmp) && ('*' == gtk_text_iter_get_char (&tmp)))
-        return TRUE;
-    }
-
-  return FALSE;
-}
-
 static gboolean
 non_space_predicate (gunichar ch,
                      gpointer user_data)
@@ -286,81 +271,41 @@ cleanup:
   return FALSE;
 }
 
+/*
+ * Moves @iter to the bracket left open before it, skipping over comments
+ * and strings. This is resolved from the buffer's bracket index.
+ */
 static gboolean
 backward_find_matching_char (GtkTextIter *iter,
                              gunichar     ch)
 {
-  GtkTextIter copy;
-  gunichar match = 0;
-  gunichar cur;
-  guint count = 1;
+  IdeBracketIndex *index;
+  GtkTextIter match;
+  gunichar open_char = 0;
 
   switch (ch) {
   case ')':
-    match = '(';
+    open_char = '(';
     break;
   case '}':
-    match = '{';
+    open_char = '{';
     break;
-  case '[':
-    match = ']';
+  case ']':
+    open_char = '[';
     break;
   default:
     g_assert_not_reached ();
     break;
   }
 
-  gtk_text_iter_assign (&copy, iter);
+  index = ide_bracket_index_get_for_buffer (gtk_text_iter_get_buffer (iter));
 
-  while (gtk_text_iter_backward_char (iter))
+  if (index != NULL && ide_bracket_index_get_enclosing (index, iter, open_char, 1, &match))
     {
-      cur = gtk_text_iter_get_char (iter);
-
-      if ((cur == '\'') || (cur == '"'))
-        {
-          gunichar strcur = 0;
-
-          while (gtk_text_iter_backward_char (iter))
-            {
-              strcur = gtk_text_iter_get_char (iter);
-              if (strcur == cur)
-                {
-                  GtkTextIter copy2 = *iter;
-
-                  /* check if the character before this is an escape char */
-                  if (gtk_text_iter_backward_char (&copy2) &&
-                      ('\\' == gtk_text_iter_get_char (&copy2)))
-                    continue;
-
-                  break;
-                }
-            }
-
-          if (strcur != cur)
-            break;
-        }
-      else if ((cur == '/') && iter_ends_c89_comment (iter))
-        {
-          GtkTextIter tmp = *iter;
-
-          if (backward_before_c89_comment (&tmp))
-            {
-              *iter = tmp;
-              cur = gtk_text_iter_get_char (iter);
-            }
-        }
-
-      if (cur == match)
-        {
-          if (--count == 0)
-            return TRUE;
-        }
-      else if (cur == ch)
-        count++;
+      *iter = match;
+      return TRUE;
     }
 
-  gtk_text_iter_assign (iter, &copy);
-
   return FALSE;
 }
 
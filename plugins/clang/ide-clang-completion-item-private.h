@@ -24,6 +24,7 @@
 #include <string.h>
 
 #include "ide-clang-completion-item.h"
+#include "ide-completion-item.h"
 #include "ide-ref-ptr.h"
 
 G_BEGIN_DECLS
@@ -36,6 +37,13 @@ struct _IdeClangCompletionItem
 
   guint             index;
   guint             priority;
+  /*
+   * The score of the last fuzzy match against the typed text. This is
+   * written from the filter worker threads, so it must not share storage
+   * with the bitfields below.
+   */
+  guint             score;
+  gboolean          matched;
   gint              typed_text_index : 16;
   guint             initialized : 1;
 
@@ -44,7 +52,13 @@ struct _IdeClangCompletionItem
   gchar            *markup;
   IdeRefPtr        *results;
   IdeSourceSnippet *snippet;
-  gchar            *typed_text;
+  /*
+   * The typed text is extracted once, on the thread that performed the
+   * code completion, into a GStringChunk shared by every item of the
+   * result set. @strings holds a reference to that arena.
+   */
+  IdeRefPtr        *strings;
+  const gchar      *typed_text;
 };
 
 static inline CXCompletionResult *
@@ -54,43 +68,34 @@ ide_clang_completion_item_get_result (const IdeClangCompletionItem *self)
 }
 
 static inline gboolean
-ide_clang_completion_item_match (IdeClangCompletionItem *self,
-                                 const gchar            *lower_is_ascii)
+ide_clang_completion_item_fuzzy_match (IdeClangCompletionItem *self,
+                                       const gchar            *casefold,
+                                       guint                  *score)
 {
   const gchar *haystack = self->typed_text;
-  const gchar *needle = lower_is_ascii;
-  const gchar *tmp;
-  char ch = *needle;
-
-  if (G_UNLIKELY (haystack == NULL))
-    haystack = ide_clang_completion_item_get_typed_text (self);
+  gchar ch = *casefold;
+  guint i;
 
   /*
-   * Optimization to require that we find the first character of
-   * needle within the first 4 characters of typed_text. Otherwise,
-   * we get way too many bogus results. It's okay to check past
-   * the trailing null byte since we know that malloc allocations
-   * are aligned to a pointer size (and therefore minimum allocation
-   * is 4 byte on 32-bit and 8 byte on 64-bit). If we hit a bogus
-   * condition, oh well, it's just one more compare below.
+   * Optimization to require that we find the first character of the
+   * needle within the first 4 characters of typed_text. Otherwise, we
+   * get way too many bogus results. The typed text lives in a shared
+   * arena, so we must be careful not to step past the trailing nul.
    */
-  if (haystack [0] != ch && haystack [1] != ch && haystack [2] != ch && haystack [3] != ch)
-    return FALSE;
-
-  for (; *needle; needle++)
+  for (i = 0; i < 4 && haystack [i] != '\0'; i++)
     {
-      tmp = strchr (haystack, *needle);
-      if (tmp == NULL)
-        tmp = strchr (haystack, g_ascii_toupper (*needle));
-      if (tmp == NULL)
-        return FALSE;
-      haystack = tmp;
+      if (haystack [i] == ch || haystack [i] == g_ascii_toupper (ch))
+        break;
     }
 
-  return TRUE;
+  if (i == 4 || haystack [i] == '\0')
+    return FALSE;
+
+  return ide_completion_item_fuzzy_match (haystack, casefold, score);
 }
 
 IdeClangCompletionItem *ide_clang_completion_item_new (IdeRefPtr *results,
+                                                       IdeRefPtr *strings,
                                                        guint      index);
 
 G_END_DECLS
@@ -337,9 +337,9 @@ ide_clang_completion_item_finalize (GObject *object)
 
   g_clear_object (&self->snippet);
   g_clear_pointer (&self->brief_comment, g_free);
-  g_clear_pointer (&self->typed_text, g_free);
   g_clear_pointer (&self->markup, g_free);
   g_clear_pointer (&self->results, ide_ref_ptr_unref);
+  g_clear_pointer (&self->strings, ide_ref_ptr_unref);
 
   G_OBJECT_CLASS (ide_clang_completion_item_parent_class)->finalize (object);
 }
@@ -464,70 +464,8 @@ ide_clang_completion_item_get_snippet (IdeClangCompletionItem *self)
 const gchar *
 ide_clang_completion_item_get_typed_text (IdeClangCompletionItem *self)
 {
-  CXCompletionResult *result;
-  CXString cxstr;
-
   g_return_val_if_fail (IDE_IS_CLANG_COMPLETION_ITEM (self), NULL);
 
-  if (self->typed_text)
-    return self->typed_text;
-
-  result = ide_clang_completion_item_get_result (self);
-
-  /*
-   * Determine the index of the typed text. Each completion result should have
-   * exaction one of these.
-   */
-  if (G_UNLIKELY (self->typed_text_index == -1))
-    {
-      guint num_chunks;
-      guint i;
-
-      num_chunks = clang_getNumCompletionChunks (result);
-
-      for (i = 0; i < num_chunks; i++)
-        {
-          enum CXCompletionChunkKind kind;
-
-          kind = clang_getCompletionChunkKind (result->CompletionString, i);
-          if (kind == CXCompletionChunk_TypedText)
-            {
-              self->typed_text_index = i;
-              break;
-            }
-        }
-    }
-
-  if (self->typed_text_index == -1)
-    {
-      /*
-       * FIXME:
-       *
-       * This seems like an implausible result, but we are definitely
-       * hitting it occasionally.
-       */
-      return "";
-    }
-
-#ifdef IDE_ENABLE_TRACE
-  {
-    enum CXCompletionChunkKind kind;
-    unsigned num_chunks;
-
-    g_assert (self->typed_text_index >= 0);
-
-    num_chunks = clang_getNumCompletionChunks (result->CompletionString);
-    g_assert (num_chunks > self->typed_text_index);
-
-    kind = clang_getCompletionChunkKind (result->CompletionString, self->typed_text_index);
-    g_assert (kind == CXCompletionChunk_TypedText);
-  }
-#endif
-
-  cxstr = clang_getCompletionChunkText (result->CompletionString, self->typed_text_index);
-  self->typed_text = g_strdup (clang_getCString (cxstr));
-  clang_disposeString (cxstr);
-
   return self->typed_text;
 }
 
@@ -560,8 +498,72 @@ ide_clang_completion_item_get_brief_comment (IdeClangCompletionItem *self)
   return self->brief_comment;
 }
 
+static const gchar *
+ide_clang_completion_item_extract_typed_text (IdeClangCompletionItem *self,
+                                              GStringChunk           *strings)
+{
+  CXCompletionResult *result;
+  const gchar *ret;
+  CXString cxstr;
+  guint num_chunks;
+  guint i;
+
+  g_assert (IDE_IS_CLANG_COMPLETION_ITEM (self));
+  g_assert (strings != NULL);
+
+  result = ide_clang_completion_item_get_result (self);
+
+  /*
+   * Determine the index of the typed text. Each completion result should have
+   * exactly one of these.
+   */
+  num_chunks = clang_getNumCompletionChunks (result->CompletionString);
+
+  for (i = 0; i < num_chunks; i++)
+    {
+      enum CXCompletionChunkKind kind;
+
+      kind = clang_getCompletionChunkKind (result->CompletionString, i);
+      if (kind == CXCompletionChunk_TypedText)
+        {
+          self->typed_text_index = i;
+          break;
+        }
+    }
+
+  if (self->typed_text_index == -1)
+    {
+      /*
+       * FIXME:
+       *
+       * This seems like an implausible result, but we are definitely
+       * hitting it occasionally.
+       */
+      return g_string_chunk_insert_const (strings, "");
+    }
+
+  cxstr = clang_getCompletionChunkText (result->CompletionString, self->typed_text_index);
+  ret = g_string_chunk_insert (strings, clang_getCString (cxstr) ?: "");
+  clang_disposeString (cxstr);
+
+  return ret;
+}
+
+/*
+ * ide_clang_completion_item_new:
+ * @results: An #IdeRefPtr containing a CXCodeCompleteResults.
+ * @strings: An #IdeRefPtr containing a #GStringChunk.
+ * @index: the index of the result within @results.
+ *
+ * Creates a new item and copies the typed text of the result into @strings.
+ * This is meant to be called from the thread that performed the code
+ * completion so that the main loop never needs to walk the completion
+ * chunks just to filter results. The #GStringChunk is not thread-safe, so
+ * items sharing @strings must be created from a single thread.
+ */
 IdeClangCompletionItem *
 ide_clang_completion_item_new (IdeRefPtr *results,
+                               IdeRefPtr *strings,
                                guint      index)
 {
   IdeClangCompletionItem *ret;
@@ -569,10 +571,12 @@ ide_clang_completion_item_new (IdeRefPtr *results,
 
   ret = g_object_new (IDE_TYPE_CLANG_COMPLETION_ITEM, NULL);
   ret->results = ide_ref_ptr_ref (results);
+  ret->strings = ide_ref_ptr_ref (strings);
   ret->index = index;
 
   result = ide_clang_completion_item_get_result (ret);
   ret->priority = clang_getCompletionPriority (result->CompletionString);
+  ret->typed_text = ide_clang_completion_item_extract_typed_text (ret, ide_ref_ptr_get (strings));
 
   return ret;
 }
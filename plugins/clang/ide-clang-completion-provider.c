@@ -36,13 +36,18 @@ struct _IdeClangCompletionProvider
   gchar         *last_line;
   GPtrArray     *last_results;
   gchar         *last_query;
+  /*
+   * The items of last_results that matched last_query, sorted by score.
+   * The items are borrowed from last_results. When the user keeps typing
+   * we only need to filter this set rather than every result.
+   */
+  GPtrArray     *matches;
   /*
    * As an optimization, the linked list for result nodes are
    * embedded in the IdeClangCompletionItem structures and we
    * do not allocate them. This is the pointer to the first item
-   * in the result set that matches our query. It is not allocated
-   * and do not tree to free it or perform g_list_*() operations
-   * upon it.
+   * in the visible window of matches. It is not allocated and do
+   * not try to free it or perform g_list_*() operations upon it.
    */
   GList         *head;
   /*
@@ -70,6 +75,28 @@ typedef struct
   gchar *query;
 } IdeClangCompletionState;
 
+typedef struct
+{
+  GMutex mutex;
+  GCond  cond;
+  guint  n_pending;
+} FilterGroup;
+
+typedef struct
+{
+  FilterGroup  *group;
+  GPtrArray    *items;
+  const gchar  *casefold;
+  guint         begin;
+  guint         end;
+} FilterChunk;
+
+/*
+ * Result sets smaller than this are filtered on the main thread since the
+ * cost of waking the workers would dominate.
+ */
+#define MIN_ITEMS_PER_CHUNK  2048
+
 static void ide_clang_completion_provider_iface_init (GtkSourceCompletionProviderIface *iface);
 
 G_DEFINE_TYPE_EXTENDED (IdeClangCompletionProvider,
@@ -93,13 +120,17 @@ ide_clang_completion_state_free (IdeClangCompletionState *state)
 }
 
 static gint
-sort_by_priority (gconstpointer a,
-                  gconstpointer b)
+sort_by_score (gconstpointer a,
+               gconstpointer b)
 {
-  IdeClangCompletionItem *itema = (IdeClangCompletionItem *)a;
-  IdeClangCompletionItem *itemb = (IdeClangCompletionItem *)b;
+  IdeClangCompletionItem *itema = *(IdeClangCompletionItem **)a;
+  IdeClangCompletionItem *itemb = *(IdeClangCompletionItem **)b;
 
-  if (itema->priority < itemb->priority)
+  if (itema->score < itemb->score)
+    return -1;
+  else if (itema->score > itemb->score)
+    return 1;
+  else if (itema->priority < itemb->priority)
     return -1;
   else if (itema->priority > itemb->priority)
     return 1;
@@ -107,11 +138,134 @@ sort_by_priority (gconstpointer a,
 }
 
 static void
-ide_clang_completion_provider_sort (IdeClangCompletionProvider *self)
+filter_chunk (FilterChunk *chunk)
 {
-  g_assert (IDE_IS_CLANG_COMPLETION_PROVIDER (self));
+  guint i;
+
+  g_assert (chunk != NULL);
+  g_assert (chunk->items != NULL);
+  g_assert (chunk->casefold != NULL);
+
+  for (i = chunk->begin; i < chunk->end; i++)
+    {
+      IdeClangCompletionItem *item = g_ptr_array_index (chunk->items, i);
+
+      item->matched = ide_clang_completion_item_fuzzy_match (item, chunk->casefold, &item->score);
+    }
+}
+
+static void
+filter_worker (gpointer data,
+               gpointer user_data)
+{
+  FilterChunk *chunk = data;
+  FilterGroup *group = chunk->group;
+
+  filter_chunk (chunk);
+
+  g_mutex_lock (&group->mutex);
+  if (--group->n_pending == 0)
+    g_cond_signal (&group->cond);
+  g_mutex_unlock (&group->mutex);
+}
+
+static GThreadPool *
+get_filter_pool (void)
+{
+  static GThreadPool *pool;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *instance;
+
+      instance = g_thread_pool_new (filter_worker,
+                                    NULL,
+                                    MAX (1, (gint)g_get_num_processors () - 1),
+                                    FALSE,
+                                    NULL);
+      g_once_init_leave (&pool, instance);
+    }
+
+  return pool;
+}
+
+/*
+ * Filters @candidates against @casefold and returns a new array containing
+ * the matching items. Large result sets are split into chunks which are
+ * scored in parallel; the main thread scores the first chunk itself and then
+ * waits for the rest. Each worker only writes to the items within its own
+ * chunk, so no locking is required beyond the completion count.
+ */
+static GPtrArray *
+ide_clang_completion_provider_filter (GPtrArray   *candidates,
+                                      const gchar *casefold)
+{
+  g_autofree FilterChunk *chunks = NULL;
+  FilterGroup group;
+  GPtrArray *ret;
+  guint n_chunks;
+  guint per_chunk;
+  guint i;
+
+  g_assert (candidates != NULL);
+  g_assert (casefold != NULL);
+
+  ret = g_ptr_array_sized_new (candidates->len);
+
+  if (*casefold == '\0')
+    {
+      for (i = 0; i < candidates->len; i++)
+        {
+          IdeClangCompletionItem *item = g_ptr_array_index (candidates, i);
 
-  self->head = g_list_sort (self->head, sort_by_priority);
+          item->score = 0;
+          g_ptr_array_add (ret, item);
+        }
+
+      return ret;
+    }
+
+  n_chunks = CLAMP (candidates->len / MIN_ITEMS_PER_CHUNK, 1, g_get_num_processors ());
+  per_chunk = (candidates->len + n_chunks - 1) / n_chunks;
+  chunks = g_new0 (FilterChunk, n_chunks);
+
+  g_mutex_init (&group.mutex);
+  g_cond_init (&group.cond);
+  group.n_pending = n_chunks - 1;
+
+  for (i = 0; i < n_chunks; i++)
+    {
+      chunks [i].group = &group;
+      chunks [i].items = candidates;
+      chunks [i].casefold = casefold;
+      chunks [i].begin = i * per_chunk;
+      chunks [i].end = MIN (candidates->len, (i + 1) * per_chunk);
+
+      if (i > 0)
+        g_thread_pool_push (get_filter_pool (), &chunks [i], NULL);
+    }
+
+  filter_chunk (&chunks [0]);
+
+  g_mutex_lock (&group.mutex);
+  while (group.n_pending > 0)
+    g_cond_wait (&group.cond, &group.mutex);
+  g_mutex_unlock (&group.mutex);
+
+  g_mutex_clear (&group.mutex);
+  g_cond_clear (&group.cond);
+
+  IDE_TRACE_MSG ("Filtered %u items in %u chunks", candidates->len, n_chunks);
+
+  for (i = 0; i < candidates->len; i++)
+    {
+      IdeClangCompletionItem *item = g_ptr_array_index (candidates, i);
+
+      if (item->matched)
+        g_ptr_array_add (ret, item);
+    }
+
+  return ret;
 }
 
 static gchar *
@@ -201,31 +355,22 @@ ide_clang_completion_provider_can_replay (IdeClangCompletionProvider *self,
 static void
 ide_clang_completion_provider_save_results (IdeClangCompletionProvider *self,
                                             GPtrArray                  *results,
-                                            const gchar                *line,
-                                            const gchar                *query)
+                                            const gchar                *line)
 {
   IDE_ENTRY;
 
   g_assert (IDE_IS_CLANG_COMPLETION_PROVIDER (self));
 
+  g_clear_pointer (&self->matches, g_ptr_array_unref);
   g_clear_pointer (&self->last_results, g_ptr_array_unref);
   g_clear_pointer (&self->last_line, g_free);
   g_clear_pointer (&self->last_query, g_free);
   self->head = NULL;
 
-  if (query && !*query)
-    query = NULL;
-
   if (results != NULL)
     {
       self->last_line = g_strdup (line);
-      self->last_query = g_strdup (query);
       self->last_results = g_ptr_array_ref (results);
-      if (results->len > 0)
-        {
-          IdeClangCompletionItem *head = g_ptr_array_index (results, 0);
-          self->head = &head->link;
-        }
     }
 
   IDE_EXIT;
@@ -233,99 +378,72 @@ ide_clang_completion_provider_save_results (IdeClangCompletionProvider *self,
 
 static void
 ide_clang_completion_provider_update_links (IdeClangCompletionProvider *self,
-                                            GPtrArray                  *results)
+                                            GPtrArray                  *matches)
 {
   IdeClangCompletionItem *item;
-  IdeClangCompletionItem *next;
-  IdeClangCompletionItem *prev;
+  GList *prev = NULL;
+  guint n_visible;
   guint i;
 
   g_assert (IDE_IS_CLANG_COMPLETION_PROVIDER (self));
-  g_assert (results != NULL);
+  g_assert (matches != NULL);
 
-  if (results->len == 0)
-    {
-      self->head = NULL;
-      return;
-    }
-
-  /* Unrolling loops for the gentoo crowd */
-
-  item = g_ptr_array_index (results, 0);
-  item->link.prev = NULL;
-  item->link.next = (results->len == 1) ? NULL : &((IdeClangCompletionItem*)g_ptr_array_index (results, 1))->link;
-
-  self->head = &item->link;
+  self->head = NULL;
 
-  prev = item;
+  n_visible = MIN (matches->len, IDE_COMPLETION_PROVIDER_MAX_VISIBLE_PROPOSALS);
 
-  for (i = 1; i < (results->len - 1); i++)
+  for (i = 0; i < n_visible; i++)
     {
-      item = g_ptr_array_index (results, i);
-      next = g_ptr_array_index (results, i + 1);
+      item = g_ptr_array_index (matches, i);
 
-      item->link.prev = &prev->link;
-      item->link.next = &next->link;
+      item->link.prev = prev;
+      item->link.next = NULL;
 
-      prev = item;
-    }
+      if (prev != NULL)
+        prev->next = &item->link;
+      else
+        self->head = &item->link;
 
-  if (results->len > 1)
-    {
-      item = g_ptr_array_index (results, results->len - 1);
-      item->link.prev = &((IdeClangCompletionItem*)g_ptr_array_index (results, results->len-2))->link;
-      item->link.next = NULL;
+      prev = &item->link;
     }
 }
 
 static void
 ide_clang_completion_provider_refilter (IdeClangCompletionProvider *self,
-                                        GPtrArray                  *results,
                                         const gchar                *query)
 {
-  g_autofree gchar *lower = NULL;
+  g_autofree gchar *casefold = NULL;
+  GPtrArray *candidates;
+  GPtrArray *matches;
 
   g_assert (IDE_IS_CLANG_COMPLETION_PROVIDER (self));
-  g_assert (results != NULL);
-  g_assert (query != NULL);
+  g_assert (self->last_results != NULL);
 
-  if (results->len == 0)
-    return;
+  if (query == NULL)
+    query = "";
 
   IDE_TRACE_MSG ("Filtering with query \"%s\"", query);
 
   /*
-   * By traversing the linked list nodes instead of the array, we allow
-   * ourselves to avoid rechecking items we already know filtered.
-   * We do need to be mindful of this in case the user backspaced
-   * and our list is no longer a continual "deep dive" of matched items.
+   * If the user has continued typing, we only need to look at the items
+   * that matched the previous query. If they backspaced, we need to start
+   * over from the full result set.
    */
-  if ((self->last_query != NULL) && g_str_has_prefix (query, self->last_query))
-    ide_clang_completion_provider_update_links (self, results);
-
-  lower = g_utf8_strdown (query, -1);
-
-  if (!g_str_is_ascii (lower))
-    {
-      g_warning ("Item filtering requires ascii input.");
-      return;
-    }
+  if ((self->matches != NULL) &&
+      (self->last_query != NULL) &&
+      g_str_has_prefix (query, self->last_query))
+    candidates = self->matches;
+  else
+    candidates = self->last_results;
 
-  for (GList *iter = self->head; iter; iter = iter->next)
-    {
-      IdeClangCompletionItem *item = iter->data;
+  casefold = g_utf8_casefold (query, -1);
+  matches = ide_clang_completion_provider_filter (candidates, casefold);
+  g_ptr_array_sort (matches, sort_by_score);
 
-      if (!ide_clang_completion_item_match (item, lower))
-        {
-          if (iter->prev != NULL)
-            iter->prev->next = iter->next;
-          else
-            self->head = iter->next;
+  g_clear_pointer (&self->matches, g_ptr_array_unref);
+  self->matches = matches;
 
-          if (iter->next != NULL)
-            iter->next->prev = iter->prev;
-        }
-    }
+  ide_clang_completion_provider_update_links (self, matches);
 
   g_free (self->last_query);
   self->last_query = g_strdup (query);
@@ -361,16 +479,13 @@ ide_clang_completion_provider_code_complete_cb (GObject      *object,
       IDE_EXIT;
     }
 
-  ide_clang_completion_provider_save_results (state->self, results, state->line, state->query);
-  ide_clang_completion_provider_update_links (state->self, results);
+  ide_clang_completion_provider_save_results (state->self, results, state->line);
 
   if (!g_cancellable_is_cancelled (state->cancellable))
     {
       if (results->len > 0)
         {
-          if (state->query && *state->query)
-            ide_clang_completion_provider_refilter (state->self, results, state->query);
-          ide_clang_completion_provider_sort (state->self);
+          ide_clang_completion_provider_refilter (state->self, state->query);
           IDE_TRACE_MSG ("%d results returned from clang", results->len);
           gtk_source_completion_context_add_proposals (state->context,
                                                        GTK_SOURCE_COMPLETION_PROVIDER (state->self),
@@ -537,8 +652,7 @@ ide_clang_completion_provider_populate (GtkSourceCompletionProvider *provider,
        * passes of this operation by traversing the already filtered
        * linked list instead of all items.
        */
-      ide_clang_completion_provider_refilter (self, self->last_results, prefix);
-      ide_clang_completion_provider_sort (self);
+      ide_clang_completion_provider_refilter (self, prefix);
       gtk_source_completion_context_add_proposals (context, provider, self->head, TRUE);
 
       IDE_EXIT;
@@ -657,6 +771,7 @@ ide_clang_completion_provider_finalize (GObject *object)
 {
   IdeClangCompletionProvider *self = (IdeClangCompletionProvider *)object;
 
+  g_clear_pointer (&self->matches, g_ptr_array_unref);
   g_clear_pointer (&self->last_results, g_ptr_array_unref);
   g_clear_pointer (&self->last_line, g_free);
   g_clear_pointer (&self->last_query, g_free);
@@ -20,23 +20,41 @@
 
 #include <clang-c/Index.h>
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <string.h>
 
 #include "egg-counter.h"
 #include "egg-task-cache.h"
 
 #include "ide-clang-highlighter.h"
+#include "ide-buffer.h"
+#include "ide-buffer-manager.h"
 #include "ide-build-system.h"
 #include "ide-clang-private.h"
 #include "ide-clang-service.h"
+#include "ide-clang-xref-index.h"
 #include "ide-context.h"
 #include "ide-debug.h"
 #include "ide-file.h"
+#include "ide-global.h"
 #include "ide-highlight-index.h"
 #include "ide-thread-pool.h"
 #include "ide-unsaved-file.h"
 #include "ide-unsaved-files.h"
 
 #define DEFAULT_EVICTION_MSEC (60 * 1000)
+/*
+ * Bump this if the format of the persisted unit cache changes so that
+ * stale entries from a previous release are ignored.
+ */
+#define UNIT_CACHE_VERSION "2"
+/*
+ * The units directory is pruned after each write. Entries that have not
+ * been used for a while go first, then the least recently used ones until
+ * the directory fits within the size limit.
+ */
+#define UNIT_CACHE_MAX_SIZE (G_GINT64_CONSTANT (512) * 1024 * 1024)
+#define UNIT_CACHE_MAX_AGE  (G_GINT64_CONSTANT (30) * 24 * 60 * 60 * G_USEC_PER_SEC)
 
 struct _IdeClangService
 {
@@ -45,6 +63,13 @@ struct _IdeClangService
   CXIndex       index;
   GCancellable *cancellable;
   EggTaskCache *units_cache;
+  /*
+   * Paths of files we have already requested a translation unit for in
+   * this session. Only the first request for a file may be satisfied from
+   * the on-disk unit cache; everything after that is a live parse.
+   */
+  GHashTable   *seen_paths;
+  IdeClangXrefIndex *xref_index;
 };
 
 typedef struct
@@ -56,8 +81,20 @@ typedef struct
   GPtrArray  *unsaved_files;
   gint64      sequence;
   guint       options;
+  guint       use_unit_cache : 1;
+  guint       deserialized : 1;
 } ParseRequest;
 
+typedef struct
+{
+  gchar      *source_filename;
+  gchar     **command_line_args;
+  GHashTable *unsaved_paths;
+  gchar      *ast_path;
+  gchar      *deps_path;
+  guint       options;
+} SaveRequest;
+
 typedef struct
 {
   IdeHighlightIndex *index;
@@ -74,6 +111,14 @@ EGG_DEFINE_COUNTER (ParseAttempts,
                     "Clang",
                     "Total Parse Attempts",
                     "Total number of attempts to create a translation unit.")
+EGG_DEFINE_COUNTER (UnitCacheHits,
+                    "Clang",
+                    "Unit Cache Hits",
+                    "Number of translation units loaded from the on-disk cache.")
+EGG_DEFINE_COUNTER (UnitCacheWrites,
+                    "Clang",
+                    "Unit Cache Writes",
+                    "Number of translation units written to the on-disk cache.")
 
 static void
 parse_request_free (gpointer data)
@@ -87,6 +132,19 @@ parse_request_free (gpointer data)
   g_slice_free (ParseRequest, request);
 }
 
+static void
+save_request_free (gpointer data)
+{
+  SaveRequest *request = data;
+
+  g_free (request->source_filename);
+  g_strfreev (request->command_line_args);
+  g_clear_pointer (&request->unsaved_paths, g_hash_table_unref);
+  g_free (request->ast_path);
+  g_free (request->deps_path);
+  g_slice_free (SaveRequest, request);
+}
+
 static enum CXChildVisitResult
 ide_clang_service_build_index_visitor (CXCursor     cursor,
                                        CXCursor     parent,
@@ -198,6 +256,397 @@ clear_unsaved_file (gpointer data)
   g_free ((gchar *)uf->Filename);
 }
 
+static gchar *
+ide_clang_service_get_unit_cache_dir (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           ide_get_program_name (),
+                           "clang",
+                           "units",
+                           NULL);
+}
+
+static gchar *
+ide_clang_service_get_unit_cache_path (ParseRequest *request,
+                                       const gchar  *suffix)
+{
+  g_autoptr(GChecksum) checksum = NULL;
+  g_autofree gchar *name = NULL;
+  g_autofree gchar *dir = NULL;
+  CXString version;
+  guint i;
+
+  g_assert (request != NULL);
+  g_assert (request->source_filename != NULL);
+  g_assert (suffix != NULL);
+
+  /*
+   * The key covers everything that can change the resulting AST other than
+   * the contents of the files involved, which are validated separately
+   * using the dependency list stored alongside the AST.
+   */
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  g_checksum_update (checksum, (const guchar *)UNIT_CACHE_VERSION, -1);
+
+  version = clang_getClangVersion ();
+  g_checksum_update (checksum, (const guchar *)clang_getCString (version), -1);
+  clang_disposeString (version);
+
+  g_checksum_update (checksum, (const guchar *)request->source_filename, -1);
+  g_checksum_update (checksum, (const guchar *)"", 1);
+
+  for (i = 0; request->command_line_args && request->command_line_args [i]; i++)
+    {
+      g_checksum_update (checksum, (const guchar *)request->command_line_args [i], -1);
+      g_checksum_update (checksum, (const guchar *)"", 1);
+    }
+
+  g_checksum_update (checksum, (const guchar *)&request->options, sizeof request->options);
+
+  name = g_strdup_printf ("%s.%s", g_checksum_get_string (checksum), suffix);
+  dir = ide_clang_service_get_unit_cache_dir ();
+
+  return g_build_filename (dir, name, NULL);
+}
+
+/*
+ * Whole seconds are too coarse to notice a header that was rewritten
+ * right after we parsed it, so stamps carry the microseconds as well.
+ */
+static gboolean
+ide_clang_service_get_file_stamp (const gchar *path,
+                                  gint64      *mtime,
+                                  gint64      *size)
+{
+  g_autoptr(GFile) file = NULL;
+  g_autoptr(GFileInfo) info = NULL;
+  GTimeVal tv;
+
+  g_assert (path != NULL);
+  g_assert (mtime != NULL);
+  g_assert (size != NULL);
+
+  file = g_file_new_for_path (path);
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC","
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE,
+                            NULL,
+                            NULL);
+
+  if (info == NULL)
+    return FALSE;
+
+  g_file_info_get_modification_time (info, &tv);
+
+  *mtime = (gint64)tv.tv_sec * G_USEC_PER_SEC + tv.tv_usec;
+  *size = g_file_info_get_size (info);
+
+  return TRUE;
+}
+
+/*
+ * The dependency list is a line per file that was included by the
+ * translation unit, in the form "mtime\tsize\tpath" with the mtime in
+ * microseconds. The unit is only reusable if every file still matches
+ * and none of them have unsaved changes in the editor.
+ */
+static gboolean
+ide_clang_service_unit_cache_is_valid (const gchar *deps_path,
+                                       GHashTable  *unsaved_paths)
+{
+  g_autofree gchar *contents = NULL;
+  g_auto(GStrv) lines = NULL;
+  guint i;
+
+  g_assert (deps_path != NULL);
+  g_assert (unsaved_paths != NULL);
+
+  if (!g_file_get_contents (deps_path, &contents, NULL, NULL))
+    return FALSE;
+
+  lines = g_strsplit (contents, "\n", 0);
+
+  for (i = 0; lines [i]; i++)
+    {
+      g_auto(GStrv) parts = NULL;
+      gint64 mtime;
+      gint64 size;
+
+      if (*lines [i] == '\0')
+        continue;
+
+      parts = g_strsplit (lines [i], "\t", 3);
+
+      if (g_strv_length (parts) != 3)
+        return FALSE;
+
+      if (g_hash_table_contains (unsaved_paths, parts [2]))
+        return FALSE;
+
+      if (!ide_clang_service_get_file_stamp (parts [2], &mtime, &size) ||
+          g_ascii_strtoll (parts [0], NULL, 10) != mtime ||
+          g_ascii_strtoll (parts [1], NULL, 10) != size)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static CXTranslationUnit
+ide_clang_service_load_unit (ParseRequest *request,
+                             GHashTable   *unsaved_paths)
+{
+  g_autofree gchar *ast_path = NULL;
+  g_autofree gchar *deps_path = NULL;
+  CXTranslationUnit tu = NULL;
+
+  g_assert (request != NULL);
+  g_assert (unsaved_paths != NULL);
+
+  deps_path = ide_clang_service_get_unit_cache_path (request, "deps");
+
+  if (!ide_clang_service_unit_cache_is_valid (deps_path, unsaved_paths))
+    return NULL;
+
+  ast_path = ide_clang_service_get_unit_cache_path (request, "ast");
+
+  if (clang_createTranslationUnit2 (request->index, ast_path, &tu) != CXError_Success)
+    {
+      IDE_TRACE_MSG ("Failed to load cached unit from %s", ast_path);
+      return NULL;
+    }
+
+  /* Pruning goes by mtime, so mark the entry as recently used. */
+  g_utime (ast_path, NULL);
+
+  return tu;
+}
+
+static void
+collect_inclusion (CXFile            included_file,
+                   CXSourceLocation *inclusion_stack,
+                   unsigned          include_len,
+                   CXClientData      user_data)
+{
+  GPtrArray *paths = user_data;
+  CXString name;
+
+  name = clang_getFileName (included_file);
+  if (clang_getCString (name) != NULL)
+    g_ptr_array_add (paths, g_strdup (clang_getCString (name)));
+  clang_disposeString (name);
+}
+
+typedef struct
+{
+  gchar  *name;
+  gint64  mtime;
+  gint64  size;
+} UnitCacheEntry;
+
+static void
+unit_cache_entry_free (gpointer data)
+{
+  UnitCacheEntry *entry = data;
+
+  g_free (entry->name);
+  g_slice_free (UnitCacheEntry, entry);
+}
+
+static gint
+unit_cache_entry_compare (gconstpointer a,
+                          gconstpointer b)
+{
+  const UnitCacheEntry *entry_a = *(const UnitCacheEntry **)a;
+  const UnitCacheEntry *entry_b = *(const UnitCacheEntry **)b;
+
+  if (entry_a->mtime < entry_b->mtime)
+    return -1;
+  else if (entry_a->mtime > entry_b->mtime)
+    return 1;
+  else
+    return 0;
+}
+
+static void
+ide_clang_service_prune_unit_cache (const gchar *dir)
+{
+  g_autoptr(GPtrArray) entries = NULL;
+  const gchar *name;
+  gint64 total = 0;
+  gint64 now;
+  GDir *gdir;
+  guint i;
+
+  g_assert (dir != NULL);
+
+  if (!(gdir = g_dir_open (dir, 0, NULL)))
+    return;
+
+  entries = g_ptr_array_new_with_free_func (unit_cache_entry_free);
+  now = g_get_real_time ();
+
+  /*
+   * Leftover temporary files are treated like entries so that they age
+   * out as well. A deps file is removed along with its AST.
+   */
+  while ((name = g_dir_read_name (gdir)))
+    {
+      g_autofree gchar *path = NULL;
+      UnitCacheEntry *entry;
+      GStatBuf st;
+
+      if (!g_str_has_suffix (name, ".ast") && !g_str_has_suffix (name, ".tmp"))
+        continue;
+
+      path = g_build_filename (dir, name, NULL);
+
+      if (g_stat (path, &st) != 0)
+        continue;
+
+      entry = g_slice_new0 (UnitCacheEntry);
+      entry->name = g_strdup (name);
+      entry->mtime = (gint64)st.st_mtime * G_USEC_PER_SEC;
+      entry->size = st.st_size;
+
+      g_ptr_array_add (entries, entry);
+
+      total += entry->size;
+    }
+
+  g_dir_close (gdir);
+
+  g_ptr_array_sort (entries, unit_cache_entry_compare);
+
+  for (i = 0; i < entries->len; i++)
+    {
+      UnitCacheEntry *entry = g_ptr_array_index (entries, i);
+      g_autofree gchar *path = NULL;
+
+      if (total <= UNIT_CACHE_MAX_SIZE && now - entry->mtime <= UNIT_CACHE_MAX_AGE)
+        break;
+
+      path = g_build_filename (dir, entry->name, NULL);
+
+      if (g_str_has_suffix (entry->name, ".ast"))
+        {
+          g_autofree gchar *deps_path = NULL;
+
+          deps_path = g_strdup_printf ("%.*s.deps", (gint)(strlen (path) - strlen (".ast")), path);
+          g_unlink (deps_path);
+        }
+
+      g_unlink (path);
+
+      total -= entry->size;
+    }
+}
+
+/*
+ * Serializing a unit takes a while and is of no use to the request that
+ * produced it, so this runs on the indexer pool once the unit has been
+ * handed out. A CXTranslationUnit may only be used by one thread at a
+ * time, and the one we handed out is shared with code completion and the
+ * main thread, so we parse a private copy from the files on disk.
+ */
+static void
+ide_clang_service_save_worker (gpointer data)
+{
+  SaveRequest *request = data;
+  g_autoptr(GPtrArray) paths = NULL;
+  g_autofree gchar *tmp_path = NULL;
+  g_autofree gchar *dir = NULL;
+  CXTranslationUnit tu = NULL;
+  CXIndex index = NULL;
+  GString *deps = NULL;
+  gint64 parse_time;
+  guint i;
+
+  g_assert (request != NULL);
+  g_assert (request->source_filename != NULL);
+
+  /* The cache only describes files on disk, not buffers being edited. */
+  if (g_hash_table_contains (request->unsaved_paths, request->source_filename))
+    goto cleanup;
+
+  /* Nothing to do if the existing entry is still good. */
+  if (ide_clang_service_unit_cache_is_valid (request->deps_path, request->unsaved_paths))
+    goto cleanup;
+
+  index = clang_createIndex (0, 0);
+  parse_time = g_get_real_time ();
+
+  if (clang_parseTranslationUnit2 (index,
+                                   request->source_filename,
+                                   (const gchar * const *)request->command_line_args,
+                                   request->command_line_args ? g_strv_length (request->command_line_args) : 0,
+                                   NULL, 0,
+                                   request->options,
+                                   &tu) != CXError_Success)
+    goto cleanup;
+
+  paths = g_ptr_array_new_with_free_func (g_free);
+  clang_getInclusions (tu, collect_inclusion, paths);
+
+  deps = g_string_new (NULL);
+
+  for (i = 0; i < paths->len; i++)
+    {
+      const gchar *path = g_ptr_array_index (paths, i);
+      gint64 mtime;
+      gint64 size;
+
+      /*
+       * An entry depending on a file with unsaved changes would be
+       * rejected on load, so don't bother. Files modified since the
+       * parse started may not match what the AST contains.
+       */
+      if (g_hash_table_contains (request->unsaved_paths, path) ||
+          !ide_clang_service_get_file_stamp (path, &mtime, &size) ||
+          mtime >= parse_time)
+        goto cleanup;
+
+      g_string_append_printf (deps, "%"G_GINT64_FORMAT"\t%"G_GINT64_FORMAT"\t%s\n",
+                              mtime, size, path);
+    }
+
+  tmp_path = g_strdup_printf ("%s.tmp", request->ast_path);
+  dir = g_path_get_dirname (request->ast_path);
+
+  if (g_mkdir_with_parents (dir, 0750) != 0)
+    goto cleanup;
+
+  /* Invalidate the old entry before replacing the AST. */
+  g_unlink (request->deps_path);
+
+  if (clang_saveTranslationUnit (tu, tmp_path, clang_defaultSaveOptions (tu)) != CXSaveError_None)
+    {
+      g_unlink (tmp_path);
+      goto cleanup;
+    }
+
+  if (g_rename (tmp_path, request->ast_path) != 0)
+    {
+      g_unlink (tmp_path);
+      goto cleanup;
+    }
+
+  if (g_file_set_contents (request->deps_path, deps->str, deps->len, NULL))
+    EGG_COUNTER_INC (UnitCacheWrites);
+
+  ide_clang_service_prune_unit_cache (dir);
+
+cleanup:
+  if (deps != NULL)
+    g_string_free (deps, TRUE);
+  g_clear_pointer (&tu, clang_disposeTranslationUnit);
+  g_clear_pointer (&index, clang_disposeIndex);
+  save_request_free (request);
+}
+
 static void
 ide_clang_service_parse_worker (GTask        *task,
                                 gpointer      source_object,
@@ -216,6 +665,7 @@ ide_clang_service_parse_worker (GTask        *task,
   gsize argc = 0;
   const gchar *detail_error = NULL;
   enum CXErrorCode code;
+  GHashTable *unsaved_paths;
   GArray *ar = NULL;
   gsize i;
 
@@ -246,6 +696,29 @@ ide_clang_service_parse_worker (GTask        *task,
       g_array_append_val (ar, uf);
     }
 
+  unsaved_paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  for (i = 0; i < ar->len; i++)
+    {
+      const struct CXUnsavedFile *uf = &g_array_index (ar, struct CXUnsavedFile, i);
+
+      if (uf->Filename != NULL)
+        g_hash_table_add (unsaved_paths, g_strdup (uf->Filename));
+    }
+
+  /*
+   * On the first request for a file in this session, try to reuse a
+   * serialized translation unit from a previous session. This lets us
+   * provide highlighting and symbols immediately while the service
+   * queues a live parse (which is required for code completion).
+   */
+  if (request->use_unit_cache && (tu = ide_clang_service_load_unit (request, unsaved_paths)))
+    {
+      EGG_COUNTER_INC (UnitCacheHits);
+      request->deserialized = TRUE;
+      index = ide_clang_service_build_index (self, tu, request);
+      goto create_unit;
+    }
+
   argv = (const gchar * const *)request->command_line_args;
   argc = argv ? g_strv_length (request->command_line_args) : 0;
 
@@ -297,13 +770,30 @@ ide_clang_service_parse_worker (GTask        *task,
       goto cleanup;
     }
 
+create_unit:
   context = ide_object_get_context (source_object);
   gfile = ide_file_get_file (request->file);
   ret = _ide_clang_translation_unit_new (context, tu, gfile, index, request->sequence);
 
   g_task_return_pointer (task, g_object_ref (ret), g_object_unref);
 
+  if (!request->deserialized)
+    {
+      SaveRequest *save;
+
+      save = g_slice_new0 (SaveRequest);
+      save->source_filename = g_strdup (request->source_filename);
+      save->command_line_args = g_strdupv (request->command_line_args);
+      save->unsaved_paths = g_hash_table_ref (unsaved_paths);
+      save->ast_path = ide_clang_service_get_unit_cache_path (request, "ast");
+      save->deps_path = ide_clang_service_get_unit_cache_path (request, "deps");
+      save->options = request->options;
+
+      ide_thread_pool_push (IDE_THREAD_POOL_INDEXER, ide_clang_service_save_worker, save);
+    }
+
 cleanup:
+  g_hash_table_unref (unsaved_paths);
   g_array_unref (ar);
 }
 
@@ -350,23 +840,91 @@ ide_clang_service__get_build_flags_cb (GObject      *object,
                              ide_clang_service_parse_worker);
 }
 
+static void
+ide_clang_service_refresh_cb (GObject      *object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
+{
+  EggTaskCache *cache = (EggTaskCache *)object;
+  g_autoptr(IdeClangTranslationUnit) unit = NULL;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (EGG_IS_TASK_CACHE (cache));
+
+  if (!(unit = egg_task_cache_get_finish (cache, result, &error)))
+    g_debug ("%s", error->message);
+}
+
+typedef struct
+{
+  IdeClangService *self;
+  IdeFile         *file;
+} RefreshRequest;
+
+static gboolean
+ide_clang_service_refresh_unit (gpointer data)
+{
+  RefreshRequest *refresh = data;
+
+  g_assert (refresh != NULL);
+  g_assert (IDE_IS_CLANG_SERVICE (refresh->self));
+  g_assert (IDE_IS_FILE (refresh->file));
+
+  if (refresh->self->units_cache != NULL)
+    egg_task_cache_get_async (refresh->self->units_cache,
+                              refresh->file,
+                              TRUE,
+                              refresh->self->cancellable,
+                              ide_clang_service_refresh_cb,
+                              NULL);
+
+  g_object_unref (refresh->self);
+  g_object_unref (refresh->file);
+  g_slice_free (RefreshRequest, refresh);
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 ide_clang_service_unit_completed_cb (GObject      *object,
                                      GAsyncResult *result,
                                      gpointer      user_data)
 {
+  IdeClangService *self = (IdeClangService *)object;
   g_autoptr(GTask) task = user_data;
+  ParseRequest *request;
   gpointer ret;
   GError *error = NULL;
 
-  g_assert (IDE_IS_CLANG_SERVICE (object));
+  g_assert (IDE_IS_CLANG_SERVICE (self));
   g_assert (G_IS_TASK (result));
   g_assert (G_IS_TASK (task));
 
+  request = g_task_get_task_data (G_TASK (result));
+
   if (!(ret = g_task_propagate_pointer (G_TASK (result), &error)))
-    g_task_return_error (task, error);
-  else
-    g_task_return_pointer (task, ret, g_object_unref);
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_task_return_pointer (task, ret, g_object_unref);
+
+  /*
+   * A unit loaded from the on-disk cache is good for highlighting and
+   * symbols, but clang cannot reparse or code complete with it.
+   * Replace it with a live parse once the cache has stored this result.
+   */
+  if (request->deserialized)
+    {
+      RefreshRequest *refresh;
+
+      refresh = g_slice_new0 (RefreshRequest);
+      refresh->self = g_object_ref (self);
+      refresh->file = g_object_ref (request->file);
+
+      g_idle_add (ide_clang_service_refresh_unit, refresh);
+    }
 }
 
 static void
@@ -414,6 +972,7 @@ ide_clang_service_get_translation_unit_worker (EggTaskCache  *cache,
   request->command_line_args = NULL;
   request->unsaved_files = ide_unsaved_files_to_array (unsaved_files);
   request->sequence = ide_unsaved_files_get_sequence (unsaved_files);
+  request->use_unit_cache = g_hash_table_add (self->seen_paths, g_strdup (path));
   /*
    * NOTE:
    *
@@ -549,6 +1108,64 @@ ide_clang_service_get_translation_unit_finish (IdeClangService  *self,
   return g_task_propagate_pointer (task, error);
 }
 
+static void
+ide_clang_service_buffer_saved (IdeClangService  *self,
+                                IdeBuffer        *buffer,
+                                IdeBufferManager *buffer_manager)
+{
+  GtkSourceLanguage *language;
+  const gchar *lang_id;
+  IdeFile *file;
+
+  g_assert (IDE_IS_CLANG_SERVICE (self));
+  g_assert (IDE_IS_BUFFER (buffer));
+  g_assert (IDE_IS_BUFFER_MANAGER (buffer_manager));
+
+  if (self->xref_index == NULL)
+    return;
+
+  if (!(language = gtk_source_buffer_get_language (GTK_SOURCE_BUFFER (buffer))))
+    return;
+
+  lang_id = gtk_source_language_get_id (language);
+
+  if (g_strcmp0 (lang_id, "c") == 0 ||
+      g_strcmp0 (lang_id, "chdr") == 0 ||
+      g_strcmp0 (lang_id, "cpp") == 0 ||
+      g_strcmp0 (lang_id, "objc") == 0)
+    {
+      file = ide_buffer_get_file (buffer);
+
+      if (!ide_file_get_is_temporary (file))
+        ide_clang_xref_index_update_file (self->xref_index, ide_file_get_file (file));
+    }
+}
+
+static void
+ide_clang_service_context_loaded (IdeService *service)
+{
+  IdeClangService *self = (IdeClangService *)service;
+  IdeBufferManager *buffer_manager;
+  IdeContext *context;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_CLANG_SERVICE (self));
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+  buffer_manager = ide_context_get_buffer_manager (context);
+
+  g_signal_connect_object (buffer_manager,
+                           "buffer-saved",
+                           G_CALLBACK (ide_clang_service_buffer_saved),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  ide_clang_xref_index_load (self->xref_index);
+
+  IDE_EXIT;
+}
+
 static void
 ide_clang_service_start (IdeService *service)
 {
@@ -575,6 +1192,10 @@ ide_clang_service_start (IdeService *service)
   self->index = clang_createIndex (0, 0);
   clang_CXIndex_setGlobalOptions (self->index,
                                   CXGlobalOpt_ThreadBackgroundPriorityForAll);
+
+  self->xref_index = g_object_new (IDE_TYPE_CLANG_XREF_INDEX,
+                                   "context", ide_object_get_context (IDE_OBJECT (self)),
+                                   NULL);
 }
 
 static void
@@ -587,6 +1208,12 @@ ide_clang_service_stop (IdeService *service)
 
   g_cancellable_cancel (self->cancellable);
   g_clear_object (&self->units_cache);
+
+  if (self->xref_index != NULL)
+    {
+      ide_clang_xref_index_shutdown (self->xref_index);
+      g_clear_object (&self->xref_index);
+    }
 }
 
 static void
@@ -597,8 +1224,12 @@ ide_clang_service_dispose (GObject *object)
   IDE_ENTRY;
 
   g_clear_object (&self->units_cache);
+  if (self->xref_index != NULL)
+    ide_clang_xref_index_shutdown (self->xref_index);
+  g_clear_object (&self->xref_index);
   g_clear_object (&self->cancellable);
   g_clear_pointer (&self->index, clang_disposeIndex);
+  g_clear_pointer (&self->seen_paths, g_hash_table_unref);
 
   G_OBJECT_CLASS (ide_clang_service_parent_class)->dispose (object);
 
@@ -627,6 +1258,7 @@ ide_clang_service_class_init (IdeClangServiceClass *klass)
 static void
 service_iface_init (IdeServiceInterface *iface)
 {
+  iface->context_loaded = ide_clang_service_context_loaded;
   iface->start = ide_clang_service_start;
   iface->stop = ide_clang_service_stop;
 }
@@ -634,6 +1266,7 @@ service_iface_init (IdeServiceInterface *iface)
 static void
 ide_clang_service_init (IdeClangService *self)
 {
+  self->seen_paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 }
 
 /**
@@ -664,3 +1297,19 @@ _ide_clang_dispose_string (CXString *str)
   if (str != NULL && str->data != NULL)
     clang_disposeString (*str);
 }
+
+/**
+ * ide_clang_service_get_xref_index:
+ * @self: A #IdeClangService.
+ *
+ * Gets the project-wide cross-reference index.
+ *
+ * Returns: (transfer none) (nullable): An #IdeClangXrefIndex or %NULL.
+ */
+IdeClangXrefIndex *
+ide_clang_service_get_xref_index (IdeClangService *self)
+{
+  g_return_val_if_fail (IDE_IS_CLANG_SERVICE (self), NULL);
+
+  return self->xref_index;
+}
@@ -20,6 +20,7 @@
 #define IDE_CLANG_SERVICE_H
 
 #include "ide-clang-translation-unit.h"
+#include "ide-clang-xref-index.h"
 #include "ide-service.h"
 
 G_BEGIN_DECLS
@@ -39,6 +40,7 @@ IdeClangTranslationUnit *ide_clang_service_get_translation_unit_finish (IdeClang
                                                                         GError              **error);
 IdeClangTranslationUnit *ide_clang_service_get_cached_translation_unit (IdeClangService      *self,
                                                                         IdeFile              *file);
+IdeClangXrefIndex       *ide_clang_service_get_xref_index              (IdeClangService      *self);
 
 G_END_DECLS
 
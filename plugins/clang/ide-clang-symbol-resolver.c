@@ -24,6 +24,7 @@
 #include "ide-debug.h"
 #include "ide-file.h"
 #include "ide-source-location.h"
+#include "ide-source-range.h"
 #include "ide-symbol.h"
 
 struct _IdeClangSymbolResolver
@@ -46,6 +47,9 @@ ide_clang_symbol_resolver_lookup_symbol_cb (GObject      *object,
   g_autoptr(IdeClangTranslationUnit) unit = NULL;
   g_autoptr(GTask) task = user_data;
   g_autoptr(IdeSymbol) symbol = NULL;
+  g_autoptr(IdeSourceLocation) definition = NULL;
+  g_autofree gchar *usr = NULL;
+  IdeClangXrefIndex *xref_index;
   IdeSourceLocation *location;
   GError *error = NULL;
 
@@ -70,6 +74,32 @@ ide_clang_symbol_resolver_lookup_symbol_cb (GObject      *object,
       return;
     }
 
+  /*
+   * The unit only knows about declarations it can see, so if the symbol
+   * is defined in another translation unit, the cross-reference index is
+   * the only way to jump to the definition.
+   */
+  if ((xref_index = ide_clang_service_get_xref_index (service)) &&
+      (usr = ide_clang_translation_unit_get_usr (unit, location)) &&
+      (definition = ide_clang_xref_index_find_definition (xref_index, usr)))
+    {
+      IdeSourceLocation *declaration = ide_symbol_get_declaration_location (symbol);
+      IdeSymbol *resolved;
+
+      if (declaration == NULL)
+        declaration = ide_symbol_get_definition_location (symbol);
+
+      resolved = ide_symbol_new (ide_symbol_get_name (symbol),
+                                 ide_symbol_get_kind (symbol),
+                                 ide_symbol_get_flags (symbol),
+                                 declaration,
+                                 definition,
+                                 ide_symbol_get_canonical_location (symbol));
+
+      g_clear_pointer (&symbol, ide_symbol_unref);
+      symbol = resolved;
+    }
+
   g_task_return_pointer (task, ide_symbol_ref (symbol), (GDestroyNotify)ide_symbol_unref);
 }
 
@@ -237,6 +267,101 @@ ide_clang_symbol_resolver_get_symbol_tree_finish (IdeSymbolResolver  *resolver,
   IDE_RETURN (ret);
 }
 
+static void
+ide_clang_symbol_resolver_find_references_cb (GObject      *object,
+                                              GAsyncResult *result,
+                                              gpointer      user_data)
+{
+  IdeClangService *service = (IdeClangService *)object;
+  g_autoptr(IdeClangTranslationUnit) unit = NULL;
+  g_autoptr(GTask) task = user_data;
+  g_autofree gchar *usr = NULL;
+  IdeClangXrefIndex *xref_index;
+  IdeSourceLocation *location;
+  GError *error = NULL;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_CLANG_SERVICE (service));
+  g_assert (G_IS_TASK (task));
+
+  location = g_task_get_task_data (task);
+
+  if (!(unit = ide_clang_service_get_translation_unit_finish (service, result, &error)))
+    {
+      g_task_return_error (task, error);
+      IDE_EXIT;
+    }
+
+  if (!(usr = ide_clang_translation_unit_get_usr (unit, location)) ||
+      !(xref_index = ide_clang_service_get_xref_index (service)))
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_NOT_FOUND,
+                               "No symbol was found at the location");
+      IDE_EXIT;
+    }
+
+  g_task_return_pointer (task,
+                         ide_clang_xref_index_find_references (xref_index, usr),
+                         (GDestroyNotify)g_ptr_array_unref);
+
+  IDE_EXIT;
+}
+
+static void
+ide_clang_symbol_resolver_find_references_async (IdeSymbolResolver   *resolver,
+                                                 IdeSourceLocation   *location,
+                                                 GCancellable        *cancellable,
+                                                 GAsyncReadyCallback  callback,
+                                                 gpointer             user_data)
+{
+  IdeClangSymbolResolver *self = (IdeClangSymbolResolver *)resolver;
+  IdeClangService *service;
+  IdeContext *context;
+  g_autoptr(GTask) task = NULL;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_CLANG_SYMBOL_RESOLVER (self));
+  g_assert (location != NULL);
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+  service = ide_context_get_service_typed (context, IDE_TYPE_CLANG_SERVICE);
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, ide_clang_symbol_resolver_find_references_async);
+  g_task_set_task_data (task, ide_source_location_ref (location),
+                        (GDestroyNotify)ide_source_location_unref);
+
+  ide_clang_service_get_translation_unit_async (service,
+                                                ide_source_location_get_file (location),
+                                                0,
+                                                cancellable,
+                                                ide_clang_symbol_resolver_find_references_cb,
+                                                g_object_ref (task));
+
+  IDE_EXIT;
+}
+
+static GPtrArray *
+ide_clang_symbol_resolver_find_references_finish (IdeSymbolResolver  *resolver,
+                                                  GAsyncResult       *result,
+                                                  GError            **error)
+{
+  GPtrArray *ret;
+
+  IDE_ENTRY;
+
+  g_return_val_if_fail (IDE_IS_CLANG_SYMBOL_RESOLVER (resolver), NULL);
+  g_return_val_if_fail (G_IS_TASK (result), NULL);
+
+  ret = g_task_propagate_pointer (G_TASK (result), error);
+
+  IDE_RETURN (ret);
+}
+
 static void
 ide_clang_symbol_resolver_class_init (IdeClangSymbolResolverClass *klass)
 {
@@ -249,6 +374,8 @@ symbol_resolver_iface_init (IdeSymbolResolverInterface *iface)
   iface->lookup_symbol_finish = ide_clang_symbol_resolver_lookup_symbol_finish;
   iface->get_symbol_tree_async = ide_clang_symbol_resolver_get_symbol_tree_async;
   iface->get_symbol_tree_finish = ide_clang_symbol_resolver_get_symbol_tree_finish;
+  iface->find_references_async = ide_clang_symbol_resolver_find_references_async;
+  iface->find_references_finish = ide_clang_symbol_resolver_find_references_finish;
 }
 
 static void
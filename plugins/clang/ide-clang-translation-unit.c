@@ -70,6 +70,8 @@ typedef struct
   gchar     *path;
 } GetSymbolsState;
 
+#define TYPED_TEXT_CHUNK_SIZE 4096
+
 G_DEFINE_TYPE (IdeClangTranslationUnit, ide_clang_translation_unit, IDE_TYPE_OBJECT)
 EGG_DEFINE_COUNTER (instances, "Clang", "Translation Units", "Number of clang translation units")
 
@@ -631,6 +633,7 @@ ide_clang_translation_unit_code_complete_worker (GTask        *task,
   CXCodeCompleteResults *results;
   CXTranslationUnit tu;
   g_autoptr(IdeRefPtr) refptr = NULL;
+  g_autoptr(IdeRefPtr) strings = NULL;
   struct CXUnsavedFile *ufs;
   GPtrArray *ar;
   gsize i;
@@ -695,16 +698,20 @@ ide_clang_translation_unit_code_complete_worker (GTask        *task,
 
   /*
    * encapsulate in refptr so we don't need to malloc lots of little strings.
-   * we will inflate result strings as necessary.
+   * we will inflate result strings as necessary. The typed text is the one
+   * exception, since it is needed for filtering. It is copied once, here on
+   * the worker thread, into a string arena shared by the whole result set.
    */
   refptr = ide_ref_ptr_new (results, (GDestroyNotify)clang_disposeCodeCompleteResults);
-  ar = g_ptr_array_new_with_free_func (g_object_unref);
+  strings = ide_ref_ptr_new (g_string_chunk_new (TYPED_TEXT_CHUNK_SIZE),
+                             (GDestroyNotify)g_string_chunk_free);
+  ar = g_ptr_array_new_full (results->NumResults, g_object_unref);
 
   for (i = 0; i < results->NumResults; i++)
     {
       GtkSourceCompletionProposal *proposal;
 
-      proposal = GTK_SOURCE_COMPLETION_PROPOSAL (ide_clang_completion_item_new (refptr, i));
+      proposal = GTK_SOURCE_COMPLETION_PROPOSAL (ide_clang_completion_item_new (refptr, strings, i));
       g_ptr_array_add (ar, proposal);
     }
 
@@ -992,6 +999,61 @@ ide_clang_translation_unit_lookup_symbol (IdeClangTranslationUnit  *self,
   IDE_RETURN (ret);
 }
 
+/**
+ * ide_clang_translation_unit_get_usr:
+ * @self: An #IdeClangTranslationUnit
+ * @location: An #IdeSourceLocation within the unit
+ *
+ * Gets the clang USR (Unified Symbol Resolution) of the symbol referenced
+ * at @location, which identifies the symbol across translation units.
+ *
+ * Returns: (transfer full) (nullable): A newly allocated string or %NULL.
+ */
+gchar *
+ide_clang_translation_unit_get_usr (IdeClangTranslationUnit *self,
+                                    IdeSourceLocation       *location)
+{
+  g_autofree gchar *filename = NULL;
+  g_auto(CXString) cxusr = { 0 };
+  CXTranslationUnit tu;
+  CXCursor cursor;
+  CXCursor referenced;
+  CXFile cxfile;
+  const gchar *usr;
+  IdeFile *file;
+  GFile *gfile;
+
+  g_return_val_if_fail (IDE_IS_CLANG_TRANSLATION_UNIT (self), NULL);
+  g_return_val_if_fail (location != NULL, NULL);
+
+  tu = ide_ref_ptr_get (self->native);
+
+  if (!(file = ide_source_location_get_file (location)) ||
+      !(gfile = ide_file_get_file (file)) ||
+      !(filename = g_file_get_path (gfile)) ||
+      !(cxfile = clang_getFile (tu, filename)))
+    return NULL;
+
+  cursor = clang_getCursor (tu, clang_getLocation (tu,
+                                                   cxfile,
+                                                   ide_source_location_get_line (location) + 1,
+                                                   ide_source_location_get_line_offset (location) + 1));
+  if (clang_Cursor_isNull (cursor))
+    return NULL;
+
+  referenced = clang_getCursorReferenced (cursor);
+  if (!clang_Cursor_isNull (referenced))
+    cursor = referenced;
+
+  cxusr = clang_getCursorUSR (cursor);
+  usr = clang_getCString (cxusr);
+
+  if (usr == NULL || *usr == '\0')
+    return NULL;
+
+  return g_strdup (usr);
+}
+
 static IdeSymbol *
 create_symbol (CXCursor         cursor,
                GetSymbolsState *state)
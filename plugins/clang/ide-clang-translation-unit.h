@@ -56,6 +56,8 @@ IdeHighlightIndex *ide_clang_translation_unit_get_index                (IdeClang
 IdeSymbol         *ide_clang_translation_unit_lookup_symbol            (IdeClangTranslationUnit  *self,
                                                                         IdeSourceLocation        *location,
                                                                         GError                  **error);
+gchar             *ide_clang_translation_unit_get_usr                  (IdeClangTranslationUnit  *self,
+                                                                        IdeSourceLocation        *location);
 GPtrArray         *ide_clang_translation_unit_get_symbols              (IdeClangTranslationUnit  *self,
                                                                         IdeFile                  *file);
 
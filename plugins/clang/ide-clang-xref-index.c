@@ -0,0 +1,908 @@
+/* ide-clang-xref-index.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-clang-xref-index"
+
+#include <clang-c/Index.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include "egg-counter.h"
+
+#include "ide-build-system.h"
+#include "ide-clang-xref-index.h"
+#include "ide-clang-xref-store.h"
+#include "ide-context.h"
+#include "ide-debug.h"
+#include "ide-file.h"
+#include "ide-global.h"
+#include "ide-source-range.h"
+#include "ide-thread-pool.h"
+#include "ide-vcs.h"
+
+/*
+ * The cross-reference index records every declaration, definition and
+ * reference of the project's symbols, keyed by their clang USR.
+ *
+ * Translation units are indexed with clang_indexSourceFile() on the
+ * indexer thread pool. The results are written to an IdeClangXrefStore,
+ * which appends a small segment per write and maps it, so queries never
+ * have to parse anything and the database is not read into memory.
+ *
+ * The database is refreshed per file when a buffer is saved, and when
+ * the project is loaded we reindex any file that changed since it was
+ * last indexed (such as after a rebuild or a VCS checkout).
+ */
+
+/*
+ * Write the pending batches after this many translation units have been
+ * indexed, so that a long crawl becomes visible to queries as it progresses.
+ */
+#define MAX_PENDING_BATCHES 25
+
+typedef struct
+{
+  CXIndex   index;
+  gchar    *path;
+  gchar    *workdir_prefix;
+  gchar   **argv;
+} IndexRequest;
+
+typedef struct
+{
+  IdeClangXrefBatch *batch;
+  const gchar       *workdir_prefix;
+  GHashTable        *cxfiles;
+  GCancellable      *cancellable;
+} IndexState;
+
+typedef struct
+{
+  GPtrArray *segments;
+  GFile     *workdir;
+  IdeVcs    *vcs;
+} CrawlRequest;
+
+struct _IdeClangXrefIndex
+{
+  IdeObject     parent_instance;
+
+  CXIndex            index;
+  GCancellable      *cancellable;
+  gchar             *workdir_prefix;
+  IdeClangXrefStore *store;
+
+  /* GFile instances waiting to be indexed. */
+  GQueue             queue;
+  GHashTable        *queued;
+
+  /* IdeClangXrefBatch that have been indexed but not yet written. */
+  GPtrArray         *pending;
+
+  guint              loaded : 1;
+  guint              indexing : 1;
+  guint              writing : 1;
+};
+
+G_DEFINE_TYPE (IdeClangXrefIndex, ide_clang_xref_index, IDE_TYPE_OBJECT)
+
+EGG_DEFINE_COUNTER (XrefUnitsIndexed,
+                    "Clang",
+                    "Xref Units Indexed",
+                    "Number of translation units indexed for cross-references.")
+
+static void ide_clang_xref_index_process (IdeClangXrefIndex *self);
+
+static const gchar *source_suffixes[] = { ".c", ".cc", ".cpp", ".cxx", ".m", ".mm", NULL };
+static IdeClangXrefFile outside_project;
+
+static void
+index_request_free (gpointer data)
+{
+  IndexRequest *request = data;
+
+  g_free (request->path);
+  g_free (request->workdir_prefix);
+  g_strfreev (request->argv);
+  g_slice_free (IndexRequest, request);
+}
+
+static void
+crawl_request_free (gpointer data)
+{
+  CrawlRequest *request = data;
+
+  g_clear_pointer (&request->segments, g_ptr_array_unref);
+  g_clear_object (&request->workdir);
+  g_clear_object (&request->vcs);
+  g_slice_free (CrawlRequest, request);
+}
+
+static gboolean
+is_source_file (const gchar *name)
+{
+  guint i;
+
+  for (i = 0; source_suffixes [i]; i++)
+    {
+      if (g_str_has_suffix (name, source_suffixes [i]))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static IdeClangXrefFile *
+index_state_get_file (IndexState *state,
+                      CXFile      cxfile)
+{
+  IdeClangXrefFile *file;
+
+  if (cxfile == NULL)
+    return NULL;
+
+  if (!(file = g_hash_table_lookup (state->cxfiles, cxfile)))
+    {
+      CXString cxname = clang_getFileName (cxfile);
+      const gchar *path = clang_getCString (cxname);
+
+      if (path != NULL && g_str_has_prefix (path, state->workdir_prefix))
+        {
+          if (!(file = g_hash_table_lookup (state->batch->files, path)))
+            file = ide_clang_xref_batch_add_file (state->batch, path, TRUE);
+        }
+
+      if (file == NULL || file->records == NULL)
+        file = &outside_project;
+
+      g_hash_table_insert (state->cxfiles, cxfile, file);
+
+      clang_disposeString (cxname);
+    }
+
+  return (file != &outside_project) ? file : NULL;
+}
+
+static void
+index_state_add (IndexState             *state,
+                 const CXIdxEntityInfo  *entity,
+                 CXIdxLoc                loc,
+                 IdeClangXrefKind        kind)
+{
+  IdeClangXrefRecord record;
+  IdeClangXrefFile *file;
+  CXFile cxfile = NULL;
+  unsigned line = 0;
+  unsigned column = 0;
+
+  if (entity == NULL || entity->USR == NULL || entity->USR [0] == '\0')
+    return;
+
+  clang_indexLoc_getFileLocation (loc, NULL, &cxfile, &line, &column, NULL);
+
+  if (line == 0 || !(file = index_state_get_file (state, cxfile)))
+    return;
+
+  record.usr = g_string_chunk_insert_const (state->batch->strings, entity->USR);
+  record.line = line;
+  record.column = column;
+  record.length = entity->name ? MIN (strlen (entity->name), G_MAXUINT16) : 0;
+  record.kind = kind;
+
+  g_array_append_val (file->records, record);
+}
+
+static int
+index_abort_query_cb (CXClientData  client_data,
+                      void         *reserved)
+{
+  IndexState *state = client_data;
+
+  return g_cancellable_is_cancelled (state->cancellable);
+}
+
+static void
+index_declaration_cb (CXClientData         client_data,
+                      const CXIdxDeclInfo *info)
+{
+  index_state_add (client_data,
+                   info->entityInfo,
+                   info->loc,
+                   info->isDefinition ? IDE_CLANG_XREF_DEFINITION : IDE_CLANG_XREF_DECLARATION);
+}
+
+static void
+index_entity_reference_cb (CXClientData              client_data,
+                           const CXIdxEntityRefInfo *info)
+{
+  index_state_add (client_data, info->referencedEntity, info->loc, IDE_CLANG_XREF_REFERENCE);
+}
+
+static void
+ide_clang_xref_index_index_worker (GTask        *task,
+                                   gpointer      source_object,
+                                   gpointer      task_data,
+                                   GCancellable *cancellable)
+{
+  IndexRequest *request = task_data;
+  IndexerCallbacks callbacks = { 0 };
+  IndexState state = { 0 };
+  CXIndexAction action;
+  int code;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (IDE_IS_CLANG_XREF_INDEX (source_object));
+  g_assert (request != NULL);
+
+  state.batch = ide_clang_xref_batch_new ();
+  state.workdir_prefix = request->workdir_prefix;
+  state.cxfiles = g_hash_table_new (NULL, NULL);
+  state.cancellable = cancellable;
+
+  callbacks.abortQuery = index_abort_query_cb;
+  callbacks.indexDeclaration = index_declaration_cb;
+  callbacks.indexEntityReference = index_entity_reference_cb;
+
+  action = clang_IndexAction_create (request->index);
+  code = clang_indexSourceFile (action,
+                                &state,
+                                &callbacks,
+                                sizeof callbacks,
+                                CXIndexOpt_SuppressWarnings | CXIndexOpt_SuppressRedundantRefs,
+                                request->path,
+                                (const char * const *)request->argv,
+                                g_strv_length (request->argv),
+                                NULL,
+                                0,
+                                NULL,
+                                CXTranslationUnit_None);
+  clang_IndexAction_dispose (action);
+
+  g_hash_table_unref (state.cxfiles);
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      ide_clang_xref_batch_free (state.batch);
+      return;
+    }
+
+  if (code != 0)
+    {
+      ide_clang_xref_batch_free (state.batch);
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_FAILED,
+                               _("Failed to index %s"),
+                               request->path);
+      return;
+    }
+
+  /*
+   * Make sure the unit itself is recorded even if it contains no symbols,
+   * so that we do not index it again every time the project is loaded.
+   */
+  if (!g_hash_table_contains (state.batch->files, request->path))
+    ide_clang_xref_batch_add_file (state.batch, request->path, TRUE);
+
+  EGG_COUNTER_INC (XrefUnitsIndexed);
+
+  g_task_return_pointer (task, state.batch, ide_clang_xref_batch_free);
+}
+
+static void
+ide_clang_xref_index_write_cb (GObject      *object,
+                               GAsyncResult *result,
+                               gpointer      user_data)
+{
+  IdeClangXrefIndex *self = (IdeClangXrefIndex *)object;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (IDE_IS_CLANG_XREF_INDEX (self));
+  g_assert (G_IS_TASK (result));
+
+  self->writing = FALSE;
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("Failed to write cross-reference index: %s", error->message);
+      return;
+    }
+
+  ide_clang_xref_store_finish_write (self->store, g_task_get_task_data (G_TASK (result)));
+
+  ide_clang_xref_index_process (self);
+}
+
+static void
+ide_clang_xref_index_write_worker (GTask        *task,
+                                   gpointer      source_object,
+                                   gpointer      task_data,
+                                   GCancellable *cancellable)
+{
+  IdeClangXrefWrite *write = task_data;
+  GError *error = NULL;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (write != NULL);
+
+  if (!ide_clang_xref_write_run (write, &error))
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+ide_clang_xref_index_write (IdeClangXrefIndex *self)
+{
+  g_autoptr(GTask) task = NULL;
+  IdeClangXrefWrite *write;
+
+  g_assert (IDE_IS_CLANG_XREF_INDEX (self));
+  g_assert (!self->writing);
+  g_assert (self->pending->len > 0);
+
+  write = ide_clang_xref_store_begin_write (self->store, self->pending);
+
+  self->pending = g_ptr_array_new_with_free_func (ide_clang_xref_batch_free);
+  self->writing = TRUE;
+
+  task = g_task_new (self, self->cancellable, ide_clang_xref_index_write_cb, NULL);
+  g_task_set_source_tag (task, ide_clang_xref_index_write);
+  g_task_set_task_data (task, write, ide_clang_xref_write_free);
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, task, ide_clang_xref_index_write_worker);
+}
+
+static void
+ide_clang_xref_index_index_cb (GObject      *object,
+                               GAsyncResult *result,
+                               gpointer      user_data)
+{
+  IdeClangXrefIndex *self = (IdeClangXrefIndex *)object;
+  g_autoptr(GError) error = NULL;
+  IdeClangXrefBatch *batch;
+
+  g_assert (IDE_IS_CLANG_XREF_INDEX (self));
+  g_assert (G_IS_TASK (result));
+
+  self->indexing = FALSE;
+
+  if (!(batch = g_task_propagate_pointer (G_TASK (result), &error)))
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        return;
+      g_debug ("%s", error->message);
+    }
+  else
+    {
+      g_ptr_array_add (self->pending, batch);
+    }
+
+  ide_clang_xref_index_process (self);
+}
+
+static void
+ide_clang_xref_index_get_build_flags_cb (GObject      *object,
+                                         GAsyncResult *result,
+                                         gpointer      user_data)
+{
+  IdeBuildSystem *build_system = (IdeBuildSystem *)object;
+  g_autoptr(GTask) task = user_data;
+  g_autoptr(GError) error = NULL;
+  IndexRequest *request;
+
+  g_assert (IDE_IS_BUILD_SYSTEM (build_system));
+  g_assert (G_IS_TASK (task));
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  request = g_task_get_task_data (task);
+
+  if (!(request->argv = ide_build_system_get_build_flags_finish (build_system, result, &error)))
+    request->argv = g_new0 (gchar *, 1);
+
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, task, ide_clang_xref_index_index_worker);
+}
+
+/*
+ * Indexes the next queued file, or writes the database once the queue
+ * has drained. Only one unit is indexed at a time so that we do not
+ * starve other users of the indexer thread pool.
+ */
+static void
+ide_clang_xref_index_process (IdeClangXrefIndex *self)
+{
+  g_autoptr(GFile) file = NULL;
+  g_autoptr(IdeFile) ifile = NULL;
+  g_autoptr(GTask) task = NULL;
+  IdeBuildSystem *build_system;
+  IndexRequest *request;
+  IdeContext *context;
+
+  g_assert (IDE_IS_CLANG_XREF_INDEX (self));
+
+  if (!self->loaded || self->indexing || g_cancellable_is_cancelled (self->cancellable))
+    return;
+
+  if (!self->writing && self->pending->len > 0 &&
+      (self->queue.length == 0 || self->pending->len >= MAX_PENDING_BATCHES))
+    ide_clang_xref_index_write (self);
+
+  if (!(file = g_queue_pop_head (&self->queue)))
+    return;
+
+  g_hash_table_remove (self->queued, file);
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+  build_system = ide_context_get_build_system (context);
+  ifile = ide_file_new (context, file);
+
+  request = g_slice_new0 (IndexRequest);
+  request->index = self->index;
+  request->path = g_file_get_path (file);
+  request->workdir_prefix = g_strdup (self->workdir_prefix);
+
+  self->indexing = TRUE;
+
+  task = g_task_new (self, self->cancellable, ide_clang_xref_index_index_cb, NULL);
+  g_task_set_source_tag (task, ide_clang_xref_index_process);
+  g_task_set_task_data (task, request, index_request_free);
+  g_task_set_priority (task, G_PRIORITY_LOW);
+
+  ide_build_system_get_build_flags_async (build_system,
+                                          ifile,
+                                          self->cancellable,
+                                          ide_clang_xref_index_get_build_flags_cb,
+                                          g_steal_pointer (&task));
+}
+
+static void
+ide_clang_xref_index_crawl_directory (CrawlRequest *request,
+                                      GFile        *directory,
+                                      GHashTable   *mtimes,
+                                      GPtrArray    *stale,
+                                      GCancellable *cancellable)
+{
+  g_autoptr(GFileEnumerator) enumerator = NULL;
+  gpointer infoptr;
+
+  enumerator = g_file_enumerate_children (directory,
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME","
+                                          G_FILE_ATTRIBUTE_STANDARD_TYPE","
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          cancellable,
+                                          NULL);
+
+  if (enumerator == NULL)
+    return;
+
+  while ((infoptr = g_file_enumerator_next_file (enumerator, cancellable, NULL)))
+    {
+      g_autoptr(GFileInfo) info = infoptr;
+      g_autoptr(GFile) child = NULL;
+      const gchar *name = g_file_info_get_name (info);
+      GFileType file_type = g_file_info_get_file_type (info);
+
+      if (name [0] == '.')
+        continue;
+
+      child = g_file_get_child (directory, name);
+
+      if (ide_vcs_is_ignored (request->vcs, child, NULL))
+        continue;
+
+      if (file_type == G_FILE_TYPE_DIRECTORY)
+        {
+          ide_clang_xref_index_crawl_directory (request, child, mtimes, stale, cancellable);
+        }
+      else if (file_type == G_FILE_TYPE_REGULAR && is_source_file (name))
+        {
+          g_autofree gchar *path = g_file_get_path (child);
+          guint64 mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+          gpointer indexed;
+
+          if (!g_hash_table_lookup_extended (mtimes, path, NULL, &indexed) ||
+              *(gint64 *)indexed != (gint64)mtime)
+            g_ptr_array_add (stale, g_steal_pointer (&path));
+        }
+    }
+}
+
+/*
+ * Finds the files that need to be indexed: sources that are not in the
+ * database and any file (including headers) whose modification time no
+ * longer matches. Files that have been removed are also returned so the
+ * caller can drop them.
+ */
+static void
+ide_clang_xref_index_crawl_worker (GTask        *task,
+                                   gpointer      source_object,
+                                   gpointer      task_data,
+                                   GCancellable *cancellable)
+{
+  CrawlRequest *request = task_data;
+  g_autoptr(GHashTable) mtimes = NULL;
+  g_autoptr(GPtrArray) stale = NULL;
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (request != NULL);
+
+  mtimes = ide_clang_xref_segments_get_mtimes (request->segments);
+  stale = g_ptr_array_new_with_free_func (g_free);
+
+  ide_clang_xref_index_crawl_directory (request, request->workdir, mtimes, stale, cancellable);
+
+  g_hash_table_iter_init (&iter, mtimes);
+
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      const gchar *path = key;
+      GStatBuf st;
+
+      /*
+       * Sources that were removed are not found by the crawl, and headers
+       * are not crawled at all, so check them against what we know.
+       */
+      if (is_source_file (path))
+        {
+          if (!g_file_test (path, G_FILE_TEST_EXISTS))
+            g_ptr_array_add (stale, g_strdup (path));
+        }
+      else if (g_stat (path, &st) != 0 || st.st_mtime != *(gint64 *)value)
+        {
+          g_ptr_array_add (stale, g_strdup (path));
+        }
+    }
+
+  g_task_return_pointer (task, g_steal_pointer (&stale), (GDestroyNotify)g_ptr_array_unref);
+}
+
+static void
+ide_clang_xref_index_crawl_cb (GObject      *object,
+                               GAsyncResult *result,
+                               gpointer      user_data)
+{
+  IdeClangXrefIndex *self = (IdeClangXrefIndex *)object;
+  g_autoptr(GPtrArray) stale = NULL;
+  g_autoptr(GError) error = NULL;
+  IdeClangXrefBatch *removed = NULL;
+  guint i;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_CLANG_XREF_INDEX (self));
+  g_assert (G_IS_TASK (result));
+
+  if (!(stale = g_task_propagate_pointer (G_TASK (result), &error)))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("%s", error->message);
+      IDE_EXIT;
+    }
+
+  IDE_TRACE_MSG ("%u files need to be indexed", stale->len);
+
+  self->loaded = TRUE;
+
+  for (i = 0; i < stale->len; i++)
+    {
+      const gchar *path = g_ptr_array_index (stale, i);
+
+      if (g_file_test (path, G_FILE_TEST_IS_REGULAR))
+        {
+          g_autoptr(GFile) file = g_file_new_for_path (path);
+
+          ide_clang_xref_index_update_file (self, file);
+        }
+      else
+        {
+          if (removed == NULL)
+            removed = ide_clang_xref_batch_new ();
+          ide_clang_xref_batch_add_file (removed, path, FALSE);
+        }
+    }
+
+  if (removed != NULL)
+    g_ptr_array_add (self->pending, removed);
+
+  ide_clang_xref_index_process (self);
+
+  IDE_EXIT;
+}
+
+static gchar *
+ide_clang_xref_index_get_store_path (GFile *workdir)
+{
+  g_autofree gchar *path = g_file_get_path (workdir);
+  g_autofree gchar *checksum = NULL;
+  g_autofree gchar *legacy_name = NULL;
+  g_autofree gchar *legacy_path = NULL;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, path, -1);
+
+  /* Previous releases kept a single database file beside the directory. */
+  legacy_name = g_strdup_printf ("%s.gvariant", checksum);
+  legacy_path = g_build_filename (g_get_user_cache_dir (),
+                                  ide_get_program_name (),
+                                  "clang",
+                                  "xref",
+                                  legacy_name,
+                                  NULL);
+  g_unlink (legacy_path);
+
+  return g_build_filename (g_get_user_cache_dir (),
+                           ide_get_program_name (),
+                           "clang",
+                           "xref",
+                           checksum,
+                           NULL);
+}
+
+/**
+ * ide_clang_xref_index_load:
+ * @self: An #IdeClangXrefIndex
+ *
+ * Maps the segments from a previous session and starts indexing the
+ * translation units that changed since they were last indexed.
+ */
+void
+ide_clang_xref_index_load (IdeClangXrefIndex *self)
+{
+  g_autoptr(GTask) task = NULL;
+  CrawlRequest *request;
+  IdeContext *context;
+  IdeVcs *vcs;
+  GFile *workdir;
+  g_autofree gchar *workpath = NULL;
+  g_autofree gchar *store_path = NULL;
+
+  IDE_ENTRY;
+
+  g_return_if_fail (IDE_IS_CLANG_XREF_INDEX (self));
+  g_return_if_fail (self->store == NULL);
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+  vcs = ide_context_get_vcs (context);
+  workdir = ide_vcs_get_working_directory (vcs);
+  workpath = g_file_get_path (workdir);
+
+  if (workpath == NULL)
+    IDE_EXIT;
+
+  self->workdir_prefix = g_build_filename (workpath, G_DIR_SEPARATOR_S, NULL);
+  store_path = ide_clang_xref_index_get_store_path (workdir);
+  self->store = ide_clang_xref_store_load (store_path);
+
+  request = g_slice_new0 (CrawlRequest);
+  request->segments = ide_clang_xref_store_get_segments (self->store);
+  request->workdir = g_object_ref (workdir);
+  request->vcs = g_object_ref (vcs);
+
+  task = g_task_new (self, self->cancellable, ide_clang_xref_index_crawl_cb, NULL);
+  g_task_set_source_tag (task, ide_clang_xref_index_load);
+  g_task_set_task_data (task, request, crawl_request_free);
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, task, ide_clang_xref_index_crawl_worker);
+
+  IDE_EXIT;
+}
+
+/**
+ * ide_clang_xref_index_update_file:
+ * @self: An #IdeClangXrefIndex
+ * @file: A #GFile
+ *
+ * Queues @file to be indexed again, such as after it has been saved.
+ */
+void
+ide_clang_xref_index_update_file (IdeClangXrefIndex *self,
+                                  GFile             *file)
+{
+  g_return_if_fail (IDE_IS_CLANG_XREF_INDEX (self));
+  g_return_if_fail (G_IS_FILE (file));
+
+  if (!g_hash_table_contains (self->queued, file))
+    {
+      g_hash_table_add (self->queued, g_object_ref (file));
+      g_queue_push_tail (&self->queue, g_object_ref (file));
+    }
+
+  ide_clang_xref_index_process (self);
+}
+
+/**
+ * ide_clang_xref_index_shutdown:
+ * @self: An #IdeClangXrefIndex
+ *
+ * Cancels any crawl, indexing or write that is in flight and drops the
+ * files waiting to be indexed. Operations still holding a reference to
+ * @self will not start further work, so this must be called before the
+ * context is torn down.
+ */
+void
+ide_clang_xref_index_shutdown (IdeClangXrefIndex *self)
+{
+  g_return_if_fail (IDE_IS_CLANG_XREF_INDEX (self));
+
+  g_cancellable_cancel (self->cancellable);
+
+  g_queue_foreach (&self->queue, (GFunc)g_object_unref, NULL);
+  g_queue_clear (&self->queue);
+  g_hash_table_remove_all (self->queued);
+  g_ptr_array_set_size (self->pending, 0);
+}
+
+static IdeFile *
+get_file (IdeClangXrefIndex *self,
+          GHashTable        *files,
+          const gchar       *path)
+{
+  IdeFile *file;
+
+  if (!(file = g_hash_table_lookup (files, path)))
+    {
+      g_autoptr(GFile) gfile = g_file_new_for_path (path);
+
+      file = ide_file_new (ide_object_get_context (IDE_OBJECT (self)), gfile);
+      g_hash_table_insert (files, (gchar *)path, file);
+    }
+
+  return file;
+}
+
+/**
+ * ide_clang_xref_index_find_references:
+ * @self: An #IdeClangXrefIndex
+ * @usr: The clang USR of the symbol
+ *
+ * Finds the declarations, definitions and references of the symbol
+ * identified by @usr throughout the project.
+ *
+ * Returns: (transfer container) (element-type Ide.SourceRange): An array
+ *   of #IdeSourceRange, sorted by file and position.
+ */
+GPtrArray *
+ide_clang_xref_index_find_references (IdeClangXrefIndex *self,
+                                      const gchar       *usr)
+{
+  g_autoptr(GHashTable) files = NULL;
+  g_autoptr(GArray) hits = NULL;
+  GPtrArray *ret;
+  guint i;
+
+  IDE_ENTRY;
+
+  g_return_val_if_fail (IDE_IS_CLANG_XREF_INDEX (self), NULL);
+
+  ret = g_ptr_array_new_with_free_func ((GDestroyNotify)ide_source_range_unref);
+
+  if (self->store == NULL)
+    IDE_RETURN (ret);
+
+  files = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+  hits = ide_clang_xref_store_lookup (self->store, usr);
+
+  for (i = 0; i < hits->len; i++)
+    {
+      const IdeClangXrefHit *hit = &g_array_index (hits, IdeClangXrefHit, i);
+      g_autoptr(IdeSourceLocation) begin = NULL;
+      g_autoptr(IdeSourceLocation) end = NULL;
+      IdeFile *file = get_file (self, files, hit->path);
+
+      begin = ide_source_location_new (file, hit->line - 1, hit->column - 1, 0);
+      end = ide_source_location_new (file, hit->line - 1, hit->column - 1 + hit->length, 0);
+
+      g_ptr_array_add (ret, ide_source_range_new (begin, end));
+    }
+
+  IDE_TRACE_MSG ("%u references to %s", ret->len, usr);
+
+  IDE_RETURN (ret);
+}
+
+/**
+ * ide_clang_xref_index_find_definition:
+ * @self: An #IdeClangXrefIndex
+ * @usr: The clang USR of the symbol
+ *
+ * Finds where the symbol identified by @usr is defined, even if the
+ * definition is in a translation unit other than the one being edited.
+ *
+ * Returns: (transfer full) (nullable): An #IdeSourceLocation or %NULL.
+ */
+IdeSourceLocation *
+ide_clang_xref_index_find_definition (IdeClangXrefIndex *self,
+                                      const gchar       *usr)
+{
+  g_autoptr(GArray) hits = NULL;
+  guint i;
+
+  g_return_val_if_fail (IDE_IS_CLANG_XREF_INDEX (self), NULL);
+
+  if (self->store == NULL)
+    return NULL;
+
+  hits = ide_clang_xref_store_lookup (self->store, usr);
+
+  for (i = 0; i < hits->len; i++)
+    {
+      const IdeClangXrefHit *hit = &g_array_index (hits, IdeClangXrefHit, i);
+
+      if (hit->kind == IDE_CLANG_XREF_DEFINITION)
+        {
+          g_autoptr(GFile) gfile = g_file_new_for_path (hit->path);
+          g_autoptr(IdeFile) file = ide_file_new (ide_object_get_context (IDE_OBJECT (self)), gfile);
+
+          return ide_source_location_new (file, hit->line - 1, hit->column - 1, 0);
+        }
+    }
+
+  return NULL;
+}
+
+static void
+ide_clang_xref_index_dispose (GObject *object)
+{
+  IdeClangXrefIndex *self = (IdeClangXrefIndex *)object;
+
+  ide_clang_xref_index_shutdown (self);
+
+  G_OBJECT_CLASS (ide_clang_xref_index_parent_class)->dispose (object);
+}
+
+static void
+ide_clang_xref_index_finalize (GObject *object)
+{
+  IdeClangXrefIndex *self = (IdeClangXrefIndex *)object;
+
+  g_queue_foreach (&self->queue, (GFunc)g_object_unref, NULL);
+  g_queue_clear (&self->queue);
+
+  g_clear_pointer (&self->queued, g_hash_table_unref);
+  g_clear_pointer (&self->pending, g_ptr_array_unref);
+  g_clear_pointer (&self->store, ide_clang_xref_store_free);
+  g_clear_pointer (&self->workdir_prefix, g_free);
+  g_clear_pointer (&self->index, clang_disposeIndex);
+  g_clear_object (&self->cancellable);
+
+  G_OBJECT_CLASS (ide_clang_xref_index_parent_class)->finalize (object);
+}
+
+static void
+ide_clang_xref_index_class_init (IdeClangXrefIndexClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = ide_clang_xref_index_dispose;
+  object_class->finalize = ide_clang_xref_index_finalize;
+}
+
+static void
+ide_clang_xref_index_init (IdeClangXrefIndex *self)
+{
+  self->cancellable = g_cancellable_new ();
+  self->queued = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal, g_object_unref, NULL);
+  self->pending = g_ptr_array_new_with_free_func (ide_clang_xref_batch_free);
+  self->index = clang_createIndex (0, 0);
+  clang_CXIndex_setGlobalOptions (self->index, CXGlobalOpt_ThreadBackgroundPriorityForIndexing);
+}
@@ -0,0 +1,42 @@
+/* ide-clang-xref-index.h
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_CLANG_XREF_INDEX_H
+#define IDE_CLANG_XREF_INDEX_H
+
+#include "ide-object.h"
+#include "ide-source-location.h"
+
+G_BEGIN_DECLS
+
+#define IDE_TYPE_CLANG_XREF_INDEX (ide_clang_xref_index_get_type())
+
+G_DECLARE_FINAL_TYPE (IdeClangXrefIndex, ide_clang_xref_index, IDE, CLANG_XREF_INDEX, IdeObject)
+
+void               ide_clang_xref_index_load            (IdeClangXrefIndex *self);
+void               ide_clang_xref_index_shutdown        (IdeClangXrefIndex *self);
+void               ide_clang_xref_index_update_file     (IdeClangXrefIndex *self,
+                                                         GFile             *file);
+GPtrArray         *ide_clang_xref_index_find_references (IdeClangXrefIndex *self,
+                                                         const gchar       *usr);
+IdeSourceLocation *ide_clang_xref_index_find_definition (IdeClangXrefIndex *self,
+                                                         const gchar       *usr);
+
+G_END_DECLS
+
+#endif /* IDE_CLANG_XREF_INDEX_H */
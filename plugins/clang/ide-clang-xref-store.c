@@ -0,0 +1,929 @@
+/* ide-clang-xref-store.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-clang-xref-store"
+
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ide-clang-xref-store.h"
+
+/*
+ * The store keeps the cross-reference database as a series of segments
+ * within a directory. Each segment is a mapped GVariant holding the files
+ * it knows about and their symbols sorted by USR, so a lookup is a binary
+ * search per segment.
+ *
+ * Writing only encodes the batches that were indexed since the previous
+ * write, so saving a file costs as much as the files its unit touched
+ * rather than the whole project. A newer segment replaces everything the
+ * older segments recorded for the files it contains; removed files are
+ * kept in segments with REMOVED_MTIME so that they hide older records.
+ *
+ * Once MAX_SEGMENTS have accumulated, the next write merges all of them
+ * into a single base segment and deletes the files it replaces. Segment
+ * files are named after an increasing sequence number, and loading skips
+ * anything older than the newest base in case a compaction was
+ * interrupted before it removed the files it replaced.
+ */
+
+/*
+ * Bump this if the layout of the database changes so that a database
+ * written by a previous release is discarded.
+ */
+#define XREF_INDEX_VERSION  1
+#define XREF_DATABASE_TYPE  "(ua(sx)a(sa(uuuqyy)))"
+#define XREF_REFERENCE_TYPE "(uuuqyy)"
+#define XREF_SEGMENT_SUFFIX ".gvariant"
+#define XREF_BASE_SUFFIX    ".base.gvariant"
+#define XREF_SEQ_DIGITS     8
+#define MAX_SEGMENTS        32
+#define REMOVED_MTIME       (-1)
+
+/*
+ * This matches the layout of XREF_REFERENCE_TYPE so that the references
+ * can be accessed with g_variant_get_fixed_array().
+ */
+typedef struct
+{
+  guint32 file;
+  guint32 line;
+  guint32 column;
+  guint16 length;
+  guint8  kind;
+  guint8  padding;
+} XrefReference;
+
+G_STATIC_ASSERT (sizeof (XrefReference) == 16);
+
+typedef struct
+{
+  GVariant   *db;
+  gchar      *path;
+  /* Paths this segment replaces in older segments, NULL for a base. */
+  GHashTable *files;
+} XrefSegment;
+
+struct _IdeClangXrefStore
+{
+  gchar     *directory;
+  /* XrefSegment, oldest first. Only the first one may be a base. */
+  GPtrArray *segments;
+  guint32    next_seq;
+};
+
+struct _IdeClangXrefWrite
+{
+  gchar     *path;
+  /* GVariant of every segment merged into a new base, oldest first. */
+  GPtrArray *inputs;
+  /* Paths of the segment files the new base replaces. */
+  GPtrArray *obsolete;
+  GPtrArray *batches;
+  GVariant  *result;
+  guint      compact : 1;
+};
+
+static void
+xref_file_free (gpointer data)
+{
+  IdeClangXrefFile *file = data;
+
+  g_clear_pointer (&file->records, g_array_unref);
+  g_slice_free (IdeClangXrefFile, file);
+}
+
+IdeClangXrefBatch *
+ide_clang_xref_batch_new (void)
+{
+  IdeClangXrefBatch *batch;
+
+  batch = g_slice_new0 (IdeClangXrefBatch);
+  batch->strings = g_string_chunk_new (4096);
+  batch->files = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, xref_file_free);
+
+  return batch;
+}
+
+void
+ide_clang_xref_batch_free (gpointer data)
+{
+  IdeClangXrefBatch *batch = data;
+
+  if (batch != NULL)
+    {
+      g_clear_pointer (&batch->files, g_hash_table_unref);
+      g_clear_pointer (&batch->strings, g_string_chunk_free);
+      g_slice_free (IdeClangXrefBatch, batch);
+    }
+}
+
+/**
+ * ide_clang_xref_batch_add_file:
+ * @batch: An #IdeClangXrefBatch
+ * @path: The absolute path of the file
+ * @exists: %FALSE if the file was removed
+ *
+ * Adds @path to @batch. Unless the file was removed, records may be
+ * appended to the records array of the result.
+ */
+IdeClangXrefFile *
+ide_clang_xref_batch_add_file (IdeClangXrefBatch *batch,
+                               const gchar       *path,
+                               gboolean           exists)
+{
+  IdeClangXrefFile *file;
+  GStatBuf st;
+
+  g_return_val_if_fail (batch != NULL, NULL);
+  g_return_val_if_fail (path != NULL, NULL);
+
+  file = g_slice_new0 (IdeClangXrefFile);
+  file->path = g_string_chunk_insert_const (batch->strings, path);
+
+  if (exists && g_stat (path, &st) == 0)
+    {
+      file->mtime = st.st_mtime;
+      file->records = g_array_new (FALSE, FALSE, sizeof (IdeClangXrefRecord));
+    }
+
+  g_hash_table_replace (batch->files, (gchar *)file->path, file);
+
+  return file;
+}
+
+static GVariant *
+xref_map (const gchar *path)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GVariant) db = NULL;
+  guint32 version = 0;
+
+  g_assert (path != NULL);
+
+  if (!(mapped = g_mapped_file_new (path, FALSE, NULL)))
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  db = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (XREF_DATABASE_TYPE), bytes, FALSE));
+
+  g_variant_get_child (db, 0, "u", &version);
+
+  if (version != XREF_INDEX_VERSION)
+    return NULL;
+
+  return g_steal_pointer (&db);
+}
+
+static XrefSegment *
+xref_segment_new (GVariant    *db,
+                  const gchar *path,
+                  gboolean     is_base)
+{
+  XrefSegment *segment;
+
+  g_assert (db != NULL);
+  g_assert (path != NULL);
+
+  segment = g_slice_new0 (XrefSegment);
+  segment->db = g_variant_ref (db);
+  segment->path = g_strdup (path);
+
+  if (!is_base)
+    {
+      g_autoptr(GVariant) files = g_variant_get_child_value (db, 1);
+      gsize n_files = g_variant_n_children (files);
+      gsize i;
+
+      segment->files = g_hash_table_new (g_str_hash, g_str_equal);
+
+      for (i = 0; i < n_files; i++)
+        {
+          const gchar *file_path;
+
+          g_variant_get_child (files, i, "(&sx)", &file_path, NULL);
+          g_hash_table_add (segment->files, (gchar *)file_path);
+        }
+    }
+
+  return segment;
+}
+
+static void
+xref_segment_free (gpointer data)
+{
+  XrefSegment *segment = data;
+
+  g_clear_pointer (&segment->files, g_hash_table_unref);
+  g_clear_pointer (&segment->db, g_variant_unref);
+  g_free (segment->path);
+  g_slice_free (XrefSegment, segment);
+}
+
+static gboolean
+parse_segment_name (const gchar *name,
+                    guint32     *seq,
+                    gboolean    *is_base)
+{
+  gchar *end = NULL;
+  guint64 value;
+
+  value = g_ascii_strtoull (name, &end, 16);
+
+  if (end - name != XREF_SEQ_DIGITS || value > G_MAXUINT32)
+    return FALSE;
+
+  if (g_str_equal (end, XREF_BASE_SUFFIX))
+    *is_base = TRUE;
+  else if (g_str_equal (end, XREF_SEGMENT_SUFFIX))
+    *is_base = FALSE;
+  else
+    return FALSE;
+
+  *seq = value;
+
+  return TRUE;
+}
+
+static gint
+compare_strings (gconstpointer a,
+                 gconstpointer b)
+{
+  return strcmp (*(const gchar * const *)a, *(const gchar * const *)b);
+}
+
+/**
+ * ide_clang_xref_store_load:
+ * @directory: The directory containing the segments
+ *
+ * Maps the segments written to @directory by a previous session. The
+ * directory does not need to exist.
+ *
+ * Returns: (transfer full): An #IdeClangXrefStore.
+ */
+IdeClangXrefStore *
+ide_clang_xref_store_load (const gchar *directory)
+{
+  IdeClangXrefStore *self;
+  g_autoptr(GPtrArray) names = NULL;
+  const gchar *name;
+  GDir *dir;
+  guint first = 0;
+  guint i;
+
+  g_return_val_if_fail (directory != NULL, NULL);
+
+  self = g_slice_new0 (IdeClangXrefStore);
+  self->directory = g_strdup (directory);
+  self->segments = g_ptr_array_new_with_free_func (xref_segment_free);
+
+  if (!(dir = g_dir_open (directory, 0, NULL)))
+    return self;
+
+  names = g_ptr_array_new_with_free_func (g_free);
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      guint32 seq;
+      gboolean is_base;
+
+      if (parse_segment_name (name, &seq, &is_base))
+        {
+          g_ptr_array_add (names, g_strdup (name));
+          self->next_seq = MAX (self->next_seq, seq + 1);
+        }
+    }
+
+  g_dir_close (dir);
+
+  /* Sequence numbers have a fixed width, so this sorts them by age. */
+  g_ptr_array_sort (names, compare_strings);
+
+  for (i = 0; i < names->len; i++)
+    {
+      if (g_str_has_suffix (g_ptr_array_index (names, i), XREF_BASE_SUFFIX))
+        first = i;
+    }
+
+  for (i = 0; i < names->len; i++)
+    {
+      const gchar *segment_name = g_ptr_array_index (names, i);
+      g_autofree gchar *path = g_build_filename (directory, segment_name, NULL);
+      g_autoptr(GVariant) db = NULL;
+
+      if (i < first)
+        {
+          g_unlink (path);
+          continue;
+        }
+
+      /*
+       * Every segment may hide records of older ones, so a missing one
+       * would leave stale records behind. Start over instead, the crawl
+       * will then index the whole project again.
+       */
+      if (!(db = xref_map (path)))
+        {
+          g_debug ("Discarding cross-reference index, %s is invalid", path);
+
+          g_ptr_array_set_size (self->segments, 0);
+
+          for (i = first; i < names->len; i++)
+            {
+              g_autofree gchar *stale_path = g_build_filename (directory, g_ptr_array_index (names, i), NULL);
+
+              g_unlink (stale_path);
+            }
+
+          break;
+        }
+
+      g_ptr_array_add (self->segments,
+                       xref_segment_new (db, path, g_str_has_suffix (segment_name, XREF_BASE_SUFFIX)));
+    }
+
+  return self;
+}
+
+void
+ide_clang_xref_store_free (IdeClangXrefStore *self)
+{
+  if (self != NULL)
+    {
+      g_clear_pointer (&self->segments, g_ptr_array_unref);
+      g_free (self->directory);
+      g_slice_free (IdeClangXrefStore, self);
+    }
+}
+
+/**
+ * ide_clang_xref_store_get_segments:
+ * @self: An #IdeClangXrefStore
+ *
+ * Gets the databases of the segments, oldest first, so that a worker
+ * thread can inspect them with ide_clang_xref_segments_get_mtimes().
+ *
+ * Returns: (transfer container) (element-type GVariant): An array of
+ *   #GVariant.
+ */
+GPtrArray *
+ide_clang_xref_store_get_segments (IdeClangXrefStore *self)
+{
+  GPtrArray *ret;
+  guint i;
+
+  g_return_val_if_fail (self != NULL, NULL);
+
+  ret = g_ptr_array_new_with_free_func ((GDestroyNotify)g_variant_unref);
+
+  for (i = 0; i < self->segments->len; i++)
+    {
+      XrefSegment *segment = g_ptr_array_index (self->segments, i);
+
+      g_ptr_array_add (ret, g_variant_ref (segment->db));
+    }
+
+  return ret;
+}
+
+/**
+ * ide_clang_xref_segments_get_mtimes:
+ * @segments: (element-type GVariant): The result of
+ *   ide_clang_xref_store_get_segments()
+ *
+ * Collects the modification time each file had when it was indexed. Removed
+ * files are left out.
+ *
+ * Returns: (transfer full): A #GHashTable of paths to a pointer to the
+ *   #gint64 modification time. Both point into @segments.
+ */
+GHashTable *
+ide_clang_xref_segments_get_mtimes (GPtrArray *segments)
+{
+  GHashTable *ret;
+  guint i;
+
+  g_return_val_if_fail (segments != NULL, NULL);
+
+  ret = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i < segments->len; i++)
+    {
+      g_autoptr(GVariant) files = g_variant_get_child_value (g_ptr_array_index (segments, i), 1);
+      gsize n_files = g_variant_n_children (files);
+      gsize j;
+
+      for (j = 0; j < n_files; j++)
+        {
+          g_autoptr(GVariant) child = g_variant_get_child_value (files, j);
+          g_autoptr(GVariant) mtime = g_variant_get_child_value (child, 1);
+          const gchar *path;
+
+          g_variant_get_child (child, 0, "&s", &path);
+
+          if (g_variant_get_int64 (mtime) == REMOVED_MTIME)
+            g_hash_table_remove (ret, path);
+          else
+            g_hash_table_insert (ret, (gchar *)path, (gpointer)g_variant_get_data (mtime));
+        }
+    }
+
+  return ret;
+}
+
+static GVariant *
+xref_segment_lookup (XrefSegment *segment,
+                     const gchar *usr)
+{
+  g_autoptr(GVariant) symbols = NULL;
+  gsize lo = 0;
+  gsize hi;
+
+  symbols = g_variant_get_child_value (segment->db, 2);
+  hi = g_variant_n_children (symbols);
+
+  while (lo < hi)
+    {
+      gsize mid = lo + (hi - lo) / 2;
+      g_autoptr(GVariant) symbol = g_variant_get_child_value (symbols, mid);
+      const gchar *key;
+      gint cmp;
+
+      g_variant_get_child (symbol, 0, "&s", &key);
+
+      if ((cmp = strcmp (key, usr)) == 0)
+        return g_variant_get_child_value (symbol, 1);
+      else if (cmp < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return NULL;
+}
+
+static gboolean
+is_replaced (IdeClangXrefStore *self,
+             guint              segment_index,
+             const gchar       *path)
+{
+  guint i;
+
+  for (i = segment_index + 1; i < self->segments->len; i++)
+    {
+      XrefSegment *segment = g_ptr_array_index (self->segments, i);
+
+      if (g_hash_table_contains (segment->files, path))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gint
+compare_hits (gconstpointer a,
+              gconstpointer b)
+{
+  const IdeClangXrefHit *hita = a;
+  const IdeClangXrefHit *hitb = b;
+  gint cmp;
+
+  if ((cmp = strcmp (hita->path, hitb->path)) != 0)
+    return cmp;
+  else if (hita->line != hitb->line)
+    return hita->line < hitb->line ? -1 : 1;
+  else if (hita->column != hitb->column)
+    return hita->column < hitb->column ? -1 : 1;
+
+  return 0;
+}
+
+/**
+ * ide_clang_xref_store_lookup:
+ * @self: An #IdeClangXrefStore
+ * @usr: The clang USR of a symbol
+ *
+ * Finds the current records of the symbol identified by @usr.
+ *
+ * Returns: (transfer full) (element-type IdeClangXrefHit): An array of
+ *   #IdeClangXrefHit sorted by path and position.
+ */
+GArray *
+ide_clang_xref_store_lookup (IdeClangXrefStore *self,
+                             const gchar       *usr)
+{
+  GArray *ret;
+  guint i;
+
+  g_return_val_if_fail (self != NULL, NULL);
+
+  ret = g_array_new (FALSE, FALSE, sizeof (IdeClangXrefHit));
+
+  if (usr == NULL)
+    return ret;
+
+  for (i = 0; i < self->segments->len; i++)
+    {
+      XrefSegment *segment = g_ptr_array_index (self->segments, i);
+      g_autoptr(GVariant) refs = NULL;
+      g_autoptr(GVariant) files = NULL;
+      const XrefReference *ar;
+      gsize n_refs = 0;
+      gsize n_files;
+      gsize j;
+
+      if (!(refs = xref_segment_lookup (segment, usr)))
+        continue;
+
+      files = g_variant_get_child_value (segment->db, 1);
+      n_files = g_variant_n_children (files);
+      ar = g_variant_get_fixed_array (refs, &n_refs, sizeof (XrefReference));
+
+      for (j = 0; j < n_refs; j++)
+        {
+          IdeClangXrefHit hit;
+
+          if (ar [j].file >= n_files)
+            continue;
+
+          g_variant_get_child (files, ar [j].file, "(&sx)", &hit.path, NULL);
+
+          if (is_replaced (self, i, hit.path))
+            continue;
+
+          hit.line = ar [j].line;
+          hit.column = ar [j].column;
+          hit.length = ar [j].length;
+          hit.kind = ar [j].kind;
+
+          g_array_append_val (ret, hit);
+        }
+    }
+
+  g_array_sort (ret, compare_hits);
+
+  return ret;
+}
+
+/**
+ * ide_clang_xref_store_begin_write:
+ * @self: An #IdeClangXrefStore
+ * @batches: (transfer full) (element-type IdeClangXrefBatch): The batches
+ *   to write, oldest first
+ *
+ * Prepares to write @batches. Run the result with ide_clang_xref_write_run(),
+ * which may be done from a thread, and then pass it to
+ * ide_clang_xref_store_finish_write(). Only one write may be in flight.
+ *
+ * Returns: (transfer full): An #IdeClangXrefWrite.
+ */
+IdeClangXrefWrite *
+ide_clang_xref_store_begin_write (IdeClangXrefStore *self,
+                                  GPtrArray         *batches)
+{
+  IdeClangXrefWrite *write;
+  g_autofree gchar *name = NULL;
+  guint i;
+
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (batches != NULL, NULL);
+
+  write = g_slice_new0 (IdeClangXrefWrite);
+  write->batches = batches;
+  write->inputs = g_ptr_array_new_with_free_func ((GDestroyNotify)g_variant_unref);
+  write->obsolete = g_ptr_array_new_with_free_func (g_free);
+  write->compact = self->segments->len >= MAX_SEGMENTS;
+
+  if (write->compact)
+    {
+      for (i = 0; i < self->segments->len; i++)
+        {
+          XrefSegment *segment = g_ptr_array_index (self->segments, i);
+
+          g_ptr_array_add (write->inputs, g_variant_ref (segment->db));
+          g_ptr_array_add (write->obsolete, g_strdup (segment->path));
+        }
+    }
+
+  name = g_strdup_printf ("%0*x%s",
+                          XREF_SEQ_DIGITS,
+                          self->next_seq++,
+                          write->compact ? XREF_BASE_SUFFIX : XREF_SEGMENT_SUFFIX);
+  write->path = g_build_filename (self->directory, name, NULL);
+
+  return write;
+}
+
+/**
+ * ide_clang_xref_store_finish_write:
+ * @self: An #IdeClangXrefStore
+ * @write: An #IdeClangXrefWrite that completed successfully
+ *
+ * Makes the segment written by @write visible to lookups.
+ */
+void
+ide_clang_xref_store_finish_write (IdeClangXrefStore *self,
+                                   IdeClangXrefWrite *write)
+{
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (write != NULL);
+  g_return_if_fail (write->result != NULL);
+
+  if (write->compact)
+    {
+      g_assert (self->segments->len >= write->inputs->len);
+
+      g_ptr_array_remove_range (self->segments, 0, write->inputs->len);
+      g_ptr_array_insert (self->segments, 0, xref_segment_new (write->result, write->path, TRUE));
+    }
+  else
+    {
+      g_ptr_array_add (self->segments, xref_segment_new (write->result, write->path, FALSE));
+    }
+}
+
+void
+ide_clang_xref_write_free (gpointer data)
+{
+  IdeClangXrefWrite *write = data;
+
+  if (write != NULL)
+    {
+      g_clear_pointer (&write->inputs, g_ptr_array_unref);
+      g_clear_pointer (&write->obsolete, g_ptr_array_unref);
+      g_clear_pointer (&write->batches, g_ptr_array_unref);
+      g_clear_pointer (&write->result, g_variant_unref);
+      g_free (write->path);
+      g_slice_free (IdeClangXrefWrite, write);
+    }
+}
+
+static gint
+compare_references (gconstpointer a,
+                    gconstpointer b)
+{
+  const XrefReference *refa = a;
+  const XrefReference *refb = b;
+
+  if (refa->file != refb->file)
+    return refa->file < refb->file ? -1 : 1;
+  else if (refa->line != refb->line)
+    return refa->line < refb->line ? -1 : 1;
+  else if (refa->column != refb->column)
+    return refa->column < refb->column ? -1 : 1;
+
+  return 0;
+}
+
+static GArray *
+get_references (GHashTable  *symbols,
+                const gchar *usr)
+{
+  GArray *refs;
+
+  if (!(refs = g_hash_table_lookup (symbols, usr)))
+    {
+      refs = g_array_new (FALSE, FALSE, sizeof (XrefReference));
+      g_hash_table_insert (symbols, (gchar *)usr, refs);
+    }
+
+  return refs;
+}
+
+/**
+ * ide_clang_xref_write_run:
+ * @write: An #IdeClangXrefWrite
+ * @error: A location for a #GError, or %NULL
+ *
+ * Encodes the batches of @write, along with the segments being compacted,
+ * and writes the result to a new segment file.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ */
+gboolean
+ide_clang_xref_write_run (IdeClangXrefWrite  *write,
+                          GError            **error)
+{
+  g_autoptr(GHashTable) updates = NULL;
+  g_autoptr(GHashTable) symbols = NULL;
+  g_autoptr(GHashTable) seen = NULL;
+  g_autoptr(GPtrArray) paths = NULL;
+  g_autoptr(GArray) mtimes = NULL;
+  g_autoptr(GVariant) db = NULL;
+  g_autofree gchar *dir = NULL;
+  g_autofree gpointer *keys = NULL;
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer value;
+  guint n_keys = 0;
+  guint i;
+
+  g_return_val_if_fail (write != NULL, FALSE);
+  g_return_val_if_fail (write->result == NULL, FALSE);
+
+  /* Later batches have newer information about a file than earlier ones. */
+  updates = g_hash_table_new (g_str_hash, g_str_equal);
+  seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i < write->batches->len; i++)
+    {
+      IdeClangXrefBatch *batch = g_ptr_array_index (write->batches, i);
+
+      g_hash_table_iter_init (&iter, batch->files);
+      while (g_hash_table_iter_next (&iter, NULL, &value))
+        {
+          IdeClangXrefFile *file = value;
+
+          g_hash_table_insert (updates, (gchar *)file->path, file);
+          g_hash_table_add (seen, (gchar *)file->path);
+        }
+    }
+
+  paths = g_ptr_array_new ();
+  mtimes = g_array_new (FALSE, FALSE, sizeof (gint64));
+  symbols = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_array_unref);
+
+  /*
+   * When compacting, walk the segments from newest to oldest so that the
+   * first record of a path is the current one. Removed files are dropped
+   * since there is nothing older left for them to hide.
+   */
+  for (i = write->inputs->len; i > 0; i--)
+    {
+      GVariant *input = g_ptr_array_index (write->inputs, i - 1);
+      g_autoptr(GVariant) files = g_variant_get_child_value (input, 1);
+      g_autoptr(GVariant) old_symbols = g_variant_get_child_value (input, 2);
+      g_autofree guint32 *remap = NULL;
+      gsize n_files = g_variant_n_children (files);
+      gsize n_symbols = g_variant_n_children (old_symbols);
+      gsize j;
+
+      remap = g_new (guint32, n_files);
+
+      for (j = 0; j < n_files; j++)
+        {
+          const gchar *path;
+          gint64 mtime;
+
+          g_variant_get_child (files, j, "(&sx)", &path, &mtime);
+
+          if (g_hash_table_contains (seen, path) || mtime == REMOVED_MTIME)
+            {
+              g_hash_table_add (seen, (gchar *)path);
+              remap [j] = G_MAXUINT32;
+              continue;
+            }
+
+          g_hash_table_add (seen, (gchar *)path);
+
+          remap [j] = paths->len;
+          g_ptr_array_add (paths, (gchar *)path);
+          g_array_append_val (mtimes, mtime);
+        }
+
+      for (j = 0; j < n_symbols; j++)
+        {
+          g_autoptr(GVariant) symbol = g_variant_get_child_value (old_symbols, j);
+          g_autoptr(GVariant) refs = g_variant_get_child_value (symbol, 1);
+          const XrefReference *old_refs;
+          const gchar *usr;
+          GArray *new_refs = NULL;
+          gsize n_refs = 0;
+          gsize k;
+
+          g_variant_get_child (symbol, 0, "&s", &usr);
+          old_refs = g_variant_get_fixed_array (refs, &n_refs, sizeof (XrefReference));
+
+          for (k = 0; k < n_refs; k++)
+            {
+              XrefReference ref = old_refs [k];
+
+              if (ref.file >= n_files || remap [ref.file] == G_MAXUINT32)
+                continue;
+
+              ref.file = remap [ref.file];
+
+              if (new_refs == NULL)
+                new_refs = get_references (symbols, usr);
+
+              g_array_append_val (new_refs, ref);
+            }
+        }
+    }
+
+  g_hash_table_iter_init (&iter, updates);
+
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      IdeClangXrefFile *file = value;
+      guint32 file_id;
+
+      if (file->records == NULL)
+        {
+          gint64 removed = REMOVED_MTIME;
+
+          /* A base has nothing older to hide. */
+          if (!write->compact)
+            {
+              g_ptr_array_add (paths, (gchar *)file->path);
+              g_array_append_val (mtimes, removed);
+            }
+
+          continue;
+        }
+
+      file_id = paths->len;
+      g_ptr_array_add (paths, (gchar *)file->path);
+      g_array_append_val (mtimes, file->mtime);
+
+      for (i = 0; i < file->records->len; i++)
+        {
+          const IdeClangXrefRecord *record = &g_array_index (file->records, IdeClangXrefRecord, i);
+          XrefReference ref = { 0 };
+
+          ref.file = file_id;
+          ref.line = record->line;
+          ref.column = record->column;
+          ref.length = record->length;
+          ref.kind = record->kind;
+
+          g_array_append_val (get_references (symbols, record->usr), ref);
+        }
+    }
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (XREF_DATABASE_TYPE));
+  g_variant_builder_add (&builder, "u", XREF_INDEX_VERSION);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(sx)"));
+  for (i = 0; i < paths->len; i++)
+    g_variant_builder_add (&builder, "(sx)",
+                           g_ptr_array_index (paths, i),
+                           g_array_index (mtimes, gint64, i));
+  g_variant_builder_close (&builder);
+
+  keys = g_hash_table_get_keys_as_array (symbols, &n_keys);
+  qsort (keys, n_keys, sizeof (gpointer), compare_strings);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(sa" XREF_REFERENCE_TYPE ")"));
+  for (i = 0; i < n_keys; i++)
+    {
+      GArray *refs = g_hash_table_lookup (symbols, keys [i]);
+
+      g_array_sort (refs, compare_references);
+      g_variant_builder_add (&builder, "(s@a" XREF_REFERENCE_TYPE ")",
+                             keys [i],
+                             g_variant_new_fixed_array (G_VARIANT_TYPE (XREF_REFERENCE_TYPE),
+                                                        refs->data,
+                                                        refs->len,
+                                                        sizeof (XrefReference)));
+    }
+  g_variant_builder_close (&builder);
+
+  db = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  dir = g_path_get_dirname (write->path);
+  g_mkdir_with_parents (dir, 0750);
+
+  if (!g_file_set_contents (write->path,
+                            g_variant_get_data (db),
+                            g_variant_get_size (db),
+                            error))
+    return FALSE;
+
+  /* Drop the heap copy in favor of mapping what we just wrote. */
+  g_clear_pointer (&db, g_variant_unref);
+
+  if (!(write->result = xref_map (write->path)))
+    {
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_INVALID_DATA,
+                   _("Failed to map %s"),
+                   write->path);
+      return FALSE;
+    }
+
+  /* The base holds everything the older segments did. */
+  for (i = 0; i < write->obsolete->len; i++)
+    g_unlink (g_ptr_array_index (write->obsolete, i));
+
+  return TRUE;
+}
@@ -0,0 +1,95 @@
+/* ide-clang-xref-store.h
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_CLANG_XREF_STORE_H
+#define IDE_CLANG_XREF_STORE_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  IDE_CLANG_XREF_REFERENCE,
+  IDE_CLANG_XREF_DECLARATION,
+  IDE_CLANG_XREF_DEFINITION,
+} IdeClangXrefKind;
+
+typedef struct
+{
+  const gchar *usr;
+  guint32      line;
+  guint32      column;
+  guint16      length;
+  guint8       kind;
+} IdeClangXrefRecord;
+
+typedef struct
+{
+  const gchar *path;
+  gint64       mtime;
+  /* NULL if the file no longer exists */
+  GArray      *records;
+} IdeClangXrefFile;
+
+/*
+ * The result of indexing a translation unit. Every project file touched
+ * by the unit gets an IdeClangXrefFile which replaces whatever the store
+ * knew about that file. Strings live in the chunk.
+ */
+typedef struct
+{
+  GStringChunk *strings;
+  GHashTable   *files;
+} IdeClangXrefBatch;
+
+typedef struct
+{
+  /* Owned by the store, valid until the next write is finished. */
+  const gchar *path;
+  guint32      line;
+  guint32      column;
+  guint16      length;
+  guint8       kind;
+} IdeClangXrefHit;
+
+typedef struct _IdeClangXrefStore IdeClangXrefStore;
+typedef struct _IdeClangXrefWrite IdeClangXrefWrite;
+
+IdeClangXrefBatch *ide_clang_xref_batch_new           (void);
+void               ide_clang_xref_batch_free          (gpointer            batch);
+IdeClangXrefFile  *ide_clang_xref_batch_add_file      (IdeClangXrefBatch  *batch,
+                                                       const gchar        *path,
+                                                       gboolean            exists);
+IdeClangXrefStore *ide_clang_xref_store_load          (const gchar        *directory);
+void               ide_clang_xref_store_free          (IdeClangXrefStore  *self);
+GPtrArray         *ide_clang_xref_store_get_segments  (IdeClangXrefStore  *self);
+GArray            *ide_clang_xref_store_lookup        (IdeClangXrefStore  *self,
+                                                       const gchar        *usr);
+IdeClangXrefWrite *ide_clang_xref_store_begin_write   (IdeClangXrefStore  *self,
+                                                       GPtrArray          *batches);
+void               ide_clang_xref_store_finish_write  (IdeClangXrefStore  *self,
+                                                       IdeClangXrefWrite  *write);
+gboolean           ide_clang_xref_write_run           (IdeClangXrefWrite  *write,
+                                                       GError            **error);
+void               ide_clang_xref_write_free          (gpointer            write);
+GHashTable        *ide_clang_xref_segments_get_mtimes (GPtrArray          *segments);
+
+G_END_DECLS
+
+#endif /* IDE_CLANG_XREF_STORE_H */
@@ -33,6 +33,8 @@ struct _IdeCtagsCompletionItem
   IdeCompletionItem           parent_instance;
   const IdeCtagsIndexEntry   *entry;
   IdeCtagsCompletionProvider *provider;
+  /* Owns the memory backing entry. */
+  IdeCtagsIndex              *index;
 };
 
 static void proposal_iface_init (GtkSourceCompletionProposalIface *iface);
@@ -47,14 +49,17 @@ EGG_DEFINE_COUNTER (instances, "IdeCtagsCompletionItem", "Instances", "Number of
 
 IdeCtagsCompletionItem *
 ide_ctags_completion_item_new (IdeCtagsCompletionProvider *provider,
+                               IdeCtagsIndex              *index,
                                const IdeCtagsIndexEntry   *entry)
 {
   IdeCtagsCompletionItem *self;
 
+  g_return_val_if_fail (IDE_IS_CTAGS_INDEX (index), NULL);
   g_return_val_if_fail (entry != NULL, NULL);
 
   self = g_object_new (IDE_TYPE_CTAGS_COMPLETION_ITEM, NULL);
   self->provider = provider;
+  self->index = g_object_ref (index);
   self->entry = entry;
 
   return self;
@@ -80,6 +85,11 @@ ide_ctags_completion_item_match (IdeCompletionItem *item,
 static void
 ide_ctags_completion_item_finalize (GObject *object)
 {
+  IdeCtagsCompletionItem *self = (IdeCtagsCompletionItem *)object;
+
+  self->entry = NULL;
+  g_clear_object (&self->index);
+
   G_OBJECT_CLASS (ide_ctags_completion_item_parent_class)->finalize (object);
 
   EGG_COUNTER_DEC (instances);
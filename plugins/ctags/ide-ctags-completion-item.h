@@ -33,6 +33,7 @@ G_DECLARE_FINAL_TYPE (IdeCtagsCompletionItem, ide_ctags_completion_item, IDE, CT
 
 IdeCtagsCompletionItem *
 ide_ctags_completion_item_new (IdeCtagsCompletionProvider *provider,
+                               IdeCtagsIndex              *index,
                                const IdeCtagsIndexEntry   *entry);
 
 G_END_DECLS
@@ -20,18 +20,39 @@
 #define IDE_CTAGS_COMPLETION_PROVIDER_PRIVATE_H
 
 #include "ide-ctags-completion-provider.h"
-#include "ide-completion-results.h"
+#include "ide-ctags-index.h"
 
 G_BEGIN_DECLS
 
+typedef struct
+{
+  const IdeCtagsIndexEntry *entry;
+  guint                     priority;
+  /* Position of the owning index within match_indexes. */
+  guint                     index;
+} IdeCtagsCompletionMatch;
+
 struct _IdeCtagsCompletionProvider
 {
-  IdeObject             parent_instance;
-  gint                  minimum_word_size;
-  GSettings            *settings;
-  GPtrArray            *indexes;
-  IdeCompletionResults *results;
-  gchar                *current_word;
+  IdeObject            parent_instance;
+  gint                 minimum_word_size;
+  GSettings           *settings;
+  GPtrArray           *indexes;
+  gchar               *current_word;
+
+  /*
+   * The deduplicated matches for match_query across every index, ranked
+   * for display. These are only references into the index entries; a
+   * proposal is created for a match when it enters the visible window.
+   * match_allowed is the suffix filter the matches were made with.
+   */
+  GArray              *matches;
+  gchar               *match_query;
+  const gchar * const *match_allowed;
+  GPtrArray           *match_indexes;
+
+  /* IdeCtagsIndexEntry -> IdeCtagsCompletionItem for the visible window */
+  GHashTable          *items;
 };
 
 G_END_DECLS
@@ -23,7 +23,6 @@
 
 #include "ide-completion-provider.h"
 #include "ide-completion-item.h"
-#include "ide-completion-results.h"
 #include "ide-context.h"
 #include "ide-ctags-completion-item.h"
 #include "ide-ctags-completion-provider.h"
@@ -66,6 +65,7 @@ ide_ctags_completion_provider_add_index (IdeCtagsCompletionProvider *self,
         {
           g_ptr_array_remove_index_fast (self->indexes, i);
           g_ptr_array_add (self->indexes, g_object_ref (index));
+          g_clear_pointer (&self->match_query, g_free);
 
           IDE_EXIT;
         }
@@ -73,6 +73,9 @@ ide_ctags_completion_provider_add_index (IdeCtagsCompletionProvider *self,
 
   g_ptr_array_add (self->indexes, g_object_ref (index));
 
+  /* Make sure the next populate queries the new index. */
+  g_clear_pointer (&self->match_query, g_free);
+
   IDE_EXIT;
 }
 
@@ -111,8 +114,11 @@ ide_ctags_completion_provider_finalize (GObject *object)
 
   g_clear_pointer (&self->current_word, g_free);
   g_clear_pointer (&self->indexes, g_ptr_array_unref);
+  g_clear_pointer (&self->items, g_hash_table_unref);
+  g_clear_pointer (&self->matches, g_array_unref);
+  g_clear_pointer (&self->match_indexes, g_ptr_array_unref);
+  g_clear_pointer (&self->match_query, g_free);
   g_clear_object (&self->settings);
-  g_clear_object (&self->results);
 
   G_OBJECT_CLASS (ide_ctags_completion_provider_parent_class)->finalize (object);
 }
@@ -138,6 +144,7 @@ ide_ctags_completion_provider_init (IdeCtagsCompletionProvider *self)
   self->minimum_word_size = 3;
   self->indexes = g_ptr_array_new_with_free_func (g_object_unref);
   self->settings = g_settings_new ("org.gnome.builder.code-insight");
+  self->items = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
 }
 
 static gchar *
@@ -164,104 +171,265 @@ get_allowed_suffixes (GtkSourceCompletionContext *context)
   return ide_ctags_get_allowed_suffixes (lang_id);
 }
 
+static gint
+sort_by_priority (gconstpointer a,
+                  gconstpointer b)
+{
+  const IdeCtagsCompletionMatch *matcha = a;
+  const IdeCtagsCompletionMatch *matchb = b;
+
+  if (matcha->priority < matchb->priority)
+    return -1;
+  else if (matcha->priority > matchb->priority)
+    return 1;
+
+  return strcmp (matcha->entry->name, matchb->entry->name);
+}
+
+typedef struct
+{
+  const IdeCtagsIndexEntry *entries;
+  gsize                     n_entries;
+  gsize                     pos;
+} PrefixCursor;
+
+/*
+ * Performs a single prefix query across all of the indexes. Each index
+ * gives us a sorted run of entries, so we merge the runs which lets us
+ * drop duplicate names as they become adjacent, without a hash table.
+ */
 static void
-ide_ctags_completion_provider_populate (GtkSourceCompletionProvider *provider,
-                                        GtkSourceCompletionContext  *context)
+ide_ctags_completion_provider_query (IdeCtagsCompletionProvider *self,
+                                     const gchar                *word,
+                                     const gchar                *casefold,
+                                     const gchar * const        *allowed)
 {
-  IdeCtagsCompletionProvider *self = (IdeCtagsCompletionProvider *)provider;
-  const gchar * const *allowed;
-  g_autofree gchar *casefold = NULL;
-  gint word_len;
+  g_autofree PrefixCursor *cursors = NULL;
+  const gchar *last_name = NULL;
+  gsize word_len;
   guint i;
-  guint j;
-  g_autoptr(GHashTable) completions = NULL;
-
-  IDE_ENTRY;
 
   g_assert (IDE_IS_CTAGS_COMPLETION_PROVIDER (self));
-  g_assert (GTK_SOURCE_IS_COMPLETION_CONTEXT (context));
+  g_assert (word != NULL);
+  g_assert (casefold != NULL);
 
-  g_clear_pointer (&self->current_word, g_free);
-  self->current_word = ide_completion_provider_context_current_word (context);
+  g_clear_pointer (&self->matches, g_array_unref);
+  g_clear_pointer (&self->match_indexes, g_ptr_array_unref);
+  g_clear_pointer (&self->match_query, g_free);
 
-  allowed = get_allowed_suffixes (context);
+  self->matches = g_array_new (FALSE, FALSE, sizeof (IdeCtagsCompletionMatch));
+  self->match_query = g_strdup (word);
+  self->match_allowed = allowed;
 
-  if (self->results != NULL)
+  /*
+   * Make sure we hold a reference to the indexes for the lifetime of the
+   * matches. When the matches are released, so could our indexes.
+   */
+  self->match_indexes = g_ptr_array_new_with_free_func (g_object_unref);
+  cursors = g_new0 (PrefixCursor, self->indexes->len);
+  word_len = strlen (word);
+
+  for (i = 0; i < self->indexes->len; i++)
     {
-      if (ide_completion_results_replay (self->results, self->current_word))
+      IdeCtagsIndex *index = g_ptr_array_index (self->indexes, i);
+      g_autofree gchar *copy = g_strdup (word);
+      gsize tmp_len = word_len;
+
+      g_ptr_array_add (self->match_indexes, g_object_ref (index));
+
+      while (cursors [i].entries == NULL && *copy)
         {
-          ide_completion_results_present (self->results, provider, context);
-          IDE_EXIT;
+          if (!(cursors [i].entries = ide_ctags_index_lookup_prefix (index, copy, &cursors [i].n_entries)))
+            copy [--tmp_len] = '\0';
         }
-      g_clear_pointer (&self->results, g_object_unref);
     }
 
-  word_len = strlen (self->current_word);
-  if (word_len < self->minimum_word_size)
-    IDE_GOTO (word_too_small);
+  for (;;)
+    {
+      const IdeCtagsIndexEntry *entry = NULL;
+      IdeCtagsCompletionMatch match;
+      guint owner = 0;
 
-  casefold = g_utf8_casefold (self->current_word, -1);
+      for (i = 0; i < self->indexes->len; i++)
+        {
+          const IdeCtagsIndexEntry *head;
 
-  self->results = ide_completion_results_new (self->current_word);
+          if (cursors [i].pos >= cursors [i].n_entries)
+            continue;
 
-  completions = g_hash_table_new (g_str_hash, g_str_equal);
+          head = &cursors [i].entries [cursors [i].pos];
 
-  for (i = 0; i < self->indexes->len; i++)
-    {
-      g_autofree gchar *copy = g_strdup (self->current_word);
-      IdeCtagsIndex *index = g_ptr_array_index (self->indexes, i);
-      const IdeCtagsIndexEntry *entries = NULL;
-      guint tmp_len = word_len;
-      gsize n_entries = 0;
-      gchar gdata_key[64];
-
-      /*
-       * Make sure we hold a reference to the index for the lifetime of the results.
-       * When the results are released, so could our indexes.
-       */
-      g_snprintf (gdata_key, sizeof gdata_key, "ctags-%d", i);
-      g_object_set_data_full (G_OBJECT (self->results), gdata_key,
-                              g_object_ref (index), g_object_unref);
-
-      while (entries == NULL && *copy)
-        {
-          if (!(entries = ide_ctags_index_lookup_prefix (index, copy, &n_entries)))
-            copy [--tmp_len] = '\0';
+          if (entry == NULL || strcmp (head->name, entry->name) < 0)
+            {
+              entry = head;
+              owner = i;
+            }
         }
 
-      if ((entries == NULL) || (n_entries == 0))
+      if (entry == NULL)
+        break;
+
+      cursors [owner].pos++;
+
+      if (last_name != NULL && strcmp (last_name, entry->name) == 0)
         continue;
 
-      for (j = 0; j < n_entries; j++)
-        {
-          const IdeCtagsIndexEntry *entry = &entries [j];
-          IdeCtagsCompletionItem *item;
+      if (!ide_ctags_is_allowed (entry, allowed))
+        continue;
 
-          if (g_hash_table_contains (completions, entry->name))
-            continue;
+      last_name = entry->name;
 
-          g_hash_table_add (completions, (gchar *)entry->name);
+      if (!ide_completion_item_fuzzy_match (entry->name, casefold, &match.priority))
+        continue;
 
-          if (!ide_ctags_is_allowed (entry, allowed))
-            continue;
+      match.entry = entry;
+      match.index = owner;
 
-          item = ide_ctags_completion_item_new (self, entry);
+      g_array_append_val (self->matches, match);
+    }
 
-          if (!ide_completion_item_match (IDE_COMPLETION_ITEM (item), self->current_word, casefold))
-            {
-              g_object_unref (item);
-              continue;
-            }
+  g_array_sort (self->matches, sort_by_priority);
+}
 
-          ide_completion_results_take_proposal (self->results, IDE_COMPLETION_ITEM (item));
-        }
+/*
+ * Narrows the previous matches to those still matching @word. This is
+ * only valid when @word extends match_query and @allowed is the filter
+ * the matches were made with.
+ */
+static void
+ide_ctags_completion_provider_refilter (IdeCtagsCompletionProvider *self,
+                                        const gchar                *word,
+                                        const gchar                *casefold,
+                                        const gchar * const        *allowed)
+{
+  guint i;
+  guint j = 0;
+
+  g_assert (IDE_IS_CTAGS_COMPLETION_PROVIDER (self));
+  g_assert (self->matches != NULL);
+  g_assert (allowed == self->match_allowed);
+
+  for (i = 0; i < self->matches->len; i++)
+    {
+      IdeCtagsCompletionMatch *match = &g_array_index (self->matches, IdeCtagsCompletionMatch, i);
+
+      if (ide_ctags_is_allowed (match->entry, allowed) &&
+          ide_completion_item_fuzzy_match (match->entry->name, casefold, &match->priority))
+        g_array_index (self->matches, IdeCtagsCompletionMatch, j++) = *match;
+    }
+
+  g_array_set_size (self->matches, j);
+  g_array_sort (self->matches, sort_by_priority);
+
+  g_free (self->match_query);
+  self->match_query = g_strdup (word);
+}
+
+/*
+ * Creates proposals for the visible window of matches, reusing those we
+ * created for the previous keystroke. Returns the head of a list linked
+ * through the items themselves, so no list nodes are allocated.
+ */
+static GList *
+ide_ctags_completion_provider_link_visible (IdeCtagsCompletionProvider *self)
+{
+  g_autoptr(GHashTable) previous = NULL;
+  GList *head = NULL;
+  GList *prev = NULL;
+  guint n_visible;
+  guint i;
+
+  g_assert (IDE_IS_CTAGS_COMPLETION_PROVIDER (self));
+  g_assert (self->matches != NULL);
+
+  previous = self->items;
+  self->items = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
+
+  n_visible = MIN (self->matches->len, IDE_COMPLETION_PROVIDER_MAX_VISIBLE_PROPOSALS);
+
+  for (i = 0; i < n_visible; i++)
+    {
+      const IdeCtagsCompletionMatch *match = &g_array_index (self->matches, IdeCtagsCompletionMatch, i);
+      IdeCtagsCompletionItem *item;
+
+      if ((item = g_hash_table_lookup (previous, match->entry)))
+        g_hash_table_steal (previous, match->entry);
+      else
+        item = ide_ctags_completion_item_new (self,
+                                              g_ptr_array_index (self->match_indexes, match->index),
+                                              match->entry);
+
+      g_hash_table_insert (self->items, (gpointer)match->entry, item);
+
+      IDE_COMPLETION_ITEM (item)->priority = match->priority;
+      IDE_COMPLETION_ITEM (item)->link.prev = prev;
+      IDE_COMPLETION_ITEM (item)->link.next = NULL;
+
+      if (prev != NULL)
+        prev->next = &IDE_COMPLETION_ITEM (item)->link;
+      else
+        head = &IDE_COMPLETION_ITEM (item)->link;
+
+      prev = &IDE_COMPLETION_ITEM (item)->link;
     }
 
-  ide_completion_results_present (self->results, provider, context);
+  return head;
+}
+
+static void
+ide_ctags_completion_provider_populate (GtkSourceCompletionProvider *provider,
+                                        GtkSourceCompletionContext  *context)
+{
+  IdeCtagsCompletionProvider *self = (IdeCtagsCompletionProvider *)provider;
+  const gchar * const *allowed;
+  g_autofree gchar *casefold = NULL;
+  gint word_len;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_CTAGS_COMPLETION_PROVIDER (self));
+  g_assert (GTK_SOURCE_IS_COMPLETION_CONTEXT (context));
+
+  g_clear_pointer (&self->current_word, g_free);
+  self->current_word = ide_completion_provider_context_current_word (context);
+
+  allowed = get_allowed_suffixes (context);
+
+  word_len = strlen (self->current_word);
+  if (word_len < self->minimum_word_size)
+    IDE_GOTO (word_too_small);
+
+  casefold = g_utf8_casefold (self->current_word, -1);
+
+  /*
+   * If the user has continued typing in a buffer of the same language, we
+   * only need to look at the entries that matched the previous query.
+   * Otherwise query the indexes again.
+   */
+  if ((self->matches != NULL) &&
+      (self->match_query != NULL) &&
+      (self->match_allowed == allowed) &&
+      g_str_has_prefix (self->current_word, self->match_query))
+    ide_ctags_completion_provider_refilter (self, self->current_word, casefold, allowed);
+  else
+    ide_ctags_completion_provider_query (self, self->current_word, casefold, allowed);
+
+  IDE_TRACE_MSG ("%u ctags matches for \"%s\"", self->matches->len, self->current_word);
+
+  gtk_source_completion_context_add_proposals (context,
+                                               provider,
+                                               ide_ctags_completion_provider_link_visible (self),
+                                               TRUE);
 
   IDE_EXIT;
 
 word_too_small:
+  g_clear_pointer (&self->matches, g_array_unref);
+  g_clear_pointer (&self->match_indexes, g_ptr_array_unref);
+  g_clear_pointer (&self->match_query, g_free);
+  self->match_allowed = NULL;
+  g_hash_table_remove_all (self->items);
+
   gtk_source_completion_context_add_proposals (context, provider, NULL, TRUE);
 
   IDE_EXIT;
@@ -20,6 +20,7 @@
 
 #include <ctype.h>
 #include <devhelp/devhelp.h>
+#include <fuzzy.h>
 #include <glib/gi18n.h>
 #include <ide.h>
 #include <libpeas/peas.h>
@@ -28,12 +29,45 @@
 #include "gbp-devhelp-search-provider.h"
 #include "gbp-devhelp-search-result.h"
 
+#define REBUILD_TIMEOUT_MSEC 500
+
+typedef struct
+{
+  const gchar *name;
+  const gchar *book_name;
+  const gchar *uri;
+  guint        deprecated : 1;
+} Keyword;
+
+typedef struct
+{
+  volatile gint  ref_count;
+  Fuzzy         *fuzzy;
+  GStringChunk  *strings;
+  GArray        *keywords;
+} KeywordIndex;
+
+typedef struct
+{
+  KeywordIndex *index;
+  gchar        *search_terms;
+  gsize         max_results;
+} Query;
+
 struct _GbpDevhelpSearchProvider
 {
   IdeObject          parent;
 
   DhBookManager     *book_manager;
-  DhKeywordModel    *keywords_model;
+
+  /*
+   * The keyword index is immutable once built and is swapped out as a whole
+   * when the set of enabled books changes. Queries hold a reference to the
+   * index they were started with, so rebuilding never blocks searching.
+   */
+  KeywordIndex      *index;
+  GCancellable      *rebuild_cancellable;
+  guint              rebuild_source;
 };
 
 static void search_provider_iface_init (IdeSearchProviderInterface *iface);
@@ -45,81 +79,333 @@ G_DEFINE_TYPE_EXTENDED (GbpDevhelpSearchProvider,
                         G_IMPLEMENT_INTERFACE (IDE_TYPE_SEARCH_PROVIDER,
                                                search_provider_iface_init))
 
+static KeywordIndex *
+keyword_index_ref (KeywordIndex *index)
+{
+  g_assert (index != NULL);
+  g_assert (index->ref_count > 0);
+
+  g_atomic_int_inc (&index->ref_count);
+
+  return index;
+}
+
 static void
-gbp_devhelp_search_provider_populate (IdeSearchProvider *provider,
-                                      IdeSearchContext  *context,
-                                      const gchar       *search_terms,
-                                      gsize              max_results,
-                                      GCancellable      *cancellable)
+keyword_index_unref (KeywordIndex *index)
 {
-  GbpDevhelpSearchProvider *self = (GbpDevhelpSearchProvider *)provider;
-  g_auto(IdeSearchReducer) reducer = { 0 };
-  IdeContext *idecontext;
-  GtkTreeIter iter;
-  gboolean valid;
-  gint count = 0;
-  gint total;
+  g_assert (index != NULL);
+  g_assert (index->ref_count > 0);
+
+  if (g_atomic_int_dec_and_test (&index->ref_count))
+    {
+      g_clear_pointer (&index->fuzzy, fuzzy_unref);
+      g_clear_pointer (&index->keywords, g_array_unref);
+      g_clear_pointer (&index->strings, g_string_chunk_free);
+      g_slice_free (KeywordIndex, index);
+    }
+}
+
+static void
+query_free (gpointer data)
+{
+  Query *query = data;
+
+  g_clear_pointer (&query->index, keyword_index_unref);
+  g_clear_pointer (&query->search_terms, g_free);
+  g_slice_free (Query, query);
+}
+
+static void
+gbp_devhelp_search_provider_build_worker (GTask        *task,
+                                          gpointer      source_object,
+                                          gpointer      task_data,
+                                          GCancellable *cancellable)
+{
+  GPtrArray *links = task_data;
+  KeywordIndex *index;
+  guint i;
+
+  IDE_ENTRY;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (GBP_IS_DEVHELP_SEARCH_PROVIDER (source_object));
+  g_assert (links != NULL);
+
+  /*
+   * We only read from the links here. They are kept alive by the task data
+   * and released from the main thread once we have completed.
+   */
+
+  index = g_slice_new0 (KeywordIndex);
+  index->ref_count = 1;
+  index->strings = g_string_chunk_new (4096 * 4);
+  index->keywords = g_array_sized_new (FALSE, FALSE, sizeof (Keyword), links->len);
+  index->fuzzy = fuzzy_new (FALSE);
+
+  for (i = 0; i < links->len; i++)
+    {
+      DhLink *link = g_ptr_array_index (links, i);
+      g_autofree gchar *uri = NULL;
+      const gchar *name;
+      Keyword keyword = { 0 };
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      if (NULL == (name = dh_link_get_name (link)) || NULL == (uri = dh_link_get_uri (link)))
+        continue;
+
+      keyword.name = g_string_chunk_insert (index->strings, name);
+      keyword.book_name = g_string_chunk_insert_const (index->strings, dh_link_get_book_name (link) ?: "");
+      keyword.uri = g_string_chunk_insert (index->strings, uri);
+      keyword.deprecated = (dh_link_get_flags (link) & DH_LINK_FLAGS_DEPRECATED) != 0;
+
+      g_array_append_val (index->keywords, keyword);
+    }
+
+  /*
+   * Insert only after the array has stopped growing, since the fuzzy index
+   * stores pointers to the elements.
+   */
+  fuzzy_begin_bulk_insert (index->fuzzy);
+  for (i = 0; i < index->keywords->len; i++)
+    {
+      Keyword *keyword = &g_array_index (index->keywords, Keyword, i);
+
+      fuzzy_insert (index->fuzzy, keyword->name, keyword);
+    }
+  fuzzy_end_bulk_insert (index->fuzzy);
+
+  if (g_cancellable_is_cancelled (cancellable))
+    {
+      keyword_index_unref (index);
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_CANCELLED,
+                               "The operation was cancelled");
+      IDE_EXIT;
+    }
+
+  IDE_TRACE_MSG ("Indexed %u devhelp keywords", index->keywords->len);
+
+  g_task_return_pointer (task, index, (GDestroyNotify)keyword_index_unref);
+
+  IDE_EXIT;
+}
+
+static void
+gbp_devhelp_search_provider_build_cb (GObject      *object,
+                                      GAsyncResult *result,
+                                      gpointer      user_data)
+{
+  GbpDevhelpSearchProvider *self = (GbpDevhelpSearchProvider *)object;
+  GTask *task = (GTask *)result;
+  KeywordIndex *index;
+  GPtrArray *links;
 
   g_assert (GBP_IS_DEVHELP_SEARCH_PROVIDER (self));
-  g_assert (IDE_IS_SEARCH_CONTEXT (context));
-  g_assert (search_terms);
-  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+  g_assert (G_IS_TASK (task));
+
+  /* DhLink is not thread-safe, so drop our references from this thread. */
+  links = g_task_get_task_data (task);
+  g_ptr_array_set_size (links, 0);
 
-  if (search_terms [0] == '\0')
+  if (NULL != (index = g_task_propagate_pointer (task, NULL)))
     {
-      ide_search_context_provider_completed (context, provider);
-      return;
+      g_clear_pointer (&self->index, keyword_index_unref);
+      self->index = index;
     }
+}
+
+static void
+gbp_devhelp_search_provider_rebuild (GbpDevhelpSearchProvider *self)
+{
+  g_autoptr(GTask) task = NULL;
+  GPtrArray *links;
+  GList *books;
+  GList *iter;
 
-  idecontext = ide_object_get_context (IDE_OBJECT (provider));
+  g_assert (GBP_IS_DEVHELP_SEARCH_PROVIDER (self));
 
-  dh_keyword_model_filter (self->keywords_model, search_terms, NULL, NULL);
+  if (self->rebuild_cancellable != NULL)
+    {
+      g_cancellable_cancel (self->rebuild_cancellable);
+      g_clear_object (&self->rebuild_cancellable);
+    }
 
-  ide_search_reducer_init (&reducer, context, provider, max_results);
+  self->rebuild_cancellable = g_cancellable_new ();
 
-  valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (self->keywords_model), &iter);
-  total = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (self->keywords_model), NULL);
+  /*
+   * Walking the books is just following pointers, which is cheap enough to
+   * do here. Everything that allocates per-keyword is done on the worker.
+   */
+  links = g_ptr_array_new_with_free_func ((GDestroyNotify)dh_link_unref);
+  books = dh_book_manager_get_books (self->book_manager);
 
-  while (valid)
+  for (iter = books; iter != NULL; iter = iter->next)
     {
-      g_autoptr(IdeSearchResult) result = NULL;
-      g_autofree gchar *name = NULL;
-      DhLink *link = NULL;
-      gfloat score = (total - count) / (gfloat)total;
+      DhBook *book = iter->data;
+      GList *keywords;
+
+      if (!dh_book_get_enabled (book))
+        continue;
+
+      for (keywords = dh_book_get_keywords (book); keywords != NULL; keywords = keywords->next)
+        g_ptr_array_add (links, dh_link_ref (keywords->data));
+    }
+
+  task = g_task_new (self, self->rebuild_cancellable, gbp_devhelp_search_provider_build_cb, NULL);
+  g_task_set_source_tag (task, gbp_devhelp_search_provider_rebuild);
+  g_task_set_task_data (task, links, (GDestroyNotify)g_ptr_array_unref);
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER,
+                             task,
+                             gbp_devhelp_search_provider_build_worker);
+}
+
+static gboolean
+gbp_devhelp_search_provider_rebuild_timeout (gpointer data)
+{
+  GbpDevhelpSearchProvider *self = data;
+
+  g_assert (GBP_IS_DEVHELP_SEARCH_PROVIDER (self));
 
-      gtk_tree_model_get (GTK_TREE_MODEL (self->keywords_model), &iter,
-                          DH_KEYWORD_MODEL_COL_NAME, &name,
-                          DH_KEYWORD_MODEL_COL_LINK, &link,
-                          -1);
+  self->rebuild_source = 0;
+  gbp_devhelp_search_provider_rebuild (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gbp_devhelp_search_provider_queue_rebuild (GbpDevhelpSearchProvider *self)
+{
+  g_assert (GBP_IS_DEVHELP_SEARCH_PROVIDER (self));
 
-      valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (self->keywords_model), &iter);
+  /* Books tend to be added and removed in bursts, so coalesce them. */
+  if (self->rebuild_source != 0)
+    g_source_remove (self->rebuild_source);
 
-      /* we traverse from best to worst, so just break */
-      if (!ide_search_reducer_accepts (&reducer, score))
+  self->rebuild_source = g_timeout_add (REBUILD_TIMEOUT_MSEC,
+                                        gbp_devhelp_search_provider_rebuild_timeout,
+                                        self);
+}
+
+static void
+gbp_devhelp_search_provider_query_worker (GTask        *task,
+                                          gpointer      source_object,
+                                          gpointer      task_data,
+                                          GCancellable *cancellable)
+{
+  Query *query = task_data;
+  GArray *matches;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (query != NULL);
+  g_assert (query->index != NULL);
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  matches = fuzzy_match (query->index->fuzzy, query->search_terms, query->max_results);
+
+  g_task_return_pointer (task, matches, (GDestroyNotify)g_array_unref);
+}
+
+static void
+gbp_devhelp_search_provider_query_cb (GObject      *object,
+                                      GAsyncResult *result,
+                                      gpointer      user_data)
+{
+  GbpDevhelpSearchProvider *self = (GbpDevhelpSearchProvider *)object;
+  g_autoptr(IdeSearchContext) context = user_data;
+  g_auto(IdeSearchReducer) reducer = { 0 };
+  g_autoptr(GArray) matches = NULL;
+  GTask *task = (GTask *)result;
+  IdeContext *idecontext;
+  Query *query;
+  guint i;
+
+  g_assert (GBP_IS_DEVHELP_SEARCH_PROVIDER (self));
+  g_assert (IDE_IS_SEARCH_CONTEXT (context));
+  g_assert (G_IS_TASK (task));
+
+  if (NULL == (matches = g_task_propagate_pointer (task, NULL)))
+    goto completed;
+
+  query = g_task_get_task_data (task);
+  idecontext = ide_object_get_context (IDE_OBJECT (self));
+
+  ide_search_reducer_init (&reducer, context, IDE_SEARCH_PROVIDER (self), query->max_results);
+
+  for (i = 0; i < matches->len; i++)
+    {
+      const FuzzyMatch *match = &g_array_index (matches, FuzzyMatch, i);
+      const Keyword *keyword = match->value;
+      g_autoptr(IdeSearchResult) search_result = NULL;
+      g_autofree gchar *title = NULL;
+
+      /* matches are sorted from best to worst, so just break */
+      if (!ide_search_reducer_accepts (&reducer, match->score))
         break;
 
-      count++;
-
-      if ((dh_link_get_flags (link) & DH_LINK_FLAGS_DEPRECATED) != 0)
-        {
-          gchar *italic_name = g_strdup_printf ("<i>%s</i>", name);
-          g_free (name);
-          name = italic_name;
-        }
-
-      result = g_object_new (GBP_TYPE_DEVHELP_SEARCH_RESULT,
-                             "context", idecontext,
-                             "provider", provider,
-                             "title", name,
-                             "subtitle", dh_link_get_book_name (link),
-                             "score", score,
-                             "uri", dh_link_get_uri (link),
-                             NULL);
-
-      ide_search_reducer_push (&reducer, result);
+      /* The title is markup, and keywords such as C++ operators contain '<'. */
+      if (keyword->deprecated)
+        title = g_markup_printf_escaped ("<i>%s</i>", keyword->name);
+      else
+        title = g_markup_escape_text (keyword->name, -1);
+
+      search_result = g_object_new (GBP_TYPE_DEVHELP_SEARCH_RESULT,
+                                    "context", idecontext,
+                                    "provider", self,
+                                    "title", title,
+                                    "subtitle", keyword->book_name,
+                                    "score", match->score,
+                                    "uri", keyword->uri,
+                                    NULL);
+
+      ide_search_reducer_push (&reducer, search_result);
+    }
+
+completed:
+  ide_search_context_provider_completed (context, IDE_SEARCH_PROVIDER (self));
+}
+
+static void
+gbp_devhelp_search_provider_populate (IdeSearchProvider *provider,
+                                      IdeSearchContext  *context,
+                                      const gchar       *search_terms,
+                                      gsize              max_results,
+                                      GCancellable      *cancellable)
+{
+  GbpDevhelpSearchProvider *self = (GbpDevhelpSearchProvider *)provider;
+  g_autoptr(GTask) task = NULL;
+  Query *query;
+
+  g_assert (GBP_IS_DEVHELP_SEARCH_PROVIDER (self));
+  g_assert (IDE_IS_SEARCH_CONTEXT (context));
+  g_assert (search_terms);
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  /* If the index is still being built, we simply have no results yet. */
+  if (search_terms [0] == '\0' || self->index == NULL)
+    {
+      ide_search_context_provider_completed (context, provider);
+      return;
     }
 
-  ide_search_context_provider_completed (context, provider);
+  query = g_slice_new0 (Query);
+  query->index = keyword_index_ref (self->index);
+  query->search_terms = g_strdup (search_terms);
+  query->max_results = max_results;
+
+  task = g_task_new (self,
+                     cancellable,
+                     gbp_devhelp_search_provider_query_cb,
+                     g_object_ref (context));
+  g_task_set_source_tag (task, gbp_devhelp_search_provider_populate);
+  g_task_set_task_data (task, query, query_free);
+  ide_thread_pool_push_task (IDE_THREAD_POOL_COMPILER,
+                             task,
+                             gbp_devhelp_search_provider_query_worker);
 }
 
 static const gchar *
@@ -133,8 +419,32 @@ gbp_devhelp_search_provider_constructed (GObject *object)
 {
   GbpDevhelpSearchProvider *self = GBP_DEVHELP_SEARCH_PROVIDER (object);
 
+  G_OBJECT_CLASS (gbp_devhelp_search_provider_parent_class)->constructed (object);
+
   dh_book_manager_populate (self->book_manager);
-  dh_keyword_model_set_words (self->keywords_model, self->book_manager);
+
+  g_signal_connect_object (self->book_manager,
+                           "book-created",
+                           G_CALLBACK (gbp_devhelp_search_provider_queue_rebuild),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->book_manager,
+                           "book-deleted",
+                           G_CALLBACK (gbp_devhelp_search_provider_queue_rebuild),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->book_manager,
+                           "book-enabled",
+                           G_CALLBACK (gbp_devhelp_search_provider_queue_rebuild),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->book_manager,
+                           "book-disabled",
+                           G_CALLBACK (gbp_devhelp_search_provider_queue_rebuild),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  gbp_devhelp_search_provider_rebuild (self);
 }
 
 static GtkWidget *
@@ -202,6 +512,17 @@ gbp_devhelp_search_provider_finalize (GObject *object)
 {
   GbpDevhelpSearchProvider *self = GBP_DEVHELP_SEARCH_PROVIDER (object);
 
+  if (self->rebuild_source != 0)
+    {
+      g_source_remove (self->rebuild_source);
+      self->rebuild_source = 0;
+    }
+
+  if (self->rebuild_cancellable != NULL)
+    g_cancellable_cancel (self->rebuild_cancellable);
+
+  g_clear_object (&self->rebuild_cancellable);
+  g_clear_pointer (&self->index, keyword_index_unref);
   g_clear_object (&self->book_manager);
 
   G_OBJECT_CLASS (gbp_devhelp_search_provider_parent_class)->finalize (object);
@@ -220,7 +541,6 @@ static void
 gbp_devhelp_search_provider_init (GbpDevhelpSearchProvider *self)
 {
   self->book_manager = dh_book_manager_new ();
-  self->keywords_model = dh_keyword_model_new ();
 }
 
 static void
@@ -22,6 +22,7 @@
 
 #include "gb-file-search-provider.h"
 #include "gb-file-search-index.h"
+#include "gb-text-search-provider.h"
 
 struct _GbFileSearchProvider
 {
@@ -315,4 +316,7 @@ peas_register_types (PeasObjectModule *module)
   peas_object_module_register_extension_type (module,
                                               IDE_TYPE_SEARCH_PROVIDER,
                                               GB_TYPE_FILE_SEARCH_PROVIDER);
+  peas_object_module_register_extension_type (module,
+                                              IDE_TYPE_SEARCH_PROVIDER,
+                                              GB_TYPE_TEXT_SEARCH_PROVIDER);
 }
@@ -0,0 +1,327 @@
+/* gb-text-search-provider.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gi18n.h>
+#include <string.h>
+
+#include "gb-text-search-provider.h"
+#include "gb-text-search-result.h"
+
+/*
+ * Queries shorter than a trigram cannot use the index and would read
+ * every file in the project on each keystroke.
+ */
+#define MIN_QUERY_LENGTH 3
+
+struct _GbTextSearchProvider
+{
+  IdeObject     parent_instance;
+  IdeTextIndex *index;
+  guint         loaded : 1;
+};
+
+typedef struct
+{
+  GbTextSearchProvider *self;
+  IdeSearchContext     *context;
+} Populate;
+
+static void search_provider_iface_init (IdeSearchProviderInterface *iface);
+
+G_DEFINE_TYPE_EXTENDED (GbTextSearchProvider, gb_text_search_provider, IDE_TYPE_OBJECT, 0,
+                        G_IMPLEMENT_INTERFACE (IDE_TYPE_SEARCH_PROVIDER, search_provider_iface_init))
+
+static void
+populate_free (gpointer data)
+{
+  Populate *populate = data;
+
+  g_clear_object (&populate->self);
+  g_clear_object (&populate->context);
+  g_slice_free (Populate, populate);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (Populate, populate_free)
+
+static const gchar *
+gb_text_search_provider_get_verb (IdeSearchProvider *provider)
+{
+  return _("Go To");
+}
+
+static gint
+gb_text_search_provider_get_priority (IdeSearchProvider *provider)
+{
+  return 200;
+}
+
+static void
+gb_text_search_provider_search_cb (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  IdeTextIndex *index = (IdeTextIndex *)object;
+  g_autoptr(Populate) populate = user_data;
+  g_autoptr(GPtrArray) matches = NULL;
+  g_autoptr(GError) error = NULL;
+  IdeSearchProvider *provider;
+  IdeSearchContext *context;
+  IdeContext *icontext;
+  guint i;
+
+  g_assert (IDE_IS_TEXT_INDEX (index));
+  g_assert (populate != NULL);
+
+  provider = IDE_SEARCH_PROVIDER (populate->self);
+  context = populate->context;
+  icontext = ide_object_get_context (IDE_OBJECT (provider));
+
+  g_assert (IDE_IS_SEARCH_CONTEXT (context));
+
+  if (!(matches = ide_text_index_search_finish (index, result, &error)))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_debug ("%s", error->message);
+      ide_search_context_provider_completed (context, provider);
+      return;
+    }
+
+  for (i = 0; i < matches->len; i++)
+    {
+      const IdeTextIndexMatch *match = g_ptr_array_index (matches, i);
+      g_autoptr(GbTextSearchResult) item = NULL;
+      g_autofree gchar *title = NULL;
+      g_autofree gchar *subtitle = NULL;
+      g_autofree gchar *stripped = NULL;
+
+      stripped = g_strstrip (g_strdup (match->text));
+      title = g_markup_printf_escaped ("%s:%u", match->path, match->line + 1);
+      subtitle = g_markup_escape_text (stripped, -1);
+
+      /* Keep the order of the index, which groups matches by file. */
+      item = g_object_new (GB_TYPE_TEXT_SEARCH_RESULT,
+                           "context", icontext,
+                           "provider", provider,
+                           "score", 1.0 - ((gfloat)i / matches->len),
+                           "title", title,
+                           "subtitle", subtitle,
+                           "path", match->path,
+                           "line", match->line,
+                           "line-offset", match->line_offset,
+                           NULL);
+
+      ide_search_context_add_result (context, provider, IDE_SEARCH_RESULT (item));
+    }
+
+  ide_search_context_provider_completed (context, provider);
+}
+
+static void
+gb_text_search_provider_populate (IdeSearchProvider *provider,
+                                  IdeSearchContext  *context,
+                                  const gchar       *search_terms,
+                                  gsize              max_results,
+                                  GCancellable      *cancellable)
+{
+  GbTextSearchProvider *self = (GbTextSearchProvider *)provider;
+  Populate *populate;
+
+  g_assert (GB_IS_TEXT_SEARCH_PROVIDER (self));
+  g_assert (IDE_IS_SEARCH_CONTEXT (context));
+  g_assert (search_terms != NULL);
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  if (!self->loaded || strlen (search_terms) < MIN_QUERY_LENGTH)
+    {
+      ide_search_context_provider_completed (context, provider);
+      return;
+    }
+
+  populate = g_slice_new0 (Populate);
+  populate->self = g_object_ref (self);
+  populate->context = g_object_ref (context);
+
+  ide_text_index_search_async (self->index,
+                               search_terms,
+                               IDE_TEXT_INDEX_SEARCH_NONE,
+                               max_results,
+                               cancellable,
+                               gb_text_search_provider_search_cb,
+                               populate);
+}
+
+static GtkWidget *
+gb_text_search_provider_create_row (IdeSearchProvider *provider,
+                                    IdeSearchResult   *result)
+{
+  g_assert (IDE_IS_SEARCH_PROVIDER (provider));
+  g_assert (IDE_IS_SEARCH_RESULT (result));
+
+  return g_object_new (IDE_TYPE_OMNI_SEARCH_ROW,
+                       "icon-name", "edit-find-symbolic",
+                       "result", result,
+                       "visible", TRUE,
+                       NULL);
+}
+
+static void
+gb_text_search_provider_activate (IdeSearchProvider *provider,
+                                  GtkWidget         *row,
+                                  IdeSearchResult   *result)
+{
+  GbTextSearchResult *item = (GbTextSearchResult *)result;
+  GtkWidget *toplevel;
+
+  g_assert (IDE_IS_SEARCH_PROVIDER (provider));
+  g_assert (GTK_IS_WIDGET (row));
+  g_assert (GB_IS_TEXT_SEARCH_RESULT (item));
+
+  toplevel = gtk_widget_get_toplevel (row);
+
+  if (IDE_IS_WORKBENCH (toplevel))
+    {
+      g_autofree gchar *fragment = NULL;
+      g_autoptr(GFile) file = NULL;
+      g_autoptr(IdeUri) uri = NULL;
+      IdeContext *context;
+      IdeVcs *vcs;
+      GFile *workdir;
+
+      context = ide_workbench_get_context (IDE_WORKBENCH (toplevel));
+      vcs = ide_context_get_vcs (context);
+      workdir = ide_vcs_get_working_directory (vcs);
+      file = g_file_get_child (workdir, gb_text_search_result_get_path (item));
+
+      uri = ide_uri_new_from_file (file);
+      fragment = g_strdup_printf ("L%u_%u",
+                                  gb_text_search_result_get_line (item),
+                                  gb_text_search_result_get_line_offset (item));
+      ide_uri_set_fragment (uri, fragment);
+
+      ide_workbench_open_uri_async (IDE_WORKBENCH (toplevel), uri, NULL, NULL, NULL, NULL);
+    }
+}
+
+static void
+gb_text_search_provider_buffer_saved (GbTextSearchProvider *self,
+                                      IdeBuffer            *buffer,
+                                      IdeBufferManager     *buffer_manager)
+{
+  IdeFile *file;
+
+  g_assert (GB_IS_TEXT_SEARCH_PROVIDER (self));
+  g_assert (IDE_IS_BUFFER (buffer));
+  g_assert (IDE_IS_BUFFER_MANAGER (buffer_manager));
+
+  file = ide_buffer_get_file (buffer);
+
+  if (!ide_file_get_is_temporary (file))
+    ide_text_index_update_file (self->index, ide_file_get_file (file));
+}
+
+static void
+gb_text_search_provider_load_cb (GObject      *object,
+                                 GAsyncResult *result,
+                                 gpointer      user_data)
+{
+  IdeTextIndex *index = (IdeTextIndex *)object;
+  g_autoptr(GbTextSearchProvider) self = user_data;
+  g_autoptr(GError) error = NULL;
+  IdeBufferManager *buffer_manager;
+  IdeContext *context;
+
+  g_assert (IDE_IS_TEXT_INDEX (index));
+  g_assert (GB_IS_TEXT_SEARCH_PROVIDER (self));
+
+  if (!ide_text_index_load_finish (index, result, &error))
+    {
+      g_warning ("%s", error->message);
+      return;
+    }
+
+  self->loaded = TRUE;
+
+  /*
+   * The index monitors directories itself, but saves are the common case
+   * and the monitors may not cover every directory of a large project.
+   */
+  context = ide_object_get_context (IDE_OBJECT (self));
+  buffer_manager = ide_context_get_buffer_manager (context);
+
+  g_signal_connect_object (buffer_manager,
+                           "buffer-saved",
+                           G_CALLBACK (gb_text_search_provider_buffer_saved),
+                           self,
+                           G_CONNECT_SWAPPED);
+}
+
+static void
+gb_text_search_provider_constructed (GObject *object)
+{
+  GbTextSearchProvider *self = (GbTextSearchProvider *)object;
+  IdeContext *context;
+  IdeVcs *vcs;
+  GFile *workdir;
+
+  G_OBJECT_CLASS (gb_text_search_provider_parent_class)->constructed (object);
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+  vcs = ide_context_get_vcs (context);
+  workdir = ide_vcs_get_working_directory (vcs);
+
+  self->index = ide_text_index_new (workdir, vcs);
+
+  ide_text_index_load_async (self->index,
+                             NULL,
+                             gb_text_search_provider_load_cb,
+                             g_object_ref (self));
+}
+
+static void
+gb_text_search_provider_finalize (GObject *object)
+{
+  GbTextSearchProvider *self = (GbTextSearchProvider *)object;
+
+  g_clear_object (&self->index);
+
+  G_OBJECT_CLASS (gb_text_search_provider_parent_class)->finalize (object);
+}
+
+static void
+gb_text_search_provider_class_init (GbTextSearchProviderClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->constructed = gb_text_search_provider_constructed;
+  object_class->finalize = gb_text_search_provider_finalize;
+}
+
+static void
+gb_text_search_provider_init (GbTextSearchProvider *self)
+{
+}
+
+static void
+search_provider_iface_init (IdeSearchProviderInterface *iface)
+{
+  iface->populate = gb_text_search_provider_populate;
+  iface->get_verb = gb_text_search_provider_get_verb;
+  iface->create_row = gb_text_search_provider_create_row;
+  iface->activate = gb_text_search_provider_activate;
+  iface->get_priority = gb_text_search_provider_get_priority;
+}
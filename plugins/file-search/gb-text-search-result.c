@@ -0,0 +1,165 @@
+/* gb-text-search-result.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gb-text-search-result.h"
+
+struct _GbTextSearchResult
+{
+  IdeSearchResult parent_instance;
+  gchar *path;
+  guint line;
+  guint line_offset;
+};
+
+G_DEFINE_TYPE (GbTextSearchResult, gb_text_search_result, IDE_TYPE_SEARCH_RESULT)
+
+enum {
+  PROP_0,
+  PROP_PATH,
+  PROP_LINE,
+  PROP_LINE_OFFSET,
+  LAST_PROP
+};
+
+static GParamSpec *properties [LAST_PROP];
+
+const gchar *
+gb_text_search_result_get_path (GbTextSearchResult *self)
+{
+  g_return_val_if_fail (GB_IS_TEXT_SEARCH_RESULT (self), NULL);
+
+  return self->path;
+}
+
+guint
+gb_text_search_result_get_line (GbTextSearchResult *self)
+{
+  g_return_val_if_fail (GB_IS_TEXT_SEARCH_RESULT (self), 0);
+
+  return self->line;
+}
+
+guint
+gb_text_search_result_get_line_offset (GbTextSearchResult *self)
+{
+  g_return_val_if_fail (GB_IS_TEXT_SEARCH_RESULT (self), 0);
+
+  return self->line_offset;
+}
+
+static void
+gb_text_search_result_finalize (GObject *object)
+{
+  GbTextSearchResult *self = (GbTextSearchResult *)object;
+
+  g_free (self->path);
+
+  G_OBJECT_CLASS (gb_text_search_result_parent_class)->finalize (object);
+}
+
+static void
+gb_text_search_result_get_property (GObject    *object,
+                                    guint       prop_id,
+                                    GValue     *value,
+                                    GParamSpec *pspec)
+{
+  GbTextSearchResult *self = (GbTextSearchResult *)object;
+
+  switch (prop_id)
+    {
+    case PROP_PATH:
+      g_value_set_string (value, self->path);
+      break;
+
+    case PROP_LINE:
+      g_value_set_uint (value, self->line);
+      break;
+
+    case PROP_LINE_OFFSET:
+      g_value_set_uint (value, self->line_offset);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gb_text_search_result_set_property (GObject      *object,
+                                    guint         prop_id,
+                                    const GValue *value,
+                                    GParamSpec   *pspec)
+{
+  GbTextSearchResult *self = (GbTextSearchResult *)object;
+
+  switch (prop_id)
+    {
+    case PROP_PATH:
+      self->path = g_value_dup_string (value);
+      break;
+
+    case PROP_LINE:
+      self->line = g_value_get_uint (value);
+      break;
+
+    case PROP_LINE_OFFSET:
+      self->line_offset = g_value_get_uint (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gb_text_search_result_class_init (GbTextSearchResultClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gb_text_search_result_finalize;
+  object_class->get_property = gb_text_search_result_get_property;
+  object_class->set_property = gb_text_search_result_set_property;
+
+  properties [PROP_PATH] =
+    g_param_spec_string ("path",
+                         "Path",
+                         "The relative path to the file.",
+                         NULL,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_LINE] =
+    g_param_spec_uint ("line",
+                       "Line",
+                       "The line of the match, starting from zero.",
+                       0, G_MAXUINT, 0,
+                       (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_LINE_OFFSET] =
+    g_param_spec_uint ("line-offset",
+                       "Line Offset",
+                       "The character offset of the match within the line.",
+                       0, G_MAXUINT, 0,
+                       (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, LAST_PROP, properties);
+}
+
+static void
+gb_text_search_result_init (GbTextSearchResult *self)
+{
+}
@@ -48,57 +48,158 @@ sanitize_name (gchar *name)
     *tmp = '\0';
 }
 
+/*
+ * Parsing the metadata of every installed ref is the slow part of loading,
+ * so the result is kept in a key file beneath the user cache directory. It is
+ * only trusted while the change stamp of the installation matches the one it
+ * was written with; flatpak touches "$installation/.changed" whenever refs
+ * are installed, updated or removed.
+ */
+#define RUNTIME_CACHE_VERSION 1
+#define RUNTIME_CACHE_GROUP   "cache"
+
+static gchar *
+get_cache_path (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           "gnome-builder",
+                           "flatpak",
+                           "runtimes.ini",
+                           NULL);
+}
+
+static gchar *
+get_installation_stamp (void)
+{
+  static const gchar *names[] = { ".changed", "runtime" };
+  g_autofree gchar *path = NULL;
+  const gchar *user_dir;
+  GString *str;
+  guint i;
+
+  if ((user_dir = g_getenv ("FLATPAK_USER_DIR")) != NULL)
+    path = g_strdup (user_dir);
+  else
+    path = g_build_filename (g_get_user_data_dir (), "flatpak", NULL);
+
+  str = g_string_new (NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    {
+      g_autofree gchar *child_path = g_build_filename (path, names [i], NULL);
+      g_autoptr(GFile) file = g_file_new_for_path (child_path);
+      g_autoptr(GFileInfo) info = NULL;
+
+      info = g_file_query_info (file,
+                                G_FILE_ATTRIBUTE_TIME_MODIFIED","
+                                G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                G_FILE_QUERY_INFO_NONE,
+                                NULL,
+                                NULL);
+
+      if (info == NULL)
+        continue;
+
+      g_string_append_printf (str, "%s=%"G_GUINT64_FORMAT".%u;",
+                              names [i],
+                              g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED),
+                              g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC));
+    }
+
+  if (str->len == 0)
+    {
+      g_string_free (str, TRUE);
+      return NULL;
+    }
+
+  return g_string_free (str, FALSE);
+}
+
+static GKeyFile *
+load_cache (const gchar *path,
+            const gchar *stamp)
+{
+  g_autoptr(GKeyFile) key_file = NULL;
+  g_autofree gchar *cached_stamp = NULL;
+
+  if (stamp == NULL)
+    return NULL;
+
+  key_file = g_key_file_new ();
+
+  if (!g_key_file_load_from_file (key_file, path, G_KEY_FILE_NONE, NULL))
+    return NULL;
+
+  if (g_key_file_get_integer (key_file, RUNTIME_CACHE_GROUP, "version", NULL) != RUNTIME_CACHE_VERSION)
+    return NULL;
+
+  cached_stamp = g_key_file_get_string (key_file, RUNTIME_CACHE_GROUP, "stamp", NULL);
+
+  if (g_strcmp0 (cached_stamp, stamp) != 0)
+    return NULL;
+
+  return g_steal_pointer (&key_file);
+}
+
 static void
-gbp_flatpak_runtime_provider_load_worker (GTask        *task,
-                                          gpointer      source_object,
-                                          gpointer      task_data,
-                                          GCancellable *cancellable)
+save_cache (GKeyFile    *key_file,
+            const gchar *path,
+            const gchar *stamp)
 {
-  GbpFlatpakRuntimeProvider *self = source_object;
-  g_autofree gchar *host_type = NULL;
-  IdeContext *context;
-  GPtrArray *ret;
+  g_autofree gchar *dir = NULL;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (key_file != NULL);
+  g_assert (path != NULL);
+
+  if (stamp == NULL)
+    return;
+
+  g_key_file_set_integer (key_file, RUNTIME_CACHE_GROUP, "version", RUNTIME_CACHE_VERSION);
+  g_key_file_set_string (key_file, RUNTIME_CACHE_GROUP, "stamp", stamp);
+
+  dir = g_path_get_dirname (path);
+  g_mkdir_with_parents (dir, 0750);
+
+  if (!g_key_file_save_to_file (key_file, path, &error))
+    g_debug ("Failed to save flatpak runtime cache: %s", error->message);
+}
+
+static GKeyFile *
+gbp_flatpak_runtime_provider_query (GbpFlatpakRuntimeProvider  *self,
+                                    GCancellable               *cancellable,
+                                    GError                    **error)
+{
+  g_autoptr(GKeyFile) ret = NULL;
   GPtrArray *ar;
-  GError *error = NULL;
   guint i;
 
-  g_assert (G_IS_TASK (task));
   g_assert (GBP_IS_FLATPAK_RUNTIME_PROVIDER (self));
-  g_assert (IDE_IS_RUNTIME_MANAGER (self->manager));
-
-  context = ide_object_get_context (IDE_OBJECT (self->manager));
-  host_type = ide_get_system_arch ();
 
-  self->installation = flatpak_installation_new_user (cancellable, &error);
+  self->installation = flatpak_installation_new_user (cancellable, error);
 
   if (self->installation == NULL)
-    {
-      g_task_return_error (task, error);
-      return;
-    }
+    return NULL;
 
   ar = flatpak_installation_list_installed_refs_by_kind (self->installation,
                                                          FLATPAK_REF_KIND_RUNTIME,
                                                          cancellable,
-                                                         &error);
+                                                         error);
 
   if (ar == NULL)
-    {
-      g_task_return_error (task, error);
-      return;
-    }
+    return NULL;
 
-  ret = g_ptr_array_new_with_free_func (g_object_unref);
+  ret = g_key_file_new ();
 
   for (i = 0; i < ar->len; i++)
     {
       FlatpakInstalledRef *ref = g_ptr_array_index (ar, i);
-      g_autofree gchar *str = NULL;
       g_autofree gchar *id = NULL;
       g_autofree gchar *name = NULL;
       const gchar *arch;
       const gchar *branch;
       g_autoptr(GBytes) metadata = NULL;
+      g_autoptr(GError) local_error = NULL;
       g_autofree gchar *sdk = NULL;
       g_autoptr(GKeyFile) key_file = NULL;
       const gchar *metadata_data;
@@ -115,18 +216,12 @@ gbp_flatpak_runtime_provider_load_worker (GTask        *task,
 
       id = g_strdup_printf ("flatpak-app:%s/%s/%s", name, branch, arch);
 
-      if (g_strcmp0 (host_type, arch) == 0)
-        str = g_strdup_printf ("%s <b>%s</b>", name, branch);
-      else
-        str = g_strdup_printf ("%s <b>%s</b> <sup>%s</sup>", name, branch, arch);
-
       metadata = flatpak_installed_ref_load_metadata (FLATPAK_INSTALLED_REF (ref),
-                                                      cancellable, &error);
+                                                      cancellable, &local_error);
 
       if (metadata == NULL)
         {
-          g_warning ("%s", error->message);
-          g_clear_error (&error);
+          g_warning ("%s", local_error->message);
           continue;
         }
 
@@ -134,20 +229,14 @@ gbp_flatpak_runtime_provider_load_worker (GTask        *task,
 
       key_file = g_key_file_new ();
 
-      if (!g_key_file_load_from_data (key_file, metadata_data, metadata_len, G_KEY_FILE_NONE, &error))
+      if (!g_key_file_load_from_data (key_file, metadata_data, metadata_len, G_KEY_FILE_NONE, &local_error))
         {
           /*
            * If this is not really a runtime, but something like a locale, then
            * the metadata file will not exist.
            */
-          if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
-            {
-              g_clear_error (&error);
-              continue;
-            }
-
-          g_warning ("%s", error->message);
-          g_clear_error (&error);
+          if (!g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+            g_warning ("%s", local_error->message);
           continue;
         }
 
@@ -156,6 +245,89 @@ gbp_flatpak_runtime_provider_load_worker (GTask        *task,
 
       sanitize_name (sdk);
 
+      g_key_file_set_string (ret, id, "name", name);
+      g_key_file_set_string (ret, id, "arch", arch);
+      g_key_file_set_string (ret, id, "branch", branch);
+      g_key_file_set_string (ret, id, "sdk", sdk);
+    }
+
+  g_ptr_array_unref (ar);
+
+  return g_steal_pointer (&ret);
+}
+
+static void
+gbp_flatpak_runtime_provider_load_worker (GTask        *task,
+                                          gpointer      source_object,
+                                          gpointer      task_data,
+                                          GCancellable *cancellable)
+{
+  GbpFlatpakRuntimeProvider *self = source_object;
+  g_autofree gchar *host_type = NULL;
+  g_autofree gchar *cache_path = NULL;
+  g_autofree gchar *stamp = NULL;
+  g_autoptr(GKeyFile) key_file = NULL;
+  g_auto(GStrv) groups = NULL;
+  IdeContext *context;
+  GPtrArray *ret;
+  GError *error = NULL;
+  guint i;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (GBP_IS_FLATPAK_RUNTIME_PROVIDER (self));
+  g_assert (IDE_IS_RUNTIME_MANAGER (self->manager));
+
+  context = ide_object_get_context (IDE_OBJECT (self->manager));
+  host_type = ide_get_system_arch ();
+
+  /*
+   * Take the stamp before querying so that a change racing with the query
+   * invalidates what we are about to write.
+   */
+  stamp = get_installation_stamp ();
+  cache_path = get_cache_path ();
+
+  if (!(key_file = load_cache (cache_path, stamp)))
+    {
+      if (!(key_file = gbp_flatpak_runtime_provider_query (self, cancellable, &error)))
+        {
+          g_task_return_error (task, error);
+          return;
+        }
+
+      save_cache (key_file, cache_path, stamp);
+    }
+
+  gbp_flatpak_runtime_set_installation_stamp (stamp);
+
+  groups = g_key_file_get_groups (key_file, NULL);
+  ret = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (i = 0; groups [i] != NULL; i++)
+    {
+      const gchar *id = groups [i];
+      g_autofree gchar *name = NULL;
+      g_autofree gchar *arch = NULL;
+      g_autofree gchar *branch = NULL;
+      g_autofree gchar *sdk = NULL;
+      g_autofree gchar *str = NULL;
+
+      if (!g_str_has_prefix (id, "flatpak-app:"))
+        continue;
+
+      name = g_key_file_get_string (key_file, id, "name", NULL);
+      arch = g_key_file_get_string (key_file, id, "arch", NULL);
+      branch = g_key_file_get_string (key_file, id, "branch", NULL);
+      sdk = g_key_file_get_string (key_file, id, "sdk", NULL);
+
+      if (name == NULL || arch == NULL || branch == NULL || sdk == NULL)
+        continue;
+
+      if (g_strcmp0 (host_type, arch) == 0)
+        str = g_strdup_printf ("%s <b>%s</b>", name, branch);
+      else
+        str = g_strdup_printf ("%s <b>%s</b> <sup>%s</sup>", name, branch, arch);
+
       g_ptr_array_add (ret,
                        g_object_new (GBP_TYPE_FLATPAK_RUNTIME,
                                      "branch", branch,
@@ -167,8 +339,6 @@ gbp_flatpak_runtime_provider_load_worker (GTask        *task,
                                      NULL));
     }
 
-  g_ptr_array_unref (ar);
-
   g_task_return_pointer (task, ret, (GDestroyNotify)g_ptr_array_unref);
 }
 
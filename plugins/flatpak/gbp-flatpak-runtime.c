@@ -39,6 +39,15 @@ enum {
 
 static GParamSpec *properties [LAST_PROP];
 
+/*
+ * Answers to contains_program_in_path() are shared by every runtime with the
+ * same id so that reloading a project does not spawn "which" again. The table
+ * is flushed whenever the provider notices the installation has changed.
+ */
+G_LOCK_DEFINE_STATIC (programs);
+static GHashTable *programs;
+static gchar *programs_stamp;
+
 static gchar *
 get_build_directory (GbpFlatpakRuntime *self)
 {
@@ -64,21 +73,84 @@ gbp_flatpak_runtime_contains_program_in_path (IdeRuntime   *runtime,
                                           const gchar  *program,
                                           GCancellable *cancellable)
 {
+  GbpFlatpakRuntime *self = (GbpFlatpakRuntime *)runtime;
   g_autoptr(IdeSubprocessLauncher) launcher = NULL;
   g_autoptr(GSubprocess) subprocess = NULL;
+  g_autofree gchar *key = NULL;
+  gpointer value;
+  gboolean ret;
 
-  g_assert (IDE_IS_RUNTIME (runtime));
+  g_assert (GBP_IS_FLATPAK_RUNTIME (self));
   g_assert (program != NULL);
   g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
 
+  key = g_strdup_printf ("%s\n%s", ide_runtime_get_id (runtime), program);
+
+  G_LOCK (programs);
+  if (programs != NULL && g_hash_table_lookup_extended (programs, key, NULL, &value))
+    {
+      G_UNLOCK (programs);
+      return GPOINTER_TO_INT (value);
+    }
+  G_UNLOCK (programs);
+
   launcher = ide_runtime_create_launcher (runtime, 0);
 
   ide_subprocess_launcher_push_argv (launcher, "which");
   ide_subprocess_launcher_push_argv (launcher, program);
 
-  subprocess = ide_subprocess_launcher_spawn_sync (launcher, cancellable, NULL);
+  if (!(subprocess = ide_subprocess_launcher_spawn_sync (launcher, cancellable, NULL)))
+    return FALSE;
+
+  ret = g_subprocess_wait_check (subprocess, cancellable, NULL);
+
+  if (g_cancellable_is_cancelled (cancellable))
+    return ret;
+
+  /*
+   * "which" runs inside the build directory, so a failure before the
+   * prebuild step has created it says nothing about the SDK.
+   */
+  if (!ret)
+    {
+      g_autofree gchar *build_path = get_build_directory (self);
+
+      if (!g_file_test (build_path, G_FILE_TEST_IS_DIR))
+        return FALSE;
+    }
+
+  G_LOCK (programs);
+  if (programs == NULL)
+    programs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_hash_table_insert (programs, g_steal_pointer (&key), GINT_TO_POINTER (ret));
+  G_UNLOCK (programs);
+
+  return ret;
+}
+
+/**
+ * gbp_flatpak_runtime_set_installation_stamp:
+ * @stamp: (nullable): the change stamp of the flatpak installation
+ *
+ * Drops the remembered program lookups if @stamp differs from the one they
+ * were collected under. A %NULL stamp means the installation could not be
+ * checked, so nothing remembered is trusted.
+ */
+void
+gbp_flatpak_runtime_set_installation_stamp (const gchar *stamp)
+{
+  G_LOCK (programs);
+
+  if (stamp == NULL || g_strcmp0 (stamp, programs_stamp) != 0)
+    {
+      g_free (programs_stamp);
+      programs_stamp = g_strdup (stamp);
+
+      if (programs != NULL)
+        g_hash_table_remove_all (programs);
+    }
 
-  return (subprocess != NULL) && g_subprocess_wait_check (subprocess, cancellable, NULL);
+  G_UNLOCK (programs);
 }
 
 static void
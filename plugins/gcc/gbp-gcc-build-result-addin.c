@@ -30,16 +30,48 @@
   "(?<level>[\\w\\s]+): "            \
   "(?<message>.*)"
 
+/*
+ * Build output is collected on the main thread and handed to a worker in
+ * chunks of at least CHUNK_SIZE bytes, or after FLUSH_DELAY_MSEC of quiet,
+ * whichever comes first. Only one chunk is parsed at a time so that the
+ * "Entering directory" tracking sees the lines in order.
+ */
+#define CHUNK_SIZE       (64 * 1024)
+#define FLUSH_DELAY_MSEC 100
+
+typedef struct
+{
+  IdeContext     *context;
+  IdeBuildResult *result;
+  GFile          *workdir;
+  GString        *chunk;
+  gchar          *current_dir;
+  gchar          *top_dir;
+} ParseChunk;
+
 struct _GbpGccBuildResultAddin
 {
   IdeObject       parent_instance;
 
   EggSignalGroup *signals;
+  GString        *pending;
   gchar          *current_dir;
   gchar          *top_dir;
+
+  /*
+   * Output left over when we were unloaded while a chunk was in flight.
+   * It is parsed once that chunk has given us the directory state.
+   */
+  ParseChunk     *tail;
+
+  guint           flush_handler;
+  guint           in_flight : 1;
 };
 
 static void build_result_addin_iface_init (IdeBuildResultAddinInterface *iface);
+static void gbp_gcc_build_result_addin_flush (GbpGccBuildResultAddin *self);
+static void gbp_gcc_build_result_addin_push  (GbpGccBuildResultAddin *self,
+                                              ParseChunk             *chunk);
 
 G_DEFINE_TYPE_EXTENDED (GbpGccBuildResultAddin, gbp_gcc_build_result_addin, IDE_TYPE_OBJECT, 0,
                         G_IMPLEMENT_INTERFACE (IDE_TYPE_BUILD_RESULT_ADDIN,
@@ -47,6 +79,20 @@ G_DEFINE_TYPE_EXTENDED (GbpGccBuildResultAddin, gbp_gcc_build_result_addin, IDE_
 
 static GRegex *errfmt;
 
+static void
+parse_chunk_free (gpointer data)
+{
+  ParseChunk *chunk = data;
+
+  g_clear_object (&chunk->context);
+  g_clear_object (&chunk->result);
+  g_clear_object (&chunk->workdir);
+  g_string_free (chunk->chunk, TRUE);
+  g_free (chunk->current_dir);
+  g_free (chunk->top_dir);
+  g_slice_free (ParseChunk, chunk);
+}
+
 static IdeDiagnosticSeverity
 parse_severity (const gchar *str)
 {
@@ -78,9 +124,50 @@ parse_severity (const gchar *str)
   return IDE_DIAGNOSTIC_WARNING;
 }
 
+/*
+ * Nearly all build output is compiler command lines and progress messages.
+ * A line can only match errfmt if one of the levels understood by
+ * parse_severity() is directly followed by ':', so look for that before
+ * paying for the regex.
+ */
+static gboolean
+maybe_diagnostic (const gchar *line,
+                  gsize        len)
+{
+  static const struct {
+    const gchar *str;
+    gsize        len;
+  } levels[] = {
+    { "error", 5 },
+    { "warning", 7 },
+    { "note", 4 },
+    { "deprecated", 10 },
+    { "ignored", 7 },
+  };
+  const gchar *end = line + len;
+  const gchar *iter;
+
+  for (iter = memchr (line, ':', len); iter != NULL; iter = memchr (iter, ':', end - iter))
+    {
+      gsize offset = iter - line;
+      guint i;
+
+      for (i = 0; i < G_N_ELEMENTS (levels); i++)
+        {
+          if (offset >= levels [i].len &&
+              g_ascii_strncasecmp (iter - levels [i].len, levels [i].str, levels [i].len) == 0)
+            return TRUE;
+        }
+
+      iter++;
+    }
+
+  return FALSE;
+}
+
 static IdeDiagnostic *
-create_diagnostic (GbpGccBuildResultAddin *self,
-                   GMatchInfo             *match_info)
+create_diagnostic (ParseChunk *chunk,
+                   GMatchInfo *match_info)
 {
   g_autofree gchar *filename = NULL;
   g_autofree gchar *line = NULL;
@@ -90,14 +177,13 @@ create_diagnostic (GbpGccBuildResultAddin *self,
   g_autoptr(IdeFile) file = NULL;
   g_autoptr(IdeSourceLocation) location = NULL;
   IdeDiagnostic *diagnostic;
-  IdeContext *context;
   struct {
     gint64 line;
     gint64 column;
     IdeDiagnosticSeverity severity;
   } parsed;
 
-  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+  g_assert (chunk != NULL);
   g_assert (match_info != NULL);
 
   filename = g_match_info_fetch_named (match_info, "filename");
@@ -118,16 +204,14 @@ create_diagnostic (GbpGccBuildResultAddin *self,
 
   parsed.severity = parse_severity (level);
 
-  context = ide_object_get_context (IDE_OBJECT (self));
-
-  if (!g_path_is_absolute (filename) && self->current_dir != NULL)
+  if (!g_path_is_absolute (filename) && chunk->current_dir != NULL)
     {
-      const gchar *basedir = self->current_dir;
+      const gchar *basedir = chunk->current_dir;
       gchar *path;
 
-      if (g_str_has_prefix (basedir, self->top_dir))
+      if (g_str_has_prefix (basedir, chunk->top_dir))
         {
-          basedir += strlen (self->top_dir);
+          basedir += strlen (chunk->top_dir);
           if (*basedir == '/')
             basedir++;
         }
@@ -140,21 +224,16 @@ create_diagnostic (GbpGccBuildResultAddin *self,
   if (!g_path_is_absolute (filename))
     {
       g_autoptr(GFile) child = NULL;
-      IdeVcs *vcs;
-      GFile *workdir;
       gchar *path;
 
-      vcs = ide_context_get_vcs (context);
-      workdir = ide_vcs_get_working_directory (vcs);
-
-      child = g_file_get_child (workdir, filename);
+      child = g_file_get_child (chunk->workdir, filename);
       path = g_file_get_path (child);
 
       g_free (filename);
       filename = path;
     }
 
-  file = ide_file_new_for_path (context, filename);
+  file = ide_file_new_for_path (chunk->context, filename);
   location = ide_source_location_new (file, parsed.line, parsed.column, 0);
   diagnostic = ide_diagnostic_new (parsed.severity, message, location);
 
@@ -162,62 +241,283 @@ create_diagnostic (GbpGccBuildResultAddin *self,
 }
 
 static void
-gbp_gcc_build_result_addin_log (GbpGccBuildResultAddin *self,
-                                IdeBuildResultLog       log,
-                                const gchar            *message,
-                                IdeBuildResult         *result)
+parse_chunk_line (ParseChunk *chunk,
+                  gchar      *line,
+                  gsize       len,
+                  GPtrArray  *diagnostics)
 {
-  GMatchInfo *match_info = NULL;
   const gchar *enterdir;
 
-  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
-  g_assert (IDE_IS_BUILD_RESULT (result));
+  g_assert (chunk != NULL);
+  g_assert (line != NULL);
+  g_assert (diagnostics != NULL);
 
 #define ENTERING_DIRECTORY_BEGIN "Entering directory '"
-#define ENTERING_DIRECTORY_END   "'\n"
+#define ENTERING_DIRECTORY_END   "'"
 
   /*
    * This expects LANG=C, which is defined in the autotools Builder.
    * Not the most ideal decoupling of logic, but we don't have a whole
    * lot to work with here.
    */
-  if (NULL != (enterdir = strstr (message, ENTERING_DIRECTORY_BEGIN)) &&
+  if (NULL != (enterdir = strstr (line, ENTERING_DIRECTORY_BEGIN)) &&
       g_str_has_suffix (enterdir, ENTERING_DIRECTORY_END))
     {
-      gssize len;
+      gssize dirlen;
 
       enterdir += IDE_LITERAL_LENGTH (ENTERING_DIRECTORY_BEGIN);
-      len = strlen (enterdir) - IDE_LITERAL_LENGTH (ENTERING_DIRECTORY_END);
+      dirlen = strlen (enterdir) - IDE_LITERAL_LENGTH (ENTERING_DIRECTORY_END);
 
-      if (len > 0)
+      if (dirlen > 0)
         {
-          g_free (self->current_dir);
-          self->current_dir = g_strndup (enterdir, len);
-          if (self->top_dir == NULL)
-            self->top_dir = g_strndup (enterdir, len);
+          g_free (chunk->current_dir);
+          chunk->current_dir = g_strndup (enterdir, dirlen);
+          if (chunk->top_dir == NULL)
+            chunk->top_dir = g_strndup (enterdir, dirlen);
         }
+
+      return;
     }
 
-  if (g_regex_match (errfmt, message, 0, &match_info))
+  if (maybe_diagnostic (line, len))
     {
-      IdeDiagnostic *diagnostic;
+      GMatchInfo *match_info = NULL;
 
-      if (NULL != (diagnostic = create_diagnostic (self, match_info)))
+      if (g_regex_match_full (errfmt, line, len, 0, 0, &match_info, NULL))
         {
-          ide_build_result_emit_diagnostic (result, diagnostic);
-          ide_diagnostic_unref (diagnostic);
+          IdeDiagnostic *diagnostic;
+
+          if (NULL != (diagnostic = create_diagnostic (chunk, match_info)))
+            g_ptr_array_add (diagnostics, diagnostic);
         }
-    }
 
-  g_match_info_free (match_info);
+      g_match_info_free (match_info);
+    }
 
 #undef ENTERING_DIRECTORY_BEGIN
 #undef ENTERING_DIRECTORY_END
 }
 
+static void
+parse_chunk_worker (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+  ParseChunk *chunk = task_data;
+  g_autoptr(GPtrArray) diagnostics = NULL;
+  IdeLineReader reader;
+  gchar *line;
+  gsize len;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (source_object));
+  g_assert (chunk != NULL);
+
+  diagnostics = g_ptr_array_new_with_free_func ((GDestroyNotify)ide_diagnostic_unref);
+
+  ide_line_reader_init (&reader, chunk->chunk->str, chunk->chunk->len);
+
+  while (NULL != (line = ide_line_reader_next (&reader, &len)))
+    {
+      /* We own the chunk, so terminate the line in place for GRegex. */
+      line [len] = '\0';
+      parse_chunk_line (chunk, line, len, diagnostics);
+    }
+
+  ide_build_result_emit_diagnostics (chunk->result, diagnostics);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+parse_chunk_cb (GObject      *object,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+  GbpGccBuildResultAddin *self = (GbpGccBuildResultAddin *)object;
+  ParseChunk *chunk;
+
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+  g_assert (G_IS_TASK (result));
+
+  chunk = g_task_get_task_data (G_TASK (result));
+
+  self->in_flight = FALSE;
+
+  /* Output left over from unloading continues where this chunk stopped. */
+  if (self->tail != NULL)
+    {
+      ParseChunk *tail = g_steal_pointer (&self->tail);
+
+      tail->current_dir = g_steal_pointer (&chunk->current_dir);
+      tail->top_dir = g_steal_pointer (&chunk->top_dir);
+      gbp_gcc_build_result_addin_push (self, tail);
+      return;
+    }
+
+  /* Keep the directory state unless we were unloaded in the mean time. */
+  if (chunk->result == egg_signal_group_get_target (self->signals))
+    {
+      g_free (self->current_dir);
+      g_free (self->top_dir);
+      self->current_dir = g_steal_pointer (&chunk->current_dir);
+      self->top_dir = g_steal_pointer (&chunk->top_dir);
+    }
+
+  if (self->pending->len >= CHUNK_SIZE)
+    gbp_gcc_build_result_addin_flush (self);
+}
+
+static gboolean
+gbp_gcc_build_result_addin_flush_timeout (gpointer user_data)
+{
+  GbpGccBuildResultAddin *self = user_data;
+
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+
+  self->flush_handler = 0;
+
+  if (self->in_flight)
+    {
+      /* Try again once the current chunk has been parsed. */
+      self->flush_handler = g_timeout_add (FLUSH_DELAY_MSEC,
+                                           gbp_gcc_build_result_addin_flush_timeout,
+                                           self);
+      return G_SOURCE_REMOVE;
+    }
+
+  gbp_gcc_build_result_addin_flush (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * Moves the pending output into a new chunk for @result. The directory
+ * state is left to the caller.
+ */
+static ParseChunk *
+gbp_gcc_build_result_addin_take_pending (GbpGccBuildResultAddin *self,
+                                         IdeBuildResult         *result)
+{
+  IdeContext *context;
+  ParseChunk *chunk;
+  IdeVcs *vcs;
+
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+  g_assert (IDE_IS_BUILD_RESULT (result));
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+  vcs = ide_context_get_vcs (context);
+
+  chunk = g_slice_new0 (ParseChunk);
+  chunk->context = g_object_ref (context);
+  chunk->result = g_object_ref (result);
+  chunk->workdir = g_object_ref (ide_vcs_get_working_directory (vcs));
+  chunk->chunk = self->pending;
+
+  self->pending = g_string_sized_new (CHUNK_SIZE);
+
+  return chunk;
+}
+
+static void
+gbp_gcc_build_result_addin_push (GbpGccBuildResultAddin *self,
+                                 ParseChunk             *chunk)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+  g_assert (chunk != NULL);
+  g_assert (!self->in_flight);
+
+  self->in_flight = TRUE;
+
+  task = g_task_new (self, NULL, parse_chunk_cb, NULL);
+  g_task_set_source_tag (task, gbp_gcc_build_result_addin_flush);
+  g_task_set_task_data (task, chunk, parse_chunk_free);
+
+  ide_thread_pool_push_task (IDE_THREAD_POOL_COMPILER, task, parse_chunk_worker);
+}
+
+static void
+gbp_gcc_build_result_addin_flush (GbpGccBuildResultAddin *self)
+{
+  IdeBuildResult *result;
+  ParseChunk *chunk;
+
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+
+  if (self->in_flight || self->pending->len == 0)
+    return;
+
+  if (NULL == (result = egg_signal_group_get_target (self->signals)))
+    return;
+
+  if (self->flush_handler != 0)
+    {
+      g_source_remove (self->flush_handler);
+      self->flush_handler = 0;
+    }
+
+  chunk = gbp_gcc_build_result_addin_take_pending (self, result);
+  chunk->current_dir = g_steal_pointer (&self->current_dir);
+  chunk->top_dir = g_steal_pointer (&self->top_dir);
+
+  gbp_gcc_build_result_addin_push (self, chunk);
+}
+
+static void
+gbp_gcc_build_result_addin_log (GbpGccBuildResultAddin *self,
+                                IdeBuildResultLog       log,
+                                const gchar            *message,
+                                IdeBuildResult         *result)
+{
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+  g_assert (IDE_IS_BUILD_RESULT (result));
+
+  /*
+   * Do as little as possible here, this is called on the main thread for
+   * every line the build produces. Messages are already newline terminated.
+   */
+  g_string_append (self->pending, message);
+
+  if (self->pending->len >= CHUNK_SIZE)
+    gbp_gcc_build_result_addin_flush (self);
+  else if (self->flush_handler == 0)
+    self->flush_handler = g_timeout_add (FLUSH_DELAY_MSEC,
+                                         gbp_gcc_build_result_addin_flush_timeout,
+                                         self);
+}
+
+static void
+gbp_gcc_build_result_addin_finalize (GObject *object)
+{
+  GbpGccBuildResultAddin *self = (GbpGccBuildResultAddin *)object;
+
+  if (self->flush_handler != 0)
+    {
+      g_source_remove (self->flush_handler);
+      self->flush_handler = 0;
+    }
+
+  g_assert (self->tail == NULL);
+
+  g_clear_object (&self->signals);
+  g_string_free (self->pending, TRUE);
+  g_clear_pointer (&self->current_dir, g_free);
+  g_clear_pointer (&self->top_dir, g_free);
+
+  G_OBJECT_CLASS (gbp_gcc_build_result_addin_parent_class)->finalize (object);
+}
+
 static void
 gbp_gcc_build_result_addin_class_init (GbpGccBuildResultAddinClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_gcc_build_result_addin_finalize;
+
   errfmt = g_regex_new (ERROR_FORMAT_REGEX, G_REGEX_OPTIMIZE | G_REGEX_CASELESS, 0, NULL);
   g_assert (errfmt != NULL);
 }
@@ -225,6 +525,8 @@ gbp_gcc_build_result_addin_class_init (GbpGccBuildResultAddinClass *klass)
 static void
 gbp_gcc_build_result_addin_init (GbpGccBuildResultAddin *self)
 {
+  self->pending = g_string_sized_new (CHUNK_SIZE);
+
   self->signals = egg_signal_group_new (IDE_TYPE_BUILD_RESULT);
 
   egg_signal_group_connect_object (self->signals,
@@ -249,7 +551,27 @@ gbp_gcc_build_result_addin_unload (IdeBuildResultAddin *addin,
 {
   GbpGccBuildResultAddin *self = (GbpGccBuildResultAddin *)addin;
 
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+  g_assert (IDE_IS_BUILD_RESULT (result));
+
+  /*
+   * Parse whatever is left. If a chunk is still being processed, the
+   * rest has to wait for its directory state, so queue it behind it.
+   * The in-flight task keeps us alive until then.
+   */
+  if (!self->in_flight)
+    gbp_gcc_build_result_addin_flush (self);
+  else if (self->pending->len > 0 && self->tail == NULL)
+    self->tail = gbp_gcc_build_result_addin_take_pending (self, result);
+
+  if (self->flush_handler != 0)
+    {
+      g_source_remove (self->flush_handler);
+      self->flush_handler = 0;
+    }
+
   egg_signal_group_set_target (self->signals, NULL);
+  g_string_truncate (self->pending, 0);
   g_clear_pointer (&self->current_dir, g_free);
   g_clear_pointer (&self->top_dir, g_free);
 }
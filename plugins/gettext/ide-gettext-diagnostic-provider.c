@@ -28,7 +28,9 @@
 #include "ide-diagnostics.h"
 #include "ide-file.h"
 #include "ide-gettext-diagnostic-provider.h"
+#include "ide-gettext-scanner.h"
 #include "ide-source-location.h"
+#include "ide-thread-pool.h"
 #include "ide-unsaved-file.h"
 #include "ide-unsaved-files.h"
 
@@ -137,6 +139,26 @@ typedef struct
   IdeUnsavedFile *unsaved_file;
 } TranslationUnit;
 
+typedef struct
+{
+  IdeFile *file;
+  GBytes  *content;
+  gchar   *language_id;
+  gint64   sequence;
+} ScanRequest;
+
+static void
+scan_request_free (ScanRequest *request)
+{
+  if (request != NULL)
+    {
+      g_clear_object (&request->file);
+      g_clear_pointer (&request->content, g_bytes_unref);
+      g_clear_pointer (&request->language_id, g_free);
+      g_slice_free (ScanRequest, request);
+    }
+}
+
 static void
 translation_unit_free (TranslationUnit *unit)
 {
@@ -154,21 +176,11 @@ get_unsaved_file (IdeGettextDiagnosticProvider *self,
 {
   IdeUnsavedFiles *unsaved_files;
   IdeContext *context;
-  g_autoptr(GPtrArray) array = NULL;
-  guint index;
 
   context = ide_object_get_context (IDE_OBJECT (self));
   unsaved_files = ide_context_get_unsaved_files (context);
-  array = ide_unsaved_files_to_array (unsaved_files);
-
-  for (index = 0; index < array->len; index++)
-    {
-      IdeUnsavedFile *unsaved_file = g_ptr_array_index (array, index);
-      if (g_file_equal (ide_unsaved_file_get_file (unsaved_file), ide_file_get_file (file)))
-        return ide_unsaved_file_ref (unsaved_file);
-    }
 
-  return NULL;
+  return ide_unsaved_files_get_unsaved_file (unsaved_files, ide_file_get_file (file));
 }
 
 static void
@@ -212,7 +224,8 @@ ide_gettext_diagnostic_provider_diagnose_async (IdeDiagnosticProvider *provider,
   unsaved_file = get_unsaved_file (self, file);
 
   if ((cached = egg_task_cache_peek (self->diagnostics_cache, file)) &&
-      (cached->sequence >= ide_unsaved_file_get_sequence (unsaved_file)))
+      (unsaved_file == NULL ||
+       cached->sequence >= ide_unsaved_file_get_sequence (unsaved_file)))
     {
       g_task_return_pointer (task, g_object_ref (cached), g_object_unref);
       return;
@@ -376,6 +389,50 @@ id_to_xgettext_language (const gchar *id)
   return NULL;
 }
 
+static void
+scan_worker (GTask        *task,
+             gpointer      source_object,
+             gpointer      task_data,
+             GCancellable *cancellable)
+{
+  ScanRequest *request = task_data;
+  g_autoptr(IdeDiagnostics) local_diags = NULL;
+  g_autofree gchar *contents = NULL;
+  IdeGettextDiagnostics *diags;
+  const gchar *text;
+  GPtrArray *array;
+  gsize length;
+  GError *error = NULL;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (request != NULL);
+  g_assert (IDE_IS_FILE (request->file));
+
+  if (request->content != NULL)
+    {
+      text = g_bytes_get_data (request->content, &length);
+    }
+  else
+    {
+      if (!g_file_load_contents (ide_file_get_file (request->file),
+                                 cancellable, &contents, &length, NULL, &error))
+        {
+          g_task_return_error (task, error);
+          return;
+        }
+
+      text = contents;
+    }
+
+  array = ide_gettext_scanner_scan (request->file, request->language_id, text, length);
+  local_diags = ide_diagnostics_new (array);
+  diags = g_object_new (IDE_TYPE_GETTEXT_DIAGNOSTICS,
+                        "diagnostics", local_diags,
+                        "sequence", request->sequence,
+                        NULL);
+  g_task_return_pointer (task, diags, g_object_unref);
+}
+
 static void
 populate_cache (EggTaskCache  *cache,
                 gconstpointer  key,
@@ -391,6 +448,31 @@ populate_cache (EggTaskCache  *cache,
   TranslationUnit *unit;
   GError *error = NULL;
 
+  /*
+   * For languages with C-like string literals we check the buffer contents
+   * in process. That avoids writing the buffer to disk and spawning
+   * xgettext every time the user pauses typing.
+   */
+  if (ide_gettext_scanner_supports_language (language_id))
+    {
+      ScanRequest *request;
+
+      request = g_slice_new0 (ScanRequest);
+      request->file = g_object_ref (file);
+      request->language_id = g_strdup (language_id);
+
+      if (unsaved_file != NULL)
+        {
+          request->content = g_bytes_ref (ide_unsaved_file_get_content (unsaved_file));
+          request->sequence = ide_unsaved_file_get_sequence (unsaved_file);
+        }
+
+      g_task_set_task_data (task, request, (GDestroyNotify)scan_request_free);
+      ide_thread_pool_push_task (IDE_THREAD_POOL_COMPILER, task, scan_worker);
+
+      return;
+    }
+
   if (!ide_unsaved_file_persist (unsaved_file,
                                  g_task_get_cancellable (task),
                                  &error))
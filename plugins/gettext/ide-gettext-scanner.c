@@ -0,0 +1,413 @@
+/* ide-gettext-scanner.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-gettext-scanner"
+
+#include <glib/gi18n.h>
+#include <string.h>
+
+#include "ide-diagnostic.h"
+#include "ide-gettext-scanner.h"
+#include "ide-source-location.h"
+#include "ide-source-range.h"
+
+/*
+ * This is a small lexer for languages with C-like string literals. It finds
+ * calls to the gettext keywords and performs the same checks we used to
+ * request from xgettext with --check=ellipsis-unicode, --check=quote-unicode
+ * and --check=space-ellipsis. It runs against the buffer contents in memory,
+ * so diagnosing does not need to persist the buffer or spawn a process.
+ */
+
+#define ARG(n) (1 << ((n) - 1))
+
+typedef struct
+{
+  const gchar *name;
+  guint        args;
+} Keyword;
+
+static const Keyword keywords[] = {
+  { "C_",            ARG (2) },
+  { "NC_",           ARG (2) },
+  { "N_",            ARG (1) },
+  { "Q_",            ARG (1) },
+  { "_",             ARG (1) },
+  { "dcgettext",     ARG (2) },
+  { "dgettext",      ARG (2) },
+  { "dngettext",     ARG (2) | ARG (3) },
+  { "dpgettext",     ARG (3) },
+  { "g_dgettext",    ARG (2) },
+  { "g_dngettext",   ARG (2) | ARG (3) },
+  { "g_dpgettext2",  ARG (3) },
+  { "gettext",       ARG (1) },
+  { "gettext_noop",  ARG (1) },
+  { "ngettext",      ARG (1) | ARG (2) },
+  { "pgettext",      ARG (2) },
+};
+
+typedef struct
+{
+  IdeFile     *file;
+  GPtrArray   *diagnostics;
+  const gchar *pos;
+  const gchar *end;
+  const gchar *line_start;
+  guint        line;
+  /* JavaScript allows '' for strings, C and Vala use it for characters */
+  guint        single_quote_strings : 1;
+} Scanner;
+
+gboolean
+ide_gettext_scanner_supports_language (const gchar *language_id)
+{
+  static const gchar *supported[] = { "c", "chdr", "cpp", "js", "objc", "vala" };
+  guint i;
+
+  if (language_id == NULL)
+    return FALSE;
+
+  for (i = 0; i < G_N_ELEMENTS (supported); i++)
+    {
+      if (strcmp (language_id, supported [i]) == 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static const Keyword *
+find_keyword (const gchar *name,
+              gsize        len)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (keywords); i++)
+    {
+      if (strncmp (keywords [i].name, name, len) == 0 && keywords [i].name [len] == '\0')
+        return &keywords [i];
+    }
+
+  return NULL;
+}
+
+static inline void
+scanner_advance (Scanner *s)
+{
+  if (*s->pos == '\n')
+    {
+      s->line++;
+      s->line_start = s->pos + 1;
+    }
+
+  s->pos++;
+}
+
+static IdeSourceLocation *
+scanner_location (Scanner     *s,
+                  const gchar *pos,
+                  guint        line,
+                  const gchar *line_start)
+{
+  return ide_source_location_new (s->file,
+                                  line,
+                                  g_utf8_strlen (line_start, pos - line_start),
+                                  0);
+}
+
+static void
+skip_space_and_comments (Scanner *s)
+{
+  while (s->pos < s->end)
+    {
+      if (g_ascii_isspace (*s->pos))
+        {
+          scanner_advance (s);
+        }
+      else if (s->pos + 1 < s->end && s->pos [0] == '/' && s->pos [1] == '/')
+        {
+          while (s->pos < s->end && *s->pos != '\n')
+            scanner_advance (s);
+        }
+      else if (s->pos + 1 < s->end && s->pos [0] == '/' && s->pos [1] == '*')
+        {
+          s->pos += 2;
+
+          while (s->pos < s->end &&
+                 !(s->pos [0] == '*' && s->pos + 1 < s->end && s->pos [1] == '/'))
+            scanner_advance (s);
+
+          s->pos = MIN (s->pos + 2, s->end);
+        }
+      else
+        break;
+    }
+}
+
+static inline gboolean
+is_quote (Scanner *s)
+{
+  return *s->pos == '"' || (*s->pos == '\'' && s->single_quote_strings);
+}
+
+/*
+ * Reads the literal at the current position, which must be a quote, and
+ * appends the unescaped contents to @str if it is not %NULL.
+ */
+static void
+read_literal (Scanner *s,
+              GString *str)
+{
+  gchar quote = *s->pos;
+
+  scanner_advance (s);
+
+  while (s->pos < s->end && *s->pos != quote && *s->pos != '\n')
+    {
+      gchar ch = *s->pos;
+
+      if (ch == '\\' && s->pos + 1 < s->end)
+        {
+          scanner_advance (s);
+
+          switch (*s->pos)
+            {
+            case 'n': ch = '\n'; break;
+            case 't': ch = '\t'; break;
+            case 'r': ch = '\r'; break;
+            default:  ch = *s->pos; break;
+            }
+        }
+
+      if (str != NULL)
+        g_string_append_c (str, ch);
+
+      scanner_advance (s);
+    }
+
+  if (s->pos < s->end && *s->pos == quote)
+    scanner_advance (s);
+}
+
+static gboolean
+find_quoted_pair (const gchar *str,
+                  gchar        quote)
+{
+  const gchar *begin;
+
+  /*
+   * Apostrophes are fine, we are looking for a quote that opens at a word
+   * boundary and is closed at a later word boundary.
+   */
+  for (begin = strchr (str, quote); begin != NULL; begin = strchr (begin + 1, quote))
+    {
+      const gchar *end;
+
+      if (begin != str && g_ascii_isalnum (begin [-1]))
+        continue;
+
+      for (end = strchr (begin + 1, quote); end != NULL; end = strchr (end + 1, quote))
+        {
+          if (!g_ascii_isalnum (end [1]))
+            return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+static gboolean
+has_space_before_ellipsis (const gchar *str)
+{
+  const gchar *iter;
+
+  for (iter = str; *iter; iter++)
+    {
+      if (g_ascii_isspace (iter [0]) &&
+          (strncmp (&iter [1], "...", 3) == 0 || strncmp (&iter [1], "\xe2\x80\xa6", 3) == 0))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+check_message (Scanner           *s,
+               const gchar       *message,
+               IdeSourceLocation *begin,
+               IdeSourceLocation *end)
+{
+  const gchar *warnings [4];
+  guint n_warnings = 0;
+  guint i;
+
+  if (strstr (message, "...") != NULL)
+    warnings [n_warnings++] = _("ASCII ellipsis ('...') instead of Unicode");
+
+  if (has_space_before_ellipsis (message))
+    warnings [n_warnings++] = _("space before ellipsis found in user visible strings");
+
+  if (find_quoted_pair (message, '"'))
+    warnings [n_warnings++] = _("ASCII double quote used instead of Unicode");
+
+  if (find_quoted_pair (message, '\''))
+    warnings [n_warnings++] = _("ASCII single quote used instead of Unicode");
+
+  for (i = 0; i < n_warnings; i++)
+    {
+      IdeDiagnostic *diag;
+
+      diag = ide_diagnostic_new (IDE_DIAGNOSTIC_WARNING, warnings [i], begin);
+      ide_diagnostic_take_range (diag, ide_source_range_new (begin, end));
+      g_ptr_array_add (s->diagnostics, diag);
+    }
+}
+
+static void
+scan_call (Scanner       *s,
+           const Keyword *keyword)
+{
+  guint arg;
+
+  skip_space_and_comments (s);
+
+  if (s->pos >= s->end || *s->pos != '(')
+    return;
+
+  scanner_advance (s);
+
+  for (arg = 1; s->pos < s->end; arg++)
+    {
+      guint depth = 0;
+
+      skip_space_and_comments (s);
+
+      if (s->pos < s->end && is_quote (s) && (keyword->args & ARG (arg)))
+        {
+          g_autoptr(IdeSourceLocation) begin = NULL;
+          g_autoptr(IdeSourceLocation) end = NULL;
+          g_autoptr(GString) message = g_string_new (NULL);
+
+          begin = scanner_location (s, s->pos, s->line, s->line_start);
+
+          /* Adjacent literals are concatenated */
+          while (s->pos < s->end && is_quote (s))
+            {
+              read_literal (s, message);
+              end = scanner_location (s, s->pos, s->line, s->line_start);
+              skip_space_and_comments (s);
+            }
+
+          check_message (s, message->str, begin, end);
+        }
+
+      /* Skip whatever remains of this argument */
+      while (s->pos < s->end)
+        {
+          if (*s->pos == '"' || *s->pos == '\'')
+            {
+              read_literal (s, NULL);
+              skip_space_and_comments (s);
+              continue;
+            }
+
+          if (*s->pos == '(')
+            depth++;
+          else if (*s->pos == ')')
+            {
+              if (depth == 0)
+                {
+                  scanner_advance (s);
+                  return;
+                }
+
+              depth--;
+            }
+          else if (*s->pos == ',' && depth == 0)
+            {
+              scanner_advance (s);
+              break;
+            }
+
+          scanner_advance (s);
+          skip_space_and_comments (s);
+        }
+    }
+}
+
+/**
+ * ide_gettext_scanner_scan:
+ * @file: The file to attach to the diagnostics.
+ * @language_id: A language supported by the scanner.
+ * @text: The contents of @file.
+ * @length: The length of @text in bytes.
+ *
+ * Scans @text for translatable strings that xgettext would warn about.
+ * This is safe to call from a thread.
+ *
+ * Returns: (transfer container) (element-type Ide.Diagnostic): An array of
+ *   diagnostics.
+ */
+GPtrArray *
+ide_gettext_scanner_scan (IdeFile     *file,
+                          const gchar *language_id,
+                          const gchar *text,
+                          gsize        length)
+{
+  Scanner s = { 0 };
+
+  g_return_val_if_fail (IDE_IS_FILE (file), NULL);
+  g_return_val_if_fail (text != NULL || length == 0, NULL);
+
+  s.file = file;
+  s.diagnostics = g_ptr_array_new_with_free_func ((GDestroyNotify)ide_diagnostic_unref);
+  s.pos = text;
+  s.end = text + length;
+  s.line_start = text;
+  s.single_quote_strings = (g_strcmp0 (language_id, "js") == 0);
+
+  while (s.pos < s.end)
+    {
+      skip_space_and_comments (&s);
+
+      if (s.pos >= s.end)
+        break;
+
+      if (*s.pos == '"' || *s.pos == '\'')
+        {
+          read_literal (&s, NULL);
+        }
+      else if (g_ascii_isalpha (*s.pos) || *s.pos == '_')
+        {
+          const gchar *begin = s.pos;
+          const Keyword *keyword;
+
+          while (s.pos < s.end && (g_ascii_isalnum (*s.pos) || *s.pos == '_'))
+            s.pos++;
+
+          if ((keyword = find_keyword (begin, s.pos - begin)))
+            scan_call (&s, keyword);
+        }
+      else
+        {
+          scanner_advance (&s);
+        }
+    }
+
+  return s.diagnostics;
+}
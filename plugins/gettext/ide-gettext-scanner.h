@@ -0,0 +1,34 @@
+/* ide-gettext-scanner.h
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_GETTEXT_SCANNER_H
+#define IDE_GETTEXT_SCANNER_H
+
+#include "ide-file.h"
+
+G_BEGIN_DECLS
+
+gboolean   ide_gettext_scanner_supports_language (const gchar *language_id);
+GPtrArray *ide_gettext_scanner_scan              (IdeFile     *file,
+                                                  const gchar *language_id,
+                                                  const gchar *text,
+                                                  gsize        length);
+
+G_END_DECLS
+
+#endif /* IDE_GETTEXT_SCANNER_H */
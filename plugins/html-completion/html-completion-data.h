@@ -0,0 +1,442 @@
+/* html-completion-data.h
+ *
+ * Copyright (C) 2014 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file contains the element, attribute and CSS property names used
+ * for completion. It is not a normal header; html-completion-gen.c
+ * includes it with HTML_ELEMENT(), HTML_ATTRIBUTE() and HTML_CSS_PROPERTY()
+ * defined and produces the sorted, read-only tables found in the generated
+ * html-completion-tables.h. Attributes of the element "*" apply to every
+ * element.
+ */
+
+/*
+ * TODO: We should determine what are valid attributes for given elements
+ *       and only provide those based upon the completion context.
+ */
+
+/*
+ * http://www.w3.org/TR/html-markup/elements.html
+ */
+
+HTML_ELEMENT ("a")
+HTML_ELEMENT ("abbr")
+HTML_ELEMENT ("acronym")
+HTML_ELEMENT ("address")
+HTML_ELEMENT ("applet")
+HTML_ELEMENT ("area")
+HTML_ELEMENT ("article")
+HTML_ELEMENT ("aside")
+HTML_ELEMENT ("audio")
+HTML_ELEMENT ("b")
+HTML_ELEMENT ("base")
+HTML_ELEMENT ("basefont")
+HTML_ELEMENT ("bdi")
+HTML_ELEMENT ("bdo")
+HTML_ELEMENT ("big")
+HTML_ELEMENT ("blockquote")
+HTML_ELEMENT ("body")
+HTML_ELEMENT ("br")
+HTML_ELEMENT ("button")
+HTML_ELEMENT ("canvas")
+HTML_ELEMENT ("caption")
+HTML_ELEMENT ("center")
+HTML_ELEMENT ("cite")
+HTML_ELEMENT ("code")
+HTML_ELEMENT ("col")
+HTML_ELEMENT ("colgroup")
+HTML_ELEMENT ("datalist")
+HTML_ELEMENT ("dd")
+HTML_ELEMENT ("del")
+HTML_ELEMENT ("details")
+HTML_ELEMENT ("dfn")
+HTML_ELEMENT ("dialog")
+HTML_ELEMENT ("dir")
+HTML_ELEMENT ("div")
+HTML_ELEMENT ("dl")
+HTML_ELEMENT ("dt")
+HTML_ELEMENT ("em")
+HTML_ELEMENT ("embed")
+HTML_ELEMENT ("fieldset")
+HTML_ELEMENT ("figcaption")
+HTML_ELEMENT ("figure")
+HTML_ELEMENT ("font")
+HTML_ELEMENT ("footer")
+HTML_ELEMENT ("form")
+HTML_ELEMENT ("frame")
+HTML_ELEMENT ("frameset")
+HTML_ELEMENT ("head")
+HTML_ELEMENT ("header")
+HTML_ELEMENT ("hgroup")
+HTML_ELEMENT ("h1")
+HTML_ELEMENT ("h2")
+HTML_ELEMENT ("h3")
+HTML_ELEMENT ("h4")
+HTML_ELEMENT ("h5")
+HTML_ELEMENT ("h6")
+HTML_ELEMENT ("hr")
+HTML_ELEMENT ("html")
+HTML_ELEMENT ("i")
+HTML_ELEMENT ("iframe")
+HTML_ELEMENT ("img")
+HTML_ELEMENT ("input")
+HTML_ELEMENT ("ins")
+HTML_ELEMENT ("kbd")
+HTML_ELEMENT ("keygen")
+HTML_ELEMENT ("label")
+HTML_ELEMENT ("legend")
+HTML_ELEMENT ("li")
+HTML_ELEMENT ("link")
+HTML_ELEMENT ("main")
+HTML_ELEMENT ("map")
+HTML_ELEMENT ("mark")
+HTML_ELEMENT ("menu")
+HTML_ELEMENT ("menuitem")
+HTML_ELEMENT ("meta")
+HTML_ELEMENT ("meter")
+HTML_ELEMENT ("nav")
+HTML_ELEMENT ("noframes")
+HTML_ELEMENT ("noscript")
+HTML_ELEMENT ("object")
+HTML_ELEMENT ("ol")
+HTML_ELEMENT ("optgroup")
+HTML_ELEMENT ("option")
+HTML_ELEMENT ("output")
+HTML_ELEMENT ("p")
+HTML_ELEMENT ("param")
+HTML_ELEMENT ("pre")
+HTML_ELEMENT ("progress")
+HTML_ELEMENT ("q")
+HTML_ELEMENT ("rp")
+HTML_ELEMENT ("rt")
+HTML_ELEMENT ("ruby")
+HTML_ELEMENT ("s")
+HTML_ELEMENT ("samp")
+HTML_ELEMENT ("script")
+HTML_ELEMENT ("section")
+HTML_ELEMENT ("select")
+HTML_ELEMENT ("small")
+HTML_ELEMENT ("source")
+HTML_ELEMENT ("span")
+HTML_ELEMENT ("strike")
+HTML_ELEMENT ("strong")
+HTML_ELEMENT ("style")
+HTML_ELEMENT ("sub")
+HTML_ELEMENT ("summary")
+HTML_ELEMENT ("sup")
+HTML_ELEMENT ("table")
+HTML_ELEMENT ("tbody")
+HTML_ELEMENT ("td")
+HTML_ELEMENT ("textarea")
+HTML_ELEMENT ("tfoot")
+HTML_ELEMENT ("th")
+HTML_ELEMENT ("thead")
+HTML_ELEMENT ("time")
+HTML_ELEMENT ("title")
+HTML_ELEMENT ("tr")
+HTML_ELEMENT ("track")
+HTML_ELEMENT ("tt")
+HTML_ELEMENT ("u")
+HTML_ELEMENT ("ul")
+HTML_ELEMENT ("var")
+HTML_ELEMENT ("video")
+HTML_ELEMENT ("wbr")
+
+HTML_ATTRIBUTE ("*", "accesskey")
+HTML_ATTRIBUTE ("*", "class")
+HTML_ATTRIBUTE ("*", "contenteditable")
+HTML_ATTRIBUTE ("*", "contextmenu")
+HTML_ATTRIBUTE ("*", "dir")
+HTML_ATTRIBUTE ("*", "draggable")
+HTML_ATTRIBUTE ("*", "dropzone")
+HTML_ATTRIBUTE ("*", "hidden")
+HTML_ATTRIBUTE ("*", "id")
+HTML_ATTRIBUTE ("*", "lang")
+HTML_ATTRIBUTE ("*", "spellcheck")
+HTML_ATTRIBUTE ("*", "style")
+HTML_ATTRIBUTE ("*", "tabindex")
+HTML_ATTRIBUTE ("*", "title")
+HTML_ATTRIBUTE ("*", "translate")
+
+HTML_ATTRIBUTE ("a", "href")
+HTML_ATTRIBUTE ("a", "target")
+HTML_ATTRIBUTE ("a", "rel")
+HTML_ATTRIBUTE ("a", "hreflang")
+HTML_ATTRIBUTE ("a", "media")
+HTML_ATTRIBUTE ("a", "type")
+
+HTML_ATTRIBUTE ("area", "alt")
+HTML_ATTRIBUTE ("area", "href")
+HTML_ATTRIBUTE ("area", "target")
+HTML_ATTRIBUTE ("area", "rel")
+HTML_ATTRIBUTE ("area", "media")
+HTML_ATTRIBUTE ("area", "hreflang")
+HTML_ATTRIBUTE ("area", "type")
+HTML_ATTRIBUTE ("area", "shape")
+HTML_ATTRIBUTE ("area", "coords")
+
+HTML_ATTRIBUTE ("audio", "autoplay")
+HTML_ATTRIBUTE ("audio", "preload")
+HTML_ATTRIBUTE ("audio", "controls")
+HTML_ATTRIBUTE ("audio", "loop")
+HTML_ATTRIBUTE ("audio", "mediagroup")
+HTML_ATTRIBUTE ("audio", "muted")
+HTML_ATTRIBUTE ("audio", "src")
+
+HTML_ATTRIBUTE ("base", "href")
+HTML_ATTRIBUTE ("base", "target")
+
+HTML_ATTRIBUTE ("blockquote", "cite")
+
+HTML_ATTRIBUTE ("button", "type")
+HTML_ATTRIBUTE ("button", "name")
+HTML_ATTRIBUTE ("button", "disabled")
+HTML_ATTRIBUTE ("button", "form")
+HTML_ATTRIBUTE ("button", "value")
+HTML_ATTRIBUTE ("button", "formaction")
+HTML_ATTRIBUTE ("button", "autofocus")
+HTML_ATTRIBUTE ("button", "formmethod")
+HTML_ATTRIBUTE ("button", "formtarget")
+HTML_ATTRIBUTE ("button", "formnovalidate")
+
+HTML_ATTRIBUTE ("canvas", "height")
+HTML_ATTRIBUTE ("canvas", "width")
+
+HTML_ATTRIBUTE ("col", "span")
+
+HTML_ATTRIBUTE ("colgroup", "span")
+
+HTML_ATTRIBUTE ("command", "type")
+HTML_ATTRIBUTE ("command", "label")
+HTML_ATTRIBUTE ("command", "icon")
+HTML_ATTRIBUTE ("command", "radiogroup")
+HTML_ATTRIBUTE ("command", "checked")
+HTML_ATTRIBUTE ("command", "type")
+
+HTML_ATTRIBUTE ("del", "cite")
+HTML_ATTRIBUTE ("del", "datetime")
+
+HTML_ATTRIBUTE ("details", "open")
+
+HTML_ATTRIBUTE ("embed", "src")
+HTML_ATTRIBUTE ("embed", "type")
+HTML_ATTRIBUTE ("embed", "height")
+HTML_ATTRIBUTE ("embed", "width")
+
+HTML_ATTRIBUTE ("fieldset", "name")
+HTML_ATTRIBUTE ("fieldset", "disabled")
+HTML_ATTRIBUTE ("fieldset", "form")
+
+HTML_ATTRIBUTE ("form", "action")
+HTML_ATTRIBUTE ("form", "method")
+HTML_ATTRIBUTE ("form", "enctype")
+HTML_ATTRIBUTE ("form", "name")
+HTML_ATTRIBUTE ("form", "accept-charset")
+HTML_ATTRIBUTE ("form", "novalidate")
+HTML_ATTRIBUTE ("form", "target")
+HTML_ATTRIBUTE ("form", "autocomplete")
+
+HTML_ATTRIBUTE ("html", "manifest")
+
+HTML_ATTRIBUTE ("iframe", "src")
+HTML_ATTRIBUTE ("iframe", "srcdoc")
+HTML_ATTRIBUTE ("iframe", "name")
+HTML_ATTRIBUTE ("iframe", "width")
+HTML_ATTRIBUTE ("iframe", "height")
+HTML_ATTRIBUTE ("iframe", "sandbox")
+HTML_ATTRIBUTE ("iframe", "seamless")
+
+HTML_ATTRIBUTE ("img", "src")
+HTML_ATTRIBUTE ("img", "alt")
+HTML_ATTRIBUTE ("img", "height")
+HTML_ATTRIBUTE ("img", "width")
+HTML_ATTRIBUTE ("img", "usemap")
+HTML_ATTRIBUTE ("img", "ismap")
+
+HTML_ATTRIBUTE ("input", "accept")
+HTML_ATTRIBUTE ("input", "alt")
+HTML_ATTRIBUTE ("input", "autocomplete")
+HTML_ATTRIBUTE ("input", "autofocus")
+HTML_ATTRIBUTE ("input", "dirname")
+HTML_ATTRIBUTE ("input", "disabled")
+HTML_ATTRIBUTE ("input", "form")
+HTML_ATTRIBUTE ("input", "formaction")
+HTML_ATTRIBUTE ("input", "formenctype")
+HTML_ATTRIBUTE ("input", "formmethod")
+HTML_ATTRIBUTE ("input", "formnovalidate")
+HTML_ATTRIBUTE ("input", "formtarget")
+HTML_ATTRIBUTE ("input", "height")
+HTML_ATTRIBUTE ("input", "list")
+HTML_ATTRIBUTE ("input", "list")
+HTML_ATTRIBUTE ("input", "max")
+HTML_ATTRIBUTE ("input", "maxlength")
+HTML_ATTRIBUTE ("input", "min")
+HTML_ATTRIBUTE ("input", "multiple")
+HTML_ATTRIBUTE ("input", "name")
+HTML_ATTRIBUTE ("input", "pattern")
+HTML_ATTRIBUTE ("input", "placeholder")
+HTML_ATTRIBUTE ("input", "readonly")
+HTML_ATTRIBUTE ("input", "required")
+HTML_ATTRIBUTE ("input", "size")
+HTML_ATTRIBUTE ("input", "src")
+HTML_ATTRIBUTE ("input", "step")
+HTML_ATTRIBUTE ("input", "type")
+HTML_ATTRIBUTE ("input", "value")
+HTML_ATTRIBUTE ("input", "width")
+
+HTML_ATTRIBUTE ("ins", "cite")
+HTML_ATTRIBUTE ("ins", "datetime")
+
+HTML_ATTRIBUTE ("keygen", "challenge")
+HTML_ATTRIBUTE ("keygen", "keytype")
+HTML_ATTRIBUTE ("keygen", "autofocus")
+HTML_ATTRIBUTE ("keygen", "name")
+HTML_ATTRIBUTE ("keygen", "disabled")
+HTML_ATTRIBUTE ("keygen", "form")
+
+HTML_ATTRIBUTE ("label", "for")
+HTML_ATTRIBUTE ("label", "form")
+
+HTML_ATTRIBUTE ("li", "value")
+
+HTML_ATTRIBUTE ("link", "href")
+HTML_ATTRIBUTE ("link", "rel")
+HTML_ATTRIBUTE ("link", "hreflang")
+HTML_ATTRIBUTE ("link", "media")
+HTML_ATTRIBUTE ("link", "type")
+HTML_ATTRIBUTE ("link", "sizes")
+
+HTML_ATTRIBUTE ("map", "name")
+
+HTML_ATTRIBUTE ("menu", "type")
+HTML_ATTRIBUTE ("menu", "label")
+
+HTML_ATTRIBUTE ("meta", "http-equiv")
+HTML_ATTRIBUTE ("meta", "content")
+HTML_ATTRIBUTE ("meta", "charset")
+
+HTML_ATTRIBUTE ("meter", "high")
+HTML_ATTRIBUTE ("meter", "low")
+HTML_ATTRIBUTE ("meter", "max")
+HTML_ATTRIBUTE ("meter", "min")
+HTML_ATTRIBUTE ("meter", "optimum")
+HTML_ATTRIBUTE ("meter", "value")
+
+HTML_ATTRIBUTE ("object", "data")
+HTML_ATTRIBUTE ("object", "type")
+HTML_ATTRIBUTE ("object", "height")
+HTML_ATTRIBUTE ("object", "width")
+HTML_ATTRIBUTE ("object", "usemap")
+HTML_ATTRIBUTE ("object", "name")
+HTML_ATTRIBUTE ("object", "form")
+
+HTML_ATTRIBUTE ("ol", "start")
+HTML_ATTRIBUTE ("ol", "reversed")
+HTML_ATTRIBUTE ("ol", "type")
+
+HTML_ATTRIBUTE ("optgroup", "label")
+HTML_ATTRIBUTE ("optgroup", "disabled")
+
+HTML_ATTRIBUTE ("option", "disabled")
+HTML_ATTRIBUTE ("option", "selected")
+HTML_ATTRIBUTE ("option", "label")
+HTML_ATTRIBUTE ("option", "value")
+
+HTML_ATTRIBUTE ("output", "name")
+HTML_ATTRIBUTE ("output", "form")
+HTML_ATTRIBUTE ("output", "for")
+
+HTML_ATTRIBUTE ("param", "name")
+HTML_ATTRIBUTE ("param", "value")
+
+HTML_ATTRIBUTE ("progress", "value")
+HTML_ATTRIBUTE ("progress", "max")
+
+HTML_ATTRIBUTE ("q", "cite")
+
+HTML_ATTRIBUTE ("script", "type")
+HTML_ATTRIBUTE ("script", "language")
+HTML_ATTRIBUTE ("script", "src")
+HTML_ATTRIBUTE ("script", "defer")
+HTML_ATTRIBUTE ("script", "async")
+HTML_ATTRIBUTE ("script", "charset")
+
+HTML_ATTRIBUTE ("select", "name")
+HTML_ATTRIBUTE ("select", "disabled")
+HTML_ATTRIBUTE ("select", "form")
+HTML_ATTRIBUTE ("select", "size")
+HTML_ATTRIBUTE ("select", "multiple")
+HTML_ATTRIBUTE ("select", "autofocus")
+HTML_ATTRIBUTE ("select", "required")
+
+HTML_ATTRIBUTE ("source", "src")
+HTML_ATTRIBUTE ("source", "type")
+HTML_ATTRIBUTE ("source", "media")
+
+HTML_ATTRIBUTE ("style", "type")
+HTML_ATTRIBUTE ("style", "media")
+HTML_ATTRIBUTE ("style", "scoped")
+
+HTML_ATTRIBUTE ("table", "border")
+
+HTML_ATTRIBUTE ("td", "colspan")
+HTML_ATTRIBUTE ("td", "rowspan")
+HTML_ATTRIBUTE ("td", "headers")
+
+HTML_ATTRIBUTE ("textarea", "name")
+HTML_ATTRIBUTE ("textarea", "disabled")
+HTML_ATTRIBUTE ("textarea", "form")
+HTML_ATTRIBUTE ("textarea", "readonly")
+HTML_ATTRIBUTE ("textarea", "maxlength")
+HTML_ATTRIBUTE ("textarea", "autofocus")
+HTML_ATTRIBUTE ("textarea", "required")
+HTML_ATTRIBUTE ("textarea", "placeholder")
+HTML_ATTRIBUTE ("textarea", "dirname")
+HTML_ATTRIBUTE ("textarea", "rows")
+HTML_ATTRIBUTE ("textarea", "wrap")
+HTML_ATTRIBUTE ("textarea", "cols")
+
+HTML_ATTRIBUTE ("th", "scope")
+HTML_ATTRIBUTE ("th", "colspan")
+HTML_ATTRIBUTE ("th", "rowspan")
+HTML_ATTRIBUTE ("th", "headers")
+
+HTML_ATTRIBUTE ("time", "datetime")
+
+HTML_ATTRIBUTE ("track", "kind")
+HTML_ATTRIBUTE ("track", "src")
+HTML_ATTRIBUTE ("track", "srclang")
+HTML_ATTRIBUTE ("track", "label")
+HTML_ATTRIBUTE ("track", "default")
+
+HTML_ATTRIBUTE ("video", "autoplay")
+HTML_ATTRIBUTE ("video", "preload")
+HTML_ATTRIBUTE ("video", "controls")
+HTML_ATTRIBUTE ("video", "loop")
+HTML_ATTRIBUTE ("video", "poster")
+HTML_ATTRIBUTE ("video", "height")
+HTML_ATTRIBUTE ("video", "width")
+HTML_ATTRIBUTE ("video", "mediagroup")
+HTML_ATTRIBUTE ("video", "muted")
+HTML_ATTRIBUTE ("video", "src")
+
+HTML_CSS_PROPERTY ("border")
+HTML_CSS_PROPERTY ("background")
+HTML_CSS_PROPERTY ("background-image")
+HTML_CSS_PROPERTY ("background-color")
+HTML_CSS_PROPERTY ("text-align")
@@ -0,0 +1,246 @@
+/* html-completion-gen.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Generates html-completion-tables.h from html-completion-data.h.
+ *
+ * This runs on the build machine, so it only depends on the C library.
+ * Every table is sorted so that prefix queries are a binary search
+ * followed by a scan of the matching range. Attributes are grouped by
+ * the element they belong to, and the elements owning attributes are
+ * found with a perfect hash.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "html-completion-hash.h"
+
+typedef struct
+{
+  const char *owner;
+  const char *name;
+} Attribute;
+
+static const char *elements[] = {
+#define HTML_ELEMENT(name) name,
+#define HTML_ATTRIBUTE(owner, name)
+#define HTML_CSS_PROPERTY(name)
+#include "html-completion-data.h"
+#undef HTML_ELEMENT
+#undef HTML_ATTRIBUTE
+#undef HTML_CSS_PROPERTY
+};
+
+static Attribute attributes[] = {
+#define HTML_ELEMENT(name)
+#define HTML_ATTRIBUTE(owner, name) { owner, name },
+#define HTML_CSS_PROPERTY(name)
+#include "html-completion-data.h"
+#undef HTML_ELEMENT
+#undef HTML_ATTRIBUTE
+#undef HTML_CSS_PROPERTY
+};
+
+static const char *css_properties[] = {
+#define HTML_ELEMENT(name)
+#define HTML_ATTRIBUTE(owner, name)
+#define HTML_CSS_PROPERTY(name) name,
+#include "html-completion-data.h"
+#undef HTML_ELEMENT
+#undef HTML_ATTRIBUTE
+#undef HTML_CSS_PROPERTY
+};
+
+#define N_ELEMENTS(ar) (sizeof (ar) / sizeof ((ar)[0]))
+#define MAX_SEED       100000
+
+static int
+compare_strings (const void *a,
+                 const void *b)
+{
+  return strcmp (*(const char * const *)a, *(const char * const *)b);
+}
+
+static int
+compare_attributes (const void *a,
+                    const void *b)
+{
+  const Attribute *attra = a;
+  const Attribute *attrb = b;
+  int ret;
+
+  if (!(ret = strcmp (attra->owner, attrb->owner)))
+    ret = strcmp (attra->name, attrb->name);
+
+  return ret;
+}
+
+static size_t
+sort_unique_strings (const char **strv,
+                     size_t       len)
+{
+  size_t i;
+  size_t j = 0;
+
+  qsort (strv, len, sizeof *strv, compare_strings);
+
+  for (i = 0; i < len; i++)
+    {
+      if (j == 0 || strcmp (strv [j - 1], strv [i]) != 0)
+        strv [j++] = strv [i];
+    }
+
+  return j;
+}
+
+static size_t
+sort_unique_attributes (Attribute *attrs,
+                        size_t     len)
+{
+  size_t i;
+  size_t j = 0;
+
+  qsort (attrs, len, sizeof *attrs, compare_attributes);
+
+  for (i = 0; i < len; i++)
+    {
+      if (j == 0 || compare_attributes (&attrs [j - 1], &attrs [i]) != 0)
+        attrs [j++] = attrs [i];
+    }
+
+  return j;
+}
+
+static void
+print_strv (const char  *name,
+            const char **strv,
+            size_t       len)
+{
+  size_t i;
+
+  printf ("static const gchar * const %s[] = {\n", name);
+  for (i = 0; i < len; i++)
+    printf ("  \"%s\",\n", strv [i]);
+  printf ("};\n\n");
+}
+
+int
+main (void)
+{
+  const char *owners [N_ELEMENTS (attributes)];
+  size_t owner_begin [N_ELEMENTS (attributes)];
+  size_t owner_end [N_ELEMENTS (attributes)];
+  int *slots = NULL;
+  size_t n_elements;
+  size_t n_attributes;
+  size_t n_css_properties;
+  size_t n_owners = 0;
+  size_t n_slots;
+  unsigned int seed = 0;
+  size_t i;
+
+  n_elements = sort_unique_strings (elements, N_ELEMENTS (elements));
+  n_attributes = sort_unique_attributes (attributes, N_ELEMENTS (attributes));
+  n_css_properties = sort_unique_strings (css_properties, N_ELEMENTS (css_properties));
+
+  for (i = 0; i < n_attributes; i++)
+    {
+      if (n_owners == 0 || strcmp (owners [n_owners - 1], attributes [i].owner) != 0)
+        {
+          owners [n_owners] = attributes [i].owner;
+          owner_begin [n_owners] = i;
+          n_owners++;
+        }
+
+      owner_end [n_owners - 1] = i + 1;
+    }
+
+  /*
+   * Find a seed for which no two owners share a slot. Start with a load
+   * factor of 0.5 and grow the table if we cannot find one.
+   */
+  for (n_slots = 1; n_slots < n_owners * 2; n_slots <<= 1) { }
+
+  for (;;)
+    {
+      int collision = 0;
+
+      free (slots);
+      slots = malloc (n_slots * sizeof *slots);
+
+      for (i = 0; i < n_slots; i++)
+        slots [i] = -1;
+
+      for (i = 0; i < n_owners; i++)
+        {
+          size_t slot = html_completion_hash (seed, owners [i]) & (n_slots - 1);
+
+          if (slots [slot] != -1)
+            {
+              collision = 1;
+              break;
+            }
+
+          slots [slot] = (int)i;
+        }
+
+      if (!collision)
+        break;
+
+      if (++seed == MAX_SEED)
+        {
+          seed = 0;
+          n_slots <<= 1;
+        }
+    }
+
+  printf ("/* Generated by html-completion-gen from html-completion-data.h. Do not edit. */\n\n");
+
+  printf ("#define HTML_N_ELEMENTS %lu\n", (unsigned long)n_elements);
+  printf ("#define HTML_N_ATTRIBUTES %lu\n", (unsigned long)n_attributes);
+  printf ("#define HTML_N_CSS_PROPERTIES %lu\n", (unsigned long)n_css_properties);
+  printf ("#define HTML_ATTRIBUTE_OWNERS_HASH_SEED %uU\n", seed);
+  printf ("#define HTML_ATTRIBUTE_OWNERS_HASH_MASK %luU\n\n", (unsigned long)(n_slots - 1));
+
+  print_strv ("html_elements", elements, n_elements);
+  print_strv ("html_css_properties", css_properties, n_css_properties);
+
+  printf ("/* Grouped by owning element, sorted within each group. */\n");
+  printf ("static const gchar * const html_attributes[] = {\n");
+  for (i = 0; i < n_attributes; i++)
+    printf ("  \"%s\", /* %s */\n", attributes [i].name, attributes [i].owner);
+  printf ("};\n\n");
+
+  printf ("typedef struct\n{\n  const gchar *name;\n  guint16      begin;\n  guint16      end;\n} HtmlAttributeOwner;\n\n");
+
+  printf ("static const HtmlAttributeOwner html_attribute_owners[] = {\n");
+  for (i = 0; i < n_owners; i++)
+    printf ("  { \"%s\", %lu, %lu },\n", owners [i], (unsigned long)owner_begin [i], (unsigned long)owner_end [i]);
+  printf ("};\n\n");
+
+  printf ("static const gint16 html_attribute_owners_hash[] = {\n");
+  for (i = 0; i < n_slots; i++)
+    printf ("  %d,\n", slots [i]);
+  printf ("};\n");
+
+  free (slots);
+
+  return fflush (stdout) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
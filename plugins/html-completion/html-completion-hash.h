@@ -0,0 +1,42 @@
+/* html-completion-hash.h
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HTML_COMPLETION_HASH_H
+#define HTML_COMPLETION_HASH_H
+
+/*
+ * Shared by html-completion-gen.c (which runs at build time without GLib)
+ * and the completion provider, so that both agree on the perfect hash.
+ * This is FNV-1a with the offset basis perturbed by the seed.
+ */
+static inline unsigned int
+html_completion_hash (unsigned int  seed,
+                      const char   *str)
+{
+  unsigned int hash = 2166136261U ^ seed;
+
+  for (; *str; str++)
+    {
+      hash ^= (unsigned char)*str;
+      hash *= 16777619U;
+    }
+
+  return hash;
+}
+
+#endif /* HTML_COMPLETION_HASH_H */
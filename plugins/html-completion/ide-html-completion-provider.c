@@ -24,11 +24,8 @@
 #include "ide-completion-provider.h"
 #include "ide-html-completion-provider.h"
 
-#include "trie.h"
-
-static GHashTable *element_attrs;
-static Trie *css_styles;
-static Trie *elements;
+#include "html-completion-hash.h"
+#include "html-completion-tables.h"
 
 enum {
   MODE_NONE,
@@ -39,18 +36,48 @@ enum {
   MODE_CSS,
 };
 
-typedef struct
+typedef enum
 {
-  GList *results;
-  gint mode;
-} SearchState;
+  PROPOSAL_ELEMENT,
+  PROPOSAL_ATTRIBUTE,
+  PROPOSAL_CSS_PROPERTY,
+} ProposalKind;
+
+#define IDE_TYPE_HTML_PROPOSAL (ide_html_proposal_get_type())
+
+G_DECLARE_FINAL_TYPE (IdeHtmlProposal, ide_html_proposal, IDE, HTML_PROPOSAL, GObject)
+
+struct _IdeHtmlProposal
+{
+  GObject       parent_instance;
+
+  /*
+   * Proposals are cached by the provider and only ever appear once in a
+   * result set, so we embed the list link to avoid allocating one per
+   * proposal on every keystroke.
+   */
+  GList         link;
+
+  /* Points into the static tables, never freed. */
+  const gchar  *word;
+  ProposalKind  kind;
+};
 
 struct _IdeHtmlCompletionProvider
 {
-  IdeObject parent_instance;
+  IdeObject         parent_instance;
+
+  /*
+   * Proposals are created the first time they are needed and reused for
+   * every subsequent populate. They are indexed like the static tables.
+   */
+  IdeHtmlProposal  *elements [HTML_N_ELEMENTS];
+  IdeHtmlProposal  *attributes [HTML_N_ATTRIBUTES];
+  IdeHtmlProposal  *css_properties [HTML_N_CSS_PROPERTIES];
 };
 
 static void completion_provider_init (GtkSourceCompletionProviderIface *);
+static void proposal_init            (GtkSourceCompletionProposalIface *);
 
 G_DEFINE_DYNAMIC_TYPE_EXTENDED (IdeHtmlCompletionProvider,
                                 ide_html_completion_provider,
@@ -59,6 +86,145 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED (IdeHtmlCompletionProvider,
                                 G_IMPLEMENT_INTERFACE (GTK_SOURCE_TYPE_COMPLETION_PROVIDER, completion_provider_init)
                                 G_IMPLEMENT_INTERFACE (IDE_TYPE_COMPLETION_PROVIDER, NULL))
 
+G_DEFINE_DYNAMIC_TYPE_EXTENDED (IdeHtmlProposal,
+                                ide_html_proposal,
+                                G_TYPE_OBJECT,
+                                0,
+                                G_IMPLEMENT_INTERFACE (GTK_SOURCE_TYPE_COMPLETION_PROPOSAL, proposal_init))
+
+static gchar *
+ide_html_proposal_get_label (GtkSourceCompletionProposal *proposal)
+{
+  IdeHtmlProposal *self = (IdeHtmlProposal *)proposal;
+
+  return g_strdup (self->word);
+}
+
+static gchar *
+ide_html_proposal_get_text (GtkSourceCompletionProposal *proposal)
+{
+  IdeHtmlProposal *self = (IdeHtmlProposal *)proposal;
+
+  if (self->kind == PROPOSAL_ATTRIBUTE)
+    return g_strdup_printf ("%s=", self->word);
+
+  return g_strdup (self->word);
+}
+
+static void
+ide_html_proposal_class_finalize (IdeHtmlProposalClass *klass)
+{
+}
+
+static void
+ide_html_proposal_class_init (IdeHtmlProposalClass *klass)
+{
+}
+
+static void
+ide_html_proposal_init (IdeHtmlProposal *self)
+{
+  self->link.data = self;
+}
+
+static void
+proposal_init (GtkSourceCompletionProposalIface *iface)
+{
+  iface->get_label = ide_html_proposal_get_label;
+  iface->get_text = ide_html_proposal_get_text;
+}
+
+static IdeHtmlProposal *
+get_proposal (IdeHtmlProposal     **cache,
+              const gchar * const *words,
+              guint                index,
+              ProposalKind         kind)
+{
+  if (cache [index] == NULL)
+    {
+      cache [index] = g_object_new (IDE_TYPE_HTML_PROPOSAL, NULL);
+      cache [index]->word = words [index];
+      cache [index]->kind = kind;
+    }
+
+  return cache [index];
+}
+
+static inline gboolean
+has_prefix (const gchar *str,
+            const gchar *prefix,
+            gsize        prefix_len)
+{
+  return strncmp (str, prefix, prefix_len) == 0;
+}
+
+/*
+ * Locates the run of words within [begin,end) of the sorted @words that
+ * start with @prefix. Returns the first match and stores the end of the
+ * run in @match_end.
+ */
+static guint
+find_prefix_range (const gchar * const *words,
+                   guint                begin,
+                   guint                end,
+                   const gchar         *prefix,
+                   guint               *match_end)
+{
+  gsize prefix_len = strlen (prefix);
+  guint lo = begin;
+  guint hi = end;
+  guint i;
+
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (strcmp (words [mid], prefix) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  for (i = lo; i < end && has_prefix (words [i], prefix, prefix_len); i++)
+    { /* Do Nothing */ }
+
+  *match_end = i;
+
+  return lo;
+}
+
+static const HtmlAttributeOwner *
+find_attribute_owner (const gchar *element)
+{
+  guint slot;
+  gint index;
+
+  if (element == NULL)
+    return NULL;
+
+  slot = html_completion_hash (HTML_ATTRIBUTE_OWNERS_HASH_SEED, element)
+       & HTML_ATTRIBUTE_OWNERS_HASH_MASK;
+  index = html_attribute_owners_hash [slot];
+
+  if (index >= 0 && strcmp (html_attribute_owners [index].name, element) == 0)
+    return &html_attribute_owners [index];
+
+  return NULL;
+}
+
+static GList *
+append_proposal (GList           *tail,
+                 IdeHtmlProposal *proposal)
+{
+  proposal->link.prev = tail;
+  proposal->link.next = NULL;
+
+  if (tail != NULL)
+    tail->next = &proposal->link;
+
+  return &proposal->link;
+}
+
 static gchar *
 get_word (GtkSourceCompletionContext *context)
 {
@@ -263,38 +429,6 @@ get_mode (GtkSourceCompletionContext *context)
   return MODE_NONE;
 }
 
-static gboolean
-traverse_cb (Trie        *trie,
-             const gchar *key,
-             gpointer     value,
-             gpointer     user_data)
-{
-  SearchState *state = user_data;
-  GtkSourceCompletionItem *item;
-  const gchar *text = key;
-  gchar *tmp = NULL;
-
-  g_return_val_if_fail (trie, FALSE);
-  g_return_val_if_fail (state, FALSE);
-
-  if (state->mode == MODE_ATTRIBUTE_NAME)
-    {
-      tmp = g_strdup_printf ("%s=", key);
-      text = tmp;
-    }
-
-  item = g_object_new (GTK_SOURCE_TYPE_COMPLETION_ITEM,
-                       "text", text,
-                       "label", key,
-                       NULL);
-
-  state->results = g_list_prepend (state->results, item);
-
-  g_free (tmp);
-
-  return FALSE;
-}
-
 static gboolean
 find_space (gunichar ch,
             gpointer user_data)
@@ -327,119 +461,122 @@ get_element (GtkSourceCompletionContext *context)
   return NULL;
 }
 
-static gint
-sort_completion_items (gconstpointer a,
-                       gconstpointer b)
-{
-  gchar *astr;
-  gchar *bstr;
-  gint ret;
-
-  /*
-   * XXX: This is very much not ideal. We are allocating a string for every
-   *      compare! But we don't have accessor funcs into the completion item.
-   *      We should probably make our completion item class.
-   */
-
-  g_object_get (GTK_SOURCE_COMPLETION_ITEM (a),
-                "label", &astr,
-                NULL);
-  g_object_get (GTK_SOURCE_COMPLETION_ITEM (b),
-                "label", &bstr,
-                NULL);
-
-  ret = g_strcmp0 (astr, bstr);
-
-  g_free (astr);
-  g_free (bstr);
-
-  return ret;
-}
-
 static void
 ide_html_completion_provider_populate (GtkSourceCompletionProvider *provider,
                                       GtkSourceCompletionContext  *context)
 {
-  SearchState state = { 0 };
-  Trie *trie = NULL;
-  gchar *word;
+  IdeHtmlCompletionProvider *self = (IdeHtmlCompletionProvider *)provider;
+  g_autofree gchar *word = NULL;
+  GList *head = NULL;
+  GList *tail = NULL;
   gint mode;
 
-  g_return_if_fail (IDE_IS_HTML_COMPLETION_PROVIDER (provider));
+  g_return_if_fail (IDE_IS_HTML_COMPLETION_PROVIDER (self));
   g_return_if_fail (GTK_SOURCE_IS_COMPLETION_CONTEXT (context));
 
   mode = get_mode (context);
-  word = get_word (context);
+
+  if (!(word = get_word (context)))
+    word = g_strdup ("");
 
   switch (mode)
     {
-    case MODE_NONE:
-      break;
-
     case MODE_ELEMENT_END:
     case MODE_ELEMENT_START:
-      trie = elements;
-      break;
+      {
+        guint end;
+        guint i;
+
+        for (i = find_prefix_range (html_elements, 0, HTML_N_ELEMENTS, word, &end); i < end; i++)
+          {
+            IdeHtmlProposal *proposal;
+
+            proposal = get_proposal (self->elements, html_elements, i, PROPOSAL_ELEMENT);
+            tail = append_proposal (tail, proposal);
+            if (head == NULL)
+              head = tail;
+          }
+
+        break;
+      }
 
     case MODE_ATTRIBUTE_NAME:
       {
-        gchar *element;
+        g_autofree gchar *element = NULL;
+        const HtmlAttributeOwner *owner;
+        const HtmlAttributeOwner *global;
+        guint a = 0, a_end = 0;
+        guint g = 0, g_end = 0;
+
+        /*
+         * Merge the attributes of the element with the global attributes.
+         * Both ranges are sorted, so the result is too.
+         */
+        element = get_element (context);
 
-        if ((element = get_element (context)))
+        if ((owner = find_attribute_owner (element)))
+          a = find_prefix_range (html_attributes, owner->begin, owner->end, word, &a_end);
+
+        if ((global = find_attribute_owner ("*")))
+          g = find_prefix_range (html_attributes, global->begin, global->end, word, &g_end);
+
+        while (a < a_end || g < g_end)
           {
-            trie = g_hash_table_lookup (element_attrs, element);
-            g_free (element);
+            IdeHtmlProposal *proposal;
+            guint index;
+
+            if (g == g_end)
+              index = a++;
+            else if (a == a_end)
+              index = g++;
+            else
+              {
+                gint cmp = strcmp (html_attributes [a], html_attributes [g]);
+
+                if (cmp == 0)
+                  a++;
+
+                index = (cmp < 0) ? a++ : g++;
+              }
+
+            proposal = get_proposal (self->attributes, html_attributes, index, PROPOSAL_ATTRIBUTE);
+            tail = append_proposal (tail, proposal);
+            if (head == NULL)
+              head = tail;
           }
 
         break;
       }
 
     case MODE_CSS:
-      trie = css_styles;
-      break;
-
-    case MODE_ATTRIBUTE_VALUE:
-      break;
-
-    default:
-      break;
-    }
+      {
+        guint end;
+        guint i;
 
-  state.mode = mode;
+        for (i = find_prefix_range (html_css_properties, 0, HTML_N_CSS_PROPERTIES, word, &end); i < end; i++)
+          {
+            IdeHtmlProposal *proposal;
 
-  /*
-   * Load the values for the context.
-   */
-  if (trie && word)
-    {
-      trie_traverse (trie, word, G_PRE_ORDER, G_TRAVERSE_LEAVES, -1,
-                     traverse_cb, &state);
-    }
+            proposal = get_proposal (self->css_properties, html_css_properties, i, PROPOSAL_CSS_PROPERTY);
+            tail = append_proposal (tail, proposal);
+            if (head == NULL)
+              head = tail;
+          }
 
-  /*
-   * If we are in an attribute, also load the global attributes values.
-   */
-  if (mode == MODE_ATTRIBUTE_NAME)
-    {
-      Trie *global;
+        break;
+      }
 
-      global = g_hash_table_lookup (element_attrs, "*");
-      trie_traverse (global, word, G_PRE_ORDER, G_TRAVERSE_LEAVES, -1,
-                     traverse_cb, &state);
+    case MODE_NONE:
+    case MODE_ATTRIBUTE_VALUE:
+    default:
+      break;
     }
 
   /*
-   * TODO: Not exactly an ideal sort mechanism.
+   * The context takes its own references to the proposals and copies the
+   * list, so our embedded links are free to be reused next time.
    */
-  state.results = g_list_sort (state.results, sort_completion_items);
-
-  gtk_source_completion_context_add_proposals (context, provider,
-                                               state.results, TRUE);
-
-  g_list_foreach (state.results, (GFunc)g_object_unref, NULL);
-  g_list_free (state.results);
-
-  g_free (word);
+  gtk_source_completion_context_add_proposals (context, provider, head, TRUE);
 }
 
 static GdkPixbuf *
@@ -454,441 +591,33 @@ ide_html_completion_provider_class_finalize (IdeHtmlCompletionProviderClass *kla
 }
 
 static void
-ide_html_completion_provider_class_init (IdeHtmlCompletionProviderClass *klass)
+clear_proposals (IdeHtmlProposal **proposals,
+                 guint             n_proposals)
 {
-  elements = trie_new (NULL);
-  element_attrs = g_hash_table_new (g_str_hash, g_str_equal);
-  css_styles = trie_new (NULL);
-
-#define ADD_ELEMENT(str)        trie_insert(elements,str,str)
-#define ADD_STRING(dict, str)   trie_insert(dict,str,str)
-#define ADD_ATTRIBUTE(ele,attr) \
-  G_STMT_START { \
-    Trie *t = g_hash_table_lookup (element_attrs, ele); \
-    if (!t) { \
-      t = trie_new (NULL); \
-      g_hash_table_insert (element_attrs, ele, t); \
-    } \
-    trie_insert (t,attr,attr); \
-  } G_STMT_END
+  guint i;
 
-  /*
-   * TODO: We should determine what are valid attributes for given elements
-   *       and only provide those based upon the completion context.
-   */
+  for (i = 0; i < n_proposals; i++)
+    g_clear_object (&proposals [i]);
+}
 
-  /*
-   * http://www.w3.org/TR/html-markup/elements.html
-   */
+static void
+ide_html_completion_provider_finalize (GObject *object)
+{
+  IdeHtmlCompletionProvider *self = (IdeHtmlCompletionProvider *)object;
+
+  clear_proposals (self->elements, G_N_ELEMENTS (self->elements));
+  clear_proposals (self->attributes, G_N_ELEMENTS (self->attributes));
+  clear_proposals (self->css_properties, G_N_ELEMENTS (self->css_properties));
+
+  G_OBJECT_CLASS (ide_html_completion_provider_parent_class)->finalize (object);
+}
+
+static void
+ide_html_completion_provider_class_init (IdeHtmlCompletionProviderClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
-  ADD_ELEMENT ("a");
-  ADD_ELEMENT ("abbr");
-  ADD_ELEMENT ("acronym");
-  ADD_ELEMENT ("address");
-  ADD_ELEMENT ("applet");
-  ADD_ELEMENT ("area");
-  ADD_ELEMENT ("article");
-  ADD_ELEMENT ("aside");
-  ADD_ELEMENT ("audio");
-  ADD_ELEMENT ("b");
-  ADD_ELEMENT ("base");
-  ADD_ELEMENT ("basefont");
-  ADD_ELEMENT ("bdi");
-  ADD_ELEMENT ("bdo");
-  ADD_ELEMENT ("big");
-  ADD_ELEMENT ("blockquote");
-  ADD_ELEMENT ("body");
-  ADD_ELEMENT ("br");
-  ADD_ELEMENT ("button");
-  ADD_ELEMENT ("canvas");
-  ADD_ELEMENT ("caption");
-  ADD_ELEMENT ("center");
-  ADD_ELEMENT ("cite");
-  ADD_ELEMENT ("code");
-  ADD_ELEMENT ("col");
-  ADD_ELEMENT ("colgroup");
-  ADD_ELEMENT ("datalist");
-  ADD_ELEMENT ("dd");
-  ADD_ELEMENT ("del");
-  ADD_ELEMENT ("details");
-  ADD_ELEMENT ("dfn");
-  ADD_ELEMENT ("dialog");
-  ADD_ELEMENT ("dir");
-  ADD_ELEMENT ("div");
-  ADD_ELEMENT ("dl");
-  ADD_ELEMENT ("dt");
-  ADD_ELEMENT ("em");
-  ADD_ELEMENT ("embed");
-  ADD_ELEMENT ("fieldset");
-  ADD_ELEMENT ("figcaption");
-  ADD_ELEMENT ("figure");
-  ADD_ELEMENT ("font");
-  ADD_ELEMENT ("footer");
-  ADD_ELEMENT ("form");
-  ADD_ELEMENT ("frame");
-  ADD_ELEMENT ("frameset");
-  ADD_ELEMENT ("head");
-  ADD_ELEMENT ("header");
-  ADD_ELEMENT ("hgroup");
-  ADD_ELEMENT ("h1");
-  ADD_ELEMENT ("h2");
-  ADD_ELEMENT ("h3");
-  ADD_ELEMENT ("h4");
-  ADD_ELEMENT ("h5");
-  ADD_ELEMENT ("h6");
-  ADD_ELEMENT ("hr");
-  ADD_ELEMENT ("html");
-  ADD_ELEMENT ("i");
-  ADD_ELEMENT ("iframe");
-  ADD_ELEMENT ("img");
-  ADD_ELEMENT ("input");
-  ADD_ELEMENT ("ins");
-  ADD_ELEMENT ("kbd");
-  ADD_ELEMENT ("keygen");
-  ADD_ELEMENT ("label");
-  ADD_ELEMENT ("legend");
-  ADD_ELEMENT ("li");
-  ADD_ELEMENT ("link");
-  ADD_ELEMENT ("main");
-  ADD_ELEMENT ("map");
-  ADD_ELEMENT ("mark");
-  ADD_ELEMENT ("menu");
-  ADD_ELEMENT ("menuitem");
-  ADD_ELEMENT ("meta");
-  ADD_ELEMENT ("meter");
-  ADD_ELEMENT ("nav");
-  ADD_ELEMENT ("noframes");
-  ADD_ELEMENT ("noscript");
-  ADD_ELEMENT ("object");
-  ADD_ELEMENT ("ol");
-  ADD_ELEMENT ("optgroup");
-  ADD_ELEMENT ("option");
-  ADD_ELEMENT ("output");
-  ADD_ELEMENT ("p");
-  ADD_ELEMENT ("param");
-  ADD_ELEMENT ("pre");
-  ADD_ELEMENT ("progress");
-  ADD_ELEMENT ("q");
-  ADD_ELEMENT ("rp");
-  ADD_ELEMENT ("rt");
-  ADD_ELEMENT ("ruby");
-  ADD_ELEMENT ("s");
-  ADD_ELEMENT ("samp");
-  ADD_ELEMENT ("script");
-  ADD_ELEMENT ("section");
-  ADD_ELEMENT ("select");
-  ADD_ELEMENT ("small");
-  ADD_ELEMENT ("source");
-  ADD_ELEMENT ("span");
-  ADD_ELEMENT ("strike");
-  ADD_ELEMENT ("strong");
-  ADD_ELEMENT ("style");
-  ADD_ELEMENT ("sub");
-  ADD_ELEMENT ("summary");
-  ADD_ELEMENT ("sup");
-  ADD_ELEMENT ("table");
-  ADD_ELEMENT ("tbody");
-  ADD_ELEMENT ("td");
-  ADD_ELEMENT ("textarea");
-  ADD_ELEMENT ("tfoot");
-  ADD_ELEMENT ("th");
-  ADD_ELEMENT ("thead");
-  ADD_ELEMENT ("time");
-  ADD_ELEMENT ("title");
-  ADD_ELEMENT ("tr");
-  ADD_ELEMENT ("track");
-  ADD_ELEMENT ("tt");
-  ADD_ELEMENT ("u");
-  ADD_ELEMENT ("ul");
-  ADD_ELEMENT ("var");
-  ADD_ELEMENT ("video");
-  ADD_ELEMENT ("wbr");
-
-  ADD_ATTRIBUTE ("*", "accesskey");
-  ADD_ATTRIBUTE ("*", "class");
-  ADD_ATTRIBUTE ("*", "contenteditable");
-  ADD_ATTRIBUTE ("*", "contextmenu");
-  ADD_ATTRIBUTE ("*", "dir");
-  ADD_ATTRIBUTE ("*", "draggable");
-  ADD_ATTRIBUTE ("*", "dropzone");
-  ADD_ATTRIBUTE ("*", "hidden");
-  ADD_ATTRIBUTE ("*", "id");
-  ADD_ATTRIBUTE ("*", "lang");
-  ADD_ATTRIBUTE ("*", "spellcheck");
-  ADD_ATTRIBUTE ("*", "style");
-  ADD_ATTRIBUTE ("*", "tabindex");
-  ADD_ATTRIBUTE ("*", "title");
-  ADD_ATTRIBUTE ("*", "translate");
-
-  ADD_ATTRIBUTE ("a", "href");
-  ADD_ATTRIBUTE ("a", "target");
-  ADD_ATTRIBUTE ("a", "rel");
-  ADD_ATTRIBUTE ("a", "hreflang");
-  ADD_ATTRIBUTE ("a", "media");
-  ADD_ATTRIBUTE ("a", "type");
-
-  ADD_ATTRIBUTE ("area", "alt");
-  ADD_ATTRIBUTE ("area", "href");
-  ADD_ATTRIBUTE ("area", "target");
-  ADD_ATTRIBUTE ("area", "rel");
-  ADD_ATTRIBUTE ("area", "media");
-  ADD_ATTRIBUTE ("area", "hreflang");
-  ADD_ATTRIBUTE ("area", "type");
-  ADD_ATTRIBUTE ("area", "shape");
-  ADD_ATTRIBUTE ("area", "coords");
-
-  ADD_ATTRIBUTE ("audio", "autoplay");
-  ADD_ATTRIBUTE ("audio", "preload");
-  ADD_ATTRIBUTE ("audio", "controls");
-  ADD_ATTRIBUTE ("audio", "loop");
-  ADD_ATTRIBUTE ("audio", "mediagroup");
-  ADD_ATTRIBUTE ("audio", "muted");
-  ADD_ATTRIBUTE ("audio", "src");
-
-  ADD_ATTRIBUTE ("base", "href");
-  ADD_ATTRIBUTE ("base", "target");
-
-  ADD_ATTRIBUTE ("blockquote", "cite");
-
-  ADD_ATTRIBUTE ("button", "type");
-  ADD_ATTRIBUTE ("button", "name");
-  ADD_ATTRIBUTE ("button", "disabled");
-  ADD_ATTRIBUTE ("button", "form");
-  ADD_ATTRIBUTE ("button", "value");
-  ADD_ATTRIBUTE ("button", "formaction");
-  ADD_ATTRIBUTE ("button", "autofocus");
-  ADD_ATTRIBUTE ("button", "formmethod");
-  ADD_ATTRIBUTE ("button", "formtarget");
-  ADD_ATTRIBUTE ("button", "formnovalidate");
-
-  ADD_ATTRIBUTE ("canvas", "height");
-  ADD_ATTRIBUTE ("canvas", "width");
-
-  ADD_ATTRIBUTE ("col", "span");
-
-  ADD_ATTRIBUTE ("colgroup", "span");
-
-  ADD_ATTRIBUTE ("command", "type");
-  ADD_ATTRIBUTE ("command", "label");
-  ADD_ATTRIBUTE ("command", "icon");
-  ADD_ATTRIBUTE ("command", "radiogroup");
-  ADD_ATTRIBUTE ("command", "checked");
-  ADD_ATTRIBUTE ("command", "type");
-
-  ADD_ATTRIBUTE ("del", "cite");
-  ADD_ATTRIBUTE ("del", "datetime");
-
-  ADD_ATTRIBUTE ("details", "open");
-
-  ADD_ATTRIBUTE ("embed", "src");
-  ADD_ATTRIBUTE ("embed", "type");
-  ADD_ATTRIBUTE ("embed", "height");
-  ADD_ATTRIBUTE ("embed", "width");
-
-  ADD_ATTRIBUTE ("fieldset", "name");
-  ADD_ATTRIBUTE ("fieldset", "disabled");
-  ADD_ATTRIBUTE ("fieldset", "form");
-
-  ADD_ATTRIBUTE ("form", "action");
-  ADD_ATTRIBUTE ("form", "method");
-  ADD_ATTRIBUTE ("form", "enctype");
-  ADD_ATTRIBUTE ("form", "name");
-  ADD_ATTRIBUTE ("form", "accept-charset");
-  ADD_ATTRIBUTE ("form", "novalidate");
-  ADD_ATTRIBUTE ("form", "target");
-  ADD_ATTRIBUTE ("form", "autocomplete");
-
-  ADD_ATTRIBUTE ("html", "manifest");
-
-  ADD_ATTRIBUTE ("iframe", "src");
-  ADD_ATTRIBUTE ("iframe", "srcdoc");
-  ADD_ATTRIBUTE ("iframe", "name");
-  ADD_ATTRIBUTE ("iframe", "width");
-  ADD_ATTRIBUTE ("iframe", "height");
-  ADD_ATTRIBUTE ("iframe", "sandbox");
-  ADD_ATTRIBUTE ("iframe", "seamless");
-
-  ADD_ATTRIBUTE ("img", "src");
-  ADD_ATTRIBUTE ("img", "alt");
-  ADD_ATTRIBUTE ("img", "height");
-  ADD_ATTRIBUTE ("img", "width");
-  ADD_ATTRIBUTE ("img", "usemap");
-  ADD_ATTRIBUTE ("img", "ismap");
-
-  ADD_ATTRIBUTE ("input", "accept");
-  ADD_ATTRIBUTE ("input", "alt");
-  ADD_ATTRIBUTE ("input", "autocomplete");
-  ADD_ATTRIBUTE ("input", "autofocus");
-  ADD_ATTRIBUTE ("input", "dirname");
-  ADD_ATTRIBUTE ("input", "disabled");
-  ADD_ATTRIBUTE ("input", "form");
-  ADD_ATTRIBUTE ("input", "formaction");
-  ADD_ATTRIBUTE ("input", "formenctype");
-  ADD_ATTRIBUTE ("input", "formmethod");
-  ADD_ATTRIBUTE ("input", "formnovalidate");
-  ADD_ATTRIBUTE ("input", "formtarget");
-  ADD_ATTRIBUTE ("input", "height");
-  ADD_ATTRIBUTE ("input", "list");
-  ADD_ATTRIBUTE ("input", "list");
-  ADD_ATTRIBUTE ("input", "max");
-  ADD_ATTRIBUTE ("input", "maxlength");
-  ADD_ATTRIBUTE ("input", "min");
-  ADD_ATTRIBUTE ("input", "multiple");
-  ADD_ATTRIBUTE ("input", "name");
-  ADD_ATTRIBUTE ("input", "pattern");
-  ADD_ATTRIBUTE ("input", "placeholder");
-  ADD_ATTRIBUTE ("input", "readonly");
-  ADD_ATTRIBUTE ("input", "required");
-  ADD_ATTRIBUTE ("input", "size");
-  ADD_ATTRIBUTE ("input", "src");
-  ADD_ATTRIBUTE ("input", "step");
-  ADD_ATTRIBUTE ("input", "type");
-  ADD_ATTRIBUTE ("input", "value");
-  ADD_ATTRIBUTE ("input", "width");
-
-  ADD_ATTRIBUTE ("ins", "cite");
-  ADD_ATTRIBUTE ("ins", "datetime");
-
-  ADD_ATTRIBUTE ("keygen", "challenge");
-  ADD_ATTRIBUTE ("keygen", "keytype");
-  ADD_ATTRIBUTE ("keygen", "autofocus");
-  ADD_ATTRIBUTE ("keygen", "name");
-  ADD_ATTRIBUTE ("keygen", "disabled");
-  ADD_ATTRIBUTE ("keygen", "form");
-
-  ADD_ATTRIBUTE ("label", "for");
-  ADD_ATTRIBUTE ("label", "form");
-
-  ADD_ATTRIBUTE ("li", "value");
-
-  ADD_ATTRIBUTE ("link", "href");
-  ADD_ATTRIBUTE ("link", "rel");
-  ADD_ATTRIBUTE ("link", "hreflang");
-  ADD_ATTRIBUTE ("link", "media");
-  ADD_ATTRIBUTE ("link", "type");
-  ADD_ATTRIBUTE ("link", "sizes");
-
-  ADD_ATTRIBUTE ("map", "name");
-
-  ADD_ATTRIBUTE ("menu", "type");
-  ADD_ATTRIBUTE ("menu", "label");
-
-  ADD_ATTRIBUTE ("meta", "http-equiv");
-  ADD_ATTRIBUTE ("meta", "content");
-  ADD_ATTRIBUTE ("meta", "charset");
-
-  ADD_ATTRIBUTE ("meter", "high");
-  ADD_ATTRIBUTE ("meter", "low");
-  ADD_ATTRIBUTE ("meter", "max");
-  ADD_ATTRIBUTE ("meter", "min");
-  ADD_ATTRIBUTE ("meter", "optimum");
-  ADD_ATTRIBUTE ("meter", "value");
-
-  ADD_ATTRIBUTE ("object", "data");
-  ADD_ATTRIBUTE ("object", "type");
-  ADD_ATTRIBUTE ("object", "height");
-  ADD_ATTRIBUTE ("object", "width");
-  ADD_ATTRIBUTE ("object", "usemap");
-  ADD_ATTRIBUTE ("object", "name");
-  ADD_ATTRIBUTE ("object", "form");
-
-  ADD_ATTRIBUTE ("ol", "start");
-  ADD_ATTRIBUTE ("ol", "reversed");
-  ADD_ATTRIBUTE ("ol", "type");
-
-  ADD_ATTRIBUTE ("optgroup", "label");
-  ADD_ATTRIBUTE ("optgroup", "disabled");
-
-  ADD_ATTRIBUTE ("option", "disabled");
-  ADD_ATTRIBUTE ("option", "selected");
-  ADD_ATTRIBUTE ("option", "label");
-  ADD_ATTRIBUTE ("option", "value");
-
-  ADD_ATTRIBUTE ("output", "name");
-  ADD_ATTRIBUTE ("output", "form");
-  ADD_ATTRIBUTE ("output", "for");
-
-  ADD_ATTRIBUTE ("param", "name");
-  ADD_ATTRIBUTE ("param", "value");
-
-  ADD_ATTRIBUTE ("progress", "value");
-  ADD_ATTRIBUTE ("progress", "max");
-
-  ADD_ATTRIBUTE ("q", "cite");
-
-  ADD_ATTRIBUTE ("script", "type");
-  ADD_ATTRIBUTE ("script", "language");
-  ADD_ATTRIBUTE ("script", "src");
-  ADD_ATTRIBUTE ("script", "defer");
-  ADD_ATTRIBUTE ("script", "async");
-  ADD_ATTRIBUTE ("script", "charset");
-
-  ADD_ATTRIBUTE ("select", "name");
-  ADD_ATTRIBUTE ("select", "disabled");
-  ADD_ATTRIBUTE ("select", "form");
-  ADD_ATTRIBUTE ("select", "size");
-  ADD_ATTRIBUTE ("select", "multiple");
-  ADD_ATTRIBUTE ("select", "autofocus");
-  ADD_ATTRIBUTE ("select", "required");
-
-  ADD_ATTRIBUTE ("source", "src");
-  ADD_ATTRIBUTE ("source", "type");
-  ADD_ATTRIBUTE ("source", "media");
-
-  ADD_ATTRIBUTE ("style", "type");
-  ADD_ATTRIBUTE ("style", "media");
-  ADD_ATTRIBUTE ("style", "scoped");
-
-  ADD_ATTRIBUTE ("table", "border");
-
-  ADD_ATTRIBUTE ("td", "colspan");
-  ADD_ATTRIBUTE ("td", "rowspan");
-  ADD_ATTRIBUTE ("td", "headers");
-
-  ADD_ATTRIBUTE ("textarea", "name");
-  ADD_ATTRIBUTE ("textarea", "disabled");
-  ADD_ATTRIBUTE ("textarea", "form");
-  ADD_ATTRIBUTE ("textarea", "readonly");
-  ADD_ATTRIBUTE ("textarea", "maxlength");
-  ADD_ATTRIBUTE ("textarea", "autofocus");
-  ADD_ATTRIBUTE ("textarea", "required");
-  ADD_ATTRIBUTE ("textarea", "placeholder");
-  ADD_ATTRIBUTE ("textarea", "dirname");
-  ADD_ATTRIBUTE ("textarea", "rows");
-  ADD_ATTRIBUTE ("textarea", "wrap");
-  ADD_ATTRIBUTE ("textarea", "cols");
-
-  ADD_ATTRIBUTE ("th", "scope");
-  ADD_ATTRIBUTE ("th", "colspan");
-  ADD_ATTRIBUTE ("th", "rowspan");
-  ADD_ATTRIBUTE ("th", "headers");
-
-  ADD_ATTRIBUTE ("time", "datetime");
-
-  ADD_ATTRIBUTE ("track", "kind");
-  ADD_ATTRIBUTE ("track", "src");
-  ADD_ATTRIBUTE ("track", "srclang");
-  ADD_ATTRIBUTE ("track", "label");
-  ADD_ATTRIBUTE ("track", "default");
-
-  ADD_ATTRIBUTE ("video", "autoplay");
-  ADD_ATTRIBUTE ("video", "preload");
-  ADD_ATTRIBUTE ("video", "controls");
-  ADD_ATTRIBUTE ("video", "loop");
-  ADD_ATTRIBUTE ("video", "poster");
-  ADD_ATTRIBUTE ("video", "height");
-  ADD_ATTRIBUTE ("video", "width");
-  ADD_ATTRIBUTE ("video", "mediagroup");
-  ADD_ATTRIBUTE ("video", "muted");
-  ADD_ATTRIBUTE ("video", "src");
-
-  ADD_STRING (css_styles, "border");
-  ADD_STRING (css_styles, "background");
-  ADD_STRING (css_styles, "background-image");
-  ADD_STRING (css_styles, "background-color");
-  ADD_STRING (css_styles, "text-align");
-
-#undef ADD_STRING
+  object_class->finalize = ide_html_completion_provider_finalize;
 }
 
 static void
@@ -907,6 +636,7 @@ void
 peas_register_types (PeasObjectModule *module)
 {
   ide_html_completion_provider_register_type (G_TYPE_MODULE (module));
+  ide_html_proposal_register_type (G_TYPE_MODULE (module));
 
   peas_object_module_register_extension_type (module,
                                               IDE_TYPE_COMPLETION_PROVIDER,
@@ -30,9 +30,11 @@ try:
 except ImportError:
     HAS_LXML = False
     print('Warning: python3-lxml is not installed, no documentation will be available in Python auto-completion')
+import importlib.util
 import os
 import os.path
 import sqlite3
+import sys
 import threading
 
 gi.require_version('GIRepository', '2.0')
@@ -87,94 +89,105 @@ _ICONS = {
     _TYPE_MODULE: 'lang-namespace-symbolic',
 }
 
-try:
-    import jedi
-    from jedi.evaluate.compiled import CompiledObject
-    from jedi.evaluate.compiled import _create_from_name
-    from jedi.evaluate.compiled import builtin
-    from jedi.evaluate.docstrings import _evaluate_for_statement_string
-    from jedi.evaluate.imports import Importer
-
-    class PatchedJediCompiledObject(CompiledObject):
-        "A modified version of Jedi CompiledObject to work with GObject Introspection modules"
-        def _cls(self):
-            if self.obj.__class__ == IntrospectionModule:
-                return self
-            else:
-                return super()._cls()
-
-        @property
-        def py__call__(self):
-            def actual(evaluator, params):
-                # Parse the docstring to find the return type:
-                ret_type = ''
-                if '->' in self.obj.__doc__:
-                    ret_type = self.obj.__doc__.split('->')[1].strip()
-                    ret_type = ret_type.replace(' or None', '')
-                if ret_type.startswith('iter:'):
-                    ret_type = ret_type[len('iter:'):]  # we don't care if it's an iterator
-
-                if ret_type in __builtins__:
-                    # The function we're inspecting returns a builtin python type, that's easy
-                    obj = _create_from_name(builtin, builtin, ret_type)
-                    return evaluator.execute(obj, params)
+# jedi and the GObject Introspection documentation index are only loaded
+# inside the worker process (see JediWorker). The UI process only needs to
+# know whether jedi is available, so avoid paying for the import there.
+HAS_JEDI = importlib.util.find_spec('jedi') is not None
+PatchedJediCompiledObject = None
+
+def init_jedi():
+    global HAS_JEDI
+    global PatchedJediCompiledObject
+    global jedi
+
+    try:
+        import jedi
+        from jedi.evaluate.compiled import CompiledObject
+        from jedi.evaluate.compiled import _create_from_name
+        from jedi.evaluate.compiled import builtin
+        from jedi.evaluate.docstrings import _evaluate_for_statement_string
+        from jedi.evaluate.imports import Importer
+
+        class PatchedJediCompiledObject(CompiledObject):
+            "A modified version of Jedi CompiledObject to work with GObject Introspection modules"
+            def _cls(self):
+                if self.obj.__class__ == IntrospectionModule:
+                    return self
                 else:
-                    # The function we're inspecting returns a GObject type
-                    parent = self.parent.obj.__name__
-                    if parent.startswith('gi.repository'):
-                        parent = parent[len('gi.repository.'):]
-                    else:
-                        # a module with overrides, such as Gtk, behaves differently
-                        parent_module = self.parent.obj.__module__
-                        if parent_module.startswith('gi.overrides'):
-                            parent_module = parent_module[len('gi.overrides.'):]
-                            parent = '%s.%s' % (parent_module, parent)
-
-                    if ret_type.startswith(parent):
-                        # A pygobject type in the same module
-                        ret_type = ret_type[len(parent):]
+                    return super()._cls()
+
+            @property
+            def py__call__(self):
+                def actual(evaluator, params):
+                    # Parse the docstring to find the return type:
+                    ret_type = ''
+                    if '->' in self.obj.__doc__:
+                        ret_type = self.obj.__doc__.split('->')[1].strip()
+                        ret_type = ret_type.replace(' or None', '')
+                    if ret_type.startswith('iter:'):
+                        ret_type = ret_type[len('iter:'):]  # we don't care if it's an iterator
+
+                    if ret_type in __builtins__:
+                        # The function we're inspecting returns a builtin python type, that's easy
+                        obj = _create_from_name(builtin, builtin, ret_type)
+                        return evaluator.execute(obj, params)
                     else:
-                        # A pygobject type in a different module
-                        return_type_parent = ret_type.split('.', 1)[0]
-                        ret_type = 'from gi.repository import %s\n%s' % (return_type_parent, ret_type)
-                    result = _evaluate_for_statement_string(evaluator, ret_type, self.parent)
-                    return result
-            if type(self.obj) == FunctionInfo:
-                return actual
-            return super().py__call__
-
-    class PatchedJediImporter(Importer):
-        "A modified version of Jedi Importer to work with GObject Introspection modules"
-        def follow(self):
-            module_list = super().follow()
-            if module_list == []:
-                import_path = '.'.join([str(i) for i in self.import_path])
-                if import_path.startswith('gi.repository'):
-                    try:
-                        module = gi_importer.load_module(import_path)
-                        module_list = [PatchedJediCompiledObject(module)]
-                    except ImportError:
-                        pass
-            return module_list
-
-    original_jedi_get_module = jedi.evaluate.compiled.fake.get_module
-
-    def patched_jedi_get_module(obj):
-        "Work around a weird bug in jedi"
-        try:
-            return original_jedi_get_module(obj)
-        except ImportError as e:
-            if e.msg == "No module named 'gi._gobject._gobject'":
-                return original_jedi_get_module('gi._gobject')
+                        # The function we're inspecting returns a GObject type
+                        parent = self.parent.obj.__name__
+                        if parent.startswith('gi.repository'):
+                            parent = parent[len('gi.repository.'):]
+                        else:
+                            # a module with overrides, such as Gtk, behaves differently
+                            parent_module = self.parent.obj.__module__
+                            if parent_module.startswith('gi.overrides'):
+                                parent_module = parent_module[len('gi.overrides.'):]
+                                parent = '%s.%s' % (parent_module, parent)
+
+                        if ret_type.startswith(parent):
+                            # A pygobject type in the same module
+                            ret_type = ret_type[len(parent):]
+                        else:
+                            # A pygobject type in a different module
+                            return_type_parent = ret_type.split('.', 1)[0]
+                            ret_type = 'from gi.repository import %s\n%s' % (return_type_parent, ret_type)
+                        result = _evaluate_for_statement_string(evaluator, ret_type, self.parent)
+                        return result
+                if type(self.obj) == FunctionInfo:
+                    return actual
+                return super().py__call__
+
+        class PatchedJediImporter(Importer):
+            "A modified version of Jedi Importer to work with GObject Introspection modules"
+            def follow(self):
+                module_list = super().follow()
+                if module_list == []:
+                    import_path = '.'.join([str(i) for i in self.import_path])
+                    if import_path.startswith('gi.repository'):
+                        try:
+                            module = gi_importer.load_module(import_path)
+                            module_list = [PatchedJediCompiledObject(module)]
+                        except ImportError:
+                            pass
+                return module_list
+
+        original_jedi_get_module = jedi.evaluate.compiled.fake.get_module
+
+        def patched_jedi_get_module(obj):
+            "Work around a weird bug in jedi"
+            try:
+                return original_jedi_get_module(obj)
+            except ImportError as e:
+                if e.msg == "No module named 'gi._gobject._gobject'":
+                    return original_jedi_get_module('gi._gobject')
 
-    jedi.evaluate.compiled.fake.get_module = patched_jedi_get_module
+        jedi.evaluate.compiled.fake.get_module = patched_jedi_get_module
 
-    jedi.evaluate.imports.Importer = PatchedJediImporter
-    jedi.evaluate.compiled.CompiledObject = PatchedJediCompiledObject
-    HAS_JEDI = True
-except ImportError:
-    print("jedi not found, python auto-completion not possible.")
-    HAS_JEDI = False
+        jedi.evaluate.imports.Importer = PatchedJediImporter
+        jedi.evaluate.compiled.CompiledObject = PatchedJediCompiledObject
+        HAS_JEDI = True
+    except ImportError:
+        print("jedi not found, python auto-completion not possible.")
+        HAS_JEDI = False
 
 GIR_PATH_LIST = []
 
@@ -317,12 +330,46 @@ class DocumentationDB(object):
         if close_when_done:
             self.close()
 
+    def load(self):
+        "Load every documentation entry, keyed by (symbol, library_version)"
+        self.open()
+        self.cursor.execute('SELECT symbol, library_version, doc FROM doc')
+        return {(sys.intern(symbol), sys.intern(version)): doc
+                for symbol, version, doc in self.cursor}
+
 
-def update_doc_db_on_startup():
-    db = DocumentationDB()
-    threading.Thread(target=db.update, args={'close_when_done': True}).start()
+class GirDocIndex(object):
+    """
+    An in-memory copy of the documentation DB, owned by the worker process.
 
-update_doc_db_on_startup()
+    The DB is brought up to date and then loaded in one pass on a thread,
+    so completion requests never need to query sqlite per result. Until
+    the index is ready, requests simply use the docstrings from jedi.
+    """
+    def __init__(self):
+        self._docs = {}
+        self._ready = False
+
+    def load_async(self):
+        threading.Thread(target=self._load, daemon=True).start()
+
+    def _load(self):
+        db = DocumentationDB()
+        try:
+            db.update()
+            docs = db.load()
+        finally:
+            db.close()
+        # Swap in the whole dict at once so readers never see a partial index.
+        self._docs = docs
+        self._ready = True
+
+    @property
+    def ready(self):
+        return self._ready
+
+    def lookup(self, symbol, version):
+        return self._docs.get((symbol, version))
 
 
 class JediCompletionProvider(Ide.Object, GtkSource.CompletionProvider, Ide.CompletionProvider):
@@ -567,11 +614,12 @@ class JediCompletionRequest:
     did_run = False
     cancelled = False
 
-    def __init__(self, invocation, filename, line, column, content):
+    def __init__(self, invocation, doc_index, filename, line, column, content):
         assert(type(line) == int)
         assert(type(column) == int)
 
         self.invocation = invocation
+        self.doc_index = doc_index
         self.filename = filename
         self.line = line
         self.column = column
@@ -592,7 +640,6 @@ class JediCompletionRequest:
         # Jedi uses 1-based line indexes, we use 0 throughout Builder.
         script = jedi.Script(self.content, self.line + 1, self.column, self.filename)
 
-        db = DocumentationDB()
         for info in script.completions():
             if self.cancelled:
                 return
@@ -643,14 +690,12 @@ class JediCompletionRequest:
                         else:
                             parent = new_parent
                     version = parent.obj._version
-                    result = db.query(symbol, version)
+                    result = self.doc_index.lookup(symbol, version)
                     if result is not None:
                         doc = result
 
             results.append((_TYPES.get(info.real_type, 0), info.name, info.complete, params, doc))
 
-        db.close()
-
         self.invocation.return_value(GLib.Variant('(a(issass))', (results,)))
 
     def cancel(self):
@@ -658,21 +703,42 @@ class JediCompletionRequest:
             self.cancelled = True
             self.invocation.return_error_literal(Gio.io_error_quark(), Gio.IOErrorEnum.CANCELLED, "Operation was cancelled")
 
+# Modules that most Python code in Builder imports. Completing against
+# them once when the worker starts means the user's first completion does
+# not pay for loading the typelibs and building jedi's caches.
+_WARM_MODULES = ('GLib', 'GObject', 'Gio', 'Gtk', 'Ide')
+
 class JediService(Ide.DBusService):
     queue = None
     handler_id = None
+    doc_index = None
 
     def __init__(self):
         super().__init__()
         self.queue = {}
         self.handler_id = 0
+        self.doc_index = GirDocIndex()
+        self.doc_index.load_async()
+        GLib.idle_add(self.warm, list(_WARM_MODULES), priority=GLib.PRIORITY_LOW)
+
+    def warm(self, modules):
+        # Do one module per idle so real requests are not delayed for long.
+        if self.queue or not modules:
+            return bool(modules)
+        name = modules.pop(0)
+        content = 'from gi.repository import %s\n%s.' % (name, name)
+        try:
+            jedi.Script(content, 2, len(name) + 1, None).completions()
+        except Exception as ex:
+            print('Failed to warm %s: %s' % (name, repr(ex)))
+        return bool(modules)
 
     @Ide.DBusMethod('org.gnome.builder.plugins.jedi', in_signature='siis', out_signature='a(issass)', async=True)
     def CodeComplete(self, invocation, filename, line, column, content):
         if filename in self.queue:
             request = self.queue.pop(filename)
             request.cancel()
-        self.queue[filename] = JediCompletionRequest(invocation, filename, line, column, content)
+        self.queue[filename] = JediCompletionRequest(invocation, self.doc_index, filename, line, column, content)
         if not self.handler_id:
             self.handler_id = GLib.timeout_add(5, self.process)
 
@@ -687,6 +753,8 @@ class JediWorker(GObject.Object, Ide.Worker):
     _service = None
 
     def do_register_service(self, connection):
+        # Only the worker process pays for importing jedi.
+        init_jedi()
         self._service = JediService()
         self._service.export(connection, '/')
 
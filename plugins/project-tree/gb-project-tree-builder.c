@@ -22,6 +22,7 @@
 #include "gb-project-file.h"
 #include "gb-project-tree.h"
 #include "gb-project-tree-builder.h"
+#include "gb-project-tree-private.h"
 
 struct _GbProjectTreeBuilder
 {
@@ -29,6 +30,9 @@ struct _GbProjectTreeBuilder
 
   GSettings      *file_chooser_settings;
 
+  /* IdeTreeNode => GTask, for directories being populated */
+  GHashTable     *populating;
+
   guint           sort_directories_first : 1;
 };
 
@@ -113,104 +117,580 @@ compare_nodes_func (IdeTreeNode *a,
     return gb_project_file_compare (file_a, file_b);
 }
 
+#define PROJECT_FILE_ATTRIBUTES \
+  G_FILE_ATTRIBUTE_STANDARD_NAME"," \
+  G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME"," \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE
+
+/* Number of children inserted into the tree per main loop iteration. */
+#define POPULATE_BATCH_SIZE 100
+
+typedef struct
+{
+  GbProjectFile *item;
+  guint          ignored : 1;
+} PopulateChild;
+
+typedef struct
+{
+  IdeTreeNode *node;
+  IdeTreeNode *placeholder;
+  GFile       *directory;
+  IdeVcs      *vcs;
+  GArray      *children;
+  guint        position;
+  guint        show_ignored_files : 1;
+  guint        sort_directories_first : 1;
+} Populate;
+
+typedef struct
+{
+  GbProjectTreeBuilder *self;
+  IdeTreeNode          *node;
+} AddFile;
+
 static void
-build_file (GbProjectTreeBuilder *self,
-            IdeTreeNode          *node)
+populate_child_clear (gpointer data)
+{
+  PopulateChild *child = data;
+
+  g_clear_object (&child->item);
+}
+
+static void
+populate_free (gpointer data)
+{
+  Populate *state = data;
+
+  g_clear_object (&state->node);
+  g_clear_object (&state->placeholder);
+  g_clear_object (&state->directory);
+  g_clear_object (&state->vcs);
+  g_clear_pointer (&state->children, g_array_unref);
+  g_slice_free (Populate, state);
+}
+
+static void
+add_file_free (AddFile *state)
+{
+  g_clear_object (&state->self);
+  g_clear_object (&state->node);
+  g_slice_free (AddFile, state);
+}
+
+static void
+directory_monitor_free (gpointer data)
+{
+  GFileMonitor *monitor = data;
+
+  g_file_monitor_cancel (monitor);
+  g_object_unref (monitor);
+}
+
+static IdeTreeNode *
+create_file_node (GbProjectFile *item,
+                  gboolean       ignored)
+{
+  g_assert (GB_IS_PROJECT_FILE (item));
+
+  return g_object_new (IDE_TYPE_TREE_NODE,
+                       "icon-name", gb_project_file_get_icon_name (item),
+                       "text", gb_project_file_get_display_name (item),
+                       "item", item,
+                       "use-dim-label", ignored,
+                       NULL);
+}
+
+static IdeTreeNode *
+create_placeholder_node (const gchar *text)
+{
+  return g_object_new (IDE_TYPE_TREE_NODE,
+                       "icon-name", NULL,
+                       "text", text,
+                       "use-dim-label", TRUE,
+                       NULL);
+}
+
+static gboolean
+find_file_func (IdeTree     *tree,
+                IdeTreeNode *node,
+                IdeTreeNode *child,
+                gpointer     user_data)
+{
+  GFile *file = user_data;
+  GObject *item;
+
+  item = ide_tree_node_get_item (child);
+
+  return GB_IS_PROJECT_FILE (item) &&
+         g_file_equal (file, gb_project_file_get_file (GB_PROJECT_FILE (item)));
+}
+
+static gboolean
+find_placeholder_func (IdeTree     *tree,
+                       IdeTreeNode *node,
+                       IdeTreeNode *child,
+                       gpointer     user_data)
+{
+  return ide_tree_node_get_item (child) == NULL;
+}
+
+static gboolean
+find_sibling_func (IdeTree     *tree,
+                   IdeTreeNode *node,
+                   IdeTreeNode *child,
+                   gpointer     user_data)
+{
+  return child != user_data;
+}
+
+static gint
+populate_child_compare (gconstpointer a,
+                        gconstpointer b,
+                        gpointer      user_data)
+{
+  const PopulateChild *child_a = a;
+  const PopulateChild *child_b = b;
+  Populate *state = user_data;
+
+  if (state->sort_directories_first)
+    return gb_project_file_compare_directories_first (child_a->item, child_b->item);
+  else
+    return gb_project_file_compare (child_a->item, child_b->item);
+}
+
+static void
+gb_project_tree_builder_populate_worker (GTask        *task,
+                                         gpointer      source_object,
+                                         gpointer      task_data,
+                                         GCancellable *cancellable)
 {
   g_autoptr(GFileEnumerator) enumerator = NULL;
-  GbProjectFile *project_file;
+  Populate *state = task_data;
   gpointer file_info_ptr;
-  IdeVcs *vcs;
-  GFile *file;
-  IdeTree *tree;
-  gint count = 0;
-  gboolean show_ignored_files;
+  GError *error = NULL;
 
-  g_return_if_fail (GB_IS_PROJECT_TREE_BUILDER (self));
-  g_return_if_fail (IDE_IS_TREE_NODE (node));
+  g_assert (G_IS_TASK (task));
+  g_assert (GB_IS_PROJECT_TREE_BUILDER (source_object));
+  g_assert (state != NULL);
+  g_assert (G_IS_FILE (state->directory));
 
-  project_file = GB_PROJECT_FILE (ide_tree_node_get_item (node));
+  enumerator = g_file_enumerate_children (state->directory,
+                                          PROJECT_FILE_ATTRIBUTES,
+                                          G_FILE_QUERY_INFO_NONE,
+                                          cancellable,
+                                          &error);
+
+  if (enumerator == NULL)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  while ((file_info_ptr = g_file_enumerator_next_file (enumerator, cancellable, &error)))
+    {
+      g_autoptr(GFileInfo) file_info = file_info_ptr;
+      g_autoptr(GFile) file = NULL;
+      PopulateChild child = { 0 };
+
+      file = g_file_get_child (state->directory, g_file_info_get_name (file_info));
+
+      child.ignored = ide_vcs_is_ignored (state->vcs, file, NULL);
+      if (child.ignored && !state->show_ignored_files)
+        continue;
+
+      child.item = gb_project_file_new (file, file_info);
+      g_array_append_val (state->children, child);
+    }
+
+  if (error != NULL)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_array_sort_with_data (state->children, populate_child_compare, state);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+gb_project_tree_builder_directory_changed (GbProjectTreeBuilder *self,
+                                           GFile                *file,
+                                           GFile                *other_file,
+                                           GFileMonitorEvent     event,
+                                           GFileMonitor         *monitor);
+
+static void
+gb_project_tree_builder_monitor (GbProjectTreeBuilder *self,
+                                 IdeTreeNode          *node,
+                                 GFile                *directory)
+{
+  GFileMonitor *monitor;
+
+  g_assert (GB_IS_PROJECT_TREE_BUILDER (self));
+  g_assert (IDE_IS_TREE_NODE (node));
+  g_assert (G_IS_FILE (directory));
+
+  monitor = g_file_monitor_directory (directory, G_FILE_MONITOR_WATCH_MOVES, NULL, NULL);
+  if (monitor == NULL)
+    return;
+
+  /* The monitor is owned by the node, so the node outlives it. */
+  g_object_set_data (G_OBJECT (monitor), "IDE_TREE_NODE", node);
+  g_signal_connect_object (monitor,
+                           "changed",
+                           G_CALLBACK (gb_project_tree_builder_directory_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_object_set_data_full (G_OBJECT (node),
+                          "GB_PROJECT_TREE_MONITOR",
+                          monitor,
+                          directory_monitor_free);
+}
+
+static void
+gb_project_tree_builder_populated (GbProjectTreeBuilder *self,
+                                   IdeTreeNode          *node)
+{
+  IdeTree *tree;
+
+  g_assert (GB_IS_PROJECT_TREE_BUILDER (self));
+  g_assert (IDE_IS_TREE_NODE (node));
 
   tree = ide_tree_builder_get_tree (IDE_TREE_BUILDER (self));
-  show_ignored_files = gb_project_tree_get_show_ignored_files (GB_PROJECT_TREE (tree));
 
-  vcs = get_vcs (node);
+  if (GB_IS_PROJECT_TREE (tree))
+    _gb_project_tree_node_populated (GB_PROJECT_TREE (tree), node);
+}
+
+static gboolean
+gb_project_tree_builder_populate_batch (gpointer data)
+{
+  GbProjectTreeBuilder *self;
+  GTask *task = data;
+  IdeTreeNode *node;
+  Populate *state;
+  GtkTreeIter iter;
+  guint end;
+
+  g_assert (G_IS_TASK (task));
+
+  self = g_task_get_source_object (task);
+  state = g_task_get_task_data (task);
+
+  /* The node was invalidated and is being populated again. */
+  if (g_hash_table_lookup (self->populating, state->node) != (gpointer)task)
+    return G_SOURCE_REMOVE;
+
+  /* The node was removed from the tree. */
+  if (!ide_tree_node_get_iter (state->node, &iter))
+    {
+      g_hash_table_remove (self->populating, state->node);
+      return G_SOURCE_REMOVE;
+    }
 
   /*
-   * TODO: Make this all async.
+   * If we didn't find any children for this node, insert an empty node to
+   * notify the user that nothing was found.
    */
+  if (state->children->len == 0)
+    ide_tree_node_append (state->node, create_placeholder_node (_("Empty")));
 
-  if (!gb_project_file_get_is_directory (project_file))
-    return;
+  end = MIN (state->position + POPULATE_BATCH_SIZE, state->children->len);
 
-  file = gb_project_file_get_file (project_file);
+  for (; state->position < end; state->position++)
+    {
+      const PopulateChild *child = &g_array_index (state->children, PopulateChild, state->position);
+      IdeTreeNode *child_node;
 
-  enumerator = g_file_enumerate_children (file,
-                                          G_FILE_ATTRIBUTE_STANDARD_NAME","
-                                          G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME","
-                                          G_FILE_ATTRIBUTE_STANDARD_TYPE,
-                                          G_FILE_QUERY_INFO_NONE,
-                                          NULL,
-                                          NULL);
+      /* Children are already sorted, so we can avoid insert_sorted(). */
+      child_node = create_file_node (child->item, child->ignored);
+      ide_tree_node_append (state->node, child_node);
 
-  if (enumerator == NULL)
-    return;
+      if (gb_project_file_get_is_directory (child->item))
+        ide_tree_node_set_children_possible (child_node, TRUE);
+    }
 
-  while ((file_info_ptr = g_file_enumerator_next_file (enumerator, NULL, NULL)))
+  /*
+   * Remove the loading placeholder after the first batch has been added so
+   * that the node does not collapse for lack of children.
+   */
+  if (state->placeholder != NULL)
     {
-      g_autoptr(GFileInfo) item_file_info = file_info_ptr;
-      g_autoptr(GFile) item_file = NULL;
-      g_autoptr(GbProjectFile) item = NULL;
-      IdeTreeNode *child;
-      const gchar *name;
-      const gchar *display_name;
-      const gchar *icon_name;
-      gboolean ignored;
+      ide_tree_node_remove (state->node, state->placeholder);
+      g_clear_object (&state->placeholder);
+    }
 
-      name = g_file_info_get_name (item_file_info);
-      item_file = g_file_get_child (file, name);
+  if (state->position < state->children->len)
+    return G_SOURCE_CONTINUE;
 
-      ignored = ide_vcs_is_ignored (vcs, item_file, NULL);
-      if (ignored && !show_ignored_files)
-        continue;
+  gb_project_tree_builder_monitor (self, state->node, state->directory);
 
-      item = gb_project_file_new (item_file, item_file_info);
+  /* Drop the node from @populating first so a deferred reveal can finish. */
+  node = g_object_ref (state->node);
+  g_hash_table_remove (self->populating, node);
+  gb_project_tree_builder_populated (self, node);
+  g_object_unref (node);
 
-      display_name = gb_project_file_get_display_name (item);
-      icon_name = gb_project_file_get_icon_name (item);
+  return G_SOURCE_REMOVE;
+}
 
-      child = g_object_new (IDE_TYPE_TREE_NODE,
-                            "icon-name", icon_name,
-                            "text", display_name,
-                            "item", item,
-                            "use-dim-label", ignored,
-                            NULL);
+static void
+gb_project_tree_builder_populate_cb (GObject      *object,
+                                     GAsyncResult *result,
+                                     gpointer      user_data)
+{
+  GbProjectTreeBuilder *self = (GbProjectTreeBuilder *)object;
+  GTask *task = (GTask *)result;
+  g_autoptr(GError) error = NULL;
+  Populate *state;
 
-      ide_tree_node_insert_sorted (node, child, compare_nodes_func, self);
+  g_assert (GB_IS_PROJECT_TREE_BUILDER (self));
+  g_assert (G_IS_TASK (task));
+
+  state = g_task_get_task_data (task);
 
-      if (g_file_info_get_file_type (item_file_info) == G_FILE_TYPE_DIRECTORY)
-        ide_tree_node_set_children_possible (child, TRUE);
+  if (!g_task_propagate_boolean (task, &error))
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        return;
 
-      count++;
+      g_debug ("Failed to enumerate directory: %s", error->message);
+      g_array_set_size (state->children, 0);
     }
 
   /*
-   * If we didn't add any children to this node, insert an empty node to
-   * notify the user that nothing was found.
+   * Insert the first batch immediately so that small directories are
+   * populated in one go, and trickle the rest in from an idle handler.
+   */
+  if (gb_project_tree_builder_populate_batch (task) == G_SOURCE_CONTINUE)
+    g_idle_add_full (G_PRIORITY_LOW,
+                     gb_project_tree_builder_populate_batch,
+                     g_object_ref (task),
+                     g_object_unref);
+}
+
+static void
+gb_project_tree_builder_add_file_cb (GObject      *object,
+                                     GAsyncResult *result,
+                                     gpointer      user_data)
+{
+  GFile *file = (GFile *)object;
+  g_autoptr(GFileInfo) file_info = NULL;
+  g_autoptr(GbProjectFile) item = NULL;
+  AddFile *state = user_data;
+  IdeTreeNode *placeholder;
+  IdeTreeNode *child;
+  GtkTreeIter iter;
+  IdeTree *tree;
+  gboolean ignored;
+
+  g_assert (G_IS_FILE (file));
+  g_assert (state != NULL);
+  g_assert (GB_IS_PROJECT_TREE_BUILDER (state->self));
+  g_assert (IDE_IS_TREE_NODE (state->node));
+
+  file_info = g_file_query_info_finish (file, result, NULL);
+
+  if (file_info == NULL ||
+      !ide_tree_node_get_iter (state->node, &iter) ||
+      g_hash_table_contains (state->self->populating, state->node))
+    goto cleanup;
+
+  tree = ide_tree_node_get_tree (state->node);
+
+  if (ide_tree_find_child_node (tree, state->node, find_file_func, file) != NULL)
+    goto cleanup;
+
+  ignored = ide_vcs_is_ignored (get_vcs (state->node), file, NULL);
+  if (ignored && !gb_project_tree_get_show_ignored_files (GB_PROJECT_TREE (tree)))
+    goto cleanup;
+
+  item = gb_project_file_new (file, file_info);
+  child = create_file_node (item, ignored);
+  ide_tree_node_insert_sorted (state->node, child, compare_nodes_func, state->self);
+
+  if (gb_project_file_get_is_directory (item))
+    ide_tree_node_set_children_possible (child, TRUE);
+
+  placeholder = ide_tree_find_child_node (tree, state->node, find_placeholder_func, NULL);
+  if (placeholder != NULL)
+    ide_tree_node_remove (state->node, placeholder);
+
+  gb_project_tree_builder_populated (state->self, state->node);
+
+cleanup:
+  add_file_free (state);
+}
+
+static void
+gb_project_tree_builder_add_file (GbProjectTreeBuilder *self,
+                                  IdeTreeNode          *node,
+                                  GFile                *file)
+{
+  AddFile *state;
+
+  g_assert (GB_IS_PROJECT_TREE_BUILDER (self));
+  g_assert (IDE_IS_TREE_NODE (node));
+  g_assert (G_IS_FILE (file));
+
+  state = g_slice_new0 (AddFile);
+  state->self = g_object_ref (self);
+  state->node = g_object_ref (node);
+
+  g_file_query_info_async (file,
+                           PROJECT_FILE_ATTRIBUTES,
+                           G_FILE_QUERY_INFO_NONE,
+                           G_PRIORITY_LOW,
+                           NULL,
+                           gb_project_tree_builder_add_file_cb,
+                           state);
+}
+
+static void
+gb_project_tree_builder_remove_file (GbProjectTreeBuilder *self,
+                                     IdeTreeNode          *node,
+                                     GFile                *file)
+{
+  IdeTreeNode *child;
+  IdeTree *tree;
+
+  g_assert (GB_IS_PROJECT_TREE_BUILDER (self));
+  g_assert (IDE_IS_TREE_NODE (node));
+  g_assert (G_IS_FILE (file));
+
+  tree = ide_tree_node_get_tree (node);
+
+  if (NULL == (child = ide_tree_find_child_node (tree, node, find_file_func, file)))
+    return;
+
+  /* Keep the node from collapsing when its last child goes away. */
+  if (ide_tree_find_child_node (tree, node, find_sibling_func, child) == NULL)
+    ide_tree_node_append (node, create_placeholder_node (_("Empty")));
+
+  ide_tree_node_remove (node, child);
+}
+
+static void
+gb_project_tree_builder_directory_changed (GbProjectTreeBuilder *self,
+                                           GFile                *file,
+                                           GFile                *other_file,
+                                           GFileMonitorEvent     event,
+                                           GFileMonitor         *monitor)
+{
+  IdeTreeNode *node;
+  GtkTreeIter iter;
+
+  g_assert (GB_IS_PROJECT_TREE_BUILDER (self));
+  g_assert (G_IS_FILE (file));
+  g_assert (G_IS_FILE_MONITOR (monitor));
+
+  node = g_object_get_data (G_OBJECT (monitor), "IDE_TREE_NODE");
+
+  /*
+   * Apply the change to the existing children rather than rebuilding
+   * the directory. If the node is being populated again, the new
+   * enumeration will pick up the change.
    */
-  if (count == 0)
+  if (!IDE_IS_TREE_NODE (node) ||
+      !ide_tree_node_get_iter (node, &iter) ||
+      g_hash_table_contains (self->populating, node))
+    return;
+
+  switch (event)
     {
-      IdeTreeNode *child;
-
-      child = g_object_new (IDE_TYPE_TREE_NODE,
-                            "icon-name", NULL,
-                            "text", _("Empty"),
-                            "use-dim-label", TRUE,
-                            NULL);
-      ide_tree_node_append (node, child);
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_MOVED_IN:
+      gb_project_tree_builder_add_file (self, node, file);
+      break;
+
+    case G_FILE_MONITOR_EVENT_DELETED:
+    case G_FILE_MONITOR_EVENT_MOVED_OUT:
+      gb_project_tree_builder_remove_file (self, node, file);
+      break;
+
+    case G_FILE_MONITOR_EVENT_RENAMED:
+      gb_project_tree_builder_remove_file (self, node, file);
+      if (other_file != NULL)
+        gb_project_tree_builder_add_file (self, node, other_file);
+      break;
+
+    case G_FILE_MONITOR_EVENT_CHANGED:
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+    case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+    case G_FILE_MONITOR_EVENT_PRE_UNMOUNT:
+    case G_FILE_MONITOR_EVENT_UNMOUNTED:
+    case G_FILE_MONITOR_EVENT_MOVED:
+    default:
+      break;
     }
 }
 
+static void
+build_file (GbProjectTreeBuilder *self,
+            IdeTreeNode          *node)
+{
+  g_autoptr(GCancellable) cancellable = NULL;
+  g_autoptr(GTask) task = NULL;
+  GbProjectFile *project_file;
+  Populate *state;
+  IdeTree *tree;
+  GTask *previous;
+
+  g_return_if_fail (GB_IS_PROJECT_TREE_BUILDER (self));
+  g_return_if_fail (IDE_IS_TREE_NODE (node));
+
+  project_file = GB_PROJECT_FILE (ide_tree_node_get_item (node));
+
+  if (!gb_project_file_get_is_directory (project_file))
+    return;
+
+  tree = ide_tree_builder_get_tree (IDE_TREE_BUILDER (self));
+
+  /*
+   * Enumerating large directories and checking each child against the
+   * VCS ignore rules is too slow for the main loop. Do that (and the
+   * sorting) on a worker, and show a placeholder until we're done.
+   */
+  state = g_slice_new0 (Populate);
+  state->node = g_object_ref (node);
+  state->directory = g_object_ref (gb_project_file_get_file (project_file));
+  state->vcs = g_object_ref (get_vcs (node));
+  state->children = g_array_new (FALSE, FALSE, sizeof (PopulateChild));
+  state->show_ignored_files = gb_project_tree_get_show_ignored_files (GB_PROJECT_TREE (tree));
+  state->sort_directories_first = self->sort_directories_first;
+  state->placeholder = g_object_ref_sink (create_placeholder_node (_("Loading…")));
+  g_array_set_clear_func (state->children, populate_child_clear);
+
+  ide_tree_node_append (node, state->placeholder);
+
+  cancellable = g_cancellable_new ();
+
+  task = g_task_new (self, cancellable, gb_project_tree_builder_populate_cb, NULL);
+  g_task_set_source_tag (task, build_file);
+  g_task_set_task_data (task, state, populate_free);
+
+  if (NULL != (previous = g_hash_table_lookup (self->populating, node)))
+    g_cancellable_cancel (g_task_get_cancellable (previous));
+
+  g_hash_table_insert (self->populating, node, g_object_ref (task));
+
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER,
+                             task,
+                             gb_project_tree_builder_populate_worker);
+}
+
+gboolean
+_gb_project_tree_builder_is_populating (GbProjectTreeBuilder *self,
+                                        IdeTreeNode          *node)
+{
+  g_return_val_if_fail (GB_IS_PROJECT_TREE_BUILDER (self), FALSE);
+  g_return_val_if_fail (IDE_IS_TREE_NODE (node), FALSE);
+
+  return g_hash_table_contains (self->populating, node);
+}
+
 static void
 gb_project_tree_builder_build_node (IdeTreeBuilder *builder,
                                     IdeTreeNode    *node)
@@ -378,6 +858,7 @@ gb_project_tree_builder_finalize (GObject *object)
   GbProjectTreeBuilder *self = (GbProjectTreeBuilder *)object;
 
   g_clear_object (&self->file_chooser_settings);
+  g_clear_pointer (&self->populating, g_hash_table_unref);
 
   G_OBJECT_CLASS (gb_project_tree_builder_parent_class)->finalize (object);
 }
@@ -398,6 +879,8 @@ gb_project_tree_builder_class_init (GbProjectTreeBuilderClass *klass)
 static void
 gb_project_tree_builder_init (GbProjectTreeBuilder *self)
 {
+  self->populating = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
+
   self->file_chooser_settings = g_settings_new ("org.gtk.Settings.FileChooser");
   self->sort_directories_first = g_settings_get_boolean (self->file_chooser_settings,
                                                          "sort-directories-first");
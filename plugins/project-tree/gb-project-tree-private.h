@@ -21,18 +21,32 @@
 
 #include <ide.h>
 
+#include "gb-project-tree-builder.h"
+
 G_BEGIN_DECLS
 
 struct _GbProjectTree
 {
-  IdeTree     parent_instance;
+  IdeTree               parent_instance;
+
+  GSettings            *settings;
 
-  GSettings *settings;
+  /* Owned by the tree */
+  GbProjectTreeBuilder *builder;
 
-  guint      expanded_in_new : 1;
-  guint      show_ignored_files : 1;
+  /* Reveal to retry once @reveal_node has been populated */
+  GFile                *reveal_file;
+  IdeTreeNode          *reveal_node;
+
+  guint                 expanded_in_new : 1;
+  guint                 show_ignored_files : 1;
 };
 
+void     _gb_project_tree_node_populated         (GbProjectTree        *self,
+                                                  IdeTreeNode          *node);
+gboolean _gb_project_tree_builder_is_populating (GbProjectTreeBuilder *self,
+                                                  IdeTreeNode          *node);
+
 G_END_DECLS
 
 #endif /* GB_PROJECT_TREE_PRIVATE_H */
@@ -72,7 +72,10 @@ gb_project_tree_project_file_renamed (GbProjectTree *self,
   g_assert (G_IS_FILE (dst_file));
   g_assert (IDE_IS_PROJECT (project));
 
-  ide_tree_rebuild (IDE_TREE (self));
+  /*
+   * The directory monitors will move the node into place, so we only need
+   * to reveal it (possibly once the destination has been updated).
+   */
   gb_project_tree_reveal (self, dst_file);
 
   IDE_EXIT;
@@ -119,7 +122,7 @@ gb_project_tree_project_file_trashed (GbProjectTree *self,
     {
       IdeTreeNode *parent = ide_tree_node_get_parent (node);
 
-      ide_tree_node_invalidate (parent);
+      ide_tree_node_remove (parent, node);
       ide_tree_node_expand (parent, TRUE);
       ide_tree_node_select (parent);
     }
@@ -222,6 +225,8 @@ gb_project_tree_finalize (GObject *object)
   GbProjectTree *self = (GbProjectTree *)object;
 
   g_clear_object (&self->settings);
+  g_clear_object (&self->reveal_file);
+  g_clear_object (&self->reveal_node);
 
   G_OBJECT_CLASS (gb_project_tree_parent_class)->finalize (object);
 }
@@ -287,7 +292,6 @@ static void
 gb_project_tree_init (GbProjectTree *self)
 {
   GtkStyleContext *style_context;
-  IdeTreeBuilder *builder;
   GMenu *menu;
 
   style_context = gtk_widget_get_style_context (GTK_WIDGET (self));
@@ -302,8 +306,8 @@ gb_project_tree_init (GbProjectTree *self)
                    self, "show-ignored-files",
                    G_SETTINGS_BIND_DEFAULT);
 
-  builder = gb_project_tree_builder_new ();
-  ide_tree_add_builder (IDE_TREE (self), builder);
+  self->builder = GB_PROJECT_TREE_BUILDER (gb_project_tree_builder_new ());
+  ide_tree_add_builder (IDE_TREE (self), IDE_TREE_BUILDER (self->builder));
 
   g_signal_connect (self,
                     "notify::selection",
@@ -420,12 +424,55 @@ gb_project_tree_reveal (GbProjectTree *self,
 
   for (i = 0; parts [i]; i++)
     {
-      node = ide_tree_find_child_node (IDE_TREE (self), node, find_child_node, parts [i]);
-      if (node == NULL)
-        return;
+      IdeTreeNode *child;
+
+      child = ide_tree_find_child_node (IDE_TREE (self), node, find_child_node, parts [i]);
+
+      /*
+       * Directories are populated asynchronously, so the child may not have
+       * been added yet. Try again when @node has been populated. If it has
+       * been, the file is ignored or does not exist.
+       */
+      if (child == NULL)
+        {
+          if (_gb_project_tree_builder_is_populating (self->builder, node))
+            {
+              g_set_object (&self->reveal_file, file);
+              g_set_object (&self->reveal_node, node);
+            }
+          else
+            {
+              g_clear_object (&self->reveal_file);
+              g_clear_object (&self->reveal_node);
+            }
+
+          return;
+        }
+
+      node = child;
     }
 
+  g_clear_object (&self->reveal_file);
+  g_clear_object (&self->reveal_node);
+
   ide_tree_expand_to_node (IDE_TREE (self), node);
   ide_tree_scroll_to_node (IDE_TREE (self), node);
   ide_tree_node_select (node);
 }
+
+void
+_gb_project_tree_node_populated (GbProjectTree *self,
+                                 IdeTreeNode   *node)
+{
+  g_autoptr(GFile) file = NULL;
+
+  g_return_if_fail (GB_IS_PROJECT_TREE (self));
+  g_return_if_fail (IDE_IS_TREE_NODE (node));
+
+  if (node == self->reveal_node)
+    {
+      file = g_steal_pointer (&self->reveal_file);
+      g_clear_object (&self->reveal_node);
+      gb_project_tree_reveal (self, file);
+    }
+}
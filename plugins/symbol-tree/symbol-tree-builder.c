@@ -28,6 +28,63 @@ struct _SymbolTreeBuilder
 
 G_DEFINE_TYPE (SymbolTreeBuilder, symbol_tree_builder, IDE_TYPE_TREE_BUILDER)
 
+IdeTreeNode *
+symbol_tree_builder_create_node (IdeSymbolNode *symbol)
+{
+  const gchar *icon_name = NULL;
+
+  g_return_val_if_fail (IDE_IS_SYMBOL_NODE (symbol), NULL);
+
+  switch (ide_symbol_node_get_kind (symbol))
+    {
+    case IDE_SYMBOL_FUNCTION:
+      icon_name = "lang-function-symbolic";
+      break;
+
+    case IDE_SYMBOL_ENUM:
+      icon_name = "lang-enum-symbolic";
+      break;
+
+    case IDE_SYMBOL_ENUM_VALUE:
+      icon_name = "lang-enum-value-symbolic";
+      break;
+
+    case IDE_SYMBOL_STRUCT:
+      icon_name = "lang-struct-symbolic";
+      break;
+
+    case IDE_SYMBOL_CLASS:
+      icon_name = "lang-class-symbolic";
+      break;
+
+    case IDE_SYMBOL_METHOD:
+      icon_name = "lang-method-symbolic";
+      break;
+
+    case IDE_SYMBOL_UNION:
+      icon_name = "lang-union-symbolic";
+      break;
+
+    case IDE_SYMBOL_SCALAR:
+    case IDE_SYMBOL_FIELD:
+    case IDE_SYMBOL_VARIABLE:
+      icon_name = "lang-variable-symbolic";
+      break;
+
+    case IDE_SYMBOL_HEADER:
+    case IDE_SYMBOL_NONE:
+    default:
+      icon_name = NULL;
+      break;
+    }
+
+  return g_object_new (IDE_TYPE_TREE_NODE,
+                       "text", ide_symbol_node_get_name (symbol),
+                       "icon-name", icon_name,
+                       "item", symbol,
+                       NULL);
+}
+
 static void
 symbol_tree_builder_build_node (IdeTreeBuilder *builder,
                                 IdeTreeNode    *node)
@@ -58,64 +115,9 @@ symbol_tree_builder_build_node (IdeTreeBuilder *builder,
   for (i = 0; i < n_children; i++)
     {
       g_autoptr(IdeSymbolNode) symbol = NULL;
-      const gchar *name;
-      const gchar *icon_name = NULL;
-      IdeTreeNode *child;
-      IdeSymbolKind kind;
 
       symbol = ide_symbol_tree_get_nth_child (symbol_tree, parent, i);
-      name = ide_symbol_node_get_name (symbol);
-      kind = ide_symbol_node_get_kind (symbol);
-
-      switch (kind)
-        {
-        case IDE_SYMBOL_FUNCTION:
-          icon_name = "lang-function-symbolic";
-          break;
-
-        case IDE_SYMBOL_ENUM:
-          icon_name = "lang-enum-symbolic";
-          break;
-
-        case IDE_SYMBOL_ENUM_VALUE:
-          icon_name = "lang-enum-value-symbolic";
-          break;
-
-        case IDE_SYMBOL_STRUCT:
-          icon_name = "lang-struct-symbolic";
-          break;
-
-        case IDE_SYMBOL_CLASS:
-          icon_name = "lang-class-symbolic";
-          break;
-
-        case IDE_SYMBOL_METHOD:
-          icon_name = "lang-method-symbolic";
-          break;
-
-        case IDE_SYMBOL_UNION:
-          icon_name = "lang-union-symbolic";
-          break;
-
-        case IDE_SYMBOL_SCALAR:
-        case IDE_SYMBOL_FIELD:
-        case IDE_SYMBOL_VARIABLE:
-          icon_name = "lang-variable-symbolic";
-          break;
-
-        case IDE_SYMBOL_HEADER:
-        case IDE_SYMBOL_NONE:
-        default:
-          icon_name = NULL;
-          break;
-        }
-
-      child = g_object_new (IDE_TYPE_TREE_NODE,
-                            "text", name,
-                            "icon-name", icon_name,
-                            "item", symbol,
-                            NULL);
-      ide_tree_node_append (node, child);
+      ide_tree_node_append (node, symbol_tree_builder_create_node (symbol));
     }
 }
 
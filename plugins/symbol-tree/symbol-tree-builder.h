@@ -27,6 +27,8 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (SymbolTreeBuilder, symbol_tree_builder, SYMBOL, TREE_BUILDER, IdeTreeBuilder)
 
+IdeTreeNode *symbol_tree_builder_create_node (IdeSymbolNode *symbol);
+
 G_END_DECLS
 
 #endif /* SYMBOL_TREE_BUILDER_H */
@@ -32,11 +32,22 @@
 
 #define REFRESH_TREE_INTERVAL_MSEC (15 * 1000)
 
+typedef struct
+{
+  guint       ref_count;
+  /* IdeTreeNode => row index + 1 */
+  GHashTable *indexes;
+  /* Row texts and the index of the parent row, in depth-first order. */
+  GPtrArray  *texts;
+  GArray     *parents;
+} RowSnapshot;
+
 struct _SymbolTreePanel
 {
   PnlDockWidget   parent_instance;
 
   GCancellable   *cancellable;
+  GCancellable   *filter_cancellable;
   EggTaskCache   *symbols_cache;
   IdeTree        *tree;
   GtkSearchEntry *search_entry;
@@ -45,12 +56,131 @@ struct _SymbolTreePanel
   IdeBuffer      *last_document;
   gsize           last_change_count;
 
+  /* Rows of the store, taken while merging a refresh. */
+  RowSnapshot    *snapshot;
+
+  /*
+   * The filter applied to the tree, along with the snapshot it was
+   * computed from. Rows that are not part of that snapshot (added since)
+   * are matched directly against the pattern.
+   */
+  RowSnapshot    *filter_snapshot;
+  IdePatternSpec *filter_spec;
+  GArray         *visible;
+
   guint           refresh_tree_timeout;
 };
 
+typedef struct
+{
+  IdePatternSpec *spec;
+  GPtrArray      *texts;
+  GArray         *parents;
+} FilterRequest;
+
 G_DEFINE_TYPE (SymbolTreePanel, symbol_tree_panel, PNL_TYPE_DOCK_WIDGET)
 
-static void refresh_tree (SymbolTreePanel *self);
+static void refresh_tree               (SymbolTreePanel *self);
+static void symbol_tree_panel_refilter (SymbolTreePanel *self);
+
+static RowSnapshot *
+row_snapshot_new (void)
+{
+  RowSnapshot *snapshot;
+
+  snapshot = g_slice_new0 (RowSnapshot);
+  snapshot->ref_count = 1;
+  snapshot->indexes = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+  snapshot->texts = g_ptr_array_new_with_free_func (g_free);
+  snapshot->parents = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  return snapshot;
+}
+
+static RowSnapshot *
+row_snapshot_ref (RowSnapshot *snapshot)
+{
+  g_assert (snapshot != NULL);
+  g_assert (snapshot->ref_count > 0);
+
+  snapshot->ref_count++;
+
+  return snapshot;
+}
+
+static void
+row_snapshot_unref (RowSnapshot *snapshot)
+{
+  g_assert (snapshot != NULL);
+  g_assert (snapshot->ref_count > 0);
+
+  if (--snapshot->ref_count == 0)
+    {
+      g_hash_table_unref (snapshot->indexes);
+      g_ptr_array_unref (snapshot->texts);
+      g_array_unref (snapshot->parents);
+      g_slice_free (RowSnapshot, snapshot);
+    }
+}
+
+static gint
+row_snapshot_add (RowSnapshot *snapshot,
+                  IdeTreeNode *node,
+                  gint         parent_index)
+{
+  gint index;
+
+  g_assert (snapshot != NULL);
+  g_assert (IDE_IS_TREE_NODE (node));
+
+  index = snapshot->texts->len;
+
+  g_hash_table_insert (snapshot->indexes, g_object_ref (node), GINT_TO_POINTER (index + 1));
+  g_ptr_array_add (snapshot->texts, g_strdup (ide_tree_node_get_text (node)));
+  g_array_append_val (snapshot->parents, parent_index);
+
+  return index;
+}
+
+static void
+row_snapshot_collect (RowSnapshot  *snapshot,
+                      GtkTreeModel *model,
+                      GtkTreeIter  *parent,
+                      gint          parent_index)
+{
+  GtkTreeIter iter;
+
+  g_assert (snapshot != NULL);
+  g_assert (GTK_IS_TREE_MODEL (model));
+
+  if (gtk_tree_model_iter_children (model, &iter, parent))
+    {
+      do
+        {
+          g_autoptr(IdeTreeNode) node = NULL;
+          gint index;
+
+          gtk_tree_model_get (model, &iter, 0, &node, -1);
+          if (node == NULL)
+            continue;
+
+          index = row_snapshot_add (snapshot, node, parent_index);
+          row_snapshot_collect (snapshot, model, &iter, index);
+        }
+      while (gtk_tree_model_iter_next (model, &iter));
+    }
+}
+
+static void
+filter_request_free (gpointer data)
+{
+  FilterRequest *req = data;
+
+  g_clear_pointer (&req->spec, ide_pattern_spec_unref);
+  g_clear_pointer (&req->texts, g_ptr_array_unref);
+  g_clear_pointer (&req->parents, g_array_unref);
+  g_slice_free (FilterRequest, req);
+}
 
 static gboolean
 refresh_tree_timeout (gpointer user_data)
@@ -60,6 +190,171 @@ refresh_tree_timeout (gpointer user_data)
   return G_SOURCE_CONTINUE;
 }
 
+static GtkTreeModel *
+symbol_tree_panel_get_store (SymbolTreePanel *self)
+{
+  GtkTreeModel *model;
+
+  g_assert (SYMBOL_IS_TREE_PANEL (self));
+
+  model = gtk_tree_view_get_model (GTK_TREE_VIEW (self->tree));
+
+  if (GTK_IS_TREE_MODEL_FILTER (model))
+    model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (model));
+
+  return model;
+}
+
+static gchar *
+symbol_tree_panel_get_key (GObject *item)
+{
+  IdeSymbolNode *symbol;
+
+  if (!IDE_IS_SYMBOL_NODE (item))
+    return NULL;
+
+  symbol = IDE_SYMBOL_NODE (item);
+
+  return g_strdup_printf ("%d:%s",
+                          ide_symbol_node_get_kind (symbol),
+                          ide_symbol_node_get_name (symbol));
+}
+
+/*
+ * Reconciles the children of @node with the children of @parent in
+ * @symbol_tree. Symbols are matched by kind and name beneath the same
+ * parent, so rows for unchanged symbols stay in place and keep their
+ * expansion and selection state. Only inserted and removed symbols
+ * touch the underlying GtkTreeStore.
+ *
+ * The resulting rows are recorded in @snapshot (if any) as we go, so
+ * filtering does not need to walk the store again.
+ */
+static void
+symbol_tree_panel_merge (SymbolTreePanel *self,
+                         GtkTreeModel    *model,
+                         IdeTreeNode     *root,
+                         IdeTreeNode     *node,
+                         IdeSymbolTree   *symbol_tree,
+                         IdeSymbolNode   *parent,
+                         RowSnapshot     *snapshot,
+                         gint             parent_index)
+{
+  g_autoptr(GPtrArray) old_children = NULL;
+  g_autoptr(GHashTable) remaining = NULL;
+  GtkTreeIter *parent_iter = NULL;
+  GtkTreeIter iter;
+  GtkTreeIter child_iter;
+  guint n_children;
+  guint cursor = 0;
+  guint pos = 0;
+  guint i;
+
+  g_assert (SYMBOL_IS_TREE_PANEL (self));
+  g_assert (GTK_IS_TREE_MODEL (model));
+  g_assert (IDE_IS_TREE_NODE (node));
+  g_assert (IDE_IS_SYMBOL_TREE (symbol_tree));
+
+  old_children = g_ptr_array_new_with_free_func (g_object_unref);
+  remaining = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  /* The root node is not part of the model, its children are toplevel rows. */
+  if (node != root && ide_tree_node_get_iter (node, &iter))
+    parent_iter = &iter;
+
+  if (gtk_tree_model_iter_children (model, &child_iter, parent_iter))
+    {
+      do
+        {
+          IdeTreeNode *child = NULL;
+          gchar *key;
+
+          gtk_tree_model_get (model, &child_iter, 0, &child, -1);
+          if (child == NULL)
+            continue;
+
+          g_ptr_array_add (old_children, child);
+
+          if ((key = symbol_tree_panel_get_key (ide_tree_node_get_item (child))))
+            {
+              guint count = GPOINTER_TO_UINT (g_hash_table_lookup (remaining, key));
+              g_hash_table_insert (remaining, key, GUINT_TO_POINTER (count + 1));
+            }
+        }
+      while (gtk_tree_model_iter_next (model, &child_iter));
+    }
+
+  n_children = ide_symbol_tree_get_n_children (symbol_tree, parent);
+
+  for (i = 0; i < n_children; i++)
+    {
+      g_autoptr(IdeSymbolNode) symbol = NULL;
+      g_autofree gchar *key = NULL;
+      IdeTreeNode *child;
+      guint count;
+      gint index;
+
+      symbol = ide_symbol_tree_get_nth_child (symbol_tree, parent, i);
+      key = symbol_tree_panel_get_key (G_OBJECT (symbol));
+      count = GPOINTER_TO_UINT (g_hash_table_lookup (remaining, key));
+
+      if (count == 0)
+        {
+          child = symbol_tree_builder_create_node (symbol);
+          ide_tree_node_insert (node, child, pos++);
+          if (node == root)
+            ide_tree_node_expand (child, FALSE);
+
+          /* Pick up the rows the builder created beneath it. */
+          if (snapshot != NULL)
+            {
+              index = row_snapshot_add (snapshot, child, parent_index);
+              if (ide_tree_node_get_iter (child, &child_iter))
+                row_snapshot_collect (snapshot, model, &child_iter, index);
+            }
+
+          continue;
+        }
+
+      /* Anything before the match was removed (or moved) in the new tree. */
+      for (;;)
+        {
+          g_autofree gchar *old_key = NULL;
+
+          child = g_ptr_array_index (old_children, cursor++);
+          old_key = symbol_tree_panel_get_key (ide_tree_node_get_item (child));
+
+          if (old_key != NULL)
+            {
+              guint old_count = GPOINTER_TO_UINT (g_hash_table_lookup (remaining, old_key));
+              g_hash_table_insert (remaining, g_strdup (old_key), GUINT_TO_POINTER (old_count - 1));
+            }
+
+          if (g_strcmp0 (old_key, key) == 0)
+            break;
+
+          ide_tree_node_remove (node, child);
+        }
+
+      ide_tree_node_set_item (child, G_OBJECT (symbol));
+      pos++;
+
+      index = snapshot != NULL ? row_snapshot_add (snapshot, child, parent_index) : -1;
+
+      /*
+       * IdeTree builds the children of toplevel rows eagerly, deeper rows
+       * are only populated once built, so only descend where rows exist.
+       */
+      if (node == root ||
+          (ide_tree_node_get_iter (child, &child_iter) &&
+           gtk_tree_model_iter_has_child (model, &child_iter)))
+        symbol_tree_panel_merge (self, model, root, child, symbol_tree, symbol, snapshot, index);
+    }
+
+  for (; cursor < old_children->len; cursor++)
+    ide_tree_node_remove (node, g_ptr_array_index (old_children, cursor));
+}
+
 static void
 get_cached_symbol_tree_cb (GObject      *object,
                            GAsyncResult *result,
@@ -91,6 +386,33 @@ get_cached_symbol_tree_cb (GObject      *object,
                                               refresh_tree_timeout,
                                               self);
 
+  /*
+   * If we are still showing symbols for this document, apply only what
+   * changed instead of replacing the root and relayouting every row.
+   */
+  root = ide_tree_get_root (self->tree);
+
+  g_clear_pointer (&self->snapshot, row_snapshot_unref);
+
+  if (IDE_IS_SYMBOL_TREE (ide_tree_node_get_item (root)))
+    {
+      /* Only filtering uses the snapshot. */
+      if (!ide_str_empty0 (gtk_entry_get_text (GTK_ENTRY (self->search_entry))))
+        self->snapshot = row_snapshot_new ();
+
+      ide_tree_node_set_item (root, G_OBJECT (symbol_tree));
+      symbol_tree_panel_merge (self,
+                               symbol_tree_panel_get_store (self),
+                               root,
+                               root,
+                               symbol_tree,
+                               NULL,
+                               self->snapshot,
+                               -1);
+      symbol_tree_panel_refilter (self);
+      IDE_EXIT;
+    }
+
   root = g_object_new (IDE_TYPE_TREE_NODE,
                        "item", symbol_tree,
                        NULL);
@@ -111,6 +433,8 @@ get_cached_symbol_tree_cb (GObject      *object,
       while (gtk_tree_model_iter_next (model, &iter));
     }
 
+  symbol_tree_panel_refilter (self);
+
   IDE_EXIT;
 }
 
@@ -161,16 +485,18 @@ refresh_tree (SymbolTreePanel *self)
 
       ide_clear_source (&self->refresh_tree_timeout);
 
-      self->last_document = document;
-      self->last_change_count = change_count;
-
       /*
-       * Clear the old tree items.
-       *
-       * TODO: Get cross compile names for nodes so that we can
-       *       recompute the open state.
+       * Clear the old tree items when switching documents. Otherwise we
+       * keep the current rows and merge the new symbols into them.
        */
-      ide_tree_set_root (self->tree, ide_tree_node_new ());
+      if (document != self->last_document)
+        {
+          ide_tree_set_root (self->tree, ide_tree_node_new ());
+          g_clear_pointer (&self->snapshot, row_snapshot_unref);
+        }
+
+      self->last_document = document;
+      self->last_change_count = change_count;
 
       /*
        * Fetch the symbols via the transparent cache.
@@ -273,45 +599,187 @@ filter_symbols_cb (IdeTree     *tree,
                    IdeTreeNode *node,
                    gpointer     user_data)
 {
-  IdePatternSpec *spec = user_data;
+  SymbolTreePanel *self = user_data;
   const gchar *text;
+  gint index;
 
   g_assert (IDE_IS_TREE (tree));
   g_assert (IDE_IS_TREE_NODE (node));
-  g_assert (spec != NULL);
+  g_assert (SYMBOL_IS_TREE_PANEL (self));
+
+  if (self->filter_snapshot != NULL &&
+      0 != (index = GPOINTER_TO_INT (g_hash_table_lookup (self->filter_snapshot->indexes, node))))
+    return g_array_index (self->visible, gboolean, index - 1);
 
-  if ((text = ide_tree_node_get_text (node)) != NULL)
-    return ide_pattern_spec_match (spec, text);
+  if (self->filter_spec == NULL)
+    return TRUE;
 
-  return FALSE;
+  text = ide_tree_node_get_text (node);
+
+  return text != NULL && ide_pattern_spec_match (self->filter_spec, text);
 }
 
 static void
-symbol_tree__search_entry_changed (SymbolTreePanel *self,
-                                   GtkSearchEntry  *search_entry)
+symbol_tree_panel_clear_filter (SymbolTreePanel *self)
+{
+  g_assert (SYMBOL_IS_TREE_PANEL (self));
+
+  g_clear_pointer (&self->filter_snapshot, row_snapshot_unref);
+  g_clear_pointer (&self->filter_spec, ide_pattern_spec_unref);
+  g_clear_pointer (&self->visible, g_array_unref);
+}
+
+static void
+symbol_tree_panel_filter_worker (GTask        *task,
+                                 gpointer      source_object,
+                                 gpointer      task_data,
+                                 GCancellable *cancellable)
+{
+  FilterRequest *req = task_data;
+  GArray *visible;
+  guint i;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (req != NULL);
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  visible = g_array_sized_new (FALSE, TRUE, sizeof (gboolean), req->texts->len);
+  g_array_set_size (visible, req->texts->len);
+
+  /* A row is visible if it matches or any of its descendants match. */
+  for (i = 0; i < req->texts->len; i++)
+    {
+      const gchar *text = g_ptr_array_index (req->texts, i);
+      gint j;
+
+      if (text == NULL || !ide_pattern_spec_match (req->spec, text))
+        continue;
+
+      for (j = i; j != -1 && !g_array_index (visible, gboolean, j); j = g_array_index (req->parents, gint, j))
+        g_array_index (visible, gboolean, j) = TRUE;
+    }
+
+  g_task_return_pointer (task, visible, (GDestroyNotify)g_array_unref);
+}
+
+static void
+symbol_tree_panel_filter_cb (GObject      *object,
+                             GAsyncResult *result,
+                             gpointer      user_data)
 {
+  SymbolTreePanel *self = (SymbolTreePanel *)object;
+  RowSnapshot *snapshot = user_data;
+  g_autoptr(GArray) visible = NULL;
+  GtkTreeModel *model;
+  FilterRequest *req;
+  gboolean text_changed;
+
+  g_assert (SYMBOL_IS_TREE_PANEL (self));
+  g_assert (G_IS_TASK (result));
+  g_assert (snapshot != NULL);
+
+  if (!(visible = g_task_propagate_pointer (G_TASK (result), NULL)))
+    {
+      row_snapshot_unref (snapshot);
+      return;
+    }
+
+  req = g_task_get_task_data (G_TASK (result));
+
+  text_changed = (self->filter_spec == NULL ||
+                  g_strcmp0 (ide_pattern_spec_get_text (self->filter_spec),
+                             ide_pattern_spec_get_text (req->spec)) != 0);
+
+  symbol_tree_panel_clear_filter (self);
+
+  self->filter_snapshot = snapshot;
+  self->filter_spec = ide_pattern_spec_ref (req->spec);
+  self->visible = g_steal_pointer (&visible);
+
+  /*
+   * Refilter the model in place when we can, rows that stay visible then
+   * keep their expansion. Everything is expanded only when the search
+   * text changed, so a refresh does not undo what the user collapsed.
+   */
+  model = gtk_tree_view_get_model (GTK_TREE_VIEW (self->tree));
+
+  if (GTK_IS_TREE_MODEL_FILTER (model))
+    gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (model));
+  else
+    ide_tree_set_filter (self->tree, filter_symbols_cb, self, NULL);
+
+  if (text_changed)
+    gtk_tree_view_expand_all (GTK_TREE_VIEW (self->tree));
+}
+
+/*
+ * Matches the search text against a snapshot of the row texts on a
+ * worker thread. The tree filter then only needs a hashtable lookup
+ * per row rather than matching every descendant on the main thread.
+ * The snapshot is taken while merging a refresh, so we only walk the
+ * store ourselves when it is missing.
+ */
+static void
+symbol_tree_panel_refilter (SymbolTreePanel *self)
+{
+  g_autoptr(GTask) task = NULL;
+  FilterRequest *req;
   const gchar *text;
 
-  g_return_if_fail (SYMBOL_IS_TREE_PANEL (self));
-  g_return_if_fail (GTK_IS_SEARCH_ENTRY (search_entry));
+  g_assert (SYMBOL_IS_TREE_PANEL (self));
 
-  text = gtk_entry_get_text (GTK_ENTRY (search_entry));
+  if (self->filter_cancellable != NULL)
+    {
+      g_cancellable_cancel (self->filter_cancellable);
+      g_clear_object (&self->filter_cancellable);
+    }
+
+  text = gtk_entry_get_text (GTK_ENTRY (self->search_entry));
 
   if (ide_str_empty0 (text))
     {
       ide_tree_set_filter (self->tree, NULL, NULL, NULL);
+      symbol_tree_panel_clear_filter (self);
+      return;
     }
-  else
+
+  if (self->snapshot == NULL)
     {
-      IdePatternSpec *spec;
-
-      spec = ide_pattern_spec_new (text);
-      ide_tree_set_filter (self->tree,
-                           filter_symbols_cb,
-                           spec,
-                           (GDestroyNotify)ide_pattern_spec_unref);
-      gtk_tree_view_expand_all (GTK_TREE_VIEW (self->tree));
+      self->snapshot = row_snapshot_new ();
+      row_snapshot_collect (self->snapshot, symbol_tree_panel_get_store (self), NULL, -1);
     }
+
+  req = g_slice_new0 (FilterRequest);
+  req->spec = ide_pattern_spec_new (text);
+  req->texts = g_ptr_array_ref (self->snapshot->texts);
+  req->parents = g_array_ref (self->snapshot->parents);
+
+  self->filter_cancellable = g_cancellable_new ();
+
+  /*
+   * The row nodes stay with the callback data so that they are only
+   * released on the main thread. Filtering is quick and interactive, so
+   * it runs on the default GTask pool rather than behind compiler jobs.
+   */
+  task = g_task_new (self,
+                     self->filter_cancellable,
+                     symbol_tree_panel_filter_cb,
+                     row_snapshot_ref (self->snapshot));
+  g_task_set_source_tag (task, symbol_tree_panel_refilter);
+  g_task_set_task_data (task, req, filter_request_free);
+  g_task_run_in_thread (task, symbol_tree_panel_filter_worker);
+}
+
+static void
+symbol_tree__search_entry_changed (SymbolTreePanel *self,
+                                   GtkSearchEntry  *search_entry)
+{
+  g_return_if_fail (SYMBOL_IS_TREE_PANEL (self));
+  g_return_if_fail (GTK_IS_SEARCH_ENTRY (search_entry));
+
+  symbol_tree_panel_refilter (self);
 }
 
 static void
@@ -322,6 +790,15 @@ symbol_tree_panel_finalize (GObject *object)
   ide_clear_source (&self->refresh_tree_timeout);
   g_clear_object (&self->cancellable);
 
+  if (self->filter_cancellable != NULL)
+    {
+      g_cancellable_cancel (self->filter_cancellable);
+      g_clear_object (&self->filter_cancellable);
+    }
+
+  symbol_tree_panel_clear_filter (self);
+  g_clear_pointer (&self->snapshot, row_snapshot_unref);
+
   G_OBJECT_CLASS (symbol_tree_panel_parent_class)->finalize (object);
 }
 
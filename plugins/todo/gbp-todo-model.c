@@ -0,0 +1,516 @@
+/* gbp-todo-model.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-todo-model"
+
+#include <string.h>
+
+#include "gbp-todo-item.h"
+#include "gbp-todo-model.h"
+
+/*
+ * These mirror what we used to ask of "grep -A 5 -I". We include up to
+ * MAX_CONTEXT_LINES lines after each keyword, skip lines that are too long
+ * to be useful (such as from minified or SVG files), and skip files that
+ * look binary.
+ */
+#define MAX_CONTEXT_LINES 5
+#define MAX_LINE_LENGTH   1024
+#define MAX_FILE_SIZE     (10 * 1024 * 1024)
+#define BINARY_CHECK_SIZE 4096
+
+struct _GbpTodoModel
+{
+  GtkListStore  parent_instance;
+
+  IdeVcs       *vcs;
+
+  /*
+   * GFile -> GArray of GtkTreeIter. GtkListStore iters persist across
+   * changes to other rows, so we can replace the items for a single file
+   * without walking the rest of the model.
+   */
+  GHashTable   *iters_by_file;
+};
+
+typedef struct
+{
+  GFile     *file;
+  GPtrArray *items;
+} MinedFile;
+
+typedef struct
+{
+  IdeVcs    *vcs;
+  GFile     *file;
+  guint      single_file : 1;
+} MineState;
+
+G_DEFINE_TYPE (GbpTodoModel, gbp_todo_model, GTK_TYPE_LIST_STORE)
+
+static const gchar *keywords[] = { "FIXME:", "XXX:", "TODO:" };
+static const gchar *ignored_suffixes[] = { ".m4", ".po" };
+
+static void
+mined_file_free (gpointer data)
+{
+  MinedFile *mined = data;
+
+  g_clear_object (&mined->file);
+  g_clear_pointer (&mined->items, g_ptr_array_unref);
+  g_slice_free (MinedFile, mined);
+}
+
+static MinedFile *
+mined_file_new (GFile *file)
+{
+  MinedFile *mined;
+
+  mined = g_slice_new0 (MinedFile);
+  mined->file = g_object_ref (file);
+  mined->items = g_ptr_array_new_with_free_func (g_object_unref);
+
+  return mined;
+}
+
+static void
+mine_state_free (gpointer data)
+{
+  MineState *state = data;
+
+  g_clear_object (&state->vcs);
+  g_clear_object (&state->file);
+  g_slice_free (MineState, state);
+}
+
+static gboolean
+line_has_keyword (const gchar *line,
+                  gsize        len)
+{
+  guint i;
+
+  /* All of our keywords end in ':', which is rare enough to check first. */
+  if (memchr (line, ':', len) == NULL)
+    return FALSE;
+
+  for (i = 0; i < G_N_ELEMENTS (keywords); i++)
+    {
+      if (g_strstr_len (line, len, keywords [i]) != NULL)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+is_blank (const gchar *line,
+          gsize        len)
+{
+  gsize i;
+
+  for (i = 0; i < len; i++)
+    {
+      if (!g_ascii_isspace (line [i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+flush_item (MinedFile *mined,
+            guint      line,
+            GString   *message)
+{
+  g_assert (mined != NULL);
+  g_assert (message != NULL);
+
+  if (g_utf8_validate (message->str, message->len, NULL))
+    g_ptr_array_add (mined->items, gbp_todo_item_new (mined->file, line, message->str));
+
+  g_string_free (message, TRUE);
+}
+
+static void
+gbp_todo_model_mine_file (GFile     *file,
+                          GPtrArray *results)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autofree gchar *path = NULL;
+  g_autofree gchar *name = NULL;
+  MinedFile *mined;
+  GString *message = NULL;
+  const gchar *line;
+  const gchar *end;
+  guint message_line = 0;
+  guint n_context = 0;
+  guint lineno = 0;
+  gsize len;
+  guint i;
+
+  g_assert (G_IS_FILE (file));
+  g_assert (results != NULL);
+
+  /*
+   * Always add an entry for the file, even if it has no items, so that
+   * stale items from a previous mine are removed from the model.
+   */
+  mined = mined_file_new (file);
+  g_ptr_array_add (results, mined);
+
+  name = g_file_get_basename (file);
+
+  for (i = 0; i < G_N_ELEMENTS (ignored_suffixes); i++)
+    {
+      if (g_str_has_suffix (name, ignored_suffixes [i]))
+        return;
+    }
+
+  if (!(path = g_file_get_path (file)) ||
+      !(mapped = g_mapped_file_new (path, FALSE, NULL)))
+    return;
+
+  len = g_mapped_file_get_length (mapped);
+  line = g_mapped_file_get_contents (mapped);
+
+  if (len == 0 || len > MAX_FILE_SIZE || memchr (line, '\0', MIN (len, BINARY_CHECK_SIZE)) != NULL)
+    return;
+
+  for (end = line + len; line < end; )
+    {
+      const gchar *eol = memchr (line, '\n', end - line);
+      gsize line_len = (eol ? eol : end) - line;
+
+      lineno++;
+
+      if (line_len > 0 && line [line_len - 1] == '\r')
+        line_len--;
+
+      if (line_len <= MAX_LINE_LENGTH && line_has_keyword (line, line_len))
+        {
+          if (message != NULL)
+            flush_item (mined, message_line, message);
+
+          message = g_string_new_len (line, line_len);
+          message_line = lineno;
+          n_context = 0;
+        }
+      else if (message != NULL)
+        {
+          if (line_len <= MAX_LINE_LENGTH && !is_blank (line, line_len))
+            {
+              g_string_append_c (message, '\n');
+              g_string_append_len (message, line, line_len);
+            }
+
+          if (++n_context == MAX_CONTEXT_LINES)
+            {
+              flush_item (mined, message_line, message);
+              message = NULL;
+            }
+        }
+
+      line = eol ? eol + 1 : end;
+    }
+
+  if (message != NULL)
+    flush_item (mined, message_line, message);
+}
+
+static void
+gbp_todo_model_mine_directory (IdeVcs       *vcs,
+                               GFile        *directory,
+                               GPtrArray    *results,
+                               GCancellable *cancellable)
+{
+  g_autoptr(GFileEnumerator) enumerator = NULL;
+  g_autoptr(GPtrArray) children = NULL;
+  gpointer infoptr;
+  guint i;
+
+  g_assert (IDE_IS_VCS (vcs));
+  g_assert (G_IS_FILE (directory));
+  g_assert (results != NULL);
+
+  enumerator = g_file_enumerate_children (directory,
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME","
+                                          G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          cancellable,
+                                          NULL);
+
+  if (enumerator == NULL)
+    return;
+
+  while ((infoptr = g_file_enumerator_next_file (enumerator, cancellable, NULL)))
+    {
+      g_autoptr(GFileInfo) info = infoptr;
+      g_autoptr(GFile) child = NULL;
+      GFileType file_type;
+
+      file_type = g_file_info_get_file_type (info);
+
+      if (file_type != G_FILE_TYPE_DIRECTORY && file_type != G_FILE_TYPE_REGULAR)
+        continue;
+
+      child = g_file_get_child (directory, g_file_info_get_name (info));
+
+      /*
+       * Apply the ignore rules while walking so that we never descend into
+       * ignored directories (such as build directories) at all.
+       */
+      if (ide_vcs_is_ignored (vcs, child, NULL))
+        continue;
+
+      if (file_type == G_FILE_TYPE_DIRECTORY)
+        {
+          if (children == NULL)
+            children = g_ptr_array_new_with_free_func (g_object_unref);
+          g_ptr_array_add (children, g_steal_pointer (&child));
+          continue;
+        }
+
+      gbp_todo_model_mine_file (child, results);
+    }
+
+  /* Release the enumerator before recursing so we don't hold open fds. */
+  g_clear_object (&enumerator);
+
+  for (i = 0; children != NULL && i < children->len; i++)
+    {
+      if (g_cancellable_is_cancelled (cancellable))
+        return;
+
+      gbp_todo_model_mine_directory (vcs, g_ptr_array_index (children, i), results, cancellable);
+    }
+}
+
+static void
+gbp_todo_model_mine_worker (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  g_autoptr(GPtrArray) results = NULL;
+  MineState *state = task_data;
+  GFileType file_type;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (GBP_IS_TODO_MODEL (source_object));
+  g_assert (state != NULL);
+  g_assert (IDE_IS_VCS (state->vcs));
+  g_assert (G_IS_FILE (state->file));
+
+  results = g_ptr_array_new_with_free_func (mined_file_free);
+  file_type = g_file_query_file_type (state->file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, cancellable);
+
+  if (file_type == G_FILE_TYPE_DIRECTORY)
+    {
+      if (!ide_vcs_is_ignored (state->vcs, state->file, NULL))
+        gbp_todo_model_mine_directory (state->vcs, state->file, results, cancellable);
+    }
+  else
+    {
+      state->single_file = TRUE;
+
+      if (file_type == G_FILE_TYPE_REGULAR && !ide_vcs_is_ignored (state->vcs, state->file, NULL))
+        gbp_todo_model_mine_file (state->file, results);
+      else
+        g_ptr_array_add (results, mined_file_new (state->file));
+    }
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  g_task_return_pointer (task, g_steal_pointer (&results), (GDestroyNotify)g_ptr_array_unref);
+}
+
+static void
+gbp_todo_model_apply (GbpTodoModel *self,
+                      GPtrArray    *results,
+                      gboolean      prepend)
+{
+  guint i;
+
+  g_assert (GBP_IS_TODO_MODEL (self));
+  g_assert (results != NULL);
+
+  for (i = 0; i < results->len; i++)
+    {
+      MinedFile *mined = g_ptr_array_index (results, i);
+      GArray *iters;
+      guint j;
+
+      if ((iters = g_hash_table_lookup (self->iters_by_file, mined->file)))
+        {
+          for (j = 0; j < iters->len; j++)
+            gtk_list_store_remove (GTK_LIST_STORE (self), &g_array_index (iters, GtkTreeIter, j));
+          g_hash_table_remove (self->iters_by_file, mined->file);
+        }
+
+      if (mined->items->len == 0)
+        continue;
+
+      iters = g_array_sized_new (FALSE, FALSE, sizeof (GtkTreeIter), mined->items->len);
+
+      for (j = 0; j < mined->items->len; j++)
+        {
+          GbpTodoItem *item = g_ptr_array_index (mined->items, j);
+          GtkTreeIter iter;
+
+          /*
+           * Just updated files are placed at the top so that they can be
+           * navigated to quickly.
+           */
+          if (prepend)
+            gtk_list_store_insert (GTK_LIST_STORE (self), &iter, j);
+          else
+            gtk_list_store_append (GTK_LIST_STORE (self), &iter);
+
+          gtk_list_store_set (GTK_LIST_STORE (self), &iter,
+                              GBP_TODO_MODEL_COLUMN_ITEM, item,
+                              -1);
+
+          g_array_append_val (iters, iter);
+        }
+
+      g_hash_table_insert (self->iters_by_file, g_object_ref (mined->file), iters);
+    }
+}
+
+static void
+gbp_todo_model_mine_cb (GObject      *object,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+  GbpTodoModel *self = (GbpTodoModel *)object;
+  g_autoptr(GPtrArray) results = NULL;
+  g_autoptr(GTask) task = user_data;
+  MineState *state;
+  GError *error = NULL;
+
+  g_assert (GBP_IS_TODO_MODEL (self));
+  g_assert (G_IS_TASK (result));
+  g_assert (G_IS_TASK (task));
+
+  if (!(results = g_task_propagate_pointer (G_TASK (result), &error)))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  state = g_task_get_task_data (G_TASK (result));
+  gbp_todo_model_apply (self, results, state->single_file);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+gbp_todo_model_finalize (GObject *object)
+{
+  GbpTodoModel *self = (GbpTodoModel *)object;
+
+  g_clear_pointer (&self->iters_by_file, g_hash_table_unref);
+  g_clear_object (&self->vcs);
+
+  G_OBJECT_CLASS (gbp_todo_model_parent_class)->finalize (object);
+}
+
+static void
+gbp_todo_model_class_init (GbpTodoModelClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_todo_model_finalize;
+}
+
+static void
+gbp_todo_model_init (GbpTodoModel *self)
+{
+  GType column_types[] = { GBP_TYPE_TODO_ITEM };
+
+  gtk_list_store_set_column_types (GTK_LIST_STORE (self),
+                                   G_N_ELEMENTS (column_types),
+                                   column_types);
+
+  self->iters_by_file = g_hash_table_new_full (g_file_hash,
+                                               (GEqualFunc)g_file_equal,
+                                               g_object_unref,
+                                               (GDestroyNotify)g_array_unref);
+}
+
+GbpTodoModel *
+gbp_todo_model_new (IdeVcs *vcs)
+{
+  GbpTodoModel *self;
+
+  g_return_val_if_fail (IDE_IS_VCS (vcs), NULL);
+
+  self = g_object_new (GBP_TYPE_TODO_MODEL, NULL);
+  self->vcs = g_object_ref (vcs);
+
+  return self;
+}
+
+/**
+ * gbp_todo_model_mine_async:
+ * @self: a #GbpTodoModel
+ * @file: a #GFile for a directory or a single file
+ *
+ * Mines @file for todo items on the indexer thread pool. If @file is a
+ * directory, it is walked recursively, skipping anything ignored by the
+ * version control system. Once complete, the items for every file that
+ * was mined replace the previous items for that file in the model.
+ */
+void
+gbp_todo_model_mine_async (GbpTodoModel        *self,
+                           GFile               *file,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  g_autoptr(GTask) real_task = NULL;
+  MineState *state;
+
+  g_return_if_fail (GBP_IS_TODO_MODEL (self));
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+
+  state = g_slice_new0 (MineState);
+  state->vcs = g_object_ref (self->vcs);
+  state->file = g_object_ref (file);
+
+  real_task = g_task_new (self, cancellable, gbp_todo_model_mine_cb, g_object_ref (task));
+  g_task_set_task_data (real_task, state, mine_state_free);
+
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, real_task, gbp_todo_model_mine_worker);
+}
+
+gboolean
+gbp_todo_model_mine_finish (GbpTodoModel  *self,
+                            GAsyncResult  *result,
+                            GError       **error)
+{
+  g_return_val_if_fail (GBP_IS_TODO_MODEL (self), FALSE);
+  g_return_val_if_fail (G_IS_TASK (result), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
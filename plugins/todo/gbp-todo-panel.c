@@ -0,0 +1,269 @@
+/* gbp-todo-panel.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-todo-panel"
+
+#include <glib/gi18n.h>
+
+#include "gbp-todo-item.h"
+#include "gbp-todo-panel.h"
+
+struct _GbpTodoPanel
+{
+  PnlDockWidget  parent_instance;
+
+  GFile         *workdir;
+  GtkTreeView   *tree_view;
+};
+
+G_DEFINE_TYPE (GbpTodoPanel, gbp_todo_panel, PNL_TYPE_DOCK_WIDGET)
+
+static void
+gbp_todo_panel_file_data_func (GtkCellLayout   *layout,
+                               GtkCellRenderer *cell,
+                               GtkTreeModel    *model,
+                               GtkTreeIter     *iter,
+                               gpointer         user_data)
+{
+  GbpTodoPanel *self = user_data;
+  g_autoptr(GbpTodoItem) item = NULL;
+  g_autofree gchar *relpath = NULL;
+  g_autofree gchar *text = NULL;
+  GFile *file;
+
+  gtk_tree_model_get (model, iter, GBP_TODO_MODEL_COLUMN_ITEM, &item, -1);
+
+  if (item == NULL)
+    return;
+
+  file = gbp_todo_item_get_file (item);
+
+  if (!(relpath = g_file_get_relative_path (self->workdir, file)))
+    relpath = g_file_get_path (file);
+
+  text = g_strdup_printf ("%s:%u", relpath, gbp_todo_item_get_line (item));
+  g_object_set (cell, "text", text, NULL);
+}
+
+static void
+gbp_todo_panel_message_data_func (GtkCellLayout   *layout,
+                                  GtkCellRenderer *cell,
+                                  GtkTreeModel    *model,
+                                  GtkTreeIter     *iter,
+                                  gpointer         user_data)
+{
+  g_autoptr(GbpTodoItem) item = NULL;
+  g_autofree gchar *shortdesc = NULL;
+
+  gtk_tree_model_get (model, iter, GBP_TODO_MODEL_COLUMN_ITEM, &item, -1);
+
+  if (item == NULL)
+    return;
+
+  shortdesc = gbp_todo_item_get_shortdesc (item);
+  g_object_set (cell, "text", shortdesc, NULL);
+}
+
+static gboolean
+gbp_todo_panel_query_tooltip (GbpTodoPanel *self,
+                              gint          x,
+                              gint          y,
+                              gboolean      keyboard_mode,
+                              GtkTooltip   *tooltip,
+                              GtkTreeView  *tree_view)
+{
+  g_autoptr(GbpTodoItem) item = NULL;
+  g_autoptr(GtkTreePath) path = NULL;
+  g_autofree gchar *escaped = NULL;
+  g_autofree gchar *markup = NULL;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+
+  g_assert (GBP_IS_TODO_PANEL (self));
+  g_assert (GTK_IS_TREE_VIEW (tree_view));
+
+  gtk_tree_view_convert_widget_to_bin_window_coords (tree_view, x, y, &x, &y);
+
+  if (!gtk_tree_view_get_path_at_pos (tree_view, x, y, &path, NULL, NULL, NULL))
+    return FALSE;
+
+  model = gtk_tree_view_get_model (tree_view);
+
+  if (!gtk_tree_model_get_iter (model, &iter, path))
+    return FALSE;
+
+  gtk_tree_model_get (model, &iter, GBP_TODO_MODEL_COLUMN_ITEM, &item, -1);
+
+  if (item == NULL)
+    return FALSE;
+
+  escaped = g_markup_escape_text (gbp_todo_item_get_message (item), -1);
+  markup = g_strdup_printf ("<tt>%s</tt>", escaped);
+  gtk_tooltip_set_markup (tooltip, markup);
+
+  return TRUE;
+}
+
+static void
+gbp_todo_panel_row_activated (GbpTodoPanel      *self,
+                              GtkTreePath       *path,
+                              GtkTreeViewColumn *column,
+                              GtkTreeView       *tree_view)
+{
+  g_autoptr(GbpTodoItem) item = NULL;
+  g_autoptr(IdeUri) uri = NULL;
+  g_autofree gchar *fragment = NULL;
+  IdeWorkbench *workbench;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+
+  g_assert (GBP_IS_TODO_PANEL (self));
+  g_assert (path != NULL);
+  g_assert (GTK_IS_TREE_VIEW (tree_view));
+
+  model = gtk_tree_view_get_model (tree_view);
+
+  if (!gtk_tree_model_get_iter (model, &iter, path))
+    return;
+
+  gtk_tree_model_get (model, &iter, GBP_TODO_MODEL_COLUMN_ITEM, &item, -1);
+
+  if (item == NULL)
+    return;
+
+  uri = ide_uri_new_from_file (gbp_todo_item_get_file (item));
+  fragment = g_strdup_printf ("L%u", MAX (1, gbp_todo_item_get_line (item)) - 1);
+  ide_uri_set_fragment (uri, fragment);
+
+  workbench = ide_widget_get_workbench (GTK_WIDGET (self));
+  ide_workbench_open_uri_async (workbench, uri, "editor", NULL, NULL, NULL);
+}
+
+static void
+gbp_todo_panel_finalize (GObject *object)
+{
+  GbpTodoPanel *self = (GbpTodoPanel *)object;
+
+  g_clear_object (&self->workdir);
+
+  G_OBJECT_CLASS (gbp_todo_panel_parent_class)->finalize (object);
+}
+
+static void
+gbp_todo_panel_class_init (GbpTodoPanelClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_todo_panel_finalize;
+}
+
+static void
+gbp_todo_panel_init (GbpTodoPanel *self)
+{
+  GtkTreeViewColumn *column;
+  GtkCellRenderer *cell;
+  GtkWidget *scroller;
+
+  g_object_set (self, "title", _("Todo"), NULL);
+
+  scroller = g_object_new (GTK_TYPE_SCROLLED_WINDOW,
+                           "visible", TRUE,
+                           NULL);
+  gtk_container_add (GTK_CONTAINER (self), scroller);
+
+  self->tree_view = g_object_new (GTK_TYPE_TREE_VIEW,
+                                  "has-tooltip", TRUE,
+                                  "visible", TRUE,
+                                  NULL);
+  g_signal_connect_object (self->tree_view,
+                           "query-tooltip",
+                           G_CALLBACK (gbp_todo_panel_query_tooltip),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->tree_view,
+                           "row-activated",
+                           G_CALLBACK (gbp_todo_panel_row_activated),
+                           self,
+                           G_CONNECT_SWAPPED);
+  gtk_container_add (GTK_CONTAINER (scroller), GTK_WIDGET (self->tree_view));
+
+  column = g_object_new (GTK_TYPE_TREE_VIEW_COLUMN,
+                         "title", _("File"),
+                         NULL);
+  cell = g_object_new (GTK_TYPE_CELL_RENDERER_TEXT,
+                       "xalign", 0.0f,
+                       NULL);
+  gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (column), cell, TRUE);
+  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (column), cell,
+                                      gbp_todo_panel_file_data_func,
+                                      self, NULL);
+  gtk_tree_view_append_column (self->tree_view, column);
+
+  column = g_object_new (GTK_TYPE_TREE_VIEW_COLUMN,
+                         "title", _("Message"),
+                         NULL);
+  cell = g_object_new (GTK_TYPE_CELL_RENDERER_TEXT,
+                       "xalign", 0.0f,
+                       NULL);
+  gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (column), cell, TRUE);
+  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (column), cell,
+                                      gbp_todo_panel_message_data_func,
+                                      NULL, NULL);
+  gtk_tree_view_append_column (self->tree_view, column);
+}
+
+GtkWidget *
+gbp_todo_panel_new (GFile        *workdir,
+                    GbpTodoModel *model)
+{
+  GbpTodoPanel *self;
+
+  g_return_val_if_fail (G_IS_FILE (workdir), NULL);
+  g_return_val_if_fail (GBP_IS_TODO_MODEL (model), NULL);
+
+  self = g_object_new (GBP_TYPE_TODO_PANEL, NULL);
+  self->workdir = g_object_ref (workdir);
+  gtk_tree_view_set_model (self->tree_view, GTK_TREE_MODEL (model));
+
+  return GTK_WIDGET (self);
+}
+
+/**
+ * gbp_todo_panel_select_first:
+ *
+ * Selects and scrolls to the first item, which is where the items of a
+ * just-saved file are placed.
+ */
+void
+gbp_todo_panel_select_first (GbpTodoPanel *self)
+{
+  g_autoptr(GtkTreePath) path = NULL;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+
+  g_return_if_fail (GBP_IS_TODO_PANEL (self));
+
+  model = gtk_tree_view_get_model (self->tree_view);
+
+  if (model == NULL || !gtk_tree_model_get_iter_first (model, &iter))
+    return;
+
+  gtk_tree_selection_select_iter (gtk_tree_view_get_selection (self->tree_view), &iter);
+  path = gtk_tree_model_get_path (model, &iter);
+  gtk_tree_view_scroll_to_cell (self->tree_view, path, NULL, TRUE, 0.0, 0.0);
+}
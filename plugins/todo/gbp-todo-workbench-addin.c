@@ -0,0 +1,194 @@
+/* gbp-todo-workbench-addin.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-todo-workbench-addin"
+
+#include "gbp-todo-model.h"
+#include "gbp-todo-panel.h"
+#include "gbp-todo-workbench-addin.h"
+
+struct _GbpTodoWorkbenchAddin
+{
+  GObject       parent_instance;
+
+  GbpTodoModel *model;
+  GtkWidget    *panel;
+  GCancellable *cancellable;
+};
+
+static void workbench_addin_iface_init (IdeWorkbenchAddinInterface *iface);
+
+G_DEFINE_TYPE_EXTENDED (GbpTodoWorkbenchAddin, gbp_todo_workbench_addin, G_TYPE_OBJECT, 0,
+                        G_IMPLEMENT_INTERFACE (IDE_TYPE_WORKBENCH_ADDIN, workbench_addin_iface_init))
+
+static void
+gbp_todo_workbench_addin_mine_cb (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  GbpTodoModel *model = (GbpTodoModel *)object;
+  g_autoptr(GbpTodoWorkbenchAddin) self = user_data;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (GBP_IS_TODO_MODEL (model));
+  g_assert (GBP_IS_TODO_WORKBENCH_ADDIN (self));
+
+  if (!gbp_todo_model_mine_finish (model, result, &error))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("%s", error->message);
+    }
+}
+
+static void
+gbp_todo_workbench_addin_mine_file_cb (GObject      *object,
+                                       GAsyncResult *result,
+                                       gpointer      user_data)
+{
+  GbpTodoModel *model = (GbpTodoModel *)object;
+  g_autoptr(GbpTodoWorkbenchAddin) self = user_data;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (GBP_IS_TODO_MODEL (model));
+  g_assert (GBP_IS_TODO_WORKBENCH_ADDIN (self));
+
+  if (!gbp_todo_model_mine_finish (model, result, &error))
+    return;
+
+  if (self->panel != NULL)
+    gbp_todo_panel_select_first (GBP_TODO_PANEL (self->panel));
+}
+
+static void
+gbp_todo_workbench_addin_buffer_saved (GbpTodoWorkbenchAddin *self,
+                                       IdeBuffer             *buffer,
+                                       IdeBufferManager      *buffer_manager)
+{
+  IdeFile *file;
+
+  g_assert (GBP_IS_TODO_WORKBENCH_ADDIN (self));
+  g_assert (IDE_IS_BUFFER (buffer));
+  g_assert (IDE_IS_BUFFER_MANAGER (buffer_manager));
+
+  if (self->model == NULL || !(file = ide_buffer_get_file (buffer)))
+    return;
+
+  /* Only the saved file needs to be mined again. */
+  gbp_todo_model_mine_async (self->model,
+                             ide_file_get_file (file),
+                             self->cancellable,
+                             gbp_todo_workbench_addin_mine_file_cb,
+                             g_object_ref (self));
+}
+
+static void
+gbp_todo_workbench_addin_load (IdeWorkbenchAddin *addin,
+                               IdeWorkbench      *workbench)
+{
+  GbpTodoWorkbenchAddin *self = (GbpTodoWorkbenchAddin *)addin;
+  IdeBufferManager *buffer_manager;
+  IdePerspective *editor;
+  IdeContext *context;
+  GtkWidget *panel;
+  GtkWidget *pane;
+  IdeVcs *vcs;
+  GFile *workdir;
+
+  g_assert (GBP_IS_TODO_WORKBENCH_ADDIN (self));
+  g_assert (IDE_IS_WORKBENCH (workbench));
+
+  context = ide_workbench_get_context (workbench);
+  vcs = ide_context_get_vcs (context);
+  workdir = ide_vcs_get_working_directory (vcs);
+  buffer_manager = ide_context_get_buffer_manager (context);
+
+  self->cancellable = g_cancellable_new ();
+  self->model = gbp_todo_model_new (vcs);
+
+  editor = ide_workbench_get_perspective_by_name (workbench, "editor");
+  pane = pnl_dock_bin_get_bottom_edge (PNL_DOCK_BIN (editor));
+
+  panel = gbp_todo_panel_new (workdir, self->model);
+  g_object_set (panel,
+                "expand", TRUE,
+                "visible", TRUE,
+                NULL);
+  ide_set_weak_pointer (&self->panel, panel);
+  gtk_container_add (GTK_CONTAINER (pane), panel);
+
+  g_signal_connect_object (buffer_manager,
+                           "buffer-saved",
+                           G_CALLBACK (gbp_todo_workbench_addin_buffer_saved),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  gbp_todo_model_mine_async (self->model,
+                             workdir,
+                             self->cancellable,
+                             gbp_todo_workbench_addin_mine_cb,
+                             g_object_ref (self));
+}
+
+static void
+gbp_todo_workbench_addin_unload (IdeWorkbenchAddin *addin,
+                                 IdeWorkbench      *workbench)
+{
+  GbpTodoWorkbenchAddin *self = (GbpTodoWorkbenchAddin *)addin;
+  IdeBufferManager *buffer_manager;
+  IdeContext *context;
+
+  g_assert (GBP_IS_TODO_WORKBENCH_ADDIN (self));
+  g_assert (IDE_IS_WORKBENCH (workbench));
+
+  context = ide_workbench_get_context (workbench);
+  buffer_manager = ide_context_get_buffer_manager (context);
+
+  g_signal_handlers_disconnect_by_func (buffer_manager,
+                                        G_CALLBACK (gbp_todo_workbench_addin_buffer_saved),
+                                        self);
+
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+
+  if (self->panel != NULL)
+    {
+      GtkWidget *panel = self->panel;
+
+      ide_clear_weak_pointer (&self->panel);
+      gtk_widget_destroy (panel);
+    }
+
+  g_clear_object (&self->model);
+}
+
+static void
+workbench_addin_iface_init (IdeWorkbenchAddinInterface *iface)
+{
+  iface->load = gbp_todo_workbench_addin_load;
+  iface->unload = gbp_todo_workbench_addin_unload;
+}
+
+static void
+gbp_todo_workbench_addin_class_init (GbpTodoWorkbenchAddinClass *klass)
+{
+}
+
+static void
+gbp_todo_workbench_addin_init (GbpTodoWorkbenchAddin *self)
+{
+}
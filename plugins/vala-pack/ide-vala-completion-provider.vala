@@ -70,7 +70,8 @@ namespace Ide
 
 			var service = (this.get_context ().get_service_typed (typeof (Ide.ValaService)) as Ide.ValaService);
 			var index = service.index;
-			var unsaved_files = this.get_context ().get_unsaved_files ();
+			/* Snapshot on the main thread, the worker must not touch Ide.UnsavedFiles */
+			var unsaved_files = this.get_context ().get_unsaved_files ().to_array ();
 
 			var cancellable = new GLib.Cancellable ();
 			context.cancelled.connect(() => {
@@ -38,6 +38,13 @@ namespace Ide
 		Vala.Parser parser;
 		HashMap<GLib.File,Ide.ValaSourceFile> source_files;
 		Ide.ValaDiagnostics report;
+		bool needs_check;
+
+		/*
+		 * Diagnostics as of the last check. This is replaced wholesale
+		 * after each check so readers never wait on the code_context lock.
+		 */
+		HashMap<GLib.File,Ide.Diagnostics> diagnostics;
 
 		public ValaIndex (Ide.Context context)
 		{
@@ -45,6 +52,7 @@ namespace Ide
 			var workdir = vcs.get_working_directory();
 
 			this.source_files = new HashMap<GLib.File,Ide.ValaSourceFile> (GLib.File.hash, (GLib.EqualFunc)GLib.File.equal);
+			this.diagnostics = new HashMap<GLib.File,Ide.Diagnostics> (GLib.File.hash, (GLib.EqualFunc)GLib.File.equal);
 
 			this.context = context;
 			this.code_context = new Vala.CodeContext ();
@@ -144,6 +152,7 @@ namespace Ide
 			this.code_context.add_source_file (source_file);
 
 			this.source_files [file] = source_file;
+			this.needs_check = true;
 		}
 
 		public async void add_files (ArrayList<GLib.File> files,
@@ -262,7 +271,9 @@ namespace Ide
 
 				/* Now add external packages after vapidir/girdir have been added */
 				foreach (var package in packages) {
-					this.code_context.add_external_package (package);
+					if (this.code_context.add_external_package (package)) {
+						this.needs_check = true;
+					}
 				}
 
 				Vala.CodeContext.pop ();
@@ -309,12 +320,7 @@ namespace Ide
 						source_file.get_mapped_contents ();
 
 						this.apply_unsaved_files (unsaved_files_copy);
-						this.report.clear ();
-						this.reparse ();
-						if (this.report.get_errors () == 0 &&
-						        (cancellable == null || !cancellable.is_cancelled ())) {
-						    this.code_context.check ();
-						}
+						this.check_locked (cancellable);
 
 						GLib.Idle.add(this.parse_file.callback);
 
@@ -332,26 +338,20 @@ namespace Ide
 		                                            int line,
 		                                            int column,
 		                                            string? line_text,
-		                                            Ide.UnsavedFiles? unsaved_files,
+		                                            GLib.GenericArray<Ide.UnsavedFile>? unsaved_files,
 		                                            Ide.ValaCompletionProvider provider,
 		                                            GLib.Cancellable? cancellable,
 		                                            out int result_line,
 		                                            out int result_column)
 		{
-			var unsaved_files_copy = unsaved_files.to_array ();
 			var result = new Ide.CompletionResults (provider.query);
 
 			if ((cancellable == null) || !cancellable.is_cancelled ()) {
 				lock (this.code_context) {
 					Vala.CodeContext.push (this.code_context);
 
-					this.apply_unsaved_files (unsaved_files_copy);
-					this.report.clear ();
-					this.reparse ();
-					if (this.report.get_errors () == 0 &&
-					        (cancellable == null || !cancellable.is_cancelled ())) {
-					    this.code_context.check ();
-					}
+					this.apply_unsaved_files (unsaved_files);
+					this.check_locked (cancellable);
 
 					if (this.source_files.contains (file)) {
 						var source_file = this.source_files [file];
@@ -372,37 +372,37 @@ namespace Ide
 			return result;
 		}
 
+		/*
+		 * This is served from the snapshot published by the last check, so
+		 * it never waits behind a parse or completion holding the lock.
+		 */
 		public async Ide.Diagnostics? get_diagnostics (GLib.File file,
 		                                               GLib.Cancellable? cancellable = null)
 		{
 			Ide.Diagnostics? diagnostics = null;
 
-			Ide.ThreadPool.push (Ide.ThreadPoolKind.COMPILER, () => {
-				if ((cancellable == null) || !cancellable.is_cancelled ()) {
-					lock (this.code_context) {
-						Vala.CodeContext.push (this.code_context);
-						if (this.source_files.contains (file)) {
-							diagnostics = this.source_files[file].diagnose ();
-						}
-						Vala.CodeContext.pop ();
-					}
-				}
-				GLib.Idle.add(this.get_diagnostics.callback);
-			});
-
-			yield;
+			lock (this.diagnostics) {
+				diagnostics = this.diagnostics[file];
+			}
 
 			return diagnostics;
 		}
 
-		void apply_unsaved_files (GLib.GenericArray<Ide.UnsavedFile> unsaved_files)
+		/* Caller is expected to hold code_context lock */
+		void apply_unsaved_files (GLib.GenericArray<Ide.UnsavedFile>? unsaved_files)
 		{
-			foreach (var source_file in this.code_context.get_source_files ()) {
-				if ((source_file.file_type == Vala.SourceFileType.SOURCE) &&
-				    (source_file is Ide.ValaSourceFile)) {
-					(source_file as Ide.ValaSourceFile).sync (unsaved_files);
+			if (unsaved_files == null)
+				return;
+
+			unsaved_files.foreach ((unsaved_file) => {
+				var source_file = this.source_files[unsaved_file.get_file ()];
+
+				if ((source_file != null) &&
+				    (source_file.file_type == Vala.SourceFileType.SOURCE) &&
+				    source_file.sync (unsaved_file)) {
+					this.needs_check = true;
 				}
-			}
+			});
 		}
 
 		void reparse ()
@@ -419,6 +419,44 @@ namespace Ide
 			}
 		}
 
+		/*
+		 * Caller is expected to hold code_context lock
+		 *
+		 * Only the files whose contents changed have been reset, so only
+		 * those are reparsed. Vala can only check the whole tree at once,
+		 * so that is skipped entirely unless something changed since the
+		 * last successful check.
+		 */
+		void check_locked (GLib.Cancellable? cancellable)
+		{
+			this.reparse ();
+
+			if (!this.needs_check)
+				return;
+
+			if (this.report.get_errors () == 0 &&
+			    (cancellable == null || !cancellable.is_cancelled ())) {
+				this.code_context.check ();
+				this.needs_check = false;
+			}
+
+			this.publish_diagnostics_locked ();
+		}
+
+		/* Caller is expected to hold code_context lock */
+		void publish_diagnostics_locked ()
+		{
+			var snapshot = new HashMap<GLib.File,Ide.Diagnostics> (GLib.File.hash, (GLib.EqualFunc)GLib.File.equal);
+
+			foreach (var file in this.source_files.get_keys ()) {
+				snapshot[file] = this.source_files[file].diagnose ();
+			}
+
+			lock (this.diagnostics) {
+				this.diagnostics = snapshot;
+			}
+		}
+
 		void add_completions (Ide.ValaSourceFile source_file,
 		                      ref int line,
 		                      ref int column,
@@ -46,6 +46,7 @@ namespace Ide
 	{
 		ArrayList<Ide.Diagnostic> diagnostics;
 		internal Ide.File file;
+		int64 sequence;
 
 		public ValaSourceFile (Vala.CodeContext context,
 		                       Vala.SourceFileType type,
@@ -99,20 +100,29 @@ namespace Ide
 			this.dirty = true;
 		}
 
-		public void sync (GenericArray<Ide.UnsavedFile> unsaved_files)
+		/*
+		 * Applies @unsaved_file if it is newer than what we last applied.
+		 * The sequence check keeps a late, older request from reverting
+		 * the contents. Returns true if the file was reset.
+		 */
+		public bool sync (Ide.UnsavedFile unsaved_file)
 		{
-			var gfile = this.file.file;
-			unsaved_files.foreach((unsaved_file) => {
-				if (unsaved_file.get_file ().equal (gfile)) {
-					var bytes = unsaved_file.get_content ();
-
-					if (bytes.get_data () != (uint8[]) this.content) {
-						this.content = (string)bytes.get_data ();
-						this.reset ();
-						return;
-					}
-				}
-			});
+			var sequence = unsaved_file.get_sequence ();
+
+			if (sequence <= this.sequence)
+				return false;
+
+			this.sequence = sequence;
+
+			var bytes = unsaved_file.get_content ();
+
+			if (bytes.get_data () != (uint8[]) this.content) {
+				this.content = (string)bytes.get_data ();
+				this.reset ();
+				return true;
+			}
+
+			return false;
 		}
 
 		public void report (Vala.SourceReference source_reference,
@@ -0,0 +1,616 @@
+/* ide-xml-element-index.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "ide-xml-element-index.h"
+
+/*
+ * The index keeps every element tag of the buffer, '<' to the first '>'
+ * after it, sorted by character offset. This is the same definition of an
+ * element that ide-xml.c uses when walking the buffer with iters.
+ *
+ * Edits only shift offsets and drop the tags they touch. The text around an
+ * edit is rescanned lazily on the next query, so a burst of typing costs a
+ * single rescan of the region between the nearest untouched tags. Matching
+ * start and end tags are paired in one pass after a rescan, after which
+ * matching and enclosing element lookups are a binary search.
+ */
+
+#define INDEX_KEY "IDE_XML_ELEMENT_INDEX"
+
+typedef struct
+{
+  /* Offset of the '<' */
+  gint                  begin;
+  /* Offset of the '>' */
+  gint                  end;
+  IdeXmlElementTagType  type;
+  gchar                *name;
+  /* Index of the matching start or end tag, or -1 */
+  gint                  partner;
+  /* Index of the innermost start tag still open at this tag, or -1 */
+  gint                  parent;
+} Tag;
+
+struct _IdeXmlElementIndex
+{
+  /* Unowned, the index is attached to the buffer */
+  GtkTextBuffer *buffer;
+  GArray        *tags;
+  gint           dirty_begin;
+  gint           dirty_end;
+  guint          needs_scan : 1;
+  guint          needs_pairing : 1;
+};
+
+static void
+tag_clear (gpointer data)
+{
+  Tag *tag = data;
+
+  g_clear_pointer (&tag->name, g_free);
+}
+
+static inline Tag *
+get_tag (IdeXmlElementIndex *self,
+         guint               index)
+{
+  return &g_array_index (self->tags, Tag, index);
+}
+
+/* Returns the index of the first tag ending at or after @offset */
+static guint
+tag_index_for_end (IdeXmlElementIndex *self,
+                   gint                offset)
+{
+  guint lo = 0;
+  guint hi = self->tags->len;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (get_tag (self, mid)->end < offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+/* Returns the index of the first tag beginning at or after @offset */
+static guint
+tag_index_for_begin (IdeXmlElementIndex *self,
+                     gint                offset)
+{
+  guint lo = 0;
+  guint hi = self->tags->len;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (get_tag (self, mid)->begin < offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static void
+shift_tags (IdeXmlElementIndex *self,
+            guint               index,
+            gint                delta)
+{
+  for (; index < self->tags->len; index++)
+    {
+      Tag *tag = get_tag (self, index);
+
+      tag->begin += delta;
+      tag->end += delta;
+    }
+}
+
+static inline gboolean
+is_name_end (gchar ch)
+{
+  return g_ascii_isspace (ch) || ch == '/' || ch == '>';
+}
+
+/*
+ * @lt points at the '<' and @gt at the '>' of the tag. This mirrors
+ * ide_xml_get_element_tag_type() and ide_xml_get_element_name().
+ */
+static void
+tag_classify (Tag         *tag,
+              const gchar *lt,
+              const gchar *gt)
+{
+  const gchar *name;
+  const gchar *name_end;
+  gunichar start_ch;
+  gunichar end_ch;
+
+  start_ch = g_utf8_get_char (lt + 1);
+  end_ch = g_utf8_get_char (g_utf8_prev_char (gt));
+
+  if (end_ch == '/' ||
+      (end_ch == '?' && start_ch == '?') ||
+      (end_ch == '-' && start_ch == '!'))
+    tag->type = IDE_XML_ELEMENT_TAG_START_END;
+  else if (start_ch == '/')
+    tag->type = IDE_XML_ELEMENT_TAG_END;
+  else
+    tag->type = IDE_XML_ELEMENT_TAG_START;
+
+  for (name = lt; *name == '<' || *name == '/'; name++)
+    { /* Do Nothing */ }
+
+  /* Comments and elements starting with ? do not have a name */
+  if (name >= gt || *name == '!' || *name == '?')
+    return;
+
+  for (name_end = name; name_end < gt && !is_name_end (*name_end); name_end++)
+    { /* Do Nothing */ }
+
+  if (name_end > name)
+    tag->name = g_strndup (name, name_end - name);
+}
+
+static GArray *
+scan_range (IdeXmlElementIndex *self,
+            gint                begin_offset,
+            gint                end_offset,
+            gboolean           *unterminated)
+{
+  GtkTextIter begin;
+  GtkTextIter end;
+  const gchar *lt = NULL;
+  const gchar *p;
+  GArray *found;
+  gchar *text;
+  gint lt_offset = 0;
+  gint offset = begin_offset;
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &begin, begin_offset);
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &end, end_offset);
+  text = gtk_text_iter_get_slice (&begin, &end);
+
+  found = g_array_new (FALSE, FALSE, sizeof (Tag));
+
+  for (p = text; *p; p = g_utf8_next_char (p), offset++)
+    {
+      if (lt == NULL)
+        {
+          if (*p == '<')
+            {
+              lt = p;
+              lt_offset = offset;
+            }
+        }
+      else if (*p == '>')
+        {
+          Tag tag = { lt_offset, offset, IDE_XML_ELEMENT_TAG_UNKNOWN, NULL, -1, -1 };
+
+          tag_classify (&tag, lt, p);
+          g_array_append_val (found, tag);
+
+          lt = NULL;
+        }
+    }
+
+  *unterminated = (lt != NULL);
+
+  g_free (text);
+
+  return found;
+}
+
+static void
+ide_xml_element_index_scan (IdeXmlElementIndex *self)
+{
+  GArray *found;
+  gboolean unterminated;
+  guint lo_index;
+  guint hi_index;
+  gint lo;
+  gint hi;
+
+  g_assert (self != NULL);
+
+  if (!self->needs_scan)
+    return;
+
+  /* Widen the dirty range out to the closest tags that were not touched. */
+  lo_index = tag_index_for_end (self, self->dirty_begin);
+  hi_index = MAX (lo_index, tag_index_for_begin (self, self->dirty_end));
+  lo = (lo_index > 0) ? get_tag (self, lo_index - 1)->end + 1 : 0;
+  hi = (hi_index < self->tags->len) ? get_tag (self, hi_index)->begin
+                                    : gtk_text_buffer_get_char_count (self->buffer);
+
+  found = scan_range (self, lo, hi, &unterminated);
+
+  /*
+   * A '<' without a '>' before the next known tag runs up to that tag's
+   * '>', swallowing it. Rescan once with that tag included.
+   */
+  if (unterminated && hi_index < self->tags->len)
+    {
+      guint i;
+
+      for (i = 0; i < found->len; i++)
+        g_free (g_array_index (found, Tag, i).name);
+      g_array_free (found, TRUE);
+
+      hi = get_tag (self, hi_index)->end + 1;
+      hi_index++;
+
+      found = scan_range (self, lo, hi, &unterminated);
+    }
+
+  if (hi_index > lo_index)
+    g_array_remove_range (self->tags, lo_index, hi_index - lo_index);
+  g_array_insert_vals (self->tags, lo_index, found->data, found->len);
+  g_array_free (found, TRUE);
+
+  self->needs_scan = FALSE;
+  self->needs_pairing = TRUE;
+}
+
+static void
+ide_xml_element_index_pair (IdeXmlElementIndex *self)
+{
+  GArray *stack;
+  guint i;
+
+  g_assert (self != NULL);
+
+  if (!self->needs_pairing)
+    return;
+
+  stack = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  for (i = 0; i < self->tags->len; i++)
+    {
+      Tag *tag = get_tag (self, i);
+      gint top = -1;
+
+      if (stack->len > 0)
+        top = g_array_index (stack, guint, stack->len - 1);
+
+      tag->partner = -1;
+      tag->parent = top;
+
+      if (tag->name == NULL)
+        continue;
+
+      if (tag->type == IDE_XML_ELEMENT_TAG_START)
+        {
+          g_array_append_val (stack, i);
+        }
+      else if (tag->type == IDE_XML_ELEMENT_TAG_END && top != -1)
+        {
+          Tag *open = get_tag (self, top);
+
+          /* Unbalanced elements are left without a partner */
+          if (g_strcmp0 (open->name, tag->name) == 0)
+            {
+              open->partner = i;
+              tag->partner = top;
+              tag->parent = open->parent;
+              g_array_set_size (stack, stack->len - 1);
+            }
+        }
+    }
+
+  g_array_free (stack, TRUE);
+
+  self->needs_pairing = FALSE;
+}
+
+static void
+ide_xml_element_index_ensure (IdeXmlElementIndex *self)
+{
+  ide_xml_element_index_scan (self);
+  ide_xml_element_index_pair (self);
+}
+
+static void
+ide_xml_element_index_mark_dirty (IdeXmlElementIndex *self,
+                                  gint                begin,
+                                  gint                end)
+{
+  if (self->needs_scan)
+    {
+      self->dirty_begin = MIN (self->dirty_begin, begin);
+      self->dirty_end = MAX (self->dirty_end, end);
+    }
+  else
+    {
+      self->dirty_begin = begin;
+      self->dirty_end = end;
+      self->needs_scan = TRUE;
+    }
+}
+
+static void
+ide_xml_element_index_insert_text_cb (GtkTextBuffer      *buffer,
+                                      GtkTextIter        *location,
+                                      const gchar        *text,
+                                      gint                len,
+                                      IdeXmlElementIndex *self)
+{
+  gint offset;
+  gint n_chars;
+  guint i;
+
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+  g_assert (location != NULL);
+  g_assert (self != NULL);
+
+  offset = gtk_text_iter_get_offset (location);
+  n_chars = g_utf8_strlen (text, len);
+
+  /* Text landing inside of a tag invalidates it, the rescan will find it again */
+  i = tag_index_for_end (self, offset);
+  if (i < self->tags->len && get_tag (self, i)->begin < offset)
+    g_array_remove_index (self->tags, i);
+
+  shift_tags (self, i, n_chars);
+
+  if (self->needs_scan && self->dirty_end >= offset)
+    self->dirty_end += n_chars;
+
+  ide_xml_element_index_mark_dirty (self, offset, offset + n_chars);
+}
+
+static void
+ide_xml_element_index_delete_range_cb (GtkTextBuffer      *buffer,
+                                       GtkTextIter        *begin,
+                                       GtkTextIter        *end,
+                                       IdeXmlElementIndex *self)
+{
+  gint begin_offset;
+  gint end_offset;
+  gint n_chars;
+  guint n_touched = 0;
+  guint i;
+
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+  g_assert (begin != NULL);
+  g_assert (end != NULL);
+  g_assert (self != NULL);
+
+  begin_offset = gtk_text_iter_get_offset (begin);
+  end_offset = gtk_text_iter_get_offset (end);
+  n_chars = end_offset - begin_offset;
+
+  if (n_chars <= 0)
+    return;
+
+  i = tag_index_for_end (self, begin_offset);
+  while (i + n_touched < self->tags->len && get_tag (self, i + n_touched)->begin < end_offset)
+    n_touched++;
+
+  if (n_touched > 0)
+    g_array_remove_range (self->tags, i, n_touched);
+
+  shift_tags (self, i, -n_chars);
+
+  if (self->needs_scan)
+    {
+      if (self->dirty_begin > begin_offset)
+        self->dirty_begin = MAX (begin_offset, self->dirty_begin - n_chars);
+      if (self->dirty_end > begin_offset)
+        self->dirty_end = MAX (begin_offset, self->dirty_end - n_chars);
+    }
+
+  ide_xml_element_index_mark_dirty (self, begin_offset, begin_offset);
+}
+
+static void
+ide_xml_element_index_free (IdeXmlElementIndex *self)
+{
+  g_clear_pointer (&self->tags, g_array_unref);
+  g_slice_free (IdeXmlElementIndex, self);
+}
+
+/**
+ * ide_xml_element_index_get_for_buffer:
+ *
+ * Gets the element index attached to @buffer, creating it the first time.
+ * The index is kept up to date with edits for the lifetime of @buffer.
+ *
+ * Returns: (transfer none): An #IdeXmlElementIndex.
+ */
+IdeXmlElementIndex *
+ide_xml_element_index_get_for_buffer (GtkTextBuffer *buffer)
+{
+  IdeXmlElementIndex *self;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+
+  self = g_object_get_data (G_OBJECT (buffer), INDEX_KEY);
+
+  if (self == NULL)
+    {
+      self = g_slice_new0 (IdeXmlElementIndex);
+      self->buffer = buffer;
+      self->tags = g_array_new (FALSE, FALSE, sizeof (Tag));
+      g_array_set_clear_func (self->tags, tag_clear);
+      self->dirty_begin = 0;
+      self->dirty_end = gtk_text_buffer_get_char_count (buffer);
+      self->needs_scan = TRUE;
+
+      /*
+       * Connect before the default handlers so the iters still describe
+       * the buffer as it was before the edit. The index is freed with the
+       * buffer, so there is nothing to disconnect.
+       */
+      g_signal_connect (buffer,
+                        "insert-text",
+                        G_CALLBACK (ide_xml_element_index_insert_text_cb),
+                        self);
+      g_signal_connect (buffer,
+                        "delete-range",
+                        G_CALLBACK (ide_xml_element_index_delete_range_cb),
+                        self);
+
+      g_object_set_data_full (G_OBJECT (buffer),
+                              INDEX_KEY,
+                              self,
+                              (GDestroyNotify)ide_xml_element_index_free);
+    }
+
+  return self;
+}
+
+static void
+get_tag_bounds (IdeXmlElementIndex *self,
+                const Tag          *tag,
+                GtkTextIter        *start,
+                GtkTextIter        *end)
+{
+  if (start != NULL)
+    gtk_text_buffer_get_iter_at_offset (self->buffer, start, tag->begin);
+  if (end != NULL)
+    gtk_text_buffer_get_iter_at_offset (self->buffer, end, tag->end);
+}
+
+static const Tag *
+find_tag_at (IdeXmlElementIndex *self,
+             const GtkTextIter  *iter)
+{
+  gint offset;
+  guint i;
+
+  ide_xml_element_index_ensure (self);
+
+  offset = gtk_text_iter_get_offset (iter);
+  i = tag_index_for_end (self, offset);
+
+  if (i < self->tags->len && get_tag (self, i)->begin <= offset)
+    return get_tag (self, i);
+
+  return NULL;
+}
+
+/**
+ * ide_xml_element_index_get_element:
+ *
+ * Locates the element tag containing @iter. @start is placed on the '<'
+ * and @end on the '>' of the tag, like ide_xml_get_current_element().
+ *
+ * Returns: %TRUE if @iter is within an element tag.
+ */
+gboolean
+ide_xml_element_index_get_element (IdeXmlElementIndex   *self,
+                                   const GtkTextIter    *iter,
+                                   GtkTextIter          *start,
+                                   GtkTextIter          *end,
+                                   IdeXmlElementTagType *tag_type)
+{
+  const Tag *tag;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  if (NULL == (tag = find_tag_at (self, iter)))
+    return FALSE;
+
+  get_tag_bounds (self, tag, start, end);
+
+  if (tag_type != NULL)
+    *tag_type = tag->type;
+
+  return TRUE;
+}
+
+/**
+ * ide_xml_element_index_get_matching_element:
+ *
+ * Locates the end tag matching the start tag containing @iter, or the
+ * start tag matching the end tag containing @iter.
+ *
+ * Returns: %TRUE if a matching tag was found.
+ */
+gboolean
+ide_xml_element_index_get_matching_element (IdeXmlElementIndex *self,
+                                            const GtkTextIter  *iter,
+                                            GtkTextIter        *start,
+                                            GtkTextIter        *end)
+{
+  const Tag *tag;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  if (NULL == (tag = find_tag_at (self, iter)) || tag->partner == -1)
+    return FALSE;
+
+  get_tag_bounds (self, get_tag (self, tag->partner), start, end);
+
+  return TRUE;
+}
+
+/**
+ * ide_xml_element_index_get_enclosing_element:
+ *
+ * Locates the start tag of the innermost element that is still open at
+ * @iter, ignoring any tag @iter is within.
+ *
+ * Returns: %TRUE if @iter is within an element.
+ */
+gboolean
+ide_xml_element_index_get_enclosing_element (IdeXmlElementIndex *self,
+                                             const GtkTextIter  *iter,
+                                             GtkTextIter        *start,
+                                             GtkTextIter        *end)
+{
+  const Tag *tag;
+  gint index;
+  guint i;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  ide_xml_element_index_ensure (self);
+
+  /* The last tag closed before @iter */
+  i = tag_index_for_end (self, gtk_text_iter_get_offset (iter));
+  if (i == 0)
+    return FALSE;
+
+  tag = get_tag (self, i - 1);
+
+  if (tag->type == IDE_XML_ELEMENT_TAG_START && tag->name != NULL)
+    index = i - 1;
+  else
+    index = tag->parent;
+
+  if (index == -1)
+    return FALSE;
+
+  get_tag_bounds (self, get_tag (self, index), start, end);
+
+  return TRUE;
+}
@@ -0,0 +1,49 @@
+/* ide-xml-element-index.h
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_XML_ELEMENT_INDEX_H
+#define IDE_XML_ELEMENT_INDEX_H
+
+#include <gtk/gtk.h>
+
+#include "ide-xml.h"
+
+G_BEGIN_DECLS
+
+typedef struct _IdeXmlElementIndex IdeXmlElementIndex;
+
+IdeXmlElementIndex *ide_xml_element_index_get_for_buffer    (GtkTextBuffer        *buffer);
+gboolean            ide_xml_element_index_get_element       (IdeXmlElementIndex   *self,
+                                                             const GtkTextIter    *iter,
+                                                             GtkTextIter          *start,
+                                                             GtkTextIter          *end,
+                                                             IdeXmlElementTagType *tag_type);
+gboolean            ide_xml_element_index_get_matching_element
+                                                            (IdeXmlElementIndex   *self,
+                                                             const GtkTextIter    *iter,
+                                                             GtkTextIter          *start,
+                                                             GtkTextIter          *end);
+gboolean            ide_xml_element_index_get_enclosing_element
+                                                            (IdeXmlElementIndex   *self,
+                                                             const GtkTextIter    *iter,
+                                                             GtkTextIter          *start,
+                                                             GtkTextIter          *end);
+
+G_END_DECLS
+
+#endif /* IDE_XML_ELEMENT_INDEX_H */
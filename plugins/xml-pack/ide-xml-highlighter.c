@@ -24,6 +24,7 @@
 #include "ide-context.h"
 #include "ide-buffer.h"
 #include "ide-xml.h"
+#include "ide-xml-element-index.h"
 #include "ide-highlight-engine.h"
 
 #define HIGHLIGH_TIMEOUT_MSEC    35
@@ -35,6 +36,8 @@ struct _IdeXmlHighlighter
 
   EggSignalGroup     *signal_group;
   GtkTextMark        *iter_mark;
+  /* Bounds of the ranges tagged by the previous highlight */
+  GtkTextMark        *tagged_marks[4];
   IdeHighlightEngine *engine;
   GtkTextBuffer      *buffer;
   guint               highlight_timeout;
@@ -50,10 +53,24 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED (IdeXmlHighlighter,
                                 G_IMPLEMENT_INTERFACE (IDE_TYPE_HIGHLIGHTER,
                                                        highlighter_iface_init))
 
+static void
+ide_xml_highlighter_tag_range (IdeXmlHighlighter *self,
+                               GtkTextTag        *tag,
+                               guint              nth,
+                               const GtkTextIter *start,
+                               const GtkTextIter *end)
+{
+  gtk_text_buffer_apply_tag (self->buffer, tag, start, end);
+  gtk_text_buffer_move_mark (self->buffer, self->tagged_marks[nth * 2], start);
+  gtk_text_buffer_move_mark (self->buffer, self->tagged_marks[nth * 2 + 1], end);
+}
+
 static gboolean
 ide_xml_highlighter_highlight_timeout_handler (gpointer data)
 {
   IdeXmlHighlighter *self = data;
+  IdeXmlElementIndex *index;
+  IdeXmlElementTagType tag_type;
   GtkTextTag *tag;
   GtkTextIter iter;
   GtkTextIter start;
@@ -68,37 +85,31 @@ ide_xml_highlighter_highlight_timeout_handler (gpointer data)
 
   tag = ide_highlight_engine_get_style (self->engine, XML_TAG_MATCH_STYLE_NAME);
 
-  /*
-   * Clear previous tags. We could save the previous
-   * iters and clear only those locations but for
-   * now this should be ok.
-   */
+  /* Clear only the ranges we tagged last time */
   if (self->has_tags)
     {
-      gtk_text_buffer_get_bounds (self->buffer, &start, &end);
-      gtk_text_buffer_remove_tag (self->buffer, tag, &start, &end);
+      guint i;
+
+      for (i = 0; i < G_N_ELEMENTS (self->tagged_marks); i += 2)
+        {
+          gtk_text_buffer_get_iter_at_mark (self->buffer, &start, self->tagged_marks[i]);
+          gtk_text_buffer_get_iter_at_mark (self->buffer, &end, self->tagged_marks[i + 1]);
+          gtk_text_buffer_remove_tag (self->buffer, tag, &start, &end);
+        }
 
       self->has_tags = FALSE;
     }
 
+  index = ide_xml_element_index_get_for_buffer (self->buffer);
 
   gtk_text_buffer_get_iter_at_mark (self->buffer, &iter, self->iter_mark);
-  if (ide_xml_in_element (&iter) && ide_xml_get_current_element (&iter,
-                                                                 &start,
-                                                                 &end))
+  if (ide_xml_element_index_get_element (index, &iter, &start, &end, &tag_type))
     {
       GtkTextIter next_start;
       GtkTextIter next_end;
-      IdeXmlElementTagType tag_type = ide_xml_get_element_tag_type (&start,
-                                                                    &end);
-
-      if ((tag_type == IDE_XML_ELEMENT_TAG_START &&
-          ide_xml_find_closing_element (&start,&end,
-                                      &next_start,&next_end)) ||
-          (tag_type == IDE_XML_ELEMENT_TAG_END &&
-          ide_xml_find_opening_element (&start,&end,
-                                      &next_start,&next_end)) ||
-          tag_type == IDE_XML_ELEMENT_TAG_START_END)
+
+      if (tag_type == IDE_XML_ELEMENT_TAG_START_END ||
+          ide_xml_element_index_get_matching_element (index, &iter, &next_start, &next_end))
         {
 
           /*
@@ -108,18 +119,16 @@ ide_xml_highlighter_highlight_timeout_handler (gpointer data)
            * from the start iter
            */
           gtk_text_iter_forward_char (&start);
-          gtk_text_buffer_apply_tag (GTK_TEXT_BUFFER (self->buffer),
-                                     tag,
-                                     &start,
-                                     &end);
+          ide_xml_highlighter_tag_range (self, tag, 0, &start, &end);
 
           if (tag_type != IDE_XML_ELEMENT_TAG_START_END)
             {
               gtk_text_iter_forward_char (&next_start);
-              gtk_text_buffer_apply_tag (GTK_TEXT_BUFFER (self->buffer),
-                                         tag,
-                                         &next_start,
-                                         &next_end);
+              ide_xml_highlighter_tag_range (self, tag, 1, &next_start, &next_end);
+            }
+          else
+            {
+              ide_xml_highlighter_tag_range (self, tag, 1, &start, &start);
             }
 
           self->has_tags = TRUE;
@@ -138,6 +147,7 @@ ide_xml_highlighter_bind_buffer_cb (IdeXmlHighlighter  *self,
                                     EggSignalGroup     *group)
 {
   GtkTextIter begin;
+  guint i;
 
   g_assert (IDE_IS_XML_HIGHLIGHTER (self));
   g_assert (IDE_IS_BUFFER (buffer));
@@ -147,12 +157,17 @@ ide_xml_highlighter_bind_buffer_cb (IdeXmlHighlighter  *self,
 
   gtk_text_buffer_get_start_iter (self->buffer, &begin);
   self->iter_mark = gtk_text_buffer_create_mark (self->buffer, NULL, &begin, TRUE);
+
+  for (i = 0; i < G_N_ELEMENTS (self->tagged_marks); i++)
+    self->tagged_marks[i] = gtk_text_buffer_create_mark (self->buffer, NULL, &begin, (i % 2) == 0);
 }
 
 static void
 ide_xml_highlighter_unbind_buffer_cb (IdeXmlHighlighter  *self,
                                       EggSignalGroup     *group)
 {
+  guint i;
+
   g_assert (IDE_IS_XML_HIGHLIGHTER (self));
   g_assert (EGG_IS_SIGNAL_GROUP (group));
   g_assert (self->buffer != NULL);
@@ -166,6 +181,14 @@ ide_xml_highlighter_unbind_buffer_cb (IdeXmlHighlighter  *self,
   gtk_text_buffer_delete_mark (self->buffer, self->iter_mark);
   self->iter_mark = NULL;
 
+  for (i = 0; i < G_N_ELEMENTS (self->tagged_marks); i++)
+    {
+      gtk_text_buffer_delete_mark (self->buffer, self->tagged_marks[i]);
+      self->tagged_marks[i] = NULL;
+    }
+
+  self->has_tags = FALSE;
+
   ide_clear_weak_pointer (&self->buffer);
 }
 
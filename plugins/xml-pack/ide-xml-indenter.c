@@ -23,6 +23,7 @@
 #include <string.h>
 
 #include "ide-debug.h"
+#include "ide-xml-element-index.h"
 #include "ide-xml-indenter.h"
 
 struct _IdeXmlIndenter
@@ -134,42 +135,14 @@ static gboolean
 text_iter_backward_to_element_start (const GtkTextIter *iter,
                                      GtkTextIter       *match_begin)
 {
-  GtkTextIter tmp = *iter;
-  gboolean ret = FALSE;
-  gint depth = 0;
+  IdeXmlElementIndex *index;
 
   g_return_val_if_fail (iter, FALSE);
   g_return_val_if_fail (match_begin, FALSE);
 
-  while (gtk_text_iter_backward_char (&tmp))
-    {
-      gunichar ch;
-
-      ch = gtk_text_iter_get_char (&tmp);
-
-      if ((ch == '/') && (text_iter_peek_prev_char (&tmp) == '<'))
-        {
-          gtk_text_iter_backward_char (&tmp);
-          depth++;
-        }
-      else if ((ch == '/') && (text_iter_peek_next_char (&tmp) == '>'))
-        {
-          depth++;
-        }
-      else if ((ch == '<') && (text_iter_peek_next_char (&tmp) != '!'))
-        {
-          depth--;
-          if (depth < 0)
-            {
-              *match_begin = tmp;
-              ret = TRUE;
-              IDE_GOTO (cleanup);
-            }
-        }
-    }
+  index = ide_xml_element_index_get_for_buffer (gtk_text_iter_get_buffer (iter));
 
-cleanup:
-  return ret;
+  return ide_xml_element_index_get_enclosing_element (index, iter, match_begin, NULL);
 }
 
 static gchar *
@@ -0,0 +1,632 @@
+/* bench-ide-editing.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replays a recorded editing trace into an IdeBuffer and reports how long
+ * it takes for highlighting, diagnostics and completion to catch up with
+ * the keystrokes.
+ *
+ * Highlighting and diagnostics only need a GMainLoop, so this runs fine
+ * without a display server. Completion is driven through a GtkSourceView
+ * and is therefore only measured when gtk_init_check() succeeds.
+ */
+
+#include <ide.h>
+#include <libpeas/peas.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "egg-counter.h"
+
+#define SETTLE_TIMEOUT_MSEC     10000
+#define COMPLETION_TIMEOUT_MSEC 2000
+
+typedef struct
+{
+  const gchar *name;
+  GArray      *samples;
+  gint64       pending;
+} Metric;
+
+typedef struct
+{
+  EggCounter *counter;
+  gint64      begin;
+} CounterSnapshot;
+
+static IdeContext  *context;
+static IdeBuffer   *buffer;
+static GtkWidget   *view;
+static EggCounter  *highlight_queued;
+static GArray      *snapshots;
+static gint64       last_edit;
+static gint64       diagnose_edit;
+static guint        highlight_handler;
+static gboolean     recording;
+static gboolean     completion_shown;
+static gchar      **plugins;
+static gchar       *project_path;
+static gchar       *trace_path;
+static Metric       highlight  = { "highlight" };
+static Metric       diagnose   = { "diagnostics" };
+static Metric       completion = { "completion" };
+
+static GOptionEntry entries[] = {
+  { "project", 'p', 0, G_OPTION_ARG_FILENAME, &project_path,
+    "The project to open", "DIR" },
+  { "trace", 't', 0, G_OPTION_ARG_FILENAME, &trace_path,
+    "The editing trace to replay", "FILE" },
+  { "plugin", 0, 0, G_OPTION_ARG_STRING_ARRAY, &plugins,
+    "Load the in-tree plugin named NAME (default: clang)", "NAME" },
+  { NULL }
+};
+
+static void
+metric_sample (Metric *metric,
+               gint64  now)
+{
+  gdouble msec;
+
+  g_assert (metric != NULL);
+
+  if (metric->pending == 0)
+    return;
+
+  msec = (now - metric->pending) / 1000.0;
+  g_array_append_val (metric->samples, msec);
+  metric->pending = 0;
+}
+
+static gint
+compare_double (gconstpointer a,
+                gconstpointer b)
+{
+  gdouble da = *(const gdouble *)a;
+  gdouble db = *(const gdouble *)b;
+
+  return (da < db) ? -1 : (da > db) ? 1 : 0;
+}
+
+static gdouble
+metric_percentile (Metric *metric,
+                   guint   percentile)
+{
+  guint idx;
+
+  g_assert (metric->samples->len > 0);
+
+  idx = (metric->samples->len - 1) * percentile / 100;
+
+  return g_array_index (metric->samples, gdouble, idx);
+}
+
+static void
+metric_report (Metric      *metric,
+               const gchar *skipped)
+{
+  if (skipped != NULL)
+    {
+      g_print ("%-12s : skipped (%s)\n", metric->name, skipped);
+      return;
+    }
+
+  if (metric->samples->len == 0)
+    {
+      g_print ("%-12s : no samples\n", metric->name);
+      return;
+    }
+
+  g_array_sort (metric->samples, compare_double);
+
+  g_print ("%-12s : %6u : %9.2lf : %9.2lf : %9.2lf : %9.2lf\n",
+           metric->name,
+           metric->samples->len,
+           metric_percentile (metric, 50),
+           metric_percentile (metric, 90),
+           metric_percentile (metric, 99),
+           metric_percentile (metric, 100));
+}
+
+static gboolean
+quit_loop_cb (gpointer data)
+{
+  g_main_loop_quit (data);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+run_for (guint msec)
+{
+  g_autoptr(GMainLoop) main_loop = g_main_loop_new (NULL, FALSE);
+
+  g_timeout_add (msec, quit_loop_cb, main_loop);
+  g_main_loop_run (main_loop);
+}
+
+static gboolean
+is_settled (void)
+{
+  return !ide_buffer_get_busy (buffer) &&
+         egg_counter_get (highlight_queued) == 0 &&
+         highlight_handler == 0;
+}
+
+static void
+settle (void)
+{
+  gint64 deadline = g_get_monotonic_time () + (SETTLE_TIMEOUT_MSEC * 1000L);
+
+  /* Give the diagnose timeout a chance to fire before we check for busy. */
+  run_for (ide_buffer_get_busy (buffer) ? 0 : 500);
+
+  while (!is_settled () && g_get_monotonic_time () < deadline)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+/*
+ * The highlight engine works from a G_PRIORITY_LOW idle that re-arms itself
+ * until the invalid region is processed. A lower priority idle can only be
+ * dispatched once that work is complete, so use one to detect when the
+ * highlighter has caught up.
+ */
+static gboolean
+highlight_drained_cb (gpointer data)
+{
+  if (egg_counter_get (highlight_queued) > 0)
+    return G_SOURCE_CONTINUE;
+
+  metric_sample (&highlight, g_get_monotonic_time ());
+  highlight_handler = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+record_edit (void)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  last_edit = now;
+
+  if (highlight.pending == 0)
+    highlight.pending = now;
+
+  if (highlight_handler == 0)
+    highlight_handler = g_idle_add_full (G_PRIORITY_LOW + 1,
+                                         highlight_drained_cb,
+                                         NULL, NULL);
+}
+
+static void
+buffer_notify_busy (IdeBuffer  *buf,
+                    GParamSpec *pspec,
+                    gpointer    user_data)
+{
+  if (!recording)
+    return;
+
+  if (ide_buffer_get_busy (buf))
+    {
+      /* Diagnostics are measured from the last keystroke they include. */
+      diagnose_edit = last_edit;
+    }
+  else if (diagnose_edit != 0)
+    {
+      diagnose.pending = diagnose_edit;
+      metric_sample (&diagnose, g_get_monotonic_time ());
+      diagnose_edit = 0;
+    }
+}
+
+static void
+completion_show_cb (GtkSourceCompletion *comp,
+                    gpointer             user_data)
+{
+  completion_shown = TRUE;
+  metric_sample (&completion, g_get_monotonic_time ());
+}
+
+static void
+counters_foreach_cb (EggCounter *counter,
+                     gpointer    user_data)
+{
+  CounterSnapshot snapshot;
+
+  if (g_strcmp0 (counter->category, "IdeHighlightEngine") == 0 &&
+      g_strcmp0 (counter->name, "Queued") == 0)
+    highlight_queued = counter;
+
+  snapshot.counter = counter;
+  snapshot.begin = egg_counter_get (counter);
+
+  g_array_append_val (snapshots, snapshot);
+}
+
+static void
+counters_report (void)
+{
+  static const gchar *categories[] = {
+    "IdeBuffer", "IdeDiagnostic", "IdeHighlightEngine", "ThreadPool", NULL
+  };
+
+  g_print ("\n%-20s : %-24s : %12s\n", "Category", "Counter", "Delta");
+
+  for (guint i = 0; i < snapshots->len; i++)
+    {
+      CounterSnapshot *snapshot = &g_array_index (snapshots, CounterSnapshot, i);
+
+      if (!g_strv_contains (categories, snapshot->counter->category))
+        continue;
+
+      g_print ("%-20s : %-24s : %12"G_GINT64_FORMAT"\n",
+               snapshot->counter->category,
+               snapshot->counter->name,
+               egg_counter_get (snapshot->counter) - snapshot->begin);
+    }
+}
+
+static void
+load_plugins (void)
+{
+  static const gchar *default_plugins[] = { "clang", NULL };
+  const gchar * const *names = plugins ? (const gchar * const *)plugins : default_plugins;
+  g_autoptr(GPtrArray) dirs = g_ptr_array_new_with_free_func (g_free);
+  PeasEngine *engine = peas_engine_get_default ();
+  const GList *list;
+
+  peas_engine_prepend_search_path (engine,
+                                   "resource:///org/gnome/builder/plugins",
+                                   "resource:///org/gnome/builder/plugins");
+
+  for (guint i = 0; names [i]; i++)
+    {
+      gchar *path = g_build_filename (BUILDDIR, "plugins", names [i], NULL);
+
+      peas_engine_prepend_search_path (engine, path, path);
+      g_ptr_array_add (dirs, path);
+    }
+
+  peas_engine_rescan_plugins (engine);
+
+  /*
+   * Only load the plugins embedded in libide plus those requested, so that
+   * nothing is pulled in that expects a workbench or a display.
+   */
+  for (list = peas_engine_get_plugin_list (engine); list; list = list->next)
+    {
+      PeasPluginInfo *plugin_info = list->data;
+      const gchar *module_dir = peas_plugin_info_get_module_dir (plugin_info);
+      gboolean wanted = g_str_has_prefix (module_dir, "resource://");
+
+      for (guint i = 0; !wanted && i < dirs->len; i++)
+        wanted = g_str_equal (module_dir, g_ptr_array_index (dirs, i));
+
+      if (wanted && !peas_engine_load_plugin (engine, plugin_info))
+        g_printerr ("Failed to load plugin \"%s\"\n",
+                    peas_plugin_info_get_module_name (plugin_info));
+    }
+}
+
+static void
+context_new_cb (GObject      *object,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+  g_autoptr(GError) error = NULL;
+  GMainLoop *main_loop = user_data;
+
+  if (!(context = ide_context_new_finish (result, &error)))
+    g_printerr ("%s\n", error->message);
+
+  g_main_loop_quit (main_loop);
+}
+
+static gboolean
+open_context (void)
+{
+  g_autoptr(GMainLoop) main_loop = g_main_loop_new (NULL, FALSE);
+  g_autoptr(GFile) project_file = g_file_new_for_path (project_path);
+
+  ide_context_new_async (project_file, NULL, context_new_cb, main_loop);
+  g_main_loop_run (main_loop);
+
+  return context != NULL;
+}
+
+static void
+load_file_cb (GObject      *object,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+  g_autoptr(GError) error = NULL;
+  GMainLoop *main_loop = user_data;
+
+  if (!(buffer = ide_buffer_manager_load_file_finish (IDE_BUFFER_MANAGER (object), result, &error)))
+    g_printerr ("%s\n", error->message);
+
+  g_main_loop_quit (main_loop);
+}
+
+static gboolean
+open_file (const gchar *path,
+           gboolean     have_display)
+{
+  g_autoptr(GMainLoop) main_loop = g_main_loop_new (NULL, FALSE);
+  g_autoptr(IdeFile) file = NULL;
+  IdeBufferManager *manager;
+  IdeProject *project;
+
+  project = ide_context_get_project (context);
+  ide_project_reader_lock (project);
+  file = ide_project_get_file_for_path (project, path);
+  ide_project_reader_unlock (project);
+
+  if (view != NULL)
+    gtk_widget_destroy (gtk_widget_get_toplevel (view));
+  view = NULL;
+  g_clear_object (&buffer);
+
+  manager = ide_context_get_buffer_manager (context);
+  ide_buffer_manager_load_file_async (manager, file, FALSE, NULL, NULL, load_file_cb, main_loop);
+  g_main_loop_run (main_loop);
+
+  if (buffer == NULL)
+    return FALSE;
+
+  g_signal_connect (buffer, "notify::busy", G_CALLBACK (buffer_notify_busy), NULL);
+
+  if (have_display)
+    {
+      GtkWidget *window = gtk_offscreen_window_new ();
+
+      view = g_object_new (IDE_TYPE_SOURCE_VIEW,
+                           "buffer", buffer,
+                           "visible", TRUE,
+                           NULL);
+      gtk_container_add (GTK_CONTAINER (window), view);
+      gtk_window_set_default_size (GTK_WINDOW (window), 800, 600);
+      gtk_widget_show (window);
+
+      g_signal_connect (gtk_source_view_get_completion (GTK_SOURCE_VIEW (view)),
+                        "show",
+                        G_CALLBACK (completion_show_cb),
+                        NULL);
+    }
+
+  settle ();
+
+  return TRUE;
+}
+
+static void
+goto_position (guint line,
+               guint column)
+{
+  GtkTextIter iter;
+
+  gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &iter,
+                                           line ? line - 1 : 0,
+                                           column ? column - 1 : 0);
+  gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (buffer), &iter);
+}
+
+static void
+type_text (guint        delay,
+           const gchar *text)
+{
+  for (const gchar *iter = text; *iter; iter = g_utf8_next_char (iter))
+    {
+      const gchar *next = g_utf8_next_char (iter);
+
+      gtk_text_buffer_begin_user_action (GTK_TEXT_BUFFER (buffer));
+      gtk_text_buffer_insert_at_cursor (GTK_TEXT_BUFFER (buffer), iter, next - iter);
+      gtk_text_buffer_end_user_action (GTK_TEXT_BUFFER (buffer));
+
+      record_edit ();
+      run_for (delay);
+    }
+}
+
+static void
+erase_text (guint delay,
+            guint count)
+{
+  for (guint i = 0; i < count; i++)
+    {
+      GtkTextIter iter;
+
+      gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (buffer), &iter,
+                                        gtk_text_buffer_get_insert (GTK_TEXT_BUFFER (buffer)));
+      gtk_text_buffer_backspace (GTK_TEXT_BUFFER (buffer), &iter, TRUE, TRUE);
+
+      record_edit ();
+      run_for (delay);
+    }
+}
+
+static void
+request_completion (void)
+{
+  GtkSourceCompletion *comp;
+  gint64 deadline;
+
+  if (view == NULL)
+    return;
+
+  comp = gtk_source_view_get_completion (GTK_SOURCE_VIEW (view));
+
+  completion_shown = FALSE;
+  completion.pending = g_get_monotonic_time ();
+  deadline = completion.pending + (COMPLETION_TIMEOUT_MSEC * 1000L);
+
+  g_signal_emit_by_name (view, "show-completion");
+
+  while (!completion_shown && g_get_monotonic_time () < deadline)
+    g_main_context_iteration (NULL, FALSE);
+
+  if (!completion_shown)
+    {
+      g_printerr ("Completion did not show within %u msec\n", COMPLETION_TIMEOUT_MSEC);
+      completion.pending = 0;
+    }
+
+  gtk_source_completion_hide (comp);
+}
+
+static gboolean
+replay_line (const gchar  *line,
+             gboolean      have_display,
+             GError      **error)
+{
+  g_auto(GStrv) parts = NULL;
+  guint n_parts;
+
+  if (*line == '\0' || *line == '#')
+    return TRUE;
+
+  parts = g_strsplit (line, " ", 3);
+  n_parts = g_strv_length (parts);
+
+  if (g_str_equal (parts [0], "open") && n_parts >= 2)
+    {
+      recording = FALSE;
+
+      if (!open_file (parts [1], have_display))
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to open %s", parts [1]);
+          return FALSE;
+        }
+
+      highlight.pending = 0;
+      diagnose_edit = 0;
+      recording = TRUE;
+
+      return TRUE;
+    }
+
+  if (buffer == NULL)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "No file has been opened");
+      return FALSE;
+    }
+
+  if (g_str_equal (parts [0], "goto") && n_parts == 3)
+    goto_position (g_ascii_strtoull (parts [1], NULL, 10),
+                   g_ascii_strtoull (parts [2], NULL, 10));
+  else if (g_str_equal (parts [0], "type") && n_parts == 3)
+    {
+      g_autofree gchar *text = g_strcompress (parts [2]);
+
+      type_text (g_ascii_strtoull (parts [1], NULL, 10), text);
+    }
+  else if (g_str_equal (parts [0], "erase") && n_parts == 3)
+    erase_text (g_ascii_strtoull (parts [1], NULL, 10),
+                g_ascii_strtoull (parts [2], NULL, 10));
+  else if (g_str_equal (parts [0], "complete"))
+    request_completion ();
+  else if (g_str_equal (parts [0], "wait") && n_parts >= 2)
+    run_for (g_ascii_strtoull (parts [1], NULL, 10));
+  else
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Invalid trace command: %s", line);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autoptr(GOptionContext) option_context = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *contents = NULL;
+  g_auto(GStrv) lines = NULL;
+  gboolean have_display;
+
+  ide_set_program_name ("gnome-builder");
+  g_set_prgname ("bench-ide-editing");
+
+  option_context = g_option_context_new ("- Replay an editing trace and report latencies");
+  g_option_context_add_main_entries (option_context, entries, NULL);
+
+  if (!g_option_context_parse (option_context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (project_path == NULL)
+    project_path = g_build_filename (TEST_DATA_DIR, "bench-project", NULL);
+
+  if (trace_path == NULL)
+    trace_path = g_build_filename (TEST_DATA_DIR, "bench-project.trace", NULL);
+
+  if (!g_file_get_contents (trace_path, &contents, NULL, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (!(have_display = gtk_init_check (&argc, &argv)))
+    g_printerr ("No display available, completion will not be measured\n");
+
+  highlight.samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  diagnose.samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  completion.samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+
+  load_plugins ();
+
+  if (!open_context ())
+    return EXIT_FAILURE;
+
+  snapshots = g_array_new (FALSE, FALSE, sizeof (CounterSnapshot));
+  egg_counter_arena_foreach (egg_counter_arena_get_default (), counters_foreach_cb, NULL);
+  g_assert (highlight_queued != NULL);
+
+  lines = g_strsplit (contents, "\n", 0);
+
+  for (guint i = 0; lines [i]; i++)
+    {
+      if (!replay_line (g_strstrip (lines [i]), have_display, &error))
+        {
+          g_printerr ("%s:%u: %s\n", trace_path, i + 1, error->message);
+          return EXIT_FAILURE;
+        }
+    }
+
+  /* Let the last edits finish so they are counted. */
+  if (buffer != NULL)
+    settle ();
+
+  g_print ("%-12s : %6s : %9s : %9s : %9s : %9s\n",
+           "Latency", "Count", "p50 msec", "p90 msec", "p99 msec", "max msec");
+  metric_report (&highlight, NULL);
+  metric_report (&diagnose, NULL);
+  metric_report (&completion, have_display ? NULL : "no display");
+
+  counters_report ();
+
+  if (view != NULL)
+    gtk_widget_destroy (gtk_widget_get_toplevel (view));
+  g_clear_object (&buffer);
+  g_clear_object (&context);
+
+  return EXIT_SUCCESS;
+}
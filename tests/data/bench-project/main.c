@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "point.h"
+
+static void
+read_points (FILE      *stream,
+             PointList *list)
+{
+  double x;
+  double y;
+
+  while (fscanf (stream, "%lf %lf", &x, &y) == 2)
+    point_list_append (list, x, y);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  PointList list;
+  Point center;
+
+  point_list_init (&list);
+  read_points (stdin, &list);
+
+  center = point_list_center (&list);
+
+  printf ("points: %zu\n", list.len);
+  printf ("length: %lf\n", point_list_length (&list));
+  printf ("center: %lf,%lf\n", center.x, center.y);
+
+  point_list_clear (&list);
+
+  return EXIT_SUCCESS;
+}
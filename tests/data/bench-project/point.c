@@ -0,0 +1,72 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "point.h"
+
+void
+point_list_init (PointList *list)
+{
+  memset (list, 0, sizeof *list);
+}
+
+void
+point_list_clear (PointList *list)
+{
+  free (list->points);
+  point_list_init (list);
+}
+
+void
+point_list_append (PointList *list,
+                   double     x,
+                   double     y)
+{
+  if (list->len == list->allocated)
+    {
+      list->allocated = list->allocated ? list->allocated * 2 : 16;
+      list->points = realloc (list->points, list->allocated * sizeof (Point));
+    }
+
+  list->points [list->len].x = x;
+  list->points [list->len].y = y;
+  list->len++;
+}
+
+double
+point_list_length (const PointList *list)
+{
+  double total = 0.0;
+  size_t i;
+
+  for (i = 1; i < list->len; i++)
+    {
+      double dx = list->points [i].x - list->points [i - 1].x;
+      double dy = list->points [i].y - list->points [i - 1].y;
+
+      total += sqrt (dx * dx + dy * dy);
+    }
+
+  return total;
+}
+
+Point
+point_list_center (const PointList *list)
+{
+  Point center = { 0.0, 0.0 };
+  size_t i;
+
+  if (list->len == 0)
+    return center;
+
+  for (i = 0; i < list->len; i++)
+    {
+      center.x += list->points [i].x;
+      center.y += list->points [i].y;
+    }
+
+  center.x /= list->len;
+  center.y /= list->len;
+
+  return center;
+}
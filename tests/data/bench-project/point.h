@@ -0,0 +1,27 @@
+#ifndef POINT_H
+#define POINT_H
+
+#include <stddef.h>
+
+typedef struct
+{
+  double x;
+  double y;
+} Point;
+
+typedef struct
+{
+  Point  *points;
+  size_t  len;
+  size_t  allocated;
+} PointList;
+
+void   point_list_init    (PointList       *list);
+void   point_list_clear   (PointList       *list);
+void   point_list_append  (PointList       *list,
+                           double           x,
+                           double           y);
+double point_list_length  (const PointList *list);
+Point  point_list_center  (const PointList *list);
+
+#endif /* POINT_H */
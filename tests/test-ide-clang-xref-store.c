@@ -0,0 +1,288 @@
+/* test-ide-clang-xref-store.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gstdio.h>
+
+#include "ide-clang-xref-store.h"
+
+#define FOO_USR "c:@F@foo"
+
+static gchar *
+create_file (const gchar *dir,
+             const gchar *name)
+{
+  gchar *path = g_build_filename (dir, name, NULL);
+  g_autoptr(GError) error = NULL;
+  gboolean ret;
+
+  ret = g_file_set_contents (path, "", 0, &error);
+  g_assert_no_error (error);
+  g_assert_true (ret);
+
+  return path;
+}
+
+static void
+add_record (IdeClangXrefBatch *batch,
+            const gchar       *path,
+            guint32            line,
+            guint32            column,
+            IdeClangXrefKind   kind)
+{
+  IdeClangXrefFile *file;
+  IdeClangXrefRecord record = { 0 };
+
+  if (!(file = g_hash_table_lookup (batch->files, path)))
+    file = ide_clang_xref_batch_add_file (batch, path, TRUE);
+
+  g_assert_nonnull (file->records);
+
+  record.usr = g_string_chunk_insert_const (batch->strings, FOO_USR);
+  record.line = line;
+  record.column = column;
+  record.length = 3;
+  record.kind = kind;
+
+  g_array_append_val (file->records, record);
+}
+
+static void
+write_batch (IdeClangXrefStore *store,
+             IdeClangXrefBatch *batch)
+{
+  GPtrArray *batches = g_ptr_array_new_with_free_func (ide_clang_xref_batch_free);
+  IdeClangXrefWrite *write;
+  g_autoptr(GError) error = NULL;
+  gboolean ret;
+
+  g_ptr_array_add (batches, batch);
+
+  write = ide_clang_xref_store_begin_write (store, batches);
+  ret = ide_clang_xref_write_run (write, &error);
+  g_assert_no_error (error);
+  g_assert_true (ret);
+  ide_clang_xref_store_finish_write (store, write);
+  ide_clang_xref_write_free (write);
+}
+
+static void
+assert_hit (GArray      *hits,
+            guint        index,
+            const gchar *path,
+            guint32      line,
+            guint32      column,
+            guint8       kind)
+{
+  const IdeClangXrefHit *hit;
+
+  g_assert_cmpint (index, <, hits->len);
+
+  hit = &g_array_index (hits, IdeClangXrefHit, index);
+
+  g_assert_cmpstr (hit->path, ==, path);
+  g_assert_cmpint (hit->line, ==, line);
+  g_assert_cmpint (hit->column, ==, column);
+  g_assert_cmpint (hit->length, ==, 3);
+  g_assert_cmpint (hit->kind, ==, kind);
+}
+
+static guint
+count_segments (const gchar *dir)
+{
+  GDir *gdir = g_dir_open (dir, 0, NULL);
+  guint count = 0;
+
+  g_assert_nonnull (gdir);
+
+  while (g_dir_read_name (gdir))
+    count++;
+
+  g_dir_close (gdir);
+
+  return count;
+}
+
+static void
+remove_dir (const gchar *dir)
+{
+  GDir *gdir = g_dir_open (dir, 0, NULL);
+  const gchar *name;
+
+  if (gdir != NULL)
+    {
+      while ((name = g_dir_read_name (gdir)))
+        {
+          g_autofree gchar *path = g_build_filename (dir, name, NULL);
+
+          g_unlink (path);
+        }
+
+      g_dir_close (gdir);
+    }
+
+  g_rmdir (dir);
+}
+
+static void
+test_xref_store_update (void)
+{
+  g_autofree gchar *tmpdir = g_dir_make_tmp ("xref-XXXXXX", NULL);
+  g_autofree gchar *store_dir = g_build_filename (tmpdir, "store", NULL);
+  g_autofree gchar *a = create_file (tmpdir, "a.c");
+  g_autofree gchar *b = create_file (tmpdir, "b.c");
+  IdeClangXrefStore *store;
+  IdeClangXrefBatch *batch;
+  GArray *hits;
+
+  store = ide_clang_xref_store_load (store_dir);
+
+  hits = ide_clang_xref_store_lookup (store, FOO_USR);
+  g_assert_cmpint (hits->len, ==, 0);
+  g_array_unref (hits);
+
+  /* a.c defines foo and b.c uses it. */
+  batch = ide_clang_xref_batch_new ();
+  add_record (batch, a, 1, 5, IDE_CLANG_XREF_DEFINITION);
+  add_record (batch, b, 3, 2, IDE_CLANG_XREF_REFERENCE);
+  write_batch (store, batch);
+
+  hits = ide_clang_xref_store_lookup (store, FOO_USR);
+  g_assert_cmpint (hits->len, ==, 2);
+  assert_hit (hits, 0, a, 1, 5, IDE_CLANG_XREF_DEFINITION);
+  assert_hit (hits, 1, b, 3, 2, IDE_CLANG_XREF_REFERENCE);
+  g_array_unref (hits);
+
+  /* Reindexing a.c replaces its records and keeps those of b.c. */
+  batch = ide_clang_xref_batch_new ();
+  add_record (batch, a, 7, 5, IDE_CLANG_XREF_DEFINITION);
+  write_batch (store, batch);
+
+  hits = ide_clang_xref_store_lookup (store, FOO_USR);
+  g_assert_cmpint (hits->len, ==, 2);
+  assert_hit (hits, 0, a, 7, 5, IDE_CLANG_XREF_DEFINITION);
+  assert_hit (hits, 1, b, 3, 2, IDE_CLANG_XREF_REFERENCE);
+  g_array_unref (hits);
+
+  /* Removing b.c hides its records. */
+  batch = ide_clang_xref_batch_new ();
+  ide_clang_xref_batch_add_file (batch, b, FALSE);
+  write_batch (store, batch);
+
+  hits = ide_clang_xref_store_lookup (store, FOO_USR);
+  g_assert_cmpint (hits->len, ==, 1);
+  assert_hit (hits, 0, a, 7, 5, IDE_CLANG_XREF_DEFINITION);
+  g_array_unref (hits);
+
+  hits = ide_clang_xref_store_lookup (store, "c:@F@bar");
+  g_assert_cmpint (hits->len, ==, 0);
+  g_array_unref (hits);
+
+  /* Each write appended a segment. */
+  g_assert_cmpint (count_segments (store_dir), ==, 3);
+
+  ide_clang_xref_store_free (store);
+
+  /* A new session sees the same records. */
+  store = ide_clang_xref_store_load (store_dir);
+
+  hits = ide_clang_xref_store_lookup (store, FOO_USR);
+  g_assert_cmpint (hits->len, ==, 1);
+  assert_hit (hits, 0, a, 7, 5, IDE_CLANG_XREF_DEFINITION);
+  g_array_unref (hits);
+
+  ide_clang_xref_store_free (store);
+
+  remove_dir (store_dir);
+  g_unlink (a);
+  g_unlink (b);
+  g_rmdir (tmpdir);
+}
+
+static void
+test_xref_store_compact (void)
+{
+  g_autofree gchar *tmpdir = g_dir_make_tmp ("xref-XXXXXX", NULL);
+  g_autofree gchar *store_dir = g_build_filename (tmpdir, "store", NULL);
+  g_autofree gchar *a = create_file (tmpdir, "a.c");
+  g_autofree gchar *b = create_file (tmpdir, "b.c");
+  g_autoptr(GPtrArray) segments = NULL;
+  g_autoptr(GHashTable) mtimes = NULL;
+  IdeClangXrefStore *store;
+  IdeClangXrefBatch *batch;
+  GArray *hits;
+  guint i;
+
+  store = ide_clang_xref_store_load (store_dir);
+
+  batch = ide_clang_xref_batch_new ();
+  add_record (batch, b, 3, 2, IDE_CLANG_XREF_REFERENCE);
+  write_batch (store, batch);
+
+  batch = ide_clang_xref_batch_new ();
+  ide_clang_xref_batch_add_file (batch, b, FALSE);
+  write_batch (store, batch);
+
+  /* Enough writes to trigger at least one compaction. */
+  for (i = 1; i <= 100; i++)
+    {
+      batch = ide_clang_xref_batch_new ();
+      add_record (batch, a, i, 1, IDE_CLANG_XREF_DEFINITION);
+      write_batch (store, batch);
+    }
+
+  g_assert_cmpint (count_segments (store_dir), <, 50);
+
+  hits = ide_clang_xref_store_lookup (store, FOO_USR);
+  g_assert_cmpint (hits->len, ==, 1);
+  assert_hit (hits, 0, a, 100, 1, IDE_CLANG_XREF_DEFINITION);
+  g_array_unref (hits);
+
+  ide_clang_xref_store_free (store);
+
+  store = ide_clang_xref_store_load (store_dir);
+
+  hits = ide_clang_xref_store_lookup (store, FOO_USR);
+  g_assert_cmpint (hits->len, ==, 1);
+  assert_hit (hits, 0, a, 100, 1, IDE_CLANG_XREF_DEFINITION);
+  g_array_unref (hits);
+
+  /* Removed files are not reported as indexed. */
+  segments = ide_clang_xref_store_get_segments (store);
+  mtimes = ide_clang_xref_segments_get_mtimes (segments);
+  g_assert_true (g_hash_table_contains (mtimes, a));
+  g_assert_false (g_hash_table_contains (mtimes, b));
+
+  g_clear_pointer (&mtimes, g_hash_table_unref);
+  g_clear_pointer (&segments, g_ptr_array_unref);
+  ide_clang_xref_store_free (store);
+
+  remove_dir (store_dir);
+  g_unlink (a);
+  g_unlink (b);
+  g_rmdir (tmpdir);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/Clang/XrefStore/update", test_xref_store_update);
+  g_test_add_func ("/Ide/Clang/XrefStore/compact", test_xref_store_compact);
+  return g_test_run ();
+}
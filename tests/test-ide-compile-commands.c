@@ -0,0 +1,102 @@
+/* test-ide-compile-commands.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ide.h>
+
+static void
+test_compile_commands_lookup (void)
+{
+  g_autoptr(IdeCompileCommands) compile_commands = NULL;
+  g_autoptr(GFile) file = NULL;
+  g_autoptr(GFile) source = NULL;
+  g_autoptr(GFile) header = NULL;
+  g_autoptr(GFile) cxx = NULL;
+  g_autoptr(GFile) lang = NULL;
+  g_autoptr(GFile) missing = NULL;
+  g_auto(GStrv) flags = NULL;
+  GError *error = NULL;
+  gboolean ret;
+
+  compile_commands = ide_compile_commands_new ();
+  file = g_file_new_for_path (TEST_DATA_DIR"/project1/compile_commands.json");
+
+  ret = ide_compile_commands_load (compile_commands, file, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_true (ret);
+
+  source = g_file_new_for_path ("/tmp/project1/src/main.c");
+  flags = ide_compile_commands_lookup (compile_commands, source, &error);
+  g_assert_no_error (error);
+  g_assert (flags != NULL);
+  g_assert_cmpint (g_strv_length (flags), ==, 8);
+  g_assert_cmpstr (flags [0], ==, "-DHAVE_CONFIG_H");
+  g_assert_cmpstr (flags [1], ==, "-I/tmp/project1/build");
+  g_assert_cmpstr (flags [2], ==, "-I/tmp/project1/include");
+  g_assert_cmpstr (flags [3], ==, "-isystem");
+  g_assert_cmpstr (flags [4], ==, "/opt/include");
+  g_assert_cmpstr (flags [5], ==, "-DFOO=1");
+  g_assert_cmpstr (flags [6], ==, "-std=gnu11");
+  g_assert_cmpstr (flags [7], ==, "-Wall");
+  g_clear_pointer (&flags, g_strfreev);
+
+  /* Headers use the flags of a sibling source file */
+  header = g_file_new_for_path ("/tmp/project1/src/main.h");
+  flags = ide_compile_commands_lookup (compile_commands, header, &error);
+  g_assert_no_error (error);
+  g_assert (flags != NULL);
+  g_assert_cmpstr (flags [0], ==, "-DHAVE_CONFIG_H");
+  g_clear_pointer (&flags, g_strfreev);
+
+  cxx = g_file_new_for_path ("/tmp/project1/src/util.cpp");
+  flags = ide_compile_commands_lookup (compile_commands, cxx, &error);
+  g_assert_no_error (error);
+  g_assert (flags != NULL);
+  g_assert_cmpint (g_strv_length (flags), ==, 5);
+  g_assert_cmpstr (flags [0], ==, "-xc++");
+  g_assert_cmpstr (flags [1], ==, "-I/tmp/project1/include");
+  g_assert_cmpstr (flags [2], ==, "-D");
+  g_assert_cmpstr (flags [3], ==, "BAR");
+  g_assert_cmpstr (flags [4], ==, "-std=c++11");
+  g_clear_pointer (&flags, g_strfreev);
+
+  /* An explicit language is kept as is and linker/preprocessor -W flags are dropped */
+  lang = g_file_new_for_path ("/tmp/project1/src/lang.cc");
+  flags = ide_compile_commands_lookup (compile_commands, lang, &error);
+  g_assert_no_error (error);
+  g_assert (flags != NULL);
+  g_assert_cmpint (g_strv_length (flags), ==, 3);
+  g_assert_cmpstr (flags [0], ==, "-x");
+  g_assert_cmpstr (flags [1], ==, "c++");
+  g_assert_cmpstr (flags [2], ==, "-Wextra");
+  g_clear_pointer (&flags, g_strfreev);
+
+  missing = g_file_new_for_path ("/tmp/project1/src/missing.c");
+  flags = ide_compile_commands_lookup (compile_commands, missing, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+  g_assert (flags == NULL);
+  g_clear_error (&error);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/CompileCommands/lookup", test_compile_commands_lookup);
+  return g_test_run ();
+}
@@ -0,0 +1,66 @@
+/* test-ide-pattern-spec.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ide.h>
+
+static void
+test_pattern_spec_basic (void)
+{
+  static struct {
+    const gchar *needle;
+    const gchar *haystack;
+    gboolean     match;
+  } tests[] = {
+    { "gtk widg", "gtk_widget_show", TRUE },
+    { "gtk widg", "gtkwidget", FALSE },
+    { "gtk show", "gtk_widget_show", TRUE },
+    { "show gtk", "gtk_widget_show", FALSE },
+    { "widg", "gtk_WIDGET_show", TRUE },
+    { "Widg", "gtk_widget_show", FALSE },
+    { "Widg", "gtk_Widget_show", TRUE },
+    { "-b", "a-B", TRUE },
+    { "a  b", "a_b", TRUE },
+    { "", "anything", TRUE },
+    { "abc", "ab", FALSE },
+    { "héllo", "HÉLLO world", TRUE },
+    { "héllo", "hello", FALSE },
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (tests); i++)
+    {
+      g_autoptr(IdePatternSpec) spec = ide_pattern_spec_new (tests[i].needle);
+
+      g_assert_cmpstr (ide_pattern_spec_get_text (spec), ==, tests[i].needle);
+
+      if (ide_pattern_spec_match (spec, tests[i].haystack) != tests[i].match)
+        g_error ("\"%s\" should %smatch \"%s\"",
+                 tests[i].needle,
+                 tests[i].match ? "" : "not ",
+                 tests[i].haystack);
+    }
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/PatternSpec/basic", test_pattern_spec_basic);
+  return g_test_run ();
+}
@@ -0,0 +1,181 @@
+/* test-ide-source-raster-map.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ide.h>
+#include <string.h>
+
+#include "ide-source-raster-map-private.h"
+
+/* Must match ide-source-raster-map.c */
+#define TILE_LINES  256
+#define LINE_HEIGHT 3
+#define MAP_WIDTH   100
+
+#define N_TILES     4
+#define N_LINES     1000
+
+static void
+draw_map (GtkWidget *map)
+{
+  cairo_surface_t *surface;
+  cairo_t *cr;
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        MAP_WIDTH,
+                                        N_TILES * TILE_LINES * LINE_HEIGHT);
+  cr = cairo_create (surface);
+  gtk_widget_draw (map, cr);
+  cairo_destroy (cr);
+  cairo_surface_destroy (surface);
+}
+
+static void
+assert_tiles (GtkWidget   *map,
+              const gchar *expected)
+{
+  guint i;
+
+  g_assert_cmpint (strlen (expected), ==, N_TILES);
+
+  for (i = 0; i < N_TILES; i++)
+    {
+      gboolean has_tile = _ide_source_raster_map_has_tile (IDE_SOURCE_RASTER_MAP (map), i);
+
+      if (has_tile != (expected [i] == '1'))
+        g_error ("Tile %u should be %s, expected tiles %s",
+                 i, has_tile ? "dropped" : "cached", expected);
+    }
+}
+
+static void
+test_raster_map_invalidate (void)
+{
+  GtkSourceBuffer *buffer;
+  GtkTextTag *colored;
+  GtkTextTag *underlined;
+  GtkWidget *window;
+  GtkWidget *view;
+  GtkWidget *map;
+  GtkTextIter begin;
+  GtkTextIter end;
+  GString *str;
+  guint i;
+
+  buffer = gtk_source_buffer_new (NULL);
+
+  str = g_string_new (NULL);
+  for (i = 0; i < N_LINES - 1; i++)
+    g_string_append (str, "int foo;\n");
+  g_string_append (str, "int foo;");
+  gtk_text_buffer_set_text (GTK_TEXT_BUFFER (buffer), str->str, str->len);
+  g_string_free (str, TRUE);
+
+  colored = gtk_text_buffer_create_tag (GTK_TEXT_BUFFER (buffer), NULL,
+                                        "foreground", "#ff0000",
+                                        NULL);
+  underlined = gtk_text_buffer_create_tag (GTK_TEXT_BUFFER (buffer), NULL,
+                                           "underline", PANGO_UNDERLINE_SINGLE,
+                                           NULL);
+
+  view = g_object_ref_sink (gtk_source_view_new_with_buffer (buffer));
+  map = ide_source_raster_map_new (GTK_SOURCE_VIEW (view));
+  gtk_widget_set_size_request (map, MAP_WIDTH, N_TILES * TILE_LINES * LINE_HEIGHT);
+
+  window = gtk_offscreen_window_new ();
+  gtk_container_add (GTK_CONTAINER (window), map);
+  gtk_widget_show_all (window);
+
+  draw_map (map);
+  assert_tiles (map, "1111");
+
+  /* An edit within a line only drops the tile covering it. */
+  gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &begin, 300, 3);
+  gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &begin, "eger", -1);
+  assert_tiles (map, "1011");
+
+  draw_map (map);
+  assert_tiles (map, "1111");
+
+  gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &begin, 600, 0);
+  gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &end, 600, 4);
+  gtk_text_buffer_delete (GTK_TEXT_BUFFER (buffer), &begin, &end);
+  assert_tiles (map, "1101");
+
+  draw_map (map);
+
+  /* Adding or removing lines also drops the tiles that follow. */
+  gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &begin, 300, 0);
+  gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &begin, "\n", -1);
+  assert_tiles (map, "1000");
+
+  draw_map (map);
+
+  gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &begin, 520, 0);
+  gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &end, 521, 0);
+  gtk_text_buffer_delete (GTK_TEXT_BUFFER (buffer), &begin, &end);
+  assert_tiles (map, "1100");
+
+  draw_map (map);
+  assert_tiles (map, "1111");
+
+  /* Tags without a foreground do not change the map. */
+  gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &begin, 10, 0);
+  gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &end, 20, 0);
+  gtk_text_buffer_apply_tag (GTK_TEXT_BUFFER (buffer), underlined, &begin, &end);
+  assert_tiles (map, "1111");
+
+  /* Tags with a foreground drop the tiles within their range. */
+  gtk_text_buffer_apply_tag (GTK_TEXT_BUFFER (buffer), colored, &begin, &end);
+  assert_tiles (map, "0111");
+
+  draw_map (map);
+
+  gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &begin, 250, 0);
+  gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (buffer), &end, 260, 0);
+  gtk_text_buffer_apply_tag (GTK_TEXT_BUFFER (buffer), colored, &begin, &end);
+  assert_tiles (map, "0011");
+
+  draw_map (map);
+
+  gtk_text_buffer_remove_tag (GTK_TEXT_BUFFER (buffer), colored, &begin, &end);
+  assert_tiles (map, "0011");
+
+  draw_map (map);
+  assert_tiles (map, "1111");
+
+  /* Changing the tab width clears everything. */
+  gtk_source_view_set_tab_width (GTK_SOURCE_VIEW (view), 4);
+  assert_tiles (map, "0000");
+
+  gtk_widget_destroy (window);
+  g_object_unref (view);
+  g_object_unref (buffer);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  gtk_init (&argc, &argv);
+  g_test_add_func ("/Ide/SourceRasterMap/invalidate", test_raster_map_invalidate);
+  return g_test_run ();
+}
@@ -0,0 +1,189 @@
+/* ide-grep.c
+ *
+ * Copyright (C) 2016 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <ide.h>
+#include <stdlib.h>
+
+static GMainLoop *main_loop;
+static gint exit_code = EXIT_SUCCESS;
+static IdeTextIndex *text_index;
+static GTimer *timer;
+static const gchar *query;
+static gboolean regex;
+static gboolean ignore_case;
+static gboolean quiet;
+static gint max_count;
+static gint repeat = 1;
+
+static GOptionEntry entries[] = {
+  { "regex", 'e', 0, G_OPTION_ARG_NONE, &regex,
+    N_("Treat PATTERN as a regular expression") },
+  { "ignore-case", 'i', 0, G_OPTION_ARG_NONE, &ignore_case,
+    N_("Ignore case distinctions") },
+  { "max-count", 'm', 0, G_OPTION_ARG_INT, &max_count,
+    N_("Stop after NUM matches"), N_("NUM") },
+  { "quiet", 'q', 0, G_OPTION_ARG_NONE, &quiet,
+    N_("Only print timings") },
+  { "repeat", 'r', 0, G_OPTION_ARG_INT, &repeat,
+    N_("Run the query NUM times"), N_("NUM") },
+  { NULL }
+};
+
+static void
+quit (gint code)
+{
+  exit_code = code;
+  g_main_loop_quit (main_loop);
+}
+
+static void search (void);
+
+static void
+search_cb (GObject      *object,
+           GAsyncResult *result,
+           gpointer      user_data)
+{
+  g_autoptr(GPtrArray) matches = NULL;
+  g_autoptr(GError) error = NULL;
+  gdouble elapsed;
+  guint i;
+
+  elapsed = g_timer_elapsed (timer, NULL) * 1000.0;
+
+  if (!(matches = ide_text_index_search_finish (text_index, result, &error)))
+    {
+      g_printerr ("%s\n", error->message);
+      quit (EXIT_FAILURE);
+      return;
+    }
+
+  if (!quiet && repeat == 1)
+    {
+      for (i = 0; i < matches->len; i++)
+        {
+          const IdeTextIndexMatch *match = g_ptr_array_index (matches, i);
+
+          g_print ("%s:%u:%u:%s\n",
+                   match->path,
+                   match->line + 1,
+                   match->line_offset + 1,
+                   match->text);
+        }
+    }
+
+  g_printerr (_("Query completed in %.2lf msec with %u matches\n"), elapsed, matches->len);
+
+  if (--repeat > 0)
+    search ();
+  else
+    quit (matches->len > 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+static void
+search (void)
+{
+  IdeTextIndexSearchFlags flags = IDE_TEXT_INDEX_SEARCH_NONE;
+
+  if (regex)
+    flags |= IDE_TEXT_INDEX_SEARCH_REGEX;
+
+  if (!ignore_case)
+    flags |= IDE_TEXT_INDEX_SEARCH_CASE_SENSITIVE;
+
+  g_timer_start (timer);
+  ide_text_index_search_async (text_index, query, flags, MAX (0, max_count), NULL, search_cb, NULL);
+}
+
+static void
+load_cb (GObject      *object,
+         GAsyncResult *result,
+         gpointer      user_data)
+{
+  g_autoptr(GError) error = NULL;
+
+  if (!ide_text_index_load_finish (text_index, result, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      quit (EXIT_FAILURE);
+      return;
+    }
+
+  g_printerr (_("Loaded %u files in %.2lf msec\n"),
+              ide_text_index_get_n_files (text_index),
+              g_timer_elapsed (timer, NULL) * 1000.0);
+
+  search ();
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autoptr(GOptionContext) context = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GFile) directory = NULL;
+  const gchar *path = ".";
+
+  ide_set_program_name ("gnome-builder");
+  g_set_prgname ("ide-grep");
+
+  context = g_option_context_new (_("PATTERN [DIRECTORY] - Search the contents of a project."));
+  g_option_context_add_main_entries (context, entries, GETTEXT_PACKAGE);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (argc < 2)
+    {
+      g_printerr (_("A pattern is required.\n"));
+      return EXIT_FAILURE;
+    }
+
+  query = argv [1];
+
+  if (argc > 2)
+    path = argv [2];
+
+  main_loop = g_main_loop_new (NULL, FALSE);
+  timer = g_timer_new ();
+
+  /*
+   * Without a project context there is no version control to consult, so
+   * only hidden files and directories are skipped.
+   */
+  directory = g_file_new_for_commandline_arg (path);
+  text_index = ide_text_index_new (directory, NULL);
+  ide_text_index_load_async (text_index, NULL, load_cb, NULL);
+
+  g_main_loop_run (main_loop);
+
+  g_clear_object (&text_index);
+  g_clear_pointer (&timer, g_timer_destroy);
+  g_clear_pointer (&main_loop, g_main_loop_unref);
+
+  return exit_code;
+}